@@ -0,0 +1,151 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifndef _SDL_atomic_h
+#define _SDL_atomic_h
+
+/** @file SDL_atomic.h
+ *  Atomic operations and spin locks
+ *
+ *  The atomic operations that change a value are full memory barriers.
+ *  SDL_AtomicGet() and SDL_AtomicGetPtr() are only acquire barriers:
+ *  later loads and stores can't move before them, but earlier ones can
+ *  move after.  Where the compiler has no atomic builtins they're
+ *  emulated with a lock, so they stay correct but lose their speed.
+ *
+ *  @note These are independent of the other SDL routines.
+ */
+
+#include "SDL_stdinc.h"
+
+#include "begin_code.h"
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/** @name Spin lock functions                                    */ /*@{*/
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/** A spin lock, initialize it to 0 (unlocked).
+ *  Spin locks are meant for very short critical sections, use a
+ *  mutex if the lock may be held for long or while sleeping.
+ */
+typedef int SDL_SpinLock;
+
+/** Try to lock a spin lock
+ *  @return SDL_TRUE if the lock was taken, SDL_FALSE if it's held
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_AtomicTryLock(SDL_SpinLock *lock);
+
+/** Lock a spin lock, spinning a while and then yielding until it's free */
+extern DECLSPEC void SDLCALL SDL_AtomicLock(SDL_SpinLock *lock);
+
+/** Unlock a spin lock held by the current thread */
+extern DECLSPEC void SDLCALL SDL_AtomicUnlock(SDL_SpinLock *lock);
+
+/*@}*/
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/** @name Memory barriers                                        */ /*@{*/
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/** Keep the compiler from moving memory accesses across this point */
+#if defined(__GNUC__)
+#define SDL_CompilerBarrier()	__asm__ __volatile__ ("" : : : "memory")
+#elif defined(_MSC_VER) && (_MSC_VER >= 1400)
+extern void _ReadWriteBarrier(void);
+#pragma intrinsic(_ReadWriteBarrier)
+#define SDL_CompilerBarrier()	_ReadWriteBarrier()
+#else
+#define SDL_CompilerBarrier()	SDL_MemoryBarrier()
+#endif
+
+/** Keep the compiler and the CPU from moving memory accesses across
+ *  this point, so writes before it are seen by other threads before
+ *  writes after it.
+ */
+extern DECLSPEC void SDLCALL SDL_MemoryBarrier(void);
+#if defined(__GNUC__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+#define SDL_MemoryBarrier()	__sync_synchronize()
+#endif
+
+/*@}*/
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/** @name Atomic integer and pointer functions                   */ /*@{*/
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/** An atomic integer, only accessed with the functions below */
+typedef struct SDL_atomic_t {
+	volatile int value;
+} SDL_atomic_t;
+
+/** Set an atomic integer to 'newval' if it's currently 'oldval'
+ *  @return SDL_TRUE if it was set
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_AtomicCAS(SDL_atomic_t *a, int oldval, int newval);
+
+/** Set an atomic integer
+ *  @return The previous value
+ */
+extern DECLSPEC int SDLCALL SDL_AtomicSet(SDL_atomic_t *a, int value);
+
+/** Get the value of an atomic integer, with acquire semantics */
+extern DECLSPEC int SDLCALL SDL_AtomicGet(SDL_atomic_t *a);
+
+/** Add to an atomic integer, 'value' may be negative
+ *  @return The previous value
+ */
+extern DECLSPEC int SDLCALL SDL_AtomicAdd(SDL_atomic_t *a, int value);
+
+/** Increment an atomic reference count */
+#define SDL_AtomicIncRef(a)	SDL_AtomicAdd(a, 1)
+
+/** Decrement an atomic reference count
+ *  @return SDL_TRUE if it dropped to zero
+ */
+#define SDL_AtomicDecRef(a)	(SDL_AtomicAdd(a, -1) == 1)
+
+/** Set a pointer to 'newval' if it's currently 'oldval'
+ *  @return SDL_TRUE if it was set
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_AtomicCASPtr(void **a, void *oldval, void *newval);
+
+/** Set a pointer
+ *  @return The previous value
+ */
+extern DECLSPEC void * SDLCALL SDL_AtomicSetPtr(void **a, void *value);
+
+/** Get the value of a pointer, with acquire semantics */
+extern DECLSPEC void * SDLCALL SDL_AtomicGetPtr(void **a);
+
+/*@}*/
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+#include "close_code.h"
+
+#endif /* _SDL_atomic_h */
@@ -65,6 +65,7 @@ extern "C" {
  *     This function usually runs in a separate thread, and so you should
  *     protect data structures that it accesses by calling SDL_LockAudio()
  *     and SDL_UnlockAudio() in your code.
+ *     If it is NULL, the audio is instead fed with SDL_QueueAudio().
  * - 'desired->userdata' is passed as the first parameter to your callback
  *     function.
  *
@@ -105,6 +106,12 @@ typedef struct SDL_AudioSpec {
 #define AUDIO_S16MSB	0x9010	/**< As above, but big-endian byte order */
 #define AUDIO_U16	AUDIO_U16LSB
 #define AUDIO_S16	AUDIO_S16LSB
+#define AUDIO_S32LSB	0x8020	/**< 32-bit signed samples */
+#define AUDIO_S32MSB	0x9020	/**< As above, but big-endian byte order */
+#define AUDIO_S32	AUDIO_S32LSB
+#define AUDIO_F32LSB	0x8120	/**< 32-bit floating point samples, -1.0 to 1.0 */
+#define AUDIO_F32MSB	0x9120	/**< As above, but big-endian byte order */
+#define AUDIO_F32	AUDIO_F32LSB
 
 /**
  *  @name Native audio byte ordering
@@ -113,9 +120,13 @@ typedef struct SDL_AudioSpec {
 #if SDL_BYTEORDER == SDL_LIL_ENDIAN
 #define AUDIO_U16SYS	AUDIO_U16LSB
 #define AUDIO_S16SYS	AUDIO_S16LSB
+#define AUDIO_S32SYS	AUDIO_S32LSB
+#define AUDIO_F32SYS	AUDIO_F32LSB
 #else
 #define AUDIO_U16SYS	AUDIO_U16MSB
 #define AUDIO_S16SYS	AUDIO_S16MSB
+#define AUDIO_S32SYS	AUDIO_S32MSB
+#define AUDIO_F32SYS	AUDIO_F32MSB
 #endif
 /*@}*/
 
@@ -195,6 +206,24 @@ extern DECLSPEC SDL_audiostatus SDLCALL SDL_GetAudioStatus(void);
  */
 extern DECLSPEC void SDLCALL SDL_PauseAudio(int pause_on);
 
+/**
+ * When the audio device was opened with a NULL callback, this copies
+ * 'len' bytes of audio in the format passed to SDL_OpenAudio() to the
+ * end of the queue the audio thread plays from.  The queue holds about
+ * a second of audio and is lock-free, so it may be called at any time
+ * from one thread, without SDL_LockAudio().
+ *
+ * @return The number of bytes queued, which is less than 'len' when the
+ *         queue is full, or -1 if the device isn't open in queue mode.
+ */
+extern DECLSPEC int SDLCALL SDL_QueueAudio(const void *data, Uint32 len);
+
+/**
+ * Returns the number of bytes that have been queued with SDL_QueueAudio()
+ * but not played yet, or 0 if the device isn't open in queue mode.
+ */
+extern DECLSPEC Uint32 SDLCALL SDL_GetQueuedAudioSize(void);
+
 /**
  * This function loads a WAVE from the data source, automatically freeing
  * that source if 'freesrc' is non-zero.  For example, to load a WAVE file,
@@ -208,6 +237,11 @@ extern DECLSPEC void SDLCALL SDL_PauseAudio(int pause_on);
  * You need to free the audio buffer with SDL_FreeWAV() when you are 
  * done with it.
  *
+ * Data from memory streams is read in place.  If 'src' comes from
+ * SDL_RWFromMappedFile() and 'freesrc' is set, PCM data isn't copied at
+ * all: 'audio_buf' points into the mapped file, which stays open until
+ * SDL_FreeWAV().
+ *
  * This function returns NULL and sets the SDL error message if the 
  * wave file cannot be opened, uses an unknown data format, or is 
  * corrupt.  Currently raw and MS-ADPCM WAVE files are supported.
@@ -246,6 +280,61 @@ extern DECLSPEC int SDLCALL SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
  */
 extern DECLSPEC int SDLCALL SDL_ConvertAudio(SDL_AudioCVT *cvt);
 
+/**
+ * @name Audio Streams
+ * An audio stream converts audio incrementally: data is put into the
+ * stream in chunks of any size and the converted data is read back out
+ * as it becomes available.  Unlike SDL_ConvertAudio(), rate conversion
+ * keeps its filter history between chunks, so there are no clicks at the
+ * chunk boundaries.
+ * The rate can only be converted for 1, 2, 4 or 6 output channels.
+ */
+/*@{*/
+typedef struct SDL_AudioStream SDL_AudioStream;
+
+/**
+ * Create a stream converting from the source format, channels and rate
+ * to the destination ones.
+ *
+ * @return The new stream, or NULL if there was an error.
+ */
+extern DECLSPEC SDL_AudioStream * SDLCALL SDL_NewAudioStream(
+		Uint16 src_format, Uint8 src_channels, int src_rate,
+		Uint16 dst_format, Uint8 dst_channels, int dst_rate);
+
+/**
+ * Add 'len' bytes of source audio to the stream.  A partial sample frame
+ * at the end is kept until the rest of it is put in.
+ *
+ * @return 0, or -1 if there was an error.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamPut(SDL_AudioStream *stream, const void *buf, int len);
+
+/**
+ * Read up to 'len' bytes of converted audio from the stream, in whole
+ * sample frames.
+ *
+ * @return The number of bytes read, or -1 if there was an error.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamGet(SDL_AudioStream *stream, void *buf, int len);
+
+/**
+ * @return The number of converted bytes ready to be read.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamAvailable(SDL_AudioStream *stream);
+
+/**
+ * Tell the stream there's no more input for now, so the audio still held
+ * back for the rate conversion filter is converted and made available.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamFlush(SDL_AudioStream *stream);
+
+/** Drop all audio in the stream and start over */
+extern DECLSPEC void SDLCALL SDL_AudioStreamClear(SDL_AudioStream *stream);
+
+extern DECLSPEC void SDLCALL SDL_FreeAudioStream(SDL_AudioStream *stream);
+/*@}*/
+
 
 #define SDL_MIX_MAXVOLUME 128
 /**
@@ -257,6 +346,24 @@ extern DECLSPEC int SDLCALL SDL_ConvertAudio(SDL_AudioCVT *cvt);
  */
 extern DECLSPEC void SDLCALL SDL_MixAudio(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
 
+/**
+ * This works like SDL_MixAudio(), but for audio in the given format
+ * instead of the format of the open audio device.  AUDIO_U8, AUDIO_S8,
+ * AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_F32LSB and
+ * AUDIO_F32MSB are supported.
+ * Float samples are clipped to -1.0 .. 1.0.
+ */
+extern DECLSPEC void SDLCALL SDL_MixAudioFormat(Uint8 *dst, const Uint8 *src, Uint16 format, Uint32 len, int volume);
+
+/**
+ * This mixes 'count' source buffers, each with its own volume, into one
+ * destination buffer of 'len' bytes in a single pass.  The sum is only
+ * clipped once at the end, so the result can differ slightly from
+ * calling SDL_MixAudioFormat() for each source in turn, and is faster
+ * because the destination is only read and written once.
+ */
+extern DECLSPEC void SDLCALL SDL_MixAudioSources(Uint8 *dst, const Uint8 **srcs, const int *volumes, int count, Uint16 format, Uint32 len);
+
 /**
  * @name Audio Locks
  * The lock manipulated by these functions protects the callback function.
@@ -39,6 +39,9 @@ extern "C" {
 /** This function returns true if the CPU has the RDTSC instruction */
 extern DECLSPEC SDL_bool SDLCALL SDL_HasRDTSC(void);
 
+/** This function returns true if the RDTSC counter runs at a constant rate */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasInvariantTSC(void);
+
 /** This function returns true if the CPU has MMX features */
 extern DECLSPEC SDL_bool SDLCALL SDL_HasMMX(void);
 
@@ -60,6 +63,51 @@ extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE2(void);
 /** This function returns true if the CPU has AltiVec features */
 extern DECLSPEC SDL_bool SDLCALL SDL_HasAltiVec(void);
 
+/** This function returns true if the CPU has AVX2 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasAVX2(void);
+
+/** This function returns true if the CPU has SSSE3 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasSSSE3(void);
+
+/** This function returns true if the CPU has SSE4.1 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE41(void);
+
+/** This function returns true if the CPU has ARM NEON features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasNEON(void);
+
+/** This function returns true if the CPU has SSE3 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE3(void);
+
+/** This function returns true if the CPU has SSE4.2 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE42(void);
+
+/** This function returns true if the CPU has AVX features and the OS supports them */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasAVX(void);
+
+/** This function returns true if the CPU has AVX-512 Foundation features
+ *  and the OS supports them
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasAVX512F(void);
+
+/** This function returns the number of logical CPUs available, at least 1 */
+extern DECLSPEC int SDLCALL SDL_GetCPUCount(void);
+
+/** This function returns the number of physical CPU cores, at least 1.
+ *  It's the same as SDL_GetCPUCount() when hyperthreading is off or
+ *  the topology can't be queried.
+ */
+extern DECLSPEC int SDLCALL SDL_GetCPUCoreCount(void);
+
+/** This function returns the L1 data cache line size in bytes, useful
+ *  for padding data shared between threads
+ */
+extern DECLSPEC int SDLCALL SDL_GetCPUCacheLineSize(void);
+
+/** This function returns the amount of system RAM in megabytes, or 0 if
+ *  it can't be determined
+ */
+extern DECLSPEC int SDLCALL SDL_GetSystemRAM(void);
+
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
 }
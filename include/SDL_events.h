@@ -289,12 +289,24 @@ extern DECLSPEC int SDLCALL SDL_PollEvent(SDL_Event *event);
  */
 extern DECLSPEC int SDLCALL SDL_WaitEvent(SDL_Event *event);
 
+/** Waits up to 'timeout' milliseconds for the next available event,
+ *  returning 1, or 0 if the timeout elapsed or there was an error.
+ *  A negative timeout waits indefinitely, like SDL_WaitEvent().
+ */
+extern DECLSPEC int SDLCALL SDL_WaitEventTimeout(SDL_Event *event, int timeout);
+
 /** Add an event to the event queue.
  *  This function returns 0 on success, or -1 if the event queue was full
  *  or there was some other error.
  */
 extern DECLSPEC int SDLCALL SDL_PushEvent(SDL_Event *event);
 
+/** Reports the most events the queue has held at once and the number of
+ *  events dropped because it couldn't grow any further, since the event
+ *  loop was started.  Either pointer may be NULL.
+ */
+extern DECLSPEC void SDLCALL SDL_GetEventQueueStats(Uint32 *highwater, Uint32 *dropped);
+
 /** @name Event Filtering */
 /*@{*/
 typedef int (SDLCALL *SDL_EventFilter)(const SDL_Event *event);
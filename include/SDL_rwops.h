@@ -105,6 +105,38 @@ extern DECLSPEC SDL_RWops * SDLCALL SDL_RWFromFP(FILE *fp, int autoclose);
 extern DECLSPEC SDL_RWops * SDLCALL SDL_RWFromMem(void *mem, int size);
 extern DECLSPEC SDL_RWops * SDLCALL SDL_RWFromConstMem(const void *mem, int size);
 
+/** Read and write a POSIX file descriptor through a read-ahead buffer.
+ *  SDL_RWFromFile() uses this where it's available.
+ */
+extern DECLSPEC SDL_RWops * SDLCALL SDL_RWFromFD(int fd, int autoclose);
+
+/** Open a file read-only and map it into memory, or read it all into
+ *  memory where it can't be mapped.  Reads are then plain copies and
+ *  SDL_RWMappedData() gives the data without copying.
+ */
+extern DECLSPEC SDL_RWops * SDLCALL SDL_RWFromMappedFile(const char *file);
+
+/** Get the data behind a stream from SDL_RWFromMappedFile(), and its size
+ *  in 'size' if that isn't NULL.  Returns NULL for other streams.
+ */
+extern DECLSPEC const void * SDLCALL SDL_RWMappedData(SDL_RWops *context, size_t *size);
+
+/** Get a pointer to the next 'size' bytes of a memory stream, from
+ *  SDL_RWFromMem(), SDL_RWFromConstMem() or SDL_RWFromMappedFile(), and
+ *  move past them without copying.  The data stays valid as long as the
+ *  memory behind the stream does and must not be written to.
+ *  Returns the number of bytes available, which is less than 'size' at
+ *  the end of the data, or -1 without setting an error if the stream
+ *  isn't in memory.
+ */
+extern DECLSPEC int SDLCALL SDL_RWborrow(SDL_RWops *context, const void **ptr, int size);
+
+/** Set the read-ahead buffer size of a file stream from SDL_RWFromFile()
+ *  or SDL_RWFromFD(), 0 reads straight through.
+ *  Returns 0, or -1 if the stream isn't buffered by SDL.
+ */
+extern DECLSPEC int SDLCALL SDL_RWSetReadAhead(SDL_RWops *context, int size);
+
 extern DECLSPEC SDL_RWops * SDLCALL SDL_AllocRW(void);
 extern DECLSPEC void SDLCALL SDL_FreeRW(SDL_RWops *area);
 
@@ -126,6 +158,19 @@ extern DECLSPEC void SDLCALL SDL_FreeRW(SDL_RWops *area);
 #define SDL_RWclose(ctx)		(ctx)->close(ctx)
 /*@}*/
 
+#ifdef SDL_HAS_64BIT_TYPE
+/** @name 64-bit offsets
+ *  These reach past 2 GB in the streams SDL creates; other streams go
+ *  through their seek function and fail for offsets that don't fit.
+ */
+/*@{*/
+extern DECLSPEC Sint64 SDLCALL SDL_RWseek64(SDL_RWops *context, Sint64 offset, int whence);
+extern DECLSPEC Sint64 SDLCALL SDL_RWtell64(SDL_RWops *context);
+/** Returns the size of the data source, or -1 if it isn't seekable */
+extern DECLSPEC Sint64 SDLCALL SDL_RWsize(SDL_RWops *context);
+/*@}*/
+#endif /* SDL_HAS_64BIT_TYPE */
+
 /** @name Read an item of the specified endianness and return in native format */
 /*@{*/
 extern DECLSPEC Uint16 SDLCALL SDL_ReadLE16(SDL_RWops *src);
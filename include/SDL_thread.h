@@ -110,6 +110,78 @@ extern DECLSPEC void SDLCALL SDL_WaitThread(SDL_Thread *thread, int *status);
 /** Forcefully kill a thread without worrying about its state */
 extern DECLSPEC void SDLCALL SDL_KillThread(SDL_Thread *thread);
 
+/** Thread local storage ID, 0 is the invalid ID */
+typedef unsigned int SDL_TLSID;
+
+/**
+ * Create an identifier that is globally visible to all threads but
+ * refers to data that is thread-specific.
+ *
+ * @return The newly created thread local storage identifier, or 0 on error
+ */
+extern DECLSPEC SDL_TLSID SDLCALL SDL_TLSCreate(void);
+
+/**
+ * Get the value associated with a thread local storage ID for the
+ * current thread, or NULL if no value has been set.
+ */
+extern DECLSPEC void * SDLCALL SDL_TLSGet(SDL_TLSID id);
+
+/**
+ * Set the value associated with a thread local storage ID for the
+ * current thread.  The destructor is called with the value when a
+ * thread created with SDL_CreateThread() exits, if it is not NULL.
+ *
+ * @return 0 on success, -1 on error
+ */
+extern DECLSPEC int SDLCALL SDL_TLSSet(SDL_TLSID id, const void *value, void (SDLCALL *destructor)(void*));
+
+/** A group of tasks that can be waited on together, defined in SDL_threadpool.c */
+struct SDL_TaskGroup;
+typedef struct SDL_TaskGroup SDL_TaskGroup;
+
+typedef void (SDLCALL *SDL_TaskFunction)(void *data);
+typedef void (SDLCALL *SDL_RangeFunction)(void *data, int start, int end);
+
+/**
+ * Get the number of threads that run tasks, counting the thread that
+ * waits for them.  The pool is started on first use with one thread per
+ * CPU, or as many as the SDL_THREADPOOL_THREADS environment variable
+ * says, and stopped by SDL_Quit().
+ */
+extern DECLSPEC int SDLCALL SDL_GetThreadPoolSize(void);
+
+/** Create a task group, or return NULL on error */
+extern DECLSPEC SDL_TaskGroup * SDLCALL SDL_CreateTaskGroup(void);
+
+/**
+ * Queue a task on the thread pool.  If 'group' isn't NULL, the task is
+ * added to it and SDL_WaitTaskGroup() won't return until it's done.
+ * Tasks queued by a pool thread go to that thread first, the others
+ * take them when they run out of work.  If the pool has no threads,
+ * the task runs before this function returns.
+ *
+ * @return 0 on success, -1 on error
+ */
+extern DECLSPEC int SDLCALL SDL_AddTask(SDL_TaskGroup *group, SDL_TaskFunction func, void *data);
+
+/**
+ * Wait for all tasks in a group to finish.  The calling thread runs
+ * queued tasks while it waits, so this may be called from a task.
+ */
+extern DECLSPEC void SDLCALL SDL_WaitTaskGroup(SDL_TaskGroup *group);
+
+/** Destroy a task group, after waiting for it */
+extern DECLSPEC void SDLCALL SDL_DestroyTaskGroup(SDL_TaskGroup *group);
+
+/**
+ * Call 'func' on ranges covering start to end (exclusive) from the pool
+ * threads and the calling thread, and return when all are done.  The
+ * ranges are 'grain' long except the last one, a grain of 0 or less
+ * picks a size that gives each thread a few ranges.
+ */
+extern DECLSPEC void SDLCALL SDL_ParallelFor(int start, int end, int grain, SDL_RangeFunction func, void *data);
+
 
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
@@ -51,6 +51,25 @@ extern DECLSPEC Uint32 SDLCALL SDL_GetTicks(void);
 /** Wait a specified number of milliseconds before returning */
 extern DECLSPEC void SDLCALL SDL_Delay(Uint32 ms);
 
+#ifdef SDL_HAS_64BIT_TYPE
+/**
+ * Get the current value of the high resolution counter, for measuring
+ * short intervals.  The counter doesn't wrap, and its starting value
+ * is arbitrary.
+ */
+extern DECLSPEC Uint64 SDLCALL SDL_GetPerformanceCounter(void);
+
+/** Get the number of high resolution counter ticks per second */
+extern DECLSPEC Uint64 SDLCALL SDL_GetPerformanceFrequency(void);
+
+/**
+ * Wait a specified number of nanoseconds before returning, more
+ * precisely than SDL_Delay().  This sleeps for most of the time and
+ * spins for the last millisecond, so it is meant for frame pacing.
+ */
+extern DECLSPEC void SDLCALL SDL_DelayPrecise(Uint64 ns);
+#endif /* SDL_HAS_64BIT_TYPE */
+
 /** Function prototype for the timer callback function */
 typedef Uint32 (SDLCALL *SDL_TimerCallback)(Uint32 interval);
 
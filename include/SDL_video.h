@@ -408,6 +408,42 @@ extern DECLSPEC void SDLCALL SDL_UpdateRects
  */
 extern DECLSPEC void SDLCALL SDL_UpdateRect
 		(SDL_Surface *screen, Sint32 x, Sint32 y, Uint32 w, Uint32 h);
+
+/**
+ * Start (enable > 0) or stop (enable == 0) keeping track of the areas of
+ * the display surface changed by SDL_BlitSurface(), SDL_BlitSurfaceRects(),
+ * SDL_FillRect() and SDL_FillRects().  While tracking, SDL_UpdateRects()
+ * updates the tracked areas along with the given rectangles, and
+ * SDL_Flip() forgets them.  Overlapping and nearby areas are merged when
+ * one bigger update is cheaper than several small ones, the per-rectangle
+ * cost in pixels can be set with the SDL_DIRTYRECT_COST environment variable.
+ * Changes made by writing to the pixels directly must be added with
+ * SDL_AddDirtyRects().  Setting a new video mode stops tracking.
+ *
+ * Returns 1 if tracking was on before the call, 0 if it was off, or -1
+ * if 'screen' isn't the display surface.  Pass -1 to only query it.
+ */
+extern DECLSPEC int SDLCALL SDL_TrackDirtyRects(SDL_Surface *screen, int enable);
+
+/**
+ * Add rectangles to the areas of the screen that need updating, without
+ * updating them yet.
+ */
+extern DECLSPEC void SDLCALL SDL_AddDirtyRects
+		(SDL_Surface *screen, int numrects, const SDL_Rect *rects);
+
+/**
+ * Update the areas of the screen that need updating, and forget them.
+ */
+extern DECLSPEC void SDLCALL SDL_UpdateDirtyRects(SDL_Surface *screen);
+
+/**
+ * Reports how many rectangles were added to the dirty areas, how many
+ * were updated after merging, and how many pixels those covered, since
+ * the last call.  Any of the pointers may be NULL.
+ */
+extern DECLSPEC void SDLCALL SDL_GetDirtyRectStats
+		(Uint32 *rectsin, Uint32 *rectsout, Uint32 *pixels);
 /*@}*/
 
 /**
@@ -764,6 +800,33 @@ extern DECLSPEC int SDLCALL SDL_LowerBlit
 			(SDL_Surface *src, SDL_Rect *srcrect,
 			 SDL_Surface *dst, SDL_Rect *dstrect);
 
+/** Blits 'numrects' rectangles from one surface to another, the same as
+ *  calling SDL_BlitSurface() with srcrects[i] and dstrects[i] for each,
+ *  but the surfaces are checked and locked only once.  If 'srcrects' is
+ *  NULL the whole source is blitted each time.  Each destination rect
+ *  is updated with the clipped area, as with SDL_BlitSurface().
+ *
+ *  With SDL_BLIT_SORTROWS in 'flags' the rects are blitted from the top
+ *  of the destination down, which can be faster for many small blits
+ *  spread over a large surface.  Blits starting on the same row keep
+ *  their order, but use it only if overlapping blits can be reordered.
+ *
+ *  @return 0 if all blits succeeded, or a negative error code as for
+ *  SDL_BlitSurface().
+ */
+#define SDL_BLIT_SORTROWS	0x00000001
+extern DECLSPEC int SDLCALL SDL_BlitSurfaceRects
+			(SDL_Surface *src, SDL_Rect *srcrects,
+			 SDL_Surface *dst, SDL_Rect *dstrects,
+			 int numrects, Uint32 flags);
+
+/** Reports how many times a blit mapping between two surfaces had to be
+ *  built, and how many times one was reused because the source surface
+ *  remembered it from a recent destination, since the last call.  Call it
+ *  once a frame to see the rebuilds per frame.  Either pointer may be NULL.
+ */
+extern DECLSPEC void SDLCALL SDL_GetBlitMapStats(Uint32 *rebuilds, Uint32 *reused);
+
 /**
  * This function performs a fast fill of the given rectangle with 'color'
  * The given rectangle is clipped to the destination surface clip area
@@ -776,6 +839,15 @@ extern DECLSPEC int SDLCALL SDL_LowerBlit
 extern DECLSPEC int SDLCALL SDL_FillRect
 		(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color);
 
+/**
+ * Fills 'numrects' rectangles with 'color', the same as calling
+ * SDL_FillRect() for each of them, but the surface is locked only once.
+ * The rectangles are clipped to the clip area but not changed.
+ * This function returns 0 on success, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_FillRects
+		(SDL_Surface *dst, const SDL_Rect *rects, int numrects, Uint32 color);
+
 /**
  * This function takes a surface and copies it to a new surface of the
  * pixel format and colors of the video framebuffer, suitable for fast
@@ -950,6 +1022,26 @@ extern DECLSPEC SDL_GrabMode SDLCALL SDL_WM_GrabInput(SDL_GrabMode mode);
 /** @internal Not in public API at the moment - do not use! */
 extern DECLSPEC int SDLCALL SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
                                     SDL_Surface *dst, SDL_Rect *dstrect);
+
+/** Filters for SDL_SoftStretchFiltered() */
+typedef enum {
+	SDL_STRETCH_NEAREST,	/**< Nearest pixel, same as SDL_SoftStretch() */
+	SDL_STRETCH_BILINEAR,	/**< Blend of the four nearest pixels */
+	SDL_STRETCH_BOX		/**< Average of the covered area, for shrinking */
+} SDL_StretchFilter;
+
+/**
+ * Performs a filtered stretch blit between two different surfaces of the
+ * same format.  The filtered modes work on 16-bit surfaces and on 32-bit
+ * surfaces with one byte per channel; the source alpha is filtered like
+ * the other channels and copied, not blended.
+ * Large stretches are split into the bands set by SDL_BLIT_THREADS.
+ *
+ * @return 0 on success, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_SoftStretchFiltered(SDL_Surface *src,
+			SDL_Rect *srcrect, SDL_Surface *dst, SDL_Rect *dstrect,
+			SDL_StretchFilter filter);
                     
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
@@ -53,6 +53,9 @@ typedef struct SDL_error {
 		double value_f;
 		char buf[ERR_MAX_STRLEN];
 	} args[ERR_MAX_ARGS];
+
+	/* This is the formatted message returned by SDL_GetError() */
+	char msg[1024];
 } SDL_error;
 
 #endif /* _SDL_error_c_h */
@@ -0,0 +1,228 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Atomic operations and spin locks */
+
+#include "SDL_atomic.h"
+#include "SDL_mutex.h"
+#include "SDL_timer.h"
+
+#if defined(__GNUC__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+#define SDL_ATOMIC_GCC	1
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8) || \
+    (defined(__SIZEOF_POINTER__) && (__SIZEOF_POINTER__ == 4))
+#define SDL_ATOMIC_GCC_PTR	1
+#endif
+#elif defined(__WIN32__)
+#define SDL_ATOMIC_WIN32	1
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+/* Without atomic instructions everything goes through one lock */
+#if SDL_ATOMIC_GCC_PTR || SDL_ATOMIC_WIN32
+#define SDL_LockAtomics()
+#define SDL_UnlockAtomics()
+#elif SDL_THREAD_PTHREAD
+#include <pthread.h>
+static pthread_mutex_t SDL_atomic_lock = PTHREAD_MUTEX_INITIALIZER;
+#define SDL_LockAtomics()	pthread_mutex_lock(&SDL_atomic_lock)
+#define SDL_UnlockAtomics()	pthread_mutex_unlock(&SDL_atomic_lock)
+#elif SDL_THREADS_DISABLED
+#define SDL_LockAtomics()
+#define SDL_UnlockAtomics()
+#else
+/* The lock is created on first use, which SDL_Init() does before any
+   threads are started */
+static SDL_mutex *SDL_atomic_lock = NULL;
+static void SDL_LockAtomics(void)
+{
+	if ( SDL_atomic_lock == NULL ) {
+		SDL_atomic_lock = SDL_CreateMutex();
+	}
+	SDL_mutexP(SDL_atomic_lock);
+}
+#define SDL_UnlockAtomics()	SDL_mutexV(SDL_atomic_lock)
+#endif
+
+/* Loads on x86 aren't reordered with other loads or with later stores */
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define SDL_AcquireBarrier()	SDL_CompilerBarrier()
+#else
+#define SDL_AcquireBarrier()	SDL_MemoryBarrier()
+#endif
+
+/* Tell the CPU we're spinning */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define SDL_CPUPause()	__asm__ __volatile__ ("pause")
+#elif SDL_ATOMIC_WIN32 && defined(YieldProcessor)
+#define SDL_CPUPause()	YieldProcessor()
+#else
+#define SDL_CPUPause()
+#endif
+
+#define SPIN_COUNT	32
+
+#undef SDL_MemoryBarrier
+void SDL_MemoryBarrier(void)
+{
+#if SDL_ATOMIC_GCC
+	__sync_synchronize();
+#elif SDL_ATOMIC_WIN32
+	LONG barrier = 0;
+	InterlockedExchange(&barrier, 0);
+#else
+	SDL_LockAtomics();
+	SDL_UnlockAtomics();
+#endif
+}
+
+SDL_bool SDL_AtomicCAS(SDL_atomic_t *a, int oldval, int newval)
+{
+#if SDL_ATOMIC_GCC
+	return (SDL_bool)__sync_bool_compare_and_swap(&a->value, oldval, newval);
+#elif SDL_ATOMIC_WIN32
+	return (SDL_bool)(InterlockedCompareExchange((LONG *)&a->value, (LONG)newval, (LONG)oldval) == (LONG)oldval);
+#else
+	SDL_bool retval = SDL_FALSE;
+
+	SDL_LockAtomics();
+	if ( a->value == oldval ) {
+		a->value = newval;
+		retval = SDL_TRUE;
+	}
+	SDL_UnlockAtomics();
+	return(retval);
+#endif
+}
+
+int SDL_AtomicSet(SDL_atomic_t *a, int value)
+{
+	int old;
+
+	do {
+		old = a->value;
+	} while ( ! SDL_AtomicCAS(a, old, value) );
+	return(old);
+}
+
+int SDL_AtomicGet(SDL_atomic_t *a)
+{
+	int value = a->value;
+	SDL_AcquireBarrier();
+	return(value);
+}
+
+int SDL_AtomicAdd(SDL_atomic_t *a, int value)
+{
+#if SDL_ATOMIC_GCC
+	return __sync_fetch_and_add(&a->value, value);
+#elif SDL_ATOMIC_WIN32
+	return (int)InterlockedExchangeAdd((LONG *)&a->value, (LONG)value);
+#else
+	int old;
+
+	SDL_LockAtomics();
+	old = a->value;
+	a->value = old + value;
+	SDL_UnlockAtomics();
+	return(old);
+#endif
+}
+
+SDL_bool SDL_AtomicCASPtr(void **a, void *oldval, void *newval)
+{
+#if SDL_ATOMIC_GCC_PTR
+	return (SDL_bool)__sync_bool_compare_and_swap(a, oldval, newval);
+#elif SDL_ATOMIC_WIN32 && defined(_WIN64)
+	return (SDL_bool)(InterlockedCompareExchangePointer(a, newval, oldval) == oldval);
+#elif SDL_ATOMIC_WIN32
+	return (SDL_bool)(InterlockedCompareExchange((LONG *)a, (LONG)newval, (LONG)oldval) == (LONG)oldval);
+#else
+	SDL_bool retval = SDL_FALSE;
+
+	SDL_LockAtomics();
+	if ( *a == oldval ) {
+		*a = newval;
+		retval = SDL_TRUE;
+	}
+	SDL_UnlockAtomics();
+	return(retval);
+#endif
+}
+
+void *SDL_AtomicSetPtr(void **a, void *value)
+{
+	void *old;
+
+	do {
+		old = *(void * volatile *)a;
+	} while ( ! SDL_AtomicCASPtr(a, old, value) );
+	return(old);
+}
+
+void *SDL_AtomicGetPtr(void **a)
+{
+	void *value = *(void * volatile *)a;
+	SDL_AcquireBarrier();
+	return(value);
+}
+
+SDL_bool SDL_AtomicTryLock(SDL_SpinLock *lock)
+{
+#if SDL_ATOMIC_GCC
+	return (SDL_bool)(__sync_lock_test_and_set(lock, 1) == 0);
+#elif SDL_ATOMIC_WIN32
+	return (SDL_bool)(InterlockedExchange((LONG *)lock, 1) == 0);
+#else
+	return SDL_AtomicCAS((SDL_atomic_t *)lock, 0, 1);
+#endif
+}
+
+void SDL_AtomicLock(SDL_SpinLock *lock)
+{
+	int spins = 0;
+
+	while ( ! SDL_AtomicTryLock(lock) ) {
+		/* Wait until it looks free without hammering the cache line */
+		do {
+			if ( spins < SPIN_COUNT ) {
+				++spins;
+				SDL_CPUPause();
+			} else {
+				SDL_Delay(0);
+			}
+		} while ( *(volatile SDL_SpinLock *)lock );
+	}
+}
+
+void SDL_AtomicUnlock(SDL_SpinLock *lock)
+{
+#if SDL_ATOMIC_GCC
+	__sync_lock_release(lock);
+#elif SDL_ATOMIC_WIN32
+	InterlockedExchange((LONG *)lock, 0);
+#else
+	SDL_AtomicSet((SDL_atomic_t *)lock, 0);
+#endif
+}
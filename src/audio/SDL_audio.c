@@ -124,14 +124,90 @@ SDL_AudioDevice *current_audio = NULL;
 int SDL_AudioInit(const char *driver_name);
 void SDL_AudioQuit(void);
 
+/* The callback used when the application feeds the audio with
+   SDL_QueueAudio().  It runs in the audio thread, the only consumer
+   of the ring buffer, and leaves the buffer silent on underrun.
+ */
+static void SDLCALL SDL_DequeueAudio(void *userdata, Uint8 *stream, int len)
+{
+	SDL_AudioDevice *audio = (SDL_AudioDevice *)userdata;
+	Uint32 tail, avail, pos, chunk;
+
+	/* The data isn't read before the head that covers it */
+	tail = (Uint32)SDL_AtomicGet(&audio->queue_tail);
+	avail = (Uint32)SDL_AtomicGet(&audio->queue_head) - tail;
+
+	if ( avail > (Uint32)len ) {
+		avail = len - (len % audio->queue_frame);
+	}
+	if ( avail == 0 ) {
+		return;
+	}
+	pos = tail & (audio->queue_size - 1);
+	chunk = audio->queue_size - pos;
+	if ( chunk > avail ) {
+		chunk = avail;
+	}
+	SDL_memcpy(stream, audio->queue + pos, chunk);
+	SDL_memcpy(stream + chunk, audio->queue, avail - chunk);
+
+	/* Finish reading before the space is handed back */
+	SDL_AtomicSet(&audio->queue_tail, (int)(tail + avail));
+}
+
+int SDL_QueueAudio(const void *data, Uint32 len)
+{
+	SDL_AudioDevice *audio = current_audio;
+	Uint32 head, room, pos, chunk;
+
+	if ( audio == NULL || audio->queue == NULL ) {
+		SDL_SetError("Audio device isn't open for queueing");
+		return(-1);
+	}
+	/* Don't overwrite space the audio thread may still be reading */
+	head = (Uint32)SDL_AtomicGet(&audio->queue_head);
+	room = audio->queue_size -
+	       (head - (Uint32)SDL_AtomicGet(&audio->queue_tail));
+
+	if ( len > room ) {
+		len = room;
+	}
+	len -= len % audio->queue_frame;
+	pos = head & (audio->queue_size - 1);
+	chunk = audio->queue_size - pos;
+	if ( chunk > len ) {
+		chunk = len;
+	}
+	SDL_memcpy(audio->queue + pos, data, chunk);
+	SDL_memcpy(audio->queue, (const Uint8 *)data + chunk, len - chunk);
+
+	/* Publish the data before the head that covers it */
+	SDL_AtomicSet(&audio->queue_head, (int)(head + len));
+	return((int)len);
+}
+
+Uint32 SDL_GetQueuedAudioSize(void)
+{
+	SDL_AudioDevice *audio = current_audio;
+	Uint32 tail;
+
+	if ( audio == NULL || audio->queue == NULL ) {
+		return(0);
+	}
+	tail = (Uint32)SDL_AtomicGet(&audio->queue_tail);
+	return((Uint32)SDL_AtomicGet(&audio->queue_head) - tail);
+}
+
 /* The general mixing thread function */
 int SDLCALL SDL_RunAudio(void *audiop)
 {
 	SDL_AudioDevice *audio = (SDL_AudioDevice *)audiop;
 	Uint8 *stream;
 	int    stream_len;
+	int    got;
 	void  *udata;
 	void (SDLCALL *fill)(void *userdata,Uint8 *stream, int len);
+	SDL_mutex *lock;
 	int    silence;
 
 	/* Perform any thread setup */
@@ -144,13 +220,24 @@ int SDLCALL SDL_RunAudio(void *audiop)
 	fill  = audio->spec.callback;
 	udata = audio->spec.userdata;
 
+	/* The queue is lock-free, only a real callback needs the lock.
+	   Where the atomics are emulated they take a lock of their own. */
+	lock = audio->mixer_lock;
+	if ( audio->queue ) {
+		lock = NULL;
+	}
+
 	if ( audio->convert.needed ) {
 		if ( audio->convert.src_format == AUDIO_U8 ) {
 			silence = 0x80;
 		} else {
 			silence = 0;
 		}
-		stream_len = audio->convert.len;
+		if ( audio->stream ) {
+			stream_len = audio->convert.len;
+		} else {
+			stream_len = audio->spec.size;
+		}
 	} else {
 		silence = audio->spec.silence;
 		stream_len = audio->spec.size;
@@ -178,39 +265,64 @@ int SDLCALL SDL_RunAudio(void *audiop)
 #endif
 
 	/* Loop, filling the audio buffers */
-	while ( audio->enabled ) {
-
-		/* Fill the current buffer with sound */
-		if ( audio->convert.needed ) {
-			if ( audio->convert.buf ) {
-				stream = audio->convert.buf;
-			} else {
-				continue;
+	while ( SDL_AtomicGet(&audio->enabled) ) {
+
+		if ( audio->stream ) {
+			/* Mix and convert until there's a full buffer */
+			while ( SDL_AudioStreamAvailable(audio->stream) <
+			        audio->spec.size ) {
+				SDL_memset(audio->convert.buf, silence, stream_len);
+				if ( ! SDL_AtomicGet(&audio->paused) ) {
+					if ( lock ) {
+						SDL_mutexP(lock);
+					}
+					(*fill)(udata, audio->convert.buf, stream_len);
+					if ( lock ) {
+						SDL_mutexV(lock);
+					}
+				}
+				if ( SDL_AudioStreamPut(audio->stream,
+				          audio->convert.buf, stream_len) < 0 ) {
+					break;
+				}
+			}
+			stream = audio->GetAudioBuf(audio);
+			if ( stream == NULL ) {
+				stream = audio->fake_stream;
+			}
+			got = SDL_AudioStreamGet(audio->stream, stream,
+			                         audio->spec.size);
+			if ( got < audio->spec.size ) {
+				SDL_memset(stream + got, audio->spec.silence,
+				           audio->spec.size - got);
 			}
 		} else {
+			/* Mix straight into the device buffer */
 			stream = audio->GetAudioBuf(audio);
 			if ( stream == NULL ) {
 				stream = audio->fake_stream;
 			}
-		}
 
-		SDL_memset(stream, silence, stream_len);
+			SDL_memset(stream, silence, stream_len);
 
-		if ( ! audio->paused ) {
-			SDL_mutexP(audio->mixer_lock);
-			(*fill)(udata, stream, stream_len);
-			SDL_mutexV(audio->mixer_lock);
-		}
+			if ( ! SDL_AtomicGet(&audio->paused) ) {
+				if ( lock ) {
+					SDL_mutexP(lock);
+				}
+				(*fill)(udata, stream, stream_len);
+				if ( lock ) {
+					SDL_mutexV(lock);
+				}
+			}
 
-		/* Convert the audio if necessary */
-		if ( audio->convert.needed ) {
-			SDL_ConvertAudio(&audio->convert);
-			stream = audio->GetAudioBuf(audio);
-			if ( stream == NULL ) {
-				stream = audio->fake_stream;
+			/* Convert the audio in place if necessary */
+			if ( audio->convert.needed ) {
+				SDL_AudioCVT convert = audio->convert;
+
+				convert.buf = stream;
+				convert.len = stream_len;
+				SDL_ConvertAudio(&convert);
 			}
-			SDL_memcpy(stream, audio->convert.buf,
-			               audio->convert.len_cvt);
 		}
 
 		/* Ready current buffer for play and change current buffer */
@@ -268,6 +380,10 @@ static Uint16 SDL_ParseAudioFormat(const char *string)
 		++string;
 		format |= 0x8000;
 		break;
+	    case 'F':
+		++string;
+		format |= 0x8100;
+		break;
 	    default:
 		return 0;
 	}
@@ -277,8 +393,9 @@ static Uint16 SDL_ParseAudioFormat(const char *string)
 		format |= 8;
 		break;
 	    case 16:
+	    case 32:
+		format |= SDL_atoi(string);
 		string += 2;
-		format |= 16;
 		if ( SDL_strcmp(string, "LSB") == 0
 #if SDL_BYTEORDER == SDL_LIL_ENDIAN
 		     || SDL_strcmp(string, "SYS") == 0
@@ -297,6 +414,11 @@ static Uint16 SDL_ParseAudioFormat(const char *string)
 	    default:
 		return 0;
 	}
+	/* There are no unsigned 32-bit samples, and floats are 32-bit */
+	if ( (format & 0x80FF) == 0x0020 ||
+	     ((format & 0x0100) && (format & 0xFF) != 32) ) {
+		return 0;
+	}
 	return format;
 }
 
@@ -472,11 +594,6 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 		}
 		desired->samples = power2;
 	}
-	if ( desired->callback == NULL ) {
-		SDL_SetError("SDL_OpenAudio() passed a NULL callback");
-		return(-1);
-	}
-
 #if SDL_THREADS_DISABLED
 	/* Uses interrupt driven audio, without thread */
 #else
@@ -492,11 +609,43 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 	/* Calculate the silence and size of the audio specification */
 	SDL_CalculateAudioSpec(desired);
 
-	/* Open the audio subsystem */
+	/* Without a callback the application queues the audio, give it
+	   at least a second of room, and four buffers at small rates */
+	if ( desired->callback == NULL ) {
+		Uint32 size = 1;
+
+		audio->queue_frame = ((desired->format & 0xFF) / 8) *
+		                     desired->channels;
+		while ( size < (Uint32)desired->freq * audio->queue_frame ||
+		        size < 4 * desired->size ) {
+			size *= 2;
+		}
+		audio->queue = (Uint8 *)SDL_malloc(size);
+		if ( audio->queue == NULL ) {
+			SDL_CloseAudio();
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		audio->queue_size = size;
+		SDL_AtomicSet(&audio->queue_head, 0);
+		SDL_AtomicSet(&audio->queue_tail, 0);
+	}
+
+	/* Open the audio subsystem, drivers that don't know the 32-bit
+	   formats get 16-bit samples and SDL converts */
 	SDL_memcpy(&audio->spec, desired, sizeof(audio->spec));
+	if ( (audio->spec.format & 0xFF) == 32 && !audio->wide_formats ) {
+		audio->spec.format = AUDIO_S16SYS;
+		SDL_CalculateAudioSpec(&audio->spec);
+	}
+	if ( audio->queue ) {
+		audio->spec.callback = SDL_DequeueAudio;
+		audio->spec.userdata = audio;
+	}
 	audio->convert.needed = 0;
-	audio->enabled = 1;
-	audio->paused  = 1;
+	audio->stream = NULL;
+	SDL_AtomicSet(&audio->enabled, 1);
+	SDL_AtomicSet(&audio->paused, 1);
 
 	audio->opened = audio->OpenAudio(audio, &audio->spec)+1;
 
@@ -522,6 +671,8 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 	/* See if we need to do any conversion */
 	if ( obtained != NULL ) {
 		SDL_memcpy(obtained, &audio->spec, sizeof(audio->spec));
+		obtained->callback = desired->callback;
+		obtained->userdata = desired->userdata;
 	} else if ( desired->freq != audio->spec.freq ||
                     desired->format != audio->spec.format ||
 	            desired->channels != audio->spec.channels ) {
@@ -545,6 +696,24 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 				return(-1);
 			}
 		}
+		/* Conversions that change the size go through a stream in
+		   SDL_RunAudio(), so each buffer is filled exactly and the
+		   rate conversion carries over between buffers.  The rest
+		   are done in place in the device buffer. */
+		if ( audio->convert.needed &&
+		     (audio->convert.len_mult != 1 ||
+		      audio->convert.len_ratio != 1.0) ) {
+			audio->stream = SDL_NewAudioStream(
+				desired->format, desired->channels,
+				desired->freq, audio->spec.format,
+				audio->spec.channels, audio->spec.freq);
+			if ( audio->stream == NULL ) {
+				SDL_CloseAudio();
+				return(-1);
+			}
+			audio->convert.len -= audio->convert.len %
+			        (((desired->format & 0xFF) / 8) * desired->channels);
+		}
 	}
 
 	/* Start the audio thread if necessary */
@@ -578,8 +747,8 @@ SDL_audiostatus SDL_GetAudioStatus(void)
 	SDL_audiostatus status;
 
 	status = SDL_AUDIO_STOPPED;
-	if ( audio && audio->enabled ) {
-		if ( audio->paused ) {
+	if ( audio && SDL_AtomicGet(&audio->enabled) ) {
+		if ( SDL_AtomicGet(&audio->paused) ) {
 			status = SDL_AUDIO_PAUSED;
 		} else {
 			status = SDL_AUDIO_PLAYING;
@@ -593,7 +762,7 @@ void SDL_PauseAudio (int pause_on)
 	SDL_AudioDevice *audio = current_audio;
 
 	if ( audio ) {
-		audio->paused = pause_on;
+		SDL_AtomicSet(&audio->paused, pause_on);
 	}
 }
 
@@ -627,7 +796,7 @@ void SDL_AudioQuit(void)
 	SDL_AudioDevice *audio = current_audio;
 
 	if ( audio ) {
-		audio->enabled = 0;
+		SDL_AtomicSet(&audio->enabled, 0);
 		if ( audio->thread != NULL ) {
 			SDL_WaitThread(audio->thread, NULL);
 		}
@@ -641,6 +810,12 @@ void SDL_AudioQuit(void)
 			SDL_FreeAudioMem(audio->convert.buf);
 
 		}
+		if ( audio->stream ) {
+			SDL_FreeAudioStream(audio->stream);
+		}
+		if ( audio->queue ) {
+			SDL_free(audio->queue);
+		}
 		if ( audio->opened ) {
 			audio->CloseAudio(audio);
 			audio->opened = 0;
@@ -651,16 +826,30 @@ void SDL_AudioQuit(void)
 	}
 }
 
-#define NUM_FORMATS	6
+#define NUM_FORMATS	10
 static int format_idx;
 static int format_idx_sub;
 static Uint16 format_list[NUM_FORMATS][NUM_FORMATS] = {
- { AUDIO_U8, AUDIO_S8, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB },
- { AUDIO_S8, AUDIO_U8, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB },
- { AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_U8, AUDIO_S8 },
- { AUDIO_S16MSB, AUDIO_S16LSB, AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_U8, AUDIO_S8 },
- { AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U8, AUDIO_S8 },
- { AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_S16MSB, AUDIO_S16LSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_U8, AUDIO_S8, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB,
+   AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB },
+ { AUDIO_S8, AUDIO_U8, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB,
+   AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB },
+ { AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_S32LSB,
+   AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_S16MSB, AUDIO_S16LSB, AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_S32MSB,
+   AUDIO_S32LSB, AUDIO_F32MSB, AUDIO_F32LSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_S32LSB,
+   AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_S16MSB, AUDIO_S16LSB, AUDIO_S32MSB,
+   AUDIO_S32LSB, AUDIO_F32MSB, AUDIO_F32LSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB, AUDIO_S16LSB,
+   AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_S32MSB, AUDIO_S32LSB, AUDIO_F32MSB, AUDIO_F32LSB, AUDIO_S16MSB,
+   AUDIO_S16LSB, AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_F32LSB, AUDIO_F32MSB, AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_S16LSB,
+   AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_F32MSB, AUDIO_F32LSB, AUDIO_S32MSB, AUDIO_S32LSB, AUDIO_S16MSB,
+   AUDIO_S16LSB, AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_U8, AUDIO_S8 },
 };
 
 Uint16 SDL_FirstAudioFormat(Uint16 format)
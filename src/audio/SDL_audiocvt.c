@@ -24,6 +24,100 @@
 /* Functions for audio drivers to perform runtime conversion of audio format */
 
 #include "SDL_audio.h"
+#include "SDL_atomic.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_thread.h"
+#include "../cpuinfo/SDL_simd.h"
+
+#ifdef HAVE_MATH_H
+#include <math.h>	/* Used for the resampler filter tables */
+#endif
+
+/* Channel conversions for 32-bit samples.
+
+   The filter chain only carries 32-bit audio as AUDIO_S32SYS or
+   AUDIO_F32SYS, SDL_BuildAudioCVT() swaps or converts the ends, so these
+   work on native integers and floats.
+*/
+static void SDL_ConvertChannels32(SDL_AudioCVT *cvt, Uint16 format,
+                                  int in, int out)
+{
+	const int frames = cvt->len_cvt / (in * 4);
+	int i;
+
+	if ( out < in ) {
+		if ( out == 1 ) {
+			/* Average the two channels */
+			if ( format & 0x0100 ) {
+				float *buf = (float *)cvt->buf;
+
+				for ( i = 0; i < frames; ++i ) {
+					buf[i] = (buf[i*2] + buf[i*2+1]) * 0.5f;
+				}
+			} else {
+				Sint32 *buf = (Sint32 *)cvt->buf;
+
+				for ( i = 0; i < frames; ++i ) {
+					Sint32 l = buf[i*2], r = buf[i*2+1];
+					buf[i] = (l >> 1) + (r >> 1) + (l & r & 1);
+				}
+			}
+		} else {
+			/* Keep the first channels of each frame */
+			Uint32 *buf = (Uint32 *)cvt->buf;
+			int j;
+
+			for ( i = 0; i < frames; ++i ) {
+				for ( j = 0; j < out; ++j ) {
+					buf[i*out+j] = buf[i*in+j];
+				}
+			}
+		}
+	} else if ( in == 1 ) {
+		/* Duplicate a mono channel, from the end to work in place */
+		Uint32 *buf = (Uint32 *)cvt->buf;
+
+		for ( i = frames; i--; ) {
+			buf[i*2+1] = buf[i*2] = buf[i];
+		}
+	} else {
+		/* Stereo to quad or 5.1: the rears get the sides without the
+		   centre, the centre and subwoofer get the centre */
+		for ( i = frames; i--; ) {
+			if ( format & 0x0100 ) {
+				float *buf = (float *)cvt->buf;
+				float lf = buf[i*2], rf = buf[i*2+1];
+				float ce = lf * 0.5f + rf * 0.5f;
+
+				buf[i*out] = lf;
+				buf[i*out+1] = rf;
+				buf[i*out+2] = lf - ce;
+				buf[i*out+3] = rf - ce;
+				if ( out == 6 ) {
+					buf[i*out+4] = ce;
+					buf[i*out+5] = ce;
+				}
+			} else {
+				Sint32 *buf = (Sint32 *)cvt->buf;
+				Sint32 lf = buf[i*2], rf = buf[i*2+1];
+				Sint32 ce = (lf / 2) + (rf / 2);
+
+				buf[i*out] = lf;
+				buf[i*out+1] = rf;
+				buf[i*out+2] = lf - ce;
+				buf[i*out+3] = rf - ce;
+				if ( out == 6 ) {
+					buf[i*out+4] = ce;
+					buf[i*out+5] = ce;
+				}
+			}
+		}
+	}
+	cvt->len_cvt = frames * out * 4;
+	if ( cvt->filters[++cvt->filter_index] ) {
+		cvt->filters[cvt->filter_index](cvt, format);
+	}
+}
 
 
 /* Effectively mix right and left channels into a single channel */
@@ -35,6 +129,10 @@ void SDLCALL SDL_ConvertMono(SDL_AudioCVT *cvt, Uint16 format)
 #ifdef DEBUG_CONVERT
 	fprintf(stderr, "Converting to mono\n");
 #endif
+	if ( (format & 0xFF) == 32 ) {
+		SDL_ConvertChannels32(cvt, format, 2, 1);
+		return;
+	}
 	switch (format&0x8018) {
 
 		case AUDIO_U8: {
@@ -142,6 +240,10 @@ void SDLCALL SDL_ConvertStrip(SDL_AudioCVT *cvt, Uint16 format)
 #ifdef DEBUG_CONVERT
 	fprintf(stderr, "Converting down to stereo\n");
 #endif
+	if ( (format & 0xFF) == 32 ) {
+		SDL_ConvertChannels32(cvt, format, 6, 2);
+		return;
+	}
 	switch (format&0x8018) {
 
 		case AUDIO_U8: {
@@ -252,113 +354,25 @@ void SDLCALL SDL_ConvertStrip(SDL_AudioCVT *cvt, Uint16 format)
 /* Discard top 2 channels of 6 */
 void SDLCALL SDL_ConvertStrip_2(SDL_AudioCVT *cvt, Uint16 format)
 {
+	const int width = (format & 0xFF) / 8;
+	Uint8 *src, *dst;
 	int i;
-	Sint32 lsample, rsample;
 
 #ifdef DEBUG_CONVERT
 	fprintf(stderr, "Converting 6 down to quad\n");
 #endif
-	switch (format&0x8018) {
-
-		case AUDIO_U8: {
-			Uint8 *src, *dst;
-
-			src = cvt->buf;
-			dst = cvt->buf;
-			for ( i=cvt->len_cvt/4; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				src += 4;
-				dst += 2;
-			}
-		}
-		break;
-
-		case AUDIO_S8: {
-			Sint8 *src, *dst;
-
-			src = (Sint8 *)cvt->buf;
-			dst = (Sint8 *)cvt->buf;
-			for ( i=cvt->len_cvt/4; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				src += 4;
-				dst += 2;
-			}
-		}
-		break;
-
-		case AUDIO_U16: {
-			Uint8 *src, *dst;
-
-			src = cvt->buf;
-			dst = cvt->buf;
-			if ( (format & 0x1000) == 0x1000 ) {
-				for ( i=cvt->len_cvt/8; i; --i ) {
-					lsample = (Uint16)((src[0]<<8)|src[1]);
-					rsample = (Uint16)((src[2]<<8)|src[3]);
-						dst[1] = (lsample&0xFF);
-						lsample >>= 8;
-						dst[0] = (lsample&0xFF);
-						dst[3] = (rsample&0xFF);
-						rsample >>= 8;
-						dst[2] = (rsample&0xFF);
-					src += 8;
-					dst += 4;
-				}
-			} else {
-				for ( i=cvt->len_cvt/8; i; --i ) {
-					lsample = (Uint16)((src[1]<<8)|src[0]);
-					rsample = (Uint16)((src[3]<<8)|src[2]);
-						dst[0] = (lsample&0xFF);
-						lsample >>= 8;
-						dst[1] = (lsample&0xFF);
-						dst[2] = (rsample&0xFF);
-						rsample >>= 8;
-						dst[3] = (rsample&0xFF);
-					src += 8;
-					dst += 4;
-				}
-			}
-		}
-		break;
-
-		case AUDIO_S16: {
-			Uint8 *src, *dst;
-
-			src = cvt->buf;
-			dst = cvt->buf;
-			if ( (format & 0x1000) == 0x1000 ) {
-				for ( i=cvt->len_cvt/8; i; --i ) {
-					lsample = (Sint16)((src[0]<<8)|src[1]);
-					rsample = (Sint16)((src[2]<<8)|src[3]);
-						dst[1] = (lsample&0xFF);
-						lsample >>= 8;
-						dst[0] = (lsample&0xFF);
-						dst[3] = (rsample&0xFF);
-						rsample >>= 8;
-						dst[2] = (rsample&0xFF);
-					src += 8;
-					dst += 4;
-				}
-			} else {
-				for ( i=cvt->len_cvt/8; i; --i ) {
-					lsample = (Sint16)((src[1]<<8)|src[0]);
-					rsample = (Sint16)((src[3]<<8)|src[2]);
-						dst[0] = (lsample&0xFF);
-						lsample >>= 8;
-						dst[1] = (lsample&0xFF);
-						dst[2] = (rsample&0xFF);
-						rsample >>= 8;
-						dst[3] = (rsample&0xFF);
-					src += 8;
-					dst += 4;
-				}
-			}
-		}
-		break;
+	if ( (format & 0xFF) == 32 ) {
+		SDL_ConvertChannels32(cvt, format, 6, 4);
+		return;
 	}
-	cvt->len_cvt /= 2;
+	src = cvt->buf;
+	dst = cvt->buf;
+	for ( i=cvt->len_cvt/(6*width); i; --i ) {
+		SDL_memmove(dst, src, 4*width);
+		src += 6*width;
+		dst += 4*width;
+	}
+	cvt->len_cvt = (cvt->len_cvt/(6*width))*(4*width);
 	if ( cvt->filters[++cvt->filter_index] ) {
 		cvt->filters[cvt->filter_index](cvt, format);
 	}
@@ -372,6 +386,10 @@ void SDLCALL SDL_ConvertStereo(SDL_AudioCVT *cvt, Uint16 format)
 #ifdef DEBUG_CONVERT
 	fprintf(stderr, "Converting to stereo\n");
 #endif
+	if ( (format & 0xFF) == 32 ) {
+		SDL_ConvertChannels32(cvt, format, 1, 2);
+		return;
+	}
 	if ( (format & 0xFF) == 16 ) {
 		Uint16 *src, *dst;
 
@@ -410,6 +428,10 @@ void SDLCALL SDL_ConvertSurround(SDL_AudioCVT *cvt, Uint16 format)
 #ifdef DEBUG_CONVERT
 	fprintf(stderr, "Converting stereo to surround\n");
 #endif
+	if ( (format & 0xFF) == 32 ) {
+		SDL_ConvertChannels32(cvt, format, 2, 6);
+		return;
+	}
 	switch (format&0x8018) {
 
 		case AUDIO_U8: {
@@ -417,7 +439,7 @@ void SDLCALL SDL_ConvertSurround(SDL_AudioCVT *cvt, Uint16 format)
 
 			src = (Uint8 *)(cvt->buf+cvt->len_cvt);
 			dst = (Uint8 *)(cvt->buf+cvt->len_cvt*3);
-			for ( i=cvt->len_cvt; i; --i ) {
+			for ( i=cvt->len_cvt/2; i; --i ) {
 				dst -= 6;
 				src -= 2;
 				lf = src[0];
@@ -438,7 +460,7 @@ void SDLCALL SDL_ConvertSurround(SDL_AudioCVT *cvt, Uint16 format)
 
 			src = (Sint8 *)cvt->buf+cvt->len_cvt;
 			dst = (Sint8 *)cvt->buf+cvt->len_cvt*3;
-			for ( i=cvt->len_cvt; i; --i ) {
+			for ( i=cvt->len_cvt/2; i; --i ) {
 				dst -= 6;
 				src -= 2;
 				lf = src[0];
@@ -587,6 +609,10 @@ void SDLCALL SDL_ConvertSurround_4(SDL_AudioCVT *cvt, Uint16 format)
 #ifdef DEBUG_CONVERT
 	fprintf(stderr, "Converting stereo to quad\n");
 #endif
+	if ( (format & 0xFF) == 32 ) {
+		SDL_ConvertChannels32(cvt, format, 2, 4);
+		return;
+	}
 	switch (format&0x8018) {
 
 		case AUDIO_U8: {
@@ -594,7 +620,7 @@ void SDLCALL SDL_ConvertSurround_4(SDL_AudioCVT *cvt, Uint16 format)
 
 			src = (Uint8 *)(cvt->buf+cvt->len_cvt);
 			dst = (Uint8 *)(cvt->buf+cvt->len_cvt*2);
-			for ( i=cvt->len_cvt; i; --i ) {
+			for ( i=cvt->len_cvt/2; i; --i ) {
 				dst -= 4;
 				src -= 2;
 				lf = src[0];
@@ -613,7 +639,7 @@ void SDLCALL SDL_ConvertSurround_4(SDL_AudioCVT *cvt, Uint16 format)
 
 			src = (Sint8 *)cvt->buf+cvt->len_cvt;
 			dst = (Sint8 *)cvt->buf+cvt->len_cvt*2;
-			for ( i=cvt->len_cvt; i; --i ) {
+			for ( i=cvt->len_cvt/2; i; --i ) {
 				dst -= 4;
 				src -= 2;
 				lf = src[0];
@@ -844,11 +870,23 @@ void SDLCALL SDL_ConvertEndian(SDL_AudioCVT *cvt, Uint16 format)
 	fprintf(stderr, "Converting audio endianness\n");
 #endif
 	data = cvt->buf;
-	for ( i=cvt->len_cvt/2; i; --i ) {
-		tmp = data[0];
-		data[0] = data[1];
-		data[1] = tmp;
-		data += 2;
+	if ( (format & 0xFF) == 32 ) {
+		for ( i=cvt->len_cvt/4; i; --i ) {
+			tmp = data[0];
+			data[0] = data[3];
+			data[3] = tmp;
+			tmp = data[1];
+			data[1] = data[2];
+			data[2] = tmp;
+			data += 4;
+		}
+	} else {
+		for ( i=cvt->len_cvt/2; i; --i ) {
+			tmp = data[0];
+			data[0] = data[1];
+			data[1] = tmp;
+			data += 2;
+		}
 	}
 	format = (format ^ 0x1000);
 	if ( cvt->filters[++cvt->filter_index] ) {
@@ -856,450 +894,1040 @@ void SDLCALL SDL_ConvertEndian(SDL_AudioCVT *cvt, Uint16 format)
 	}
 }
 
-/* Convert rate up by multiple of 2 */
-void SDLCALL SDL_RateMUL2(SDL_AudioCVT *cvt, Uint16 format)
-{
-	int i;
-	Uint8 *src, *dst;
+/* Sample rate conversion.
 
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate * 2\n");
+   Rates are changed in a single pass by a windowed-sinc resampler.  The
+   samples are unpacked to floats, with the first and last frames repeated
+   past the ends of the buffer for the filter to run into, then each output
+   frame is the sum of the input frames around its position, weighted by
+   the filter at that position.  The filter is a Kaiser windowed sinc kept
+   as a table with RESAMPLER_PHASES steps between input samples.  When the
+   rate goes down the filter is widened so it cuts off below the new
+   Nyquist frequency, which takes proportionally more taps.
+
+   SDL_AUDIO_RESAMPLER_QUALITY picks the filter: 0 is linear interpolation,
+   1 (the default) a 16 tap filter and 2 a 64 tap filter.
+
+   SDL_ConvertAudio() keeps its float work buffer in thread local storage
+   for the next call, since an audio device converts each callback on its
+   own thread.  Buffers bigger than RESAMPLER_KEEP_FLOATS, such as for a
+   whole sound file, are freed again.
+*/
+#define RESAMPLER_PHASES		256
+#define RESAMPLER_QUALITIES		3
+#define RESAMPLER_DEFAULT_QUALITY	1
+#define RESAMPLER_KEEP_FLOATS		(256*1024)
+
+typedef struct {
+	int zero_crossings;	/* filter taps on each side of the position */
+	double beta;		/* Kaiser window shape */
+	double rolloff;		/* cutoff as a fraction of the Nyquist frequency */
+	float *kernel;		/* one side of the filter, RESAMPLER_PHASES per tap */
+	float *phases;		/* all taps for each phase, for raising the rate */
+	int ready;
+} SDL_ResampleFilter;
+
+static float resample_kernel1[8*RESAMPLER_PHASES+2];
+static float resample_phases1[(RESAMPLER_PHASES+1)*16];
+static float resample_kernel2[32*RESAMPLER_PHASES+2];
+static float resample_phases2[(RESAMPLER_PHASES+1)*64];
+
+static SDL_ResampleFilter resample_filters[RESAMPLER_QUALITIES] = {
+	{ 1, 0.0, 1.0, NULL, NULL, 1 },
+	{ 8, 7.0, 0.92, resample_kernel1, resample_phases1, 0 },
+	{ 32, 10.0, 0.97, resample_kernel2, resample_phases2, 0 }
+};
+
+/* Guards building the filter tables and creating the buffer TLS ID */
+static SDL_SpinLock resample_lock = 0;
+static SDL_TLSID resample_buffer_id = 0;
+
+#ifdef HAVE_MATH_H
+#ifndef M_PI
+#define M_PI	3.14159265358979323846
 #endif
-	src = cvt->buf+cvt->len_cvt;
-	dst = cvt->buf+cvt->len_cvt*2;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt; i; --i ) {
-				src -= 1;
-				dst -= 2;
-				dst[0] = src[0];
-				dst[1] = src[0];
-			}
-			break;
-		case 16:
-			for ( i=cvt->len_cvt/2; i; --i ) {
-				src -= 2;
-				dst -= 4;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[0];
-				dst[3] = src[1];
-			}
-			break;
-	}
-	cvt->len_cvt *= 2;
-	if ( cvt->filters[++cvt->filter_index] ) {
-		cvt->filters[cvt->filter_index](cvt, format);
+
+/* Zeroth order modified Bessel function of the first kind */
+static double SDL_BesselI0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+	int k;
+
+	for ( k = 1; term > sum * 1e-12; ++k ) {
+		term *= (x * x) / (4.0 * k * k);
+		sum += term;
 	}
+	return(sum);
 }
 
+static void SDL_InitResampleFilter(SDL_ResampleFilter *filter)
+{
+	const int zc = filter->zero_crossings;
+	const int taps = zc * 2;
+	const double scale = 1.0 / SDL_BesselI0(filter->beta);
+	int i, p;
+
+	for ( i = 0; i <= zc * RESAMPLER_PHASES; ++i ) {
+		double x = (double)i / RESAMPLER_PHASES;
+		double r = x / zc;
+		double value;
+
+		if ( i == 0 ) {
+			value = filter->rolloff;
+		} else {
+			value = sin(M_PI * x * filter->rolloff) / (M_PI * x);
+		}
+		value *= SDL_BesselI0(filter->beta * sqrt(1.0 - r * r)) * scale;
+		filter->kernel[i] = (float)value;
+	}
+	filter->kernel[zc * RESAMPLER_PHASES + 1] = 0.0f;
+
+	/* Tap i of phase p is at (i - zc + 1) - p/RESAMPLER_PHASES, and each
+	   phase is scaled to sum to 1 so the filter passes DC unchanged. */
+	for ( p = 0; p <= RESAMPLER_PHASES; ++p ) {
+		float *row = &filter->phases[p * taps];
+		double sum = 0.0;
+
+		for ( i = 0; i < taps; ++i ) {
+			int x = (i - zc + 1) * RESAMPLER_PHASES - p;
+
+			if ( x < 0 ) {
+				x = -x;
+			}
+			row[i] = (x > zc * RESAMPLER_PHASES) ?
+			         0.0f : filter->kernel[x];
+			sum += row[i];
+		}
+		for ( i = 0; i < taps; ++i ) {
+			row[i] = (float)(row[i] / sum);
+		}
+	}
+	filter->ready = 1;
+}
+#endif /* HAVE_MATH_H */
 
-/* Convert rate up by multiple of 2, for stereo */
-void SDLCALL SDL_RateMUL2_c2(SDL_AudioCVT *cvt, Uint16 format)
+static int SDL_ResampleQuality(void)
 {
-	int i;
-	Uint8 *src, *dst;
+	const char *env = SDL_getenv("SDL_AUDIO_RESAMPLER_QUALITY");
+	int quality = RESAMPLER_DEFAULT_QUALITY;
 
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate * 2\n");
+	if ( env ) {
+		quality = SDL_atoi(env);
+		if ( quality < 0 ) {
+			quality = 0;
+		}
+		if ( quality >= RESAMPLER_QUALITIES ) {
+			quality = RESAMPLER_QUALITIES - 1;
+		}
+	}
+#ifndef HAVE_MATH_H
+	/* The filter tables need sin() and sqrt() */
+	quality = 0;
 #endif
-	src = cvt->buf+cvt->len_cvt;
-	dst = cvt->buf+cvt->len_cvt*2;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/2; i; --i ) {
-				src -= 2;
-				dst -= 4;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[0];
-				dst[3] = src[1];
-			}
-			break;
-		case 16:
-			for ( i=cvt->len_cvt/4; i; --i ) {
-				src -= 4;
-				dst -= 8;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[0];
-				dst[5] = src[1];
-				dst[6] = src[2];
-				dst[7] = src[3];
-			}
-			break;
+	SDL_AtomicLock(&resample_lock);
+#ifdef HAVE_MATH_H
+	if ( !resample_filters[quality].ready ) {
+		SDL_InitResampleFilter(&resample_filters[quality]);
 	}
-	cvt->len_cvt *= 2;
-	if ( cvt->filters[++cvt->filter_index] ) {
-		cvt->filters[cvt->filter_index](cvt, format);
+#endif
+	if ( !resample_buffer_id ) {
+		resample_buffer_id = SDL_TLSCreate();
 	}
+	SDL_AtomicUnlock(&resample_lock);
+	return(quality);
 }
 
-/* Convert rate up by multiple of 2, for quad */
-void SDLCALL SDL_RateMUL2_c4(SDL_AudioCVT *cvt, Uint16 format)
+typedef struct {
+	size_t size;		/* in floats */
+	float data[1];
+} SDL_ResampleBuffer;
+
+static void SDLCALL SDL_FreeResampleBuffer(void *buffer)
 {
-	int i;
-	Uint8 *src, *dst;
+	SDL_free(buffer);
+}
 
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate * 2\n");
-#endif
-	src = cvt->buf+cvt->len_cvt;
-	dst = cvt->buf+cvt->len_cvt*2;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/4; i; --i ) {
-				src -= 4;
-				dst -= 8;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[0];
-				dst[5] = src[1];
-				dst[6] = src[2];
-				dst[7] = src[3];
-			}
-			break;
-		case 16:
-			for ( i=cvt->len_cvt/8; i; --i ) {
-				src -= 8;
-				dst -= 16;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[4];
-				dst[5] = src[5];
-				dst[6] = src[6];
-				dst[7] = src[7];
-				dst[8] = src[0];
-				dst[9] = src[1];
-				dst[10] = src[2];
-				dst[11] = src[3];
-				dst[12] = src[4];
-				dst[13] = src[5];
-				dst[14] = src[6];
-				dst[15] = src[7];
-			}
-			break;
+/* Get a work buffer of 'size' floats, pass it to SDL_PutResampleBuffer()
+   when done */
+static float *SDL_GetResampleBuffer(size_t size)
+{
+	SDL_ResampleBuffer *buffer, *old;
+
+	if ( size > RESAMPLER_KEEP_FLOATS ) {
+		return((float *)SDL_malloc(size * sizeof(float)));
 	}
-	cvt->len_cvt *= 2;
-	if ( cvt->filters[++cvt->filter_index] ) {
-		cvt->filters[cvt->filter_index](cvt, format);
+	old = (SDL_ResampleBuffer *)SDL_TLSGet(resample_buffer_id);
+	if ( old && old->size >= size ) {
+		return(old->data);
+	}
+	buffer = (SDL_ResampleBuffer *)SDL_malloc(sizeof(*buffer) +
+	                                (size - 1) * sizeof(float));
+	if ( buffer == NULL ) {
+		return(NULL);
 	}
+	buffer->size = size;
+	if ( SDL_TLSSet(resample_buffer_id, buffer, SDL_FreeResampleBuffer) < 0 ) {
+		SDL_free(buffer);
+		return(NULL);
+	}
+	SDL_free(old);
+	return(buffer->data);
 }
 
+static void SDL_PutResampleBuffer(float *data, size_t size)
+{
+	if ( size > RESAMPLER_KEEP_FLOATS ) {
+		SDL_free(data);
+	}
+}
 
-/* Convert rate up by multiple of 2, for 5.1 */
-void SDLCALL SDL_RateMUL2_c6(SDL_AudioCVT *cvt, Uint16 format)
+/* Work out the taps for an output frame 'frac' of the way past input frame
+   'first', returns the first input frame the taps apply to */
+static int SDL_ResampleTaps(const SDL_ResampleFilter *filter, int first,
+                            double frac, double step, float *coef, int taps)
 {
 	int i;
-	Uint8 *src, *dst;
 
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate * 2\n");
-#endif
-	src = cvt->buf+cvt->len_cvt;
-	dst = cvt->buf+cvt->len_cvt*2;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/6; i; --i ) {
-				src -= 6;
-				dst -= 12;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[4];
-				dst[5] = src[5];
-				dst[6] = src[0];
-				dst[7] = src[1];
-				dst[8] = src[2];
-				dst[9] = src[3];
-				dst[10] = src[4];
-				dst[11] = src[5];
+	if ( filter->zero_crossings == 1 ) {
+		/* Linear interpolation */
+		coef[0] = (float)(1.0 - frac);
+		coef[1] = (float)frac;
+	} else if ( step <= 1.0 ) {
+		/* Blend the two nearest phases of the filter */
+		double where = frac * RESAMPLER_PHASES;
+		int phase = (int)where;
+		float blend = (float)(where - phase);
+		const float *a = &filter->phases[phase * taps];
+		const float *b = a + taps;
+
+		for ( i = 0; i < taps; ++i ) {
+			coef[i] = a[i] + blend * (b[i] - a[i]);
+		}
+		first -= filter->zero_crossings - 1;
+	} else {
+		/* Stretch the filter to cut off at the output rate */
+		const double scale = RESAMPLER_PHASES / step;
+		const int limit = filter->zero_crossings * RESAMPLER_PHASES;
+		float sum = 0.0f;
+
+		first -= (taps / 2) - 1;
+		for ( i = 0; i < taps; ++i ) {
+			double x = (i - (taps / 2) + 1 - frac) * scale;
+			int index;
+			float blend;
+
+			if ( x < 0.0 ) {
+				x = -x;
 			}
-			break;
-		case 16:
-			for ( i=cvt->len_cvt/12; i; --i ) {
-				src -= 12;
-				dst -= 24;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[4];
-				dst[5] = src[5];
-				dst[6] = src[6];
-				dst[7] = src[7];
-				dst[8] = src[8];
-				dst[9] = src[9];
-				dst[10] = src[10];
-				dst[11] = src[11];
-				dst[12] = src[0];
-				dst[13] = src[1];
-				dst[14] = src[2];
-				dst[15] = src[3];
-				dst[16] = src[4];
-				dst[17] = src[5];
-				dst[18] = src[6];
-				dst[19] = src[7];
-				dst[20] = src[8];
-				dst[21] = src[9];
-				dst[22] = src[10];
-				dst[23] = src[11];
+			index = (int)x;
+			if ( index >= limit ) {
+				coef[i] = 0.0f;
+				continue;
 			}
-			break;
-	}
-	cvt->len_cvt *= 2;
-	if ( cvt->filters[++cvt->filter_index] ) {
-		cvt->filters[cvt->filter_index](cvt, format);
+			blend = (float)(x - index);
+			coef[i] = filter->kernel[index] + blend *
+			          (filter->kernel[index+1] - filter->kernel[index]);
+			sum += coef[i];
+		}
+		for ( i = 0; i < taps; ++i ) {
+			coef[i] /= sum;
+		}
 	}
+	return(first);
 }
 
-/* Convert rate down by multiple of 2 */
-void SDLCALL SDL_RateDIV2(SDL_AudioCVT *cvt, Uint16 format)
+/* Weighted sums of 'taps' input frames into one output frame */
+typedef void (*SDL_ResampleFrameFunc)(float *out, const float *in,
+                                      const float *coef, int taps);
+
+static void SDL_ResampleFrame_c1(float *out, const float *in,
+                                 const float *coef, int taps)
 {
+	float sum = 0.0f;
 	int i;
-	Uint8 *src, *dst;
 
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate / 2\n");
-#endif
-	src = cvt->buf;
-	dst = cvt->buf;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/2; i; --i ) {
-				dst[0] = src[0];
-				src += 2;
-				dst += 1;
-			}
-			break;
-		case 16:
-			for ( i=cvt->len_cvt/4; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				src += 4;
-				dst += 2;
-			}
-			break;
+	for ( i = 0; i < taps; ++i ) {
+		sum += in[i] * coef[i];
 	}
-	cvt->len_cvt /= 2;
-	if ( cvt->filters[++cvt->filter_index] ) {
-		cvt->filters[cvt->filter_index](cvt, format);
+	out[0] = sum;
+}
+
+static void SDL_ResampleFrame_c2(float *out, const float *in,
+                                 const float *coef, int taps)
+{
+	float l = 0.0f, r = 0.0f;
+	int i;
+
+	for ( i = 0; i < taps; ++i ) {
+		l += in[0] * coef[i];
+		r += in[1] * coef[i];
+		in += 2;
+	}
+	out[0] = l;
+	out[1] = r;
+}
+
+static void SDL_ResampleFrame_cN(float *out, const float *in,
+                                 const float *coef, int taps, int chans)
+{
+	int i, c;
+
+	for ( c = 0; c < chans; ++c ) {
+		out[c] = 0.0f;
+	}
+	for ( i = 0; i < taps; ++i ) {
+		for ( c = 0; c < chans; ++c ) {
+			out[c] += in[c] * coef[i];
+		}
+		in += chans;
 	}
 }
 
+static void SDL_ResampleFrame_c4(float *out, const float *in,
+                                 const float *coef, int taps)
+{
+	SDL_ResampleFrame_cN(out, in, coef, taps, 4);
+}
+
+static void SDL_ResampleFrame_c6(float *out, const float *in,
+                                 const float *coef, int taps)
+{
+	SDL_ResampleFrame_cN(out, in, coef, taps, 6);
+}
 
-/* Convert rate down by multiple of 2, for stereo */
-void SDLCALL SDL_RateDIV2_c2(SDL_AudioCVT *cvt, Uint16 format)
+#if SDL_SSE2_INTRINSICS
+static void SDL_TARGETING("sse2") SDL_ResampleFrame_c1_SSE2(float *out,
+                    const float *in, const float *coef, int taps)
 {
+	__m128 sum = _mm_setzero_ps();
+	float tail = 0.0f;
 	int i;
-	Uint8 *src, *dst;
 
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate / 2\n");
+	for ( i = 0; i + 4 <= taps; i += 4 ) {
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&in[i]),
+		                                 _mm_loadu_ps(&coef[i])));
+	}
+	for ( ; i < taps; ++i ) {
+		tail += in[i] * coef[i];
+	}
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+	out[0] = _mm_cvtss_f32(sum) + tail;
+}
+
+static void SDL_TARGETING("sse2") SDL_ResampleFrame_c2_SSE2(float *out,
+                    const float *in, const float *coef, int taps)
+{
+	__m128 sum = _mm_setzero_ps();
+	int i;
+
+	/* Two frames at a time, with the taps as c0 c0 c1 c1 */
+	for ( i = 0; i + 2 <= taps; i += 2 ) {
+		__m128 c = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)&coef[i]);
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&in[i*2]),
+		                                 _mm_unpacklo_ps(c, c)));
+	}
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	if ( i < taps ) {
+		__m128 frame = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)&in[i*2]);
+		sum = _mm_add_ps(sum, _mm_mul_ps(frame, _mm_set1_ps(coef[i])));
+	}
+	_mm_storel_pi((__m64 *)out, sum);
+}
+
+static void SDL_TARGETING("sse2") SDL_ResampleFrame_c4_SSE2(float *out,
+                    const float *in, const float *coef, int taps)
+{
+	__m128 sum = _mm_setzero_ps();
+	int i;
+
+	for ( i = 0; i < taps; ++i ) {
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&in[i*4]),
+		                                 _mm_set1_ps(coef[i])));
+	}
+	_mm_storeu_ps(out, sum);
+}
+
+static void SDL_TARGETING("sse2") SDL_ResampleFrame_c6_SSE2(float *out,
+                    const float *in, const float *coef, int taps)
+{
+	__m128 front = _mm_setzero_ps();
+	__m128 back = _mm_setzero_ps();
+	int i;
+
+	for ( i = 0; i < taps; ++i ) {
+		__m128 c = _mm_set1_ps(coef[i]);
+		front = _mm_add_ps(front, _mm_mul_ps(_mm_loadu_ps(&in[i*6]), c));
+		back = _mm_add_ps(back, _mm_mul_ps(_mm_loadl_pi(_mm_setzero_ps(),
+		                               (const __m64 *)&in[i*6+4]), c));
+	}
+	_mm_storeu_ps(out, front);
+	_mm_storel_pi((__m64 *)&out[4], back);
+}
+#endif /* SDL_SSE2_INTRINSICS */
+
+#if SDL_NEON_INTRINSICS
+static void SDL_ResampleFrame_c1_NEON(float *out, const float *in,
+                                      const float *coef, int taps)
+{
+	float32x4_t sum = vdupq_n_f32(0.0f);
+	float32x2_t half;
+	float tail = 0.0f;
+	int i;
+
+	for ( i = 0; i + 4 <= taps; i += 4 ) {
+		sum = vmlaq_f32(sum, vld1q_f32(&in[i]), vld1q_f32(&coef[i]));
+	}
+	for ( ; i < taps; ++i ) {
+		tail += in[i] * coef[i];
+	}
+	half = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+	out[0] = vget_lane_f32(vpadd_f32(half, half), 0) + tail;
+}
+
+static void SDL_ResampleFrame_c2_NEON(float *out, const float *in,
+                                      const float *coef, int taps)
+{
+	float32x2_t sum = vdup_n_f32(0.0f);
+	int i;
+
+	for ( i = 0; i < taps; ++i ) {
+		sum = vmla_n_f32(sum, vld1_f32(&in[i*2]), coef[i]);
+	}
+	vst1_f32(out, sum);
+}
+
+static void SDL_ResampleFrame_c4_NEON(float *out, const float *in,
+                                      const float *coef, int taps)
+{
+	float32x4_t sum = vdupq_n_f32(0.0f);
+	int i;
+
+	for ( i = 0; i < taps; ++i ) {
+		sum = vmlaq_n_f32(sum, vld1q_f32(&in[i*4]), coef[i]);
+	}
+	vst1q_f32(out, sum);
+}
+
+static void SDL_ResampleFrame_c6_NEON(float *out, const float *in,
+                                      const float *coef, int taps)
+{
+	float32x4_t front = vdupq_n_f32(0.0f);
+	float32x2_t back = vdup_n_f32(0.0f);
+	int i;
+
+	for ( i = 0; i < taps; ++i ) {
+		front = vmlaq_n_f32(front, vld1q_f32(&in[i*6]), coef[i]);
+		back = vmla_n_f32(back, vld1_f32(&in[i*6+4]), coef[i]);
+	}
+	vst1q_f32(out, front);
+	vst1_f32(&out[4], back);
+}
+#endif /* SDL_NEON_INTRINSICS */
+
+static SDL_ResampleFrameFunc SDL_GetResampleFrame(int chans)
+{
+#if SDL_SSE2_INTRINSICS
+	if ( SDL_HasSSE2() ) {
+		switch (chans) {
+			case 1: return SDL_ResampleFrame_c1_SSE2;
+			case 2: return SDL_ResampleFrame_c2_SSE2;
+			case 4: return SDL_ResampleFrame_c4_SSE2;
+			case 6: return SDL_ResampleFrame_c6_SSE2;
+		}
+	}
+#elif SDL_NEON_INTRINSICS
+	if ( SDL_HasNEON() ) {
+		switch (chans) {
+			case 1: return SDL_ResampleFrame_c1_NEON;
+			case 2: return SDL_ResampleFrame_c2_NEON;
+			case 4: return SDL_ResampleFrame_c4_NEON;
+			case 6: return SDL_ResampleFrame_c6_NEON;
+		}
+	}
 #endif
-	src = cvt->buf;
-	dst = cvt->buf;
+	switch (chans) {
+		case 1: return SDL_ResampleFrame_c1;
+		case 2: return SDL_ResampleFrame_c2;
+		case 4: return SDL_ResampleFrame_c4;
+		default: return SDL_ResampleFrame_c6;
+	}
+}
+
+/* Sample format conversion.
+
+   Samples of every format are converted to and from floats between -1.0
+   and 1.0, integers being scaled by a power of two so the conversion to
+   float is exact up to 24 bits.  Packing rounds half away from zero and
+   clips, in float so every path gives the same result.  SDL_UnpackSamples()
+   works from the end of the buffer and SDL_PackSamples() from the start,
+   so both can convert a buffer in place.  The SIMD versions convert
+   SAMPLE_BLOCK samples at a time, reading all of a block before storing
+   any of it.
+*/
+#define SAMPLE_BLOCK	16
+
+static float SDL_SampleScale(Uint16 format)
+{
 	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/4; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				src += 4;
-				dst += 2;
-			}
+	    case 8:
+		return(128.0f);
+	    case 16:
+		return(32768.0f);
+	    default:
+		return((format & 0x0100) ? 1.0f : 2147483648.0f);
+	}
+}
+
+static __inline__ Uint32 SDL_SampleBits(const Uint8 *src, int msb, int width)
+{
+	if ( width == 2 ) {
+		return msb ? (Uint32)((src[0] << 8) | src[1]) :
+		             (Uint32)((src[1] << 8) | src[0]);
+	}
+	return msb ? (((Uint32)src[0] << 24) | ((Uint32)src[1] << 16) |
+	              ((Uint32)src[2] << 8) | (Uint32)src[3]) :
+	             (((Uint32)src[3] << 24) | ((Uint32)src[2] << 16) |
+	              ((Uint32)src[1] << 8) | (Uint32)src[0]);
+}
+
+static void SDL_UnpackSamples_C(float *dst, const Uint8 *src, int start,
+                                int count, Uint16 format)
+{
+	const float scale = 1.0f / SDL_SampleScale(format);
+	const int msb = (format & 0x1000) ? 1 : 0;
+	int i;
+
+	for ( i = count; i-- > start; ) {
+		switch (format & ~0x1000) {
+		    case AUDIO_U8:
+			dst[i] = (float)((int)src[i] - 128) * scale;
 			break;
-		case 16:
-			for ( i=cvt->len_cvt/8; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				src += 8;
-				dst += 4;
-			}
+		    case AUDIO_S8:
+			dst[i] = (float)(Sint8)src[i] * scale;
+			break;
+		    case AUDIO_U16LSB:
+			dst[i] = (float)((int)SDL_SampleBits(&src[i*2], msb, 2) - 32768) * scale;
+			break;
+		    case AUDIO_S16LSB:
+			dst[i] = (float)(Sint16)SDL_SampleBits(&src[i*2], msb, 2) * scale;
+			break;
+		    case AUDIO_S32LSB:
+			dst[i] = (float)(Sint32)SDL_SampleBits(&src[i*4], msb, 4) * scale;
 			break;
+		    default: {
+			union { float f; Uint32 u; } sample;
+
+			sample.u = SDL_SampleBits(&src[i*4], msb, 4);
+			dst[i] = sample.f;
+		    }
+			break;
+		}
 	}
-	cvt->len_cvt /= 2;
-	if ( cvt->filters[++cvt->filter_index] ) {
-		cvt->filters[cvt->filter_index](cvt, format);
+}
+
+static void SDL_PackSamples_C(Uint8 *dst, const float *src, int start,
+                              int count, Uint16 format)
+{
+	const float scale = SDL_SampleScale(format);
+	const int width = (format & 0xFF) / 8;
+	const int msb = (format & 0x1000) ? 1 : 0;
+	const Uint32 top = (Uint32)1 << ((width * 8) - 1);
+	const Uint32 flip = (format & 0x8000) ? 0 : top;
+	int i, j;
+
+	for ( i = start; i < count; ++i ) {
+		union { float f; Uint32 u; } sample;
+		Uint32 bits;
+
+		sample.f = src[i];
+		if ( format & 0x0100 ) {
+			bits = sample.u;
+		} else {
+			float x = sample.f * scale;
+
+			x = (x < 0.0f) ? (x - 0.5f) : (x + 0.5f);
+			if ( !(x > -scale) ) {
+				bits = top;
+			} else if ( x >= scale ) {
+				bits = top - 1;
+			} else {
+				bits = (Uint32)(Sint32)x;
+			}
+			bits ^= flip;
+		}
+		for ( j = 0; j < width; ++j ) {
+			dst[i*width + (msb ? (width - 1 - j) : j)] = (Uint8)bits;
+			bits >>= 8;
+		}
 	}
 }
 
+#if SDL_SSE2_INTRINSICS
+static __m128i SDL_TARGETING("sse2") SDL_Swap16_SSE2(__m128i x)
+{
+	return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+}
 
-/* Convert rate down by multiple of 2, for quad */
-void SDLCALL SDL_RateDIV2_c4(SDL_AudioCVT *cvt, Uint16 format)
+static __m128i SDL_TARGETING("sse2") SDL_Swap32_SSE2(__m128i x)
 {
-	int i;
-	Uint8 *src, *dst;
+	x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xB1), 0xB1);
+	return SDL_Swap16_SSE2(x);
+}
 
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate / 2\n");
-#endif
-	src = cvt->buf;
-	dst = cvt->buf;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/8; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				src += 8;
-				dst += 4;
+static void SDL_TARGETING("sse2") SDL_UnpackSamples_SSE2(float *dst,
+	const Uint8 *src, int count, Uint16 format)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / SDL_SampleScale(format));
+	const int swap = ((format & 0xFF) > 8) && (format & 0x1000) !=
+	                 (AUDIO_S16SYS & 0x1000);
+	int i, j;
+
+	for ( i = count - SAMPLE_BLOCK; i >= 0; i -= SAMPLE_BLOCK ) {
+		__m128i v[4];
+
+		switch (format & 0xFF) {
+		    case 8: {
+			__m128i x = _mm_loadu_si128((const __m128i *)&src[i]);
+			__m128i lo, hi;
+
+			if ( !(format & 0x8000) ) {
+				x = _mm_xor_si128(x, _mm_set1_epi8((char)0x80));
 			}
+			lo = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+			hi = _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+			v[0] = _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16);
+			v[1] = _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16);
+			v[2] = _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16);
+			v[3] = _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16);
+		    }
 			break;
-		case 16:
-			for ( i=cvt->len_cvt/16; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[4];
-				dst[5] = src[5];
-				dst[6] = src[6];
-				dst[7] = src[7];
-				src += 16;
-				dst += 8;
+		    case 16: {
+			__m128i lo = _mm_loadu_si128((const __m128i *)&src[i*2]);
+			__m128i hi = _mm_loadu_si128((const __m128i *)&src[i*2+16]);
+
+			if ( swap ) {
+				lo = SDL_Swap16_SSE2(lo);
+				hi = SDL_Swap16_SSE2(hi);
+			}
+			if ( !(format & 0x8000) ) {
+				lo = _mm_xor_si128(lo, _mm_set1_epi16((short)0x8000));
+				hi = _mm_xor_si128(hi, _mm_set1_epi16((short)0x8000));
 			}
+			v[0] = _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16);
+			v[1] = _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16);
+			v[2] = _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16);
+			v[3] = _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16);
+		    }
 			break;
-	}
-	cvt->len_cvt /= 2;
-	if ( cvt->filters[++cvt->filter_index] ) {
-		cvt->filters[cvt->filter_index](cvt, format);
+		    default:
+			for ( j = 0; j < 4; ++j ) {
+				v[j] = _mm_loadu_si128((const __m128i *)&src[i*4+j*16]);
+				if ( swap ) {
+					v[j] = SDL_Swap32_SSE2(v[j]);
+				}
+			}
+			break;
+		}
+		for ( j = 0; j < 4; ++j ) {
+			__m128 f;
+
+			if ( format & 0x0100 ) {
+				f = _mm_castsi128_ps(v[j]);
+			} else {
+				f = _mm_mul_ps(_mm_cvtepi32_ps(v[j]), scale);
+			}
+			_mm_storeu_ps(&dst[i+j*4], f);
+		}
 	}
 }
 
-/* Convert rate down by multiple of 2, for 5.1 */
-void SDLCALL SDL_RateDIV2_c6(SDL_AudioCVT *cvt, Uint16 format)
+static void SDL_TARGETING("sse2") SDL_PackSamples_SSE2(Uint8 *dst,
+	const float *src, int count, Uint16 format)
 {
-	int i;
-	Uint8 *src, *dst;
+	const float max = SDL_SampleScale(format);
+	const __m128 scale = _mm_set1_ps(max);
+	const __m128 lo = _mm_set1_ps(-max);
+	const __m128 hi = _mm_set1_ps(max - 1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const int swap = ((format & 0xFF) > 8) && (format & 0x1000) !=
+	                 (AUDIO_S16SYS & 0x1000);
+	int i, j;
+
+	for ( i = 0; i + SAMPLE_BLOCK <= count; i += SAMPLE_BLOCK ) {
+		__m128i v[4];
+
+		for ( j = 0; j < 4; ++j ) {
+			__m128 x = _mm_loadu_ps(&src[i+j*4]);
+
+			if ( format & 0x0100 ) {
+				v[j] = _mm_castps_si128(x);
+				continue;
+			}
+			x = _mm_mul_ps(x, scale);
+			x = _mm_add_ps(x, _mm_or_ps(_mm_and_ps(x, sign), half));
+			x = _mm_max_ps(x, lo);
+			if ( (format & 0xFF) == 32 ) {
+				/* Past the top converts to 0x80000000, flip it */
+				__m128 over = _mm_cmpge_ps(x, scale);
+				v[j] = _mm_xor_si128(_mm_cvttps_epi32(x),
+				                     _mm_castps_si128(over));
+			} else {
+				v[j] = _mm_cvttps_epi32(_mm_min_ps(x, hi));
+			}
+		}
+		switch (format & 0xFF) {
+		    case 8: {
+			__m128i x = _mm_packs_epi16(_mm_packs_epi32(v[0], v[1]),
+			                            _mm_packs_epi32(v[2], v[3]));
+			if ( !(format & 0x8000) ) {
+				x = _mm_xor_si128(x, _mm_set1_epi8((char)0x80));
+			}
+			_mm_storeu_si128((__m128i *)&dst[i], x);
+		    }
+			break;
+		    case 16:
+			for ( j = 0; j < 2; ++j ) {
+				__m128i x = _mm_packs_epi32(v[j*2], v[j*2+1]);
 
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate / 2\n");
-#endif
-	src = cvt->buf;
-	dst = cvt->buf;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/12; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[4];
-				dst[5] = src[5];
-				src += 12;
-				dst += 6;
+				if ( !(format & 0x8000) ) {
+					x = _mm_xor_si128(x, _mm_set1_epi16((short)0x8000));
+				}
+				if ( swap ) {
+					x = SDL_Swap16_SSE2(x);
+				}
+				_mm_storeu_si128((__m128i *)&dst[i*2+j*16], x);
 			}
 			break;
-		case 16:
-			for ( i=cvt->len_cvt/24; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[4];
-				dst[5] = src[5];
-				dst[6] = src[6];
-				dst[7] = src[7];
-				dst[8] = src[8];
-				dst[9] = src[9];
-				dst[10] = src[10];
-				dst[11] = src[11];
-				src += 24;
-				dst += 12;
+		    default:
+			for ( j = 0; j < 4; ++j ) {
+				if ( swap ) {
+					v[j] = SDL_Swap32_SSE2(v[j]);
+				}
+				_mm_storeu_si128((__m128i *)&dst[i*4+j*16], v[j]);
 			}
 			break;
-	}
-	cvt->len_cvt /= 2;
-	if ( cvt->filters[++cvt->filter_index] ) {
-		cvt->filters[cvt->filter_index](cvt, format);
+		}
 	}
 }
+#endif /* SDL_SSE2_INTRINSICS */
 
-/* Very slow rate conversion routine */
-void SDLCALL SDL_RateSLOW(SDL_AudioCVT *cvt, Uint16 format)
+#if SDL_NEON_INTRINSICS
+static void SDL_UnpackSamples_NEON(float *dst, const Uint8 *src, int count,
+                                   Uint16 format)
 {
-	double ipos;
-	int i, clen;
+	const float scale = 1.0f / SDL_SampleScale(format);
+	const int swap = ((format & 0xFF) > 8) && (format & 0x1000) !=
+	                 (AUDIO_S16SYS & 0x1000);
+	int i, j;
+
+	for ( i = count - SAMPLE_BLOCK; i >= 0; i -= SAMPLE_BLOCK ) {
+		int32x4_t v[4];
 
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate * %4.4f\n", 1.0/cvt->rate_incr);
-#endif
-	clen = (int)((double)cvt->len_cvt / cvt->rate_incr);
-	if ( cvt->rate_incr > 1.0 ) {
 		switch (format & 0xFF) {
-			case 8: {
-				Uint8 *output;
-
-				output = cvt->buf;
-				ipos = 0.0;
-				for ( i=clen; i; --i ) {
-					*output = cvt->buf[(int)ipos];
-					ipos += cvt->rate_incr;
-					output += 1;
-				}
+		    case 8: {
+			uint8x16_t x = vld1q_u8(&src[i]);
+			int16x8_t lo, hi;
+
+			if ( !(format & 0x8000) ) {
+				x = veorq_u8(x, vdupq_n_u8(0x80));
 			}
+			lo = vmovl_s8(vget_low_s8(vreinterpretq_s8_u8(x)));
+			hi = vmovl_s8(vget_high_s8(vreinterpretq_s8_u8(x)));
+			v[0] = vmovl_s16(vget_low_s16(lo));
+			v[1] = vmovl_s16(vget_high_s16(lo));
+			v[2] = vmovl_s16(vget_low_s16(hi));
+			v[3] = vmovl_s16(vget_high_s16(hi));
+		    }
 			break;
+		    case 16:
+			for ( j = 0; j < 2; ++j ) {
+				uint8x16_t b = vld1q_u8(&src[i*2+j*16]);
+				int16x8_t x;
 
-			case 16: {
-				Uint16 *output;
+				if ( swap ) {
+					b = vrev16q_u8(b);
+				}
+				x = vreinterpretq_s16_u8(b);
+				if ( !(format & 0x8000) ) {
+					x = veorq_s16(x, vdupq_n_s16((int16_t)0x8000));
+				}
+				v[j*2] = vmovl_s16(vget_low_s16(x));
+				v[j*2+1] = vmovl_s16(vget_high_s16(x));
+			}
+			break;
+		    default:
+			for ( j = 0; j < 4; ++j ) {
+				uint8x16_t b = vld1q_u8(&src[i*4+j*16]);
 
-				clen &= ~1;
-				output = (Uint16 *)cvt->buf;
-				ipos = 0.0;
-				for ( i=clen/2; i; --i ) {
-					*output=((Uint16 *)cvt->buf)[(int)ipos];
-					ipos += cvt->rate_incr;
-					output += 1;
+				if ( swap ) {
+					b = vrev32q_u8(b);
 				}
+				v[j] = vreinterpretq_s32_u8(b);
 			}
 			break;
 		}
-	} else {
+		for ( j = 0; j < 4; ++j ) {
+			float32x4_t f;
+
+			if ( format & 0x0100 ) {
+				f = vreinterpretq_f32_s32(v[j]);
+			} else {
+				f = vmulq_n_f32(vcvtq_f32_s32(v[j]), scale);
+			}
+			vst1q_f32(&dst[i+j*4], f);
+		}
+	}
+}
+
+static void SDL_PackSamples_NEON(Uint8 *dst, const float *src, int count,
+                                 Uint16 format)
+{
+	const float max = SDL_SampleScale(format);
+	const float32x4_t lo = vdupq_n_f32(-max);
+	const float32x4_t hi = vdupq_n_f32(max - 1.0f);
+	const uint32x4_t sign = vdupq_n_u32(0x80000000);
+	const uint32x4_t half = vreinterpretq_u32_f32(vdupq_n_f32(0.5f));
+	const int swap = ((format & 0xFF) > 8) && (format & 0x1000) !=
+	                 (AUDIO_S16SYS & 0x1000);
+	int i, j;
+
+	for ( i = 0; i + SAMPLE_BLOCK <= count; i += SAMPLE_BLOCK ) {
+		int32x4_t v[4];
+
+		for ( j = 0; j < 4; ++j ) {
+			float32x4_t x = vld1q_f32(&src[i+j*4]);
+
+			if ( format & 0x0100 ) {
+				v[j] = vreinterpretq_s32_f32(x);
+				continue;
+			}
+			x = vmulq_n_f32(x, max);
+			x = vaddq_f32(x, vreinterpretq_f32_u32(vorrq_u32(
+			        vandq_u32(vreinterpretq_u32_f32(x), sign), half)));
+			if ( (format & 0xFF) == 32 ) {
+				/* The conversion saturates */
+				v[j] = vcvtq_s32_f32(x);
+			} else {
+				v[j] = vcvtq_s32_f32(vminq_f32(vmaxq_f32(x, lo), hi));
+			}
+		}
 		switch (format & 0xFF) {
-			case 8: {
-				Uint8 *output;
-
-				output = cvt->buf+clen;
-				ipos = (double)cvt->len_cvt;
-				for ( i=clen; i; --i ) {
-					ipos -= cvt->rate_incr;
-					output -= 1;
-					*output = cvt->buf[(int)ipos];
+		    case 8: {
+			int16x8_t a = vcombine_s16(vmovn_s32(v[0]), vmovn_s32(v[1]));
+			int16x8_t b = vcombine_s16(vmovn_s32(v[2]), vmovn_s32(v[3]));
+			uint8x16_t x = vreinterpretq_u8_s8(vcombine_s8(vmovn_s16(a), vmovn_s16(b)));
+
+			if ( !(format & 0x8000) ) {
+				x = veorq_u8(x, vdupq_n_u8(0x80));
+			}
+			vst1q_u8(&dst[i], x);
+		    }
+			break;
+		    case 16:
+			for ( j = 0; j < 2; ++j ) {
+				int16x8_t x = vcombine_s16(vmovn_s32(v[j*2]),
+				                           vmovn_s32(v[j*2+1]));
+				uint8x16_t b;
+
+				if ( !(format & 0x8000) ) {
+					x = veorq_s16(x, vdupq_n_s16((int16_t)0x8000));
+				}
+				b = vreinterpretq_u8_s16(x);
+				if ( swap ) {
+					b = vrev16q_u8(b);
 				}
+				vst1q_u8(&dst[i*2+j*16], b);
 			}
 			break;
+		    default:
+			for ( j = 0; j < 4; ++j ) {
+				uint8x16_t b = vreinterpretq_u8_s32(v[j]);
 
-			case 16: {
-				Uint16 *output;
-
-				clen &= ~1;
-				output = (Uint16 *)(cvt->buf+clen);
-				ipos = (double)cvt->len_cvt/2;
-				for ( i=clen/2; i; --i ) {
-					ipos -= cvt->rate_incr;
-					output -= 1;
-					*output=((Uint16 *)cvt->buf)[(int)ipos];
+				if ( swap ) {
+					b = vrev32q_u8(b);
 				}
+				vst1q_u8(&dst[i*4+j*16], b);
 			}
 			break;
 		}
 	}
-	cvt->len_cvt = clen;
+}
+#endif /* SDL_NEON_INTRINSICS */
+
+static void SDL_UnpackSamples(float *dst, const Uint8 *src, int count,
+                              Uint16 format)
+{
+	int simd = 0;
+
+#if SDL_SSE2_INTRINSICS
+	if ( SDL_HasSSE2() ) {
+		simd = count - (count % SAMPLE_BLOCK);
+	}
+#elif SDL_NEON_INTRINSICS
+	if ( SDL_HasNEON() ) {
+		simd = count - (count % SAMPLE_BLOCK);
+	}
+#endif
+	/* The tail is stored over the block sources, so it goes first */
+	SDL_UnpackSamples_C(dst, src, simd, count, format);
+#if SDL_SSE2_INTRINSICS
+	if ( simd ) {
+		SDL_UnpackSamples_SSE2(dst, src, simd, format);
+	}
+#elif SDL_NEON_INTRINSICS
+	if ( simd ) {
+		SDL_UnpackSamples_NEON(dst, src, simd, format);
+	}
+#endif
+}
+
+static void SDL_PackSamples(Uint8 *dst, const float *src, int count,
+                            Uint16 format)
+{
+	int simd = 0;
+
+#if SDL_SSE2_INTRINSICS
+	if ( SDL_HasSSE2() ) {
+		simd = count - (count % SAMPLE_BLOCK);
+		SDL_PackSamples_SSE2(dst, src, simd, format);
+	}
+#elif SDL_NEON_INTRINSICS
+	if ( SDL_HasNEON() ) {
+		simd = count - (count % SAMPLE_BLOCK);
+		SDL_PackSamples_NEON(dst, src, simd, format);
+	}
+#endif
+	SDL_PackSamples_C(dst, src, simd, count, format);
+}
+
+/* Convert to native floats in place, growing the data */
+static void SDLCALL SDL_ConvertToFloat(SDL_AudioCVT *cvt, Uint16 format)
+{
+	const int width = (format & 0xFF) / 8;
+
+#ifdef DEBUG_CONVERT
+	fprintf(stderr, "Converting to float\n");
+#endif
+	SDL_UnpackSamples((float *)cvt->buf, cvt->buf, cvt->len_cvt / width,
+	                  format);
+	cvt->len_cvt = (cvt->len_cvt / width) * 4;
+	format = AUDIO_F32SYS;
+	if ( cvt->filters[++cvt->filter_index] ) {
+		cvt->filters[cvt->filter_index](cvt, format);
+	}
+}
+
+/* Convert native floats to the destination format in place */
+static void SDLCALL SDL_ConvertFromFloat(SDL_AudioCVT *cvt, Uint16 format)
+{
+	const int width = (cvt->dst_format & 0xFF) / 8;
+
+#ifdef DEBUG_CONVERT
+	fprintf(stderr, "Converting from float\n");
+#endif
+	SDL_PackSamples(cvt->buf, (float *)cvt->buf, cvt->len_cvt / 4,
+	                cvt->dst_format);
+	cvt->len_cvt = (cvt->len_cvt / 4) * width;
+	format = cvt->dst_format;
+	if ( cvt->filters[++cvt->filter_index] ) {
+		cvt->filters[cvt->filter_index](cvt, format);
+	}
+}
+
+static void SDL_Resample(SDL_AudioCVT *cvt, Uint16 format, int chans,
+                         int quality)
+{
+	const SDL_ResampleFilter *filter = &resample_filters[quality];
+	const double step = cvt->rate_incr;
+	const int width = (format & 0xFF) / 8;
+	const int inframes = cvt->len_cvt / (width * chans);
+	const int outframes = (int)(inframes / step);
+	SDL_ResampleFrameFunc frame = SDL_GetResampleFrame(chans);
+	int taps, pad, i, j;
+	size_t size;
+	float *in, *out, *coef;
+
+#ifdef DEBUG_CONVERT
+	fprintf(stderr, "Converting audio rate * %4.4f\n", 1.0/step);
+#endif
+	taps = filter->zero_crossings * 2;
+	if ( step > 1.0 && quality > 0 ) {
+		taps = (int)(filter->zero_crossings * step + 0.999) * 2;
+	}
+	pad = taps;
+
+	size = (size_t)((inframes + pad * 2) * chans + outframes * chans + taps);
+	if ( inframes > 0 ) {
+		in = SDL_GetResampleBuffer(size);
+	} else {
+		in = NULL;
+	}
+	if ( in == NULL ) {
+		if ( inframes > 0 ) {
+			SDL_OutOfMemory();
+		}
+		cvt->len_cvt = 0;
+		goto done;
+	}
+	out = in + (inframes + pad * 2) * chans;
+	coef = out + outframes * chans;
+
+	/* Hold the first and last frames past the ends of the buffer */
+	SDL_UnpackSamples(&in[pad * chans], cvt->buf, inframes * chans, format);
+	for ( i = 0; i < pad; ++i ) {
+		for ( j = 0; j < chans; ++j ) {
+			in[i * chans + j] = in[pad * chans + j];
+			in[(pad + inframes + i) * chans + j] =
+				in[(pad + inframes - 1) * chans + j];
+		}
+	}
+
+	for ( i = 0; i < outframes; ++i ) {
+		double pos = i * step;
+		int first = SDL_ResampleTaps(filter, (int)pos, pos - (int)pos,
+		                             step, coef, taps);
+		frame(&out[i * chans], &in[(first + pad) * chans], coef, taps);
+	}
+
+	SDL_PackSamples(cvt->buf, out, outframes * chans, format);
+	cvt->len_cvt = outframes * chans * width;
+	SDL_PutResampleBuffer(in, size);
+
+done:
 	if ( cvt->filters[++cvt->filter_index] ) {
 		cvt->filters[cvt->filter_index](cvt, format);
 	}
 }
 
+#define DEFINE_RESAMPLER(chans, quality) \
+static void SDLCALL SDL_Resample_c##chans##_q##quality(SDL_AudioCVT *cvt, Uint16 format) \
+{ \
+	SDL_Resample(cvt, format, chans, quality); \
+}
+DEFINE_RESAMPLER(1, 0)
+DEFINE_RESAMPLER(1, 1)
+DEFINE_RESAMPLER(1, 2)
+DEFINE_RESAMPLER(2, 0)
+DEFINE_RESAMPLER(2, 1)
+DEFINE_RESAMPLER(2, 2)
+DEFINE_RESAMPLER(4, 0)
+DEFINE_RESAMPLER(4, 1)
+DEFINE_RESAMPLER(4, 2)
+DEFINE_RESAMPLER(6, 0)
+DEFINE_RESAMPLER(6, 1)
+DEFINE_RESAMPLER(6, 2)
+#undef DEFINE_RESAMPLER
+
+static void (SDLCALL *resamplers[4][RESAMPLER_QUALITIES])(SDL_AudioCVT *cvt, Uint16 format) = {
+	{ SDL_Resample_c1_q0, SDL_Resample_c1_q1, SDL_Resample_c1_q2 },
+	{ SDL_Resample_c2_q0, SDL_Resample_c2_q1, SDL_Resample_c2_q2 },
+	{ SDL_Resample_c4_q0, SDL_Resample_c4_q1, SDL_Resample_c4_q2 },
+	{ SDL_Resample_c6_q0, SDL_Resample_c6_q1, SDL_Resample_c6_q2 }
+};
+
 int SDL_ConvertAudio(SDL_AudioCVT *cvt)
 {
 	/* Make sure there's data to convert */
@@ -1319,6 +1947,25 @@ int SDL_ConvertAudio(SDL_AudioCVT *cvt)
 	return(0);
 }
 
+static int SDL_KnownAudioFormat(Uint16 format)
+{
+	switch (format) {
+	    case AUDIO_U8:
+	    case AUDIO_S8:
+	    case AUDIO_U16LSB:
+	    case AUDIO_S16LSB:
+	    case AUDIO_U16MSB:
+	    case AUDIO_S16MSB:
+	    case AUDIO_S32LSB:
+	    case AUDIO_S32MSB:
+	    case AUDIO_F32LSB:
+	    case AUDIO_F32MSB:
+		return(1);
+	    default:
+		return(0);
+	}
+}
+
 /* Creates a set of audio filters to convert from one format to another. 
    Returns -1 if the format conversion is not supported, or 1 if the
    audio filter is set up.
@@ -1328,6 +1975,8 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 	Uint16 src_format, Uint8 src_channels, int src_rate,
 	Uint16 dst_format, Uint8 dst_channels, int dst_rate)
 {
+	Uint16 work_format = 0;
+
 /*printf("Build format %04x->%04x, channels %u->%u, rate %d->%d\n",
 		src_format, dst_format, src_channels, dst_channels, src_rate, dst_rate);*/
 	/* Start off with no conversion necessary */
@@ -1337,37 +1986,67 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 	cvt->len_mult = 1;
 	cvt->len_ratio = 1.0;
 
-	/* First filter:  Endian conversion from src to dst */
-	if ( (src_format & 0x1000) != (dst_format & 0x1000)
-	     && ((src_format & 0xff) == 16) && ((dst_format & 0xff) == 16)) {
-		cvt->filters[cvt->filter_index++] = SDL_ConvertEndian;
+	if ( !SDL_KnownAudioFormat(src_format) ||
+	     !SDL_KnownAudioFormat(dst_format) ) {
+		SDL_SetError("Unsupported audio format");
+		return(-1);
 	}
-	
-	/* Second filter: Sign conversion -- signed/unsigned */
-	if ( (src_format & 0x8000) != (dst_format & 0x8000) ) {
-		cvt->filters[cvt->filter_index++] = SDL_ConvertSign;
+
+	/* 32-bit samples are worked on in native byte order, as integers
+	   if both ends are integers and as floats otherwise */
+	if ( (src_format & 0xFF) == 32 || (dst_format & 0xFF) == 32 ) {
+		if ( ((src_format | dst_format) & 0x0100) == 0 &&
+		     (src_format & 0xFF) == 32 && (dst_format & 0xFF) == 32 ) {
+			work_format = AUDIO_S32SYS;
+		} else {
+			work_format = AUDIO_F32SYS;
+		}
 	}
 
-	/* Next filter:  Convert 16 bit <--> 8 bit PCM */
-	if ( (src_format & 0xFF) != (dst_format & 0xFF) ) {
-		switch (dst_format&0x10FF) {
-			case AUDIO_U8:
-				cvt->filters[cvt->filter_index++] =
-							 SDL_Convert8;
-				cvt->len_ratio /= 2;
-				break;
-			case AUDIO_U16LSB:
-				cvt->filters[cvt->filter_index++] =
-							SDL_Convert16LSB;
-				cvt->len_mult *= 2;
-				cvt->len_ratio *= 2;
-				break;
-			case AUDIO_U16MSB:
-				cvt->filters[cvt->filter_index++] =
-							SDL_Convert16MSB;
-				cvt->len_mult *= 2;
-				cvt->len_ratio *= 2;
-				break;
+	if ( work_format ) {
+		const int width = (src_format & 0xFF) / 8;
+
+		if ( src_format == (work_format ^ 0x1000) &&
+		     work_format == AUDIO_S32SYS ) {
+			cvt->filters[cvt->filter_index++] = SDL_ConvertEndian;
+		} else if ( src_format != work_format ) {
+			cvt->filters[cvt->filter_index++] = SDL_ConvertToFloat;
+			cvt->len_mult *= 4 / width;
+			cvt->len_ratio *= 4.0 / width;
+		}
+	} else {
+		/* First filter:  Endian conversion from src to dst */
+		if ( (src_format & 0x1000) != (dst_format & 0x1000)
+		     && ((src_format & 0xff) == 16) && ((dst_format & 0xff) == 16)) {
+			cvt->filters[cvt->filter_index++] = SDL_ConvertEndian;
+		}
+
+		/* Second filter: Sign conversion -- signed/unsigned */
+		if ( (src_format & 0x8000) != (dst_format & 0x8000) ) {
+			cvt->filters[cvt->filter_index++] = SDL_ConvertSign;
+		}
+
+		/* Next filter:  Convert 16 bit <--> 8 bit PCM */
+		if ( (src_format & 0xFF) != (dst_format & 0xFF) ) {
+			switch (dst_format&0x10FF) {
+				case AUDIO_U8:
+					cvt->filters[cvt->filter_index++] =
+								 SDL_Convert8;
+					cvt->len_ratio /= 2;
+					break;
+				case AUDIO_U16LSB:
+					cvt->filters[cvt->filter_index++] =
+								SDL_Convert16LSB;
+					cvt->len_mult *= 2;
+					cvt->len_ratio *= 2;
+					break;
+				case AUDIO_U16MSB:
+					cvt->filters[cvt->filter_index++] =
+								SDL_Convert16MSB;
+					cvt->len_mult *= 2;
+					cvt->len_ratio *= 2;
+					break;
+			}
 		}
 	}
 
@@ -1415,7 +2094,7 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 			cvt->filters[cvt->filter_index++] =
 						 SDL_ConvertStrip_2;
 			src_channels = 4;
-			cvt->len_ratio /= 2;
+			cvt->len_ratio = (cvt->len_ratio * 2) / 3;
 		}
 		/* This assumes that 4 channel audio is in the format:
 		     Left {front/back} + Right {front/back}
@@ -1436,64 +2115,34 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 	/* Do rate conversion */
 	cvt->rate_incr = 0.0;
 	if ( (src_rate/100) != (dst_rate/100) ) {
-		Uint32 hi_rate, lo_rate;
-		int len_mult;
-		double len_ratio;
-		void (SDLCALL *rate_cvt)(SDL_AudioCVT *cvt, Uint16 format);
-
-		if ( src_rate > dst_rate ) {
-			hi_rate = src_rate;
-			lo_rate = dst_rate;
-			switch (src_channels) {
-				case 1: rate_cvt = SDL_RateDIV2; break;
-				case 2: rate_cvt = SDL_RateDIV2_c2; break;
-				case 4: rate_cvt = SDL_RateDIV2_c4; break;
-				case 6: rate_cvt = SDL_RateDIV2_c6; break;
-				default: return -1;
-			}
-			len_mult = 1;
-			len_ratio = 0.5;
-		} else {
-			hi_rate = dst_rate;
-			lo_rate = src_rate;
-			switch (src_channels) {
-				case 1: rate_cvt = SDL_RateMUL2; break;
-				case 2: rate_cvt = SDL_RateMUL2_c2; break;
-				case 4: rate_cvt = SDL_RateMUL2_c4; break;
-				case 6: rate_cvt = SDL_RateMUL2_c6; break;
-				default: return -1;
-			}
-			len_mult = 2;
-			len_ratio = 2.0;
-		}
-		/* If hi_rate = lo_rate*2^x then conversion is easy */
-		while ( ((lo_rate*2)/100) <= (hi_rate/100) ) {
-			cvt->filters[cvt->filter_index++] = rate_cvt;
-			cvt->len_mult *= len_mult;
-			lo_rate *= 2;
-			cvt->len_ratio *= len_ratio;
-		}
-		/* We may need a slow conversion here to finish up */
-		if ( (lo_rate/100) != (hi_rate/100) ) {
-#if 1
-			/* The problem with this is that if the input buffer is
-			   say 1K, and the conversion rate is say 1.1, then the
-			   output buffer is 1.1K, which may not be an acceptable
-			   buffer size for the audio driver (not a power of 2)
-			*/
-			/* For now, punt and hope the rate distortion isn't great.
-			*/
-#else
-			if ( src_rate < dst_rate ) {
-				cvt->rate_incr = (double)lo_rate/hi_rate;
-				cvt->len_mult *= 2;
-				cvt->len_ratio /= cvt->rate_incr;
-			} else {
-				cvt->rate_incr = (double)hi_rate/lo_rate;
-				cvt->len_ratio *= cvt->rate_incr;
-			}
-			cvt->filters[cvt->filter_index++] = SDL_RateSLOW;
-#endif
+		int chans;
+
+		switch (src_channels) {
+			case 1: chans = 0; break;
+			case 2: chans = 1; break;
+			case 4: chans = 2; break;
+			case 6: chans = 3; break;
+			default: return -1;
+		}
+		cvt->rate_incr = (double)src_rate / dst_rate;
+		cvt->filters[cvt->filter_index++] =
+				resamplers[chans][SDL_ResampleQuality()];
+		if ( dst_rate > src_rate ) {
+			cvt->len_mult *= (dst_rate + src_rate - 1) / src_rate;
+		}
+		cvt->len_ratio /= cvt->rate_incr;
+	}
+
+	/* Back from the 32-bit working format */
+	if ( work_format ) {
+		const int width = (dst_format & 0xFF) / 8;
+
+		if ( dst_format == (work_format ^ 0x1000) &&
+		     work_format == AUDIO_S32SYS ) {
+			cvt->filters[cvt->filter_index++] = SDL_ConvertEndian;
+		} else if ( dst_format != work_format ) {
+			cvt->filters[cvt->filter_index++] = SDL_ConvertFromFloat;
+			cvt->len_ratio *= width / 4.0;
 		}
 	}
 
@@ -1508,3 +2157,422 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 	}
 	return(cvt->needed);
 }
+
+/* Streaming conversion.
+
+   Input is converted a chunk of at most STREAM_CHUNK_FRAMES at a time.
+   The format and channel changes are done by an SDL_AudioCVT in a work
+   buffer.  Without a rate change the result goes straight into the output
+   ring buffer.  With one, the CVT produces AUDIO_S16SYS, or AUDIO_F32SYS
+   if either end has 32-bit samples, which is unpacked into a history of
+   float frames.  The resampler then reads that history, and its output is
+   packed into the ring buffer.  The history keeps the
+   frames the filter still needs, so consecutive chunks join up exactly,
+   and all the buffers are sized when the stream is made except the ring.
+   The ring only grows if the caller lets converted audio pile up.
+*/
+#define STREAM_CHUNK_FRAMES	1024
+
+struct SDL_AudioStream {
+	SDL_AudioCVT cvt;
+	Uint16 mid_format;
+	Uint16 dst_format;
+	int dst_channels;
+	int src_rate, dst_rate;
+	int src_frame, dst_frame;
+
+	/* Input not yet converted, less than a frame */
+	Uint8 partial[32];
+	int partial_len;
+	Uint8 *work;
+
+	/* Resampler state, the next output frame is at ipos+frac/dst_rate */
+	int resampling;
+	const SDL_ResampleFilter *filter;
+	SDL_ResampleFrameFunc frame;
+	double step;
+	int taps;
+	float *history;
+	int history_len, history_max;
+	int ipos;
+	int frac;
+	float *out;
+	int out_max;
+	float *coef;
+	Uint8 *packed;
+
+	/* Converted audio waiting to be read */
+	Uint8 *ring;
+	int ring_size, ring_head, ring_len;
+};
+
+static void SDL_ResetAudioStreamHistory(SDL_AudioStream *stream)
+{
+	if ( stream->resampling ) {
+		/* Start with silence before the first frame */
+		stream->history_len = stream->taps / 2;
+		SDL_memset(stream->history, 0, stream->history_len *
+		           stream->dst_channels * sizeof(float));
+		stream->ipos = stream->history_len;
+		stream->frac = 0;
+	}
+}
+
+SDL_AudioStream *SDL_NewAudioStream(Uint16 src_format, Uint8 src_channels,
+                                    int src_rate, Uint16 dst_format,
+                                    Uint8 dst_channels, int dst_rate)
+{
+	SDL_AudioStream *stream;
+	Uint16 mid_format;
+	int mid_frame;
+
+	if ( src_channels == 0 || dst_channels == 0 ||
+	     src_rate <= 0 || dst_rate <= 0 ) {
+		SDL_SetError("Invalid audio stream parameters");
+		return(NULL);
+	}
+	stream = (SDL_AudioStream *)SDL_malloc(sizeof(*stream));
+	if ( stream == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_memset(stream, 0, sizeof(*stream));
+	stream->dst_format = dst_format;
+	stream->dst_channels = dst_channels;
+	stream->src_rate = src_rate;
+	stream->dst_rate = dst_rate;
+	stream->src_frame = ((src_format & 0xFF) / 8) * src_channels;
+	stream->dst_frame = ((dst_format & 0xFF) / 8) * dst_channels;
+	if ( stream->src_frame > (int)sizeof(stream->partial) ) {
+		SDL_SetError("Too many audio channels");
+		SDL_free(stream);
+		return(NULL);
+	}
+	stream->resampling = ((src_rate/100) != (dst_rate/100));
+
+	/* The CVT does everything but the rate */
+	if ( !stream->resampling ) {
+		mid_format = dst_format;
+	} else if ( (src_format & 0xFF) == 32 || (dst_format & 0xFF) == 32 ) {
+		mid_format = AUDIO_F32SYS;
+	} else {
+		mid_format = AUDIO_S16SYS;
+	}
+	stream->mid_format = mid_format;
+	mid_frame = ((mid_format & 0xFF) / 8) * dst_channels;
+	if ( SDL_BuildAudioCVT(&stream->cvt, src_format, src_channels, src_rate,
+	                       mid_format, dst_channels, src_rate) < 0 ||
+	     (int)(stream->src_frame * stream->cvt.len_ratio + 0.5) != mid_frame ) {
+		SDL_SetError("Unsupported audio stream conversion");
+		SDL_FreeAudioStream(stream);
+		return(NULL);
+	}
+	stream->work = (Uint8 *)SDL_malloc(STREAM_CHUNK_FRAMES *
+	                        stream->src_frame * stream->cvt.len_mult);
+
+	if ( stream->resampling ) {
+		const int quality = SDL_ResampleQuality();
+
+		switch (dst_channels) {
+			case 1: case 2: case 4: case 6: break;
+			default:
+				SDL_SetError("Can't convert the rate of %d channels",
+				             dst_channels);
+				SDL_FreeAudioStream(stream);
+				return(NULL);
+		}
+		stream->filter = &resample_filters[quality];
+		stream->frame = SDL_GetResampleFrame(dst_channels);
+		stream->step = (double)src_rate / dst_rate;
+		stream->taps = stream->filter->zero_crossings * 2;
+		if ( stream->step > 1.0 && quality > 0 ) {
+			stream->taps = (int)(stream->filter->zero_crossings *
+			                     stream->step + 0.999) * 2;
+		}
+		stream->history_max = STREAM_CHUNK_FRAMES + stream->taps * 2;
+		stream->out_max = (int)((STREAM_CHUNK_FRAMES + stream->taps) /
+		                        stream->step) + 2;
+		stream->history = (float *)SDL_malloc(stream->history_max *
+		                          dst_channels * sizeof(float));
+		stream->out = (float *)SDL_malloc(stream->out_max *
+		                          dst_channels * sizeof(float));
+		stream->coef = (float *)SDL_malloc(stream->taps * sizeof(float));
+		stream->packed = (Uint8 *)SDL_malloc(stream->out_max *
+		                                     stream->dst_frame);
+		if ( !stream->history || !stream->out ||
+		     !stream->coef || !stream->packed ) {
+			SDL_FreeAudioStream(stream);
+			SDL_OutOfMemory();
+			return(NULL);
+		}
+	}
+
+	stream->ring_size = STREAM_CHUNK_FRAMES * 2 * stream->dst_frame;
+	stream->ring = (Uint8 *)SDL_malloc(stream->ring_size);
+	if ( !stream->work || !stream->ring ) {
+		SDL_FreeAudioStream(stream);
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_ResetAudioStreamHistory(stream);
+	return(stream);
+}
+
+static int SDL_AudioStreamWriteRing(SDL_AudioStream *stream,
+                                    const Uint8 *data, int len)
+{
+	int tail, chunk;
+
+	if ( stream->ring_len + len > stream->ring_size ) {
+		/* The reader is behind, make room and straighten the ring */
+		int size = stream->ring_size * 2;
+		Uint8 *ring;
+
+		while ( size < stream->ring_len + len ) {
+			size *= 2;
+		}
+		ring = (Uint8 *)SDL_malloc(size);
+		if ( ring == NULL ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		chunk = stream->ring_size - stream->ring_head;
+		if ( chunk > stream->ring_len ) {
+			chunk = stream->ring_len;
+		}
+		SDL_memcpy(ring, stream->ring + stream->ring_head, chunk);
+		SDL_memcpy(ring + chunk, stream->ring, stream->ring_len - chunk);
+		SDL_free(stream->ring);
+		stream->ring = ring;
+		stream->ring_size = size;
+		stream->ring_head = 0;
+	}
+
+	tail = (stream->ring_head + stream->ring_len) % stream->ring_size;
+	chunk = stream->ring_size - tail;
+	if ( chunk > len ) {
+		chunk = len;
+	}
+	SDL_memcpy(stream->ring + tail, data, chunk);
+	SDL_memcpy(stream->ring, data + chunk, len - chunk);
+	stream->ring_len += len;
+	return(0);
+}
+
+/* Run the resampler over the history and keep what it will need again */
+static int SDL_AudioStreamResample(SDL_AudioStream *stream)
+{
+	const int chans = stream->dst_channels;
+	const int reach = stream->taps / 2;
+	int count, drop;
+
+	do {
+		count = 0;
+		while ( stream->ipos + reach < stream->history_len &&
+		        count < stream->out_max ) {
+			int first = SDL_ResampleTaps(stream->filter, stream->ipos,
+			                 (double)stream->frac / stream->dst_rate,
+			                 stream->step, stream->coef, stream->taps);
+
+			stream->frame(&stream->out[count * chans],
+			              &stream->history[first * chans],
+			              stream->coef, stream->taps);
+			++count;
+
+			stream->frac += stream->src_rate;
+			stream->ipos += stream->frac / stream->dst_rate;
+			stream->frac %= stream->dst_rate;
+		}
+		if ( count > 0 ) {
+			SDL_PackSamples(stream->packed, stream->out,
+			                count * chans, stream->dst_format);
+			if ( SDL_AudioStreamWriteRing(stream, stream->packed,
+			                      count * stream->dst_frame) < 0 ) {
+				return(-1);
+			}
+		}
+	} while ( count == stream->out_max );
+
+	drop = stream->ipos - reach;
+	if ( drop > stream->history_len ) {
+		drop = stream->history_len;
+	}
+	if ( drop > 0 ) {
+		SDL_memmove(stream->history, &stream->history[drop * chans],
+		            (stream->history_len - drop) * chans * sizeof(float));
+		stream->history_len -= drop;
+		stream->ipos -= drop;
+	}
+	return(0);
+}
+
+/* Convert whole frames from the work buffer */
+static int SDL_AudioStreamConvert(SDL_AudioStream *stream, int frames)
+{
+	SDL_AudioCVT *cvt = &stream->cvt;
+	int width;
+
+	cvt->buf = stream->work;
+	cvt->len = frames * stream->src_frame;
+	if ( cvt->needed ) {
+		SDL_ConvertAudio(cvt);
+	} else {
+		cvt->len_cvt = cvt->len;
+	}
+	if ( !stream->resampling ) {
+		return SDL_AudioStreamWriteRing(stream, stream->work, cvt->len_cvt);
+	}
+
+	width = (stream->mid_format & 0xFF) / 8;
+	SDL_UnpackSamples(&stream->history[stream->history_len *
+	                                   stream->dst_channels],
+	                  stream->work, cvt->len_cvt / width,
+	                  stream->mid_format);
+	stream->history_len += cvt->len_cvt / (width * stream->dst_channels);
+	return SDL_AudioStreamResample(stream);
+}
+
+int SDL_AudioStreamPut(SDL_AudioStream *stream, const void *buf, int len)
+{
+	const Uint8 *data = (const Uint8 *)buf;
+	const int frame = stream->src_frame;
+
+	if ( len < 0 || (len > 0 && buf == NULL) ) {
+		SDL_SetError("Invalid audio stream data");
+		return(-1);
+	}
+
+	while ( len > 0 ) {
+		int frames = 0;
+		int size;
+
+		/* Finish off a frame left over from last time */
+		if ( stream->partial_len > 0 ) {
+			size = frame - stream->partial_len;
+			if ( size > len ) {
+				size = len;
+			}
+			SDL_memcpy(stream->partial + stream->partial_len, data, size);
+			stream->partial_len += size;
+			data += size;
+			len -= size;
+			if ( stream->partial_len < frame ) {
+				break;
+			}
+			SDL_memcpy(stream->work, stream->partial, frame);
+			stream->partial_len = 0;
+			frames = 1;
+		}
+
+		size = (STREAM_CHUNK_FRAMES - frames) * frame;
+		if ( size > len - (len % frame) ) {
+			size = len - (len % frame);
+		}
+		SDL_memcpy(stream->work + frames * frame, data, size);
+		frames += size / frame;
+		data += size;
+		len -= size;
+
+		if ( frames > 0 && SDL_AudioStreamConvert(stream, frames) < 0 ) {
+			return(-1);
+		}
+		if ( len > 0 && len < frame ) {
+			SDL_memcpy(stream->partial, data, len);
+			stream->partial_len = len;
+			break;
+		}
+	}
+	return(0);
+}
+
+int SDL_AudioStreamFlush(SDL_AudioStream *stream)
+{
+	int pad;
+
+	if ( !stream->resampling ) {
+		return(0);
+	}
+
+	/* Run silence in after the end of the input */
+	for ( pad = stream->taps / 2; pad > 0; ) {
+		int frames = stream->history_max - stream->history_len;
+
+		if ( frames > pad ) {
+			frames = pad;
+		}
+		SDL_memset(&stream->history[stream->history_len *
+		                            stream->dst_channels], 0,
+		           frames * stream->dst_channels * sizeof(float));
+		stream->history_len += frames;
+		pad -= frames;
+		if ( SDL_AudioStreamResample(stream) < 0 ) {
+			return(-1);
+		}
+	}
+	/* Keep the output lined up with the input from here on */
+	SDL_ResetAudioStreamHistory(stream);
+	return(0);
+}
+
+int SDL_AudioStreamGet(SDL_AudioStream *stream, void *buf, int len)
+{
+	Uint8 *data = (Uint8 *)buf;
+	int chunk;
+
+	if ( len < 0 || (len > 0 && buf == NULL) ) {
+		SDL_SetError("Invalid audio stream buffer");
+		return(-1);
+	}
+	if ( len > stream->ring_len ) {
+		len = stream->ring_len;
+	}
+	len -= (len % stream->dst_frame);
+
+	chunk = stream->ring_size - stream->ring_head;
+	if ( chunk > len ) {
+		chunk = len;
+	}
+	SDL_memcpy(data, stream->ring + stream->ring_head, chunk);
+	SDL_memcpy(data + chunk, stream->ring, len - chunk);
+	stream->ring_head = (stream->ring_head + len) % stream->ring_size;
+	stream->ring_len -= len;
+	return(len);
+}
+
+int SDL_AudioStreamAvailable(SDL_AudioStream *stream)
+{
+	return(stream->ring_len);
+}
+
+void SDL_AudioStreamClear(SDL_AudioStream *stream)
+{
+	stream->partial_len = 0;
+	stream->ring_head = 0;
+	stream->ring_len = 0;
+	SDL_ResetAudioStreamHistory(stream);
+}
+
+void SDL_FreeAudioStream(SDL_AudioStream *stream)
+{
+	if ( stream ) {
+		if ( stream->work ) {
+			SDL_free(stream->work);
+		}
+		if ( stream->history ) {
+			SDL_free(stream->history);
+		}
+		if ( stream->out ) {
+			SDL_free(stream->out);
+		}
+		if ( stream->coef ) {
+			SDL_free(stream->coef);
+		}
+		if ( stream->packed ) {
+			SDL_free(stream->packed);
+		}
+		if ( stream->ring ) {
+			SDL_free(stream->ring);
+		}
+		SDL_free(stream);
+	}
+}
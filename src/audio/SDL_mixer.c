@@ -30,7 +30,9 @@
 #include "SDL_mixer_MMX.h"
 #include "SDL_mixer_MMX_VC.h"
 #include "SDL_mixer_m68k.h"
+#include "../cpuinfo/SDL_simd.h"
 
+#if defined(__GNUC__) && defined(__M68000__) && defined(SDL_ASSEMBLY_ROUTINES)
 /* This table is used to add two sound values together and pin
  * the value to avoid overflow.  (used with permission from ARDI)
  * Changed to use 0xFE instead of 0xFF for better sound quality.
@@ -85,180 +87,709 @@ static const Uint8 mix8[] =
   0xFE, 0xFE, 0xFE, 0xFE, 0xFE, 0xFE, 0xFE, 0xFE, 0xFE, 0xFE, 0xFE,
   0xFE, 0xFE, 0xFE, 0xFE, 0xFE, 0xFE
 };
+#endif /* __M68000__ */
 
 /* The volume ranges from 0 - 128 */
 #define ADJUST_VOLUME(s, v)	(s = (s*v)/SDL_MIX_MAXVOLUME)
 #define ADJUST_VOLUME_U8(s, v)	(s = (((s-128)*v)/SDL_MIX_MAXVOLUME)+128)
 
-void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+/* Mixing several sources at once.
+
+   Each block of destination samples is read once, every source is added
+   to it at its volume and the sum is clipped once and written back.  The
+   C versions mix samples start to end, the SIMD versions mix as many whole
+   vectors as they can from the start and return how many samples that
+   was, leaving the rest to C.  Scaling by the volume rounds towards zero
+   like ADJUST_VOLUME, so one source at a time gives the same result as
+   the old mixers.  8-bit sums are kept in 16 bits, which saturate well
+   outside the 8-bit range.
+*/
+#define MIX_SWAP16(x)	((Uint16)(((x) << 8) | ((x) >> 8)))
+
+static void SDL_MixS16_C(Uint8 *dst, const Uint8 **srcs, const int *volumes,
+                         int count, Uint32 start, Uint32 end, int swap)
 {
-	Uint16 format;
+	const int max_audioval = ((1<<(16-1))-1);
+	const int min_audioval = -(1<<(16-1));
+	Uint32 i;
+	int n;
 
-	if ( volume == 0 ) {
-		return;
+	for ( i = start; i < end; ++i ) {
+		Uint16 sample = ((Uint16 *)dst)[i];
+		int dst_sample = (Sint16)(swap ? MIX_SWAP16(sample) : sample);
+
+		for ( n = 0; n < count; ++n ) {
+			int src_sample;
+
+			sample = ((const Uint16 *)srcs[n])[i];
+			src_sample = (Sint16)(swap ? MIX_SWAP16(sample) : sample);
+			dst_sample += ADJUST_VOLUME(src_sample, volumes[n]);
+		}
+		if ( dst_sample > max_audioval ) {
+			dst_sample = max_audioval;
+		} else
+		if ( dst_sample < min_audioval ) {
+			dst_sample = min_audioval;
+		}
+		sample = (Uint16)dst_sample;
+		((Uint16 *)dst)[i] = swap ? MIX_SWAP16(sample) : sample;
 	}
-	/* Mix the user-level audio format */
-	if ( current_audio ) {
-		if ( current_audio->convert.needed ) {
-			format = current_audio->convert.src_format;
-		} else {
-			format = current_audio->spec.format;
+}
+
+/* Unsigned samples are mixed around 128 and pinned below 0xFF, like mix8 */
+static void SDL_Mix8_C(Uint8 *dst, const Uint8 **srcs, const int *volumes,
+                       int count, Uint32 start, Uint32 end, int is_unsigned)
+{
+	const int bias = is_unsigned ? 128 : 0;
+	const int max_audioval = is_unsigned ? 126 : 127;
+	const int min_audioval = -128;
+	Uint32 i;
+	int n;
+
+	for ( i = start; i < end; ++i ) {
+		int dst_sample = is_unsigned ? (dst[i] - bias) : (Sint8)dst[i];
+
+		for ( n = 0; n < count; ++n ) {
+			int src_sample = is_unsigned ? (srcs[n][i] - bias) :
+			                               (Sint8)srcs[n][i];
+			dst_sample += ADJUST_VOLUME(src_sample, volumes[n]);
 		}
-	} else {
-  		/* HACK HACK HACK */
-		format = AUDIO_S16;
+		if ( dst_sample > max_audioval ) {
+			dst_sample = max_audioval;
+		} else
+		if ( dst_sample < min_audioval ) {
+			dst_sample = min_audioval;
+		}
+		dst[i] = (Uint8)(dst_sample + bias);
 	}
-	switch (format) {
+}
 
-		case AUDIO_U8: {
-#if defined(__GNUC__) && defined(__M68000__) && defined(SDL_ASSEMBLY_ROUTINES)
-			SDL_MixAudio_m68k_U8((char*)dst,(char*)src,(unsigned long)len,(long)volume,(char *)mix8);
+/* 32-bit sums are kept in 64 bits, or doubles without a 64-bit type */
+static void SDL_MixS32_C(Uint8 *dst, const Uint8 **srcs, const int *volumes,
+                         int count, Uint32 start, Uint32 end, int swap)
+{
+#ifdef SDL_HAS_64BIT_TYPE
+	typedef Sint64 mix_t;
 #else
-			Uint8 src_sample;
-
-			while ( len-- ) {
-				src_sample = *src;
-				ADJUST_VOLUME_U8(src_sample, volume);
-				*dst = mix8[*dst+src_sample];
-				++dst;
-				++src;
-			}
+	typedef double mix_t;
 #endif
+	const mix_t max_audioval = 2147483647;
+	const mix_t min_audioval = -max_audioval - 1;
+	Uint32 i;
+	int n;
+
+	for ( i = start; i < end; ++i ) {
+		Uint32 sample = ((Uint32 *)dst)[i];
+		mix_t dst_sample = (Sint32)(swap ? SDL_Swap32(sample) : sample);
+
+		for ( n = 0; n < count; ++n ) {
+			mix_t src_sample;
+
+			sample = ((const Uint32 *)srcs[n])[i];
+			src_sample = (Sint32)(swap ? SDL_Swap32(sample) : sample);
+			dst_sample += ADJUST_VOLUME(src_sample, volumes[n]);
 		}
-		break;
+		if ( dst_sample > max_audioval ) {
+			dst_sample = max_audioval;
+		} else
+		if ( dst_sample < min_audioval ) {
+			dst_sample = min_audioval;
+		}
+		sample = (Uint32)(Sint32)dst_sample;
+		((Uint32 *)dst)[i] = swap ? SDL_Swap32(sample) : sample;
+	}
+}
+
+static float SDL_MixSwapFloat(float x)
+{
+	union { float f; Uint32 u; } swapper;
+
+	swapper.f = x;
+	swapper.u = SDL_Swap32(swapper.u);
+	return(swapper.f);
+}
 
-		case AUDIO_S8: {
-#if defined(SDL_BUGGY_MMX_MIXERS) /* buggy, so we're disabling them. --ryan. */
-#if defined(__GNUC__) && defined(__i386__) && defined(SDL_ASSEMBLY_ROUTINES)
-			if (SDL_HasMMX())
-			{
-				SDL_MixAudio_MMX_S8((char*)dst,(char*)src,(unsigned int)len,(int)volume);
+static void SDL_MixF32_C(Uint8 *dst, const Uint8 **srcs, const int *volumes,
+                         int count, Uint32 start, Uint32 end, int swap)
+{
+	const float scale = 1.0f / SDL_MIX_MAXVOLUME;
+	Uint32 i;
+	int n;
+
+	for ( i = start; i < end; ++i ) {
+		float sample = ((float *)dst)[i];
+
+		if ( swap ) {
+			sample = SDL_MixSwapFloat(sample);
+		}
+		for ( n = 0; n < count; ++n ) {
+			float src_sample = ((const float *)srcs[n])[i];
+
+			if ( swap ) {
+				src_sample = SDL_MixSwapFloat(src_sample);
 			}
-			else
-#elif ((defined(_MSC_VER) && defined(_M_IX86)) || defined(__WATCOMC__)) && defined(SDL_ASSEMBLY_ROUTINES)
-			if (SDL_HasMMX())
-			{
-				SDL_MixAudio_MMX_S8_VC((char*)dst,(char*)src,(unsigned int)len,(int)volume);
+			sample += src_sample * (volumes[n] * scale);
+		}
+		if ( sample > 1.0f ) {
+			sample = 1.0f;
+		} else if ( sample < -1.0f ) {
+			sample = -1.0f;
+		}
+		((float *)dst)[i] = swap ? SDL_MixSwapFloat(sample) : sample;
+	}
+}
+
+#if SDL_SSE2_INTRINSICS
+/* (x * v) / 128 for 16-bit samples, as two vectors of 32-bit products */
+#define MIX_SSE2_SCALE16(x, v, lo, hi) do { \
+	__m128i mlo = _mm_mullo_epi16(x, v); \
+	__m128i mhi = _mm_mulhi_epi16(x, v); \
+	lo = _mm_unpacklo_epi16(mlo, mhi); \
+	hi = _mm_unpackhi_epi16(mlo, mhi); \
+	lo = _mm_srai_epi32(_mm_add_epi32(lo, _mm_srli_epi32(_mm_srai_epi32(lo, 31), 25)), 7); \
+	hi = _mm_srai_epi32(_mm_add_epi32(hi, _mm_srli_epi32(_mm_srai_epi32(hi, 31), 25)), 7); \
+} while (0)
+
+static Uint32 SDL_TARGETING("sse2") SDL_MixS16_SSE2(Uint8 *dst,
+	const Uint8 **srcs, const int *volumes, int count, Uint32 samples,
+	int swap)
+{
+	Uint32 i;
+	int n;
+
+	for ( i = 0; i + 8 <= samples; i += 8 ) {
+		__m128i d = _mm_loadu_si128((__m128i *)&((Uint16 *)dst)[i]);
+		__m128i lo, hi;
+
+		if ( swap ) {
+			d = _mm_or_si128(_mm_slli_epi16(d, 8), _mm_srli_epi16(d, 8));
+		}
+		lo = _mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16);
+		hi = _mm_srai_epi32(_mm_unpackhi_epi16(d, d), 16);
+		for ( n = 0; n < count; ++n ) {
+			__m128i s = _mm_loadu_si128((const __m128i *)&((const Uint16 *)srcs[n])[i]);
+			__m128i slo, shi;
+
+			if ( swap ) {
+				s = _mm_or_si128(_mm_slli_epi16(s, 8), _mm_srli_epi16(s, 8));
 			}
-			else
-#endif
-#endif
+			MIX_SSE2_SCALE16(s, _mm_set1_epi16((short)volumes[n]), slo, shi);
+			lo = _mm_add_epi32(lo, slo);
+			hi = _mm_add_epi32(hi, shi);
+		}
+		d = _mm_packs_epi32(lo, hi);
+		if ( swap ) {
+			d = _mm_or_si128(_mm_slli_epi16(d, 8), _mm_srli_epi16(d, 8));
+		}
+		_mm_storeu_si128((__m128i *)&((Uint16 *)dst)[i], d);
+	}
+	return(i);
+}
 
-#if defined(__GNUC__) && defined(__M68000__) && defined(SDL_ASSEMBLY_ROUTINES)
-			SDL_MixAudio_m68k_S8((char*)dst,(char*)src,(unsigned long)len,(long)volume);
-#else
-			{
-			Sint8 *dst8, *src8;
-			Sint8 src_sample;
-			int dst_sample;
-			const int max_audioval = ((1<<(8-1))-1);
-			const int min_audioval = -(1<<(8-1));
-
-			src8 = (Sint8 *)src;
-			dst8 = (Sint8 *)dst;
-			while ( len-- ) {
-				src_sample = *src8;
-				ADJUST_VOLUME(src_sample, volume);
-				dst_sample = *dst8 + src_sample;
-				if ( dst_sample > max_audioval ) {
-					*dst8 = max_audioval;
-				} else
-				if ( dst_sample < min_audioval ) {
-					*dst8 = min_audioval;
-				} else {
-					*dst8 = dst_sample;
-				}
-				++dst8;
-				++src8;
+static Uint32 SDL_TARGETING("sse2") SDL_Mix8_SSE2(Uint8 *dst,
+	const Uint8 **srcs, const int *volumes, int count, Uint32 samples,
+	int is_unsigned)
+{
+	const __m128i bias = _mm_set1_epi8(is_unsigned ? (char)0x80 : 0);
+	const __m128i max = _mm_set1_epi16(is_unsigned ? 126 : 127);
+	Uint32 i;
+	int n;
+
+	/* Unsigned samples become signed by flipping the top bit */
+	for ( i = 0; i + 16 <= samples; i += 16 ) {
+		__m128i d = _mm_xor_si128(_mm_loadu_si128((__m128i *)&dst[i]), bias);
+		__m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(d, d), 8);
+		__m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(d, d), 8);
+
+		for ( n = 0; n < count; ++n ) {
+			__m128i s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&srcs[n][i]), bias);
+			__m128i v = _mm_set1_epi16((short)volumes[n]);
+			__m128i slo = _mm_mullo_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(s, s), 8), v);
+			__m128i shi = _mm_mullo_epi16(_mm_srai_epi16(_mm_unpackhi_epi8(s, s), 8), v);
+
+			slo = _mm_srai_epi16(_mm_add_epi16(slo, _mm_srli_epi16(_mm_srai_epi16(slo, 15), 9)), 7);
+			shi = _mm_srai_epi16(_mm_add_epi16(shi, _mm_srli_epi16(_mm_srai_epi16(shi, 15), 9)), 7);
+			lo = _mm_adds_epi16(lo, slo);
+			hi = _mm_adds_epi16(hi, shi);
+		}
+		lo = _mm_min_epi16(lo, max);
+		hi = _mm_min_epi16(hi, max);
+		d = _mm_xor_si128(_mm_packs_epi16(lo, hi), bias);
+		_mm_storeu_si128((__m128i *)&dst[i], d);
+	}
+	return(i);
+}
+
+/* 32-bit samples are scaled and summed as doubles, which hold them exactly */
+static Uint32 SDL_TARGETING("sse2") SDL_MixS32_SSE2(Uint8 *dst,
+	const Uint8 **srcs, const int *volumes, int count, Uint32 samples,
+	int swap)
+{
+	const __m128d max = _mm_set1_pd(2147483647.0);
+	const __m128d min = _mm_set1_pd(-2147483648.0);
+	Uint32 i;
+	int n;
+
+	for ( i = 0; i + 4 <= samples; i += 4 ) {
+		__m128i d = _mm_loadu_si128((__m128i *)&((Uint32 *)dst)[i]);
+		__m128d lo, hi;
+
+		if ( swap ) {
+			d = _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, 0xB1), 0xB1);
+			d = _mm_or_si128(_mm_slli_epi16(d, 8), _mm_srli_epi16(d, 8));
+		}
+		lo = _mm_cvtepi32_pd(d);
+		hi = _mm_cvtepi32_pd(_mm_srli_si128(d, 8));
+		for ( n = 0; n < count; ++n ) {
+			__m128i s = _mm_loadu_si128((const __m128i *)&((const Uint32 *)srcs[n])[i]);
+			__m128d v = _mm_set1_pd(volumes[n] / (double)SDL_MIX_MAXVOLUME);
+
+			if ( swap ) {
+				s = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xB1), 0xB1);
+				s = _mm_or_si128(_mm_slli_epi16(s, 8), _mm_srli_epi16(s, 8));
 			}
+			/* Round towards zero like ADJUST_VOLUME */
+			lo = _mm_add_pd(lo, _mm_cvtepi32_pd(_mm_cvttpd_epi32(
+			        _mm_mul_pd(_mm_cvtepi32_pd(s), v))));
+			hi = _mm_add_pd(hi, _mm_cvtepi32_pd(_mm_cvttpd_epi32(
+			        _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(s, 8)), v))));
+		}
+		lo = _mm_max_pd(_mm_min_pd(lo, max), min);
+		hi = _mm_max_pd(_mm_min_pd(hi, max), min);
+		d = _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+		if ( swap ) {
+			d = _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, 0xB1), 0xB1);
+			d = _mm_or_si128(_mm_slli_epi16(d, 8), _mm_srli_epi16(d, 8));
+		}
+		_mm_storeu_si128((__m128i *)&((Uint32 *)dst)[i], d);
+	}
+	return(i);
+}
+
+static Uint32 SDL_TARGETING("sse2") SDL_MixF32_SSE2(Uint8 *dst,
+	const Uint8 **srcs, const int *volumes, int count, Uint32 samples)
+{
+	const float scale = 1.0f / SDL_MIX_MAXVOLUME;
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 minus_one = _mm_set1_ps(-1.0f);
+	Uint32 i;
+	int n;
+
+	for ( i = 0; i + 4 <= samples; i += 4 ) {
+		__m128 d = _mm_loadu_ps(&((float *)dst)[i]);
+
+		for ( n = 0; n < count; ++n ) {
+			__m128 s = _mm_loadu_ps(&((const float *)srcs[n])[i]);
+			d = _mm_add_ps(d, _mm_mul_ps(s, _mm_set1_ps(volumes[n] * scale)));
+		}
+		d = _mm_max_ps(_mm_min_ps(d, one), minus_one);
+		_mm_storeu_ps(&((float *)dst)[i], d);
+	}
+	return(i);
+}
+#endif /* SDL_SSE2_INTRINSICS */
+
+#if SDL_AVX2_INTRINSICS
+/* The unpacks and packs work within 128-bit lanes, so they undo each other */
+#define MIX_AVX2_SCALE16(x, v, lo, hi) do { \
+	__m256i mlo = _mm256_mullo_epi16(x, v); \
+	__m256i mhi = _mm256_mulhi_epi16(x, v); \
+	lo = _mm256_unpacklo_epi16(mlo, mhi); \
+	hi = _mm256_unpackhi_epi16(mlo, mhi); \
+	lo = _mm256_srai_epi32(_mm256_add_epi32(lo, _mm256_srli_epi32(_mm256_srai_epi32(lo, 31), 25)), 7); \
+	hi = _mm256_srai_epi32(_mm256_add_epi32(hi, _mm256_srli_epi32(_mm256_srai_epi32(hi, 31), 25)), 7); \
+} while (0)
+
+static Uint32 SDL_TARGETING("avx2") SDL_MixS16_AVX2(Uint8 *dst,
+	const Uint8 **srcs, const int *volumes, int count, Uint32 samples,
+	int swap)
+{
+	const __m256i swap16 = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6,
+	                                        9, 8, 11, 10, 13, 12, 15, 14,
+	                                        1, 0, 3, 2, 5, 4, 7, 6,
+	                                        9, 8, 11, 10, 13, 12, 15, 14);
+	Uint32 i;
+	int n;
+
+	for ( i = 0; i + 16 <= samples; i += 16 ) {
+		__m256i d = _mm256_loadu_si256((__m256i *)&((Uint16 *)dst)[i]);
+		__m256i lo, hi;
+
+		if ( swap ) {
+			d = _mm256_shuffle_epi8(d, swap16);
+		}
+		lo = _mm256_srai_epi32(_mm256_unpacklo_epi16(d, d), 16);
+		hi = _mm256_srai_epi32(_mm256_unpackhi_epi16(d, d), 16);
+		for ( n = 0; n < count; ++n ) {
+			__m256i s = _mm256_loadu_si256((const __m256i *)&((const Uint16 *)srcs[n])[i]);
+			__m256i slo, shi;
+
+			if ( swap ) {
+				s = _mm256_shuffle_epi8(s, swap16);
 			}
-#endif
+			MIX_AVX2_SCALE16(s, _mm256_set1_epi16((short)volumes[n]), slo, shi);
+			lo = _mm256_add_epi32(lo, slo);
+			hi = _mm256_add_epi32(hi, shi);
 		}
-		break;
+		d = _mm256_packs_epi32(lo, hi);
+		if ( swap ) {
+			d = _mm256_shuffle_epi8(d, swap16);
+		}
+		_mm256_storeu_si256((__m256i *)&((Uint16 *)dst)[i], d);
+	}
+	return(i);
+}
+
+static Uint32 SDL_TARGETING("avx2") SDL_Mix8_AVX2(Uint8 *dst,
+	const Uint8 **srcs, const int *volumes, int count, Uint32 samples,
+	int is_unsigned)
+{
+	const __m256i bias = _mm256_set1_epi8(is_unsigned ? (char)0x80 : 0);
+	const __m256i max = _mm256_set1_epi16(is_unsigned ? 126 : 127);
+	Uint32 i;
+	int n;
+
+	for ( i = 0; i + 32 <= samples; i += 32 ) {
+		__m256i d = _mm256_xor_si256(_mm256_loadu_si256((__m256i *)&dst[i]), bias);
+		__m256i lo = _mm256_srai_epi16(_mm256_unpacklo_epi8(d, d), 8);
+		__m256i hi = _mm256_srai_epi16(_mm256_unpackhi_epi8(d, d), 8);
+
+		for ( n = 0; n < count; ++n ) {
+			__m256i s = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&srcs[n][i]), bias);
+			__m256i v = _mm256_set1_epi16((short)volumes[n]);
+			__m256i slo = _mm256_mullo_epi16(_mm256_srai_epi16(_mm256_unpacklo_epi8(s, s), 8), v);
+			__m256i shi = _mm256_mullo_epi16(_mm256_srai_epi16(_mm256_unpackhi_epi8(s, s), 8), v);
+
+			slo = _mm256_srai_epi16(_mm256_add_epi16(slo, _mm256_srli_epi16(_mm256_srai_epi16(slo, 15), 9)), 7);
+			shi = _mm256_srai_epi16(_mm256_add_epi16(shi, _mm256_srli_epi16(_mm256_srai_epi16(shi, 15), 9)), 7);
+			lo = _mm256_adds_epi16(lo, slo);
+			hi = _mm256_adds_epi16(hi, shi);
+		}
+		lo = _mm256_min_epi16(lo, max);
+		hi = _mm256_min_epi16(hi, max);
+		d = _mm256_xor_si256(_mm256_packs_epi16(lo, hi), bias);
+		_mm256_storeu_si256((__m256i *)&dst[i], d);
+	}
+	return(i);
+}
+
+static Uint32 SDL_TARGETING("avx2") SDL_MixS32_AVX2(Uint8 *dst,
+	const Uint8 **srcs, const int *volumes, int count, Uint32 samples,
+	int swap)
+{
+	const __m128i swap32 = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+	                                     11, 10, 9, 8, 15, 14, 13, 12);
+	const __m256d max = _mm256_set1_pd(2147483647.0);
+	const __m256d min = _mm256_set1_pd(-2147483648.0);
+	Uint32 i;
+	int n;
 
-		case AUDIO_S16LSB: {
-#if defined(SDL_BUGGY_MMX_MIXERS) /* buggy, so we're disabling them. --ryan. */
-#if defined(__GNUC__) && defined(__i386__) && defined(SDL_ASSEMBLY_ROUTINES)
-			if (SDL_HasMMX())
-			{
-				SDL_MixAudio_MMX_S16((char*)dst,(char*)src,(unsigned int)len,(int)volume);
+	for ( i = 0; i + 4 <= samples; i += 4 ) {
+		__m128i d = _mm_loadu_si128((__m128i *)&((Uint32 *)dst)[i]);
+		__m256d sum;
+
+		if ( swap ) {
+			d = _mm_shuffle_epi8(d, swap32);
+		}
+		sum = _mm256_cvtepi32_pd(d);
+		for ( n = 0; n < count; ++n ) {
+			__m128i s = _mm_loadu_si128((const __m128i *)&((const Uint32 *)srcs[n])[i]);
+			__m256d v = _mm256_set1_pd(volumes[n] / (double)SDL_MIX_MAXVOLUME);
+
+			if ( swap ) {
+				s = _mm_shuffle_epi8(s, swap32);
 			}
-                        else
-#elif ((defined(_MSC_VER) && defined(_M_IX86)) || defined(__WATCOMC__)) && defined(SDL_ASSEMBLY_ROUTINES)
-			if (SDL_HasMMX())
-			{
-				SDL_MixAudio_MMX_S16_VC((char*)dst,(char*)src,(unsigned int)len,(int)volume);
+			sum = _mm256_add_pd(sum, _mm256_cvtepi32_pd(_mm256_cvttpd_epi32(
+			        _mm256_mul_pd(_mm256_cvtepi32_pd(s), v))));
+		}
+		sum = _mm256_max_pd(_mm256_min_pd(sum, max), min);
+		d = _mm256_cvttpd_epi32(sum);
+		if ( swap ) {
+			d = _mm_shuffle_epi8(d, swap32);
+		}
+		_mm_storeu_si128((__m128i *)&((Uint32 *)dst)[i], d);
+	}
+	return(i);
+}
+
+static Uint32 SDL_TARGETING("avx2") SDL_MixF32_AVX2(Uint8 *dst,
+	const Uint8 **srcs, const int *volumes, int count, Uint32 samples)
+{
+	const float scale = 1.0f / SDL_MIX_MAXVOLUME;
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 minus_one = _mm256_set1_ps(-1.0f);
+	Uint32 i;
+	int n;
+
+	for ( i = 0; i + 8 <= samples; i += 8 ) {
+		__m256 d = _mm256_loadu_ps(&((float *)dst)[i]);
+
+		for ( n = 0; n < count; ++n ) {
+			__m256 s = _mm256_loadu_ps(&((const float *)srcs[n])[i]);
+			d = _mm256_add_ps(d, _mm256_mul_ps(s, _mm256_set1_ps(volumes[n] * scale)));
+		}
+		d = _mm256_max_ps(_mm256_min_ps(d, one), minus_one);
+		_mm256_storeu_ps(&((float *)dst)[i], d);
+	}
+	return(i);
+}
+#endif /* SDL_AVX2_INTRINSICS */
+
+#if SDL_NEON_INTRINSICS
+static __inline__ int32x4_t SDL_MixScaleNEON(int32x4_t x)
+{
+	/* Divide by 128, rounding towards zero */
+	uint32x4_t neg = vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(x, 31)), 25);
+	return vshrq_n_s32(vaddq_s32(x, vreinterpretq_s32_u32(neg)), 7);
+}
+
+static Uint32 SDL_MixS16_NEON(Uint8 *dst, const Uint8 **srcs,
+	const int *volumes, int count, Uint32 samples, int swap)
+{
+	Uint32 i;
+	int n;
+
+	for ( i = 0; i + 8 <= samples; i += 8 ) {
+		int16x8_t d = vld1q_s16((int16_t *)&((Uint16 *)dst)[i]);
+		int32x4_t lo, hi;
+
+		if ( swap ) {
+			d = vreinterpretq_s16_u8(vrev16q_u8(vreinterpretq_u8_s16(d)));
+		}
+		lo = vmovl_s16(vget_low_s16(d));
+		hi = vmovl_s16(vget_high_s16(d));
+		for ( n = 0; n < count; ++n ) {
+			int16x8_t s = vld1q_s16((const int16_t *)&((const Uint16 *)srcs[n])[i]);
+			int16x4_t v = vdup_n_s16((int16_t)volumes[n]);
+
+			if ( swap ) {
+				s = vreinterpretq_s16_u8(vrev16q_u8(vreinterpretq_u8_s16(s)));
 			}
-			else
+			lo = vaddq_s32(lo, SDL_MixScaleNEON(vmull_s16(vget_low_s16(s), v)));
+			hi = vaddq_s32(hi, SDL_MixScaleNEON(vmull_s16(vget_high_s16(s), v)));
+		}
+		d = vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi));
+		if ( swap ) {
+			d = vreinterpretq_s16_u8(vrev16q_u8(vreinterpretq_u8_s16(d)));
+		}
+		vst1q_s16((int16_t *)&((Uint16 *)dst)[i], d);
+	}
+	return(i);
+}
+
+static Uint32 SDL_Mix8_NEON(Uint8 *dst, const Uint8 **srcs,
+	const int *volumes, int count, Uint32 samples, int is_unsigned)
+{
+	const uint8x16_t bias = vdupq_n_u8(is_unsigned ? 0x80 : 0);
+	const int16x8_t max = vdupq_n_s16(is_unsigned ? 126 : 127);
+	Uint32 i;
+	int n;
+
+	for ( i = 0; i + 16 <= samples; i += 16 ) {
+		int8x16_t d = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(&dst[i]), bias));
+		int16x8_t lo = vmovl_s8(vget_low_s8(d));
+		int16x8_t hi = vmovl_s8(vget_high_s8(d));
+
+		for ( n = 0; n < count; ++n ) {
+			int8x16_t s = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(&srcs[n][i]), bias));
+			int16x8_t v = vdupq_n_s16((int16_t)volumes[n]);
+			int16x8_t slo = vmulq_s16(vmovl_s8(vget_low_s8(s)), v);
+			int16x8_t shi = vmulq_s16(vmovl_s8(vget_high_s8(s)), v);
+
+			slo = vshrq_n_s16(vaddq_s16(slo, vreinterpretq_s16_u16(vshrq_n_u16(vreinterpretq_u16_s16(vshrq_n_s16(slo, 15)), 9))), 7);
+			shi = vshrq_n_s16(vaddq_s16(shi, vreinterpretq_s16_u16(vshrq_n_u16(vreinterpretq_u16_s16(vshrq_n_s16(shi, 15)), 9))), 7);
+			lo = vqaddq_s16(lo, slo);
+			hi = vqaddq_s16(hi, shi);
+		}
+		d = vcombine_s8(vqmovn_s16(vminq_s16(lo, max)),
+		                vqmovn_s16(vminq_s16(hi, max)));
+		vst1q_u8(&dst[i], veorq_u8(vreinterpretq_u8_s8(d), bias));
+	}
+	return(i);
+}
+
+static Uint32 SDL_MixF32_NEON(Uint8 *dst, const Uint8 **srcs,
+	const int *volumes, int count, Uint32 samples)
+{
+	const float scale = 1.0f / SDL_MIX_MAXVOLUME;
+	const float32x4_t one = vdupq_n_f32(1.0f);
+	const float32x4_t minus_one = vdupq_n_f32(-1.0f);
+	Uint32 i;
+	int n;
+
+	for ( i = 0; i + 4 <= samples; i += 4 ) {
+		float32x4_t d = vld1q_f32(&((float *)dst)[i]);
+
+		for ( n = 0; n < count; ++n ) {
+			d = vmlaq_n_f32(d, vld1q_f32(&((const float *)srcs[n])[i]),
+			                volumes[n] * scale);
+		}
+		d = vmaxq_f32(vminq_f32(d, one), minus_one);
+		vst1q_f32(&((float *)dst)[i], d);
+	}
+	return(i);
+}
+#endif /* SDL_NEON_INTRINSICS */
+
+void SDL_MixAudioSources(Uint8 *dst, const Uint8 **srcs, const int *volumes,
+                         int count, Uint16 format, Uint32 len)
+{
+	Uint32 samples, done = 0;
+	int simd = 1;
+	int n;
+
+	/* The vector code needs volumes that fit its 16-bit multiplies */
+	for ( n = 0; n < count; ++n ) {
+		if ( volumes[n] < 0 || volumes[n] > SDL_MIX_MAXVOLUME ) {
+			simd = 0;
+		}
+	}
+	if ( count <= 0 ) {
+		return;
+	}
+
+	switch (format) {
+	    case AUDIO_U8:
+	    case AUDIO_S8: {
+		const int is_unsigned = (format == AUDIO_U8);
+
+		samples = len;
+#if SDL_AVX2_INTRINSICS
+		if ( simd && SDL_HasAVX2() ) {
+			done = SDL_Mix8_AVX2(dst, srcs, volumes, count, samples, is_unsigned);
+		} else
 #endif
+#if SDL_SSE2_INTRINSICS
+		if ( simd && SDL_HasSSE2() ) {
+			done = SDL_Mix8_SSE2(dst, srcs, volumes, count, samples, is_unsigned);
+		}
+#elif SDL_NEON_INTRINSICS
+		if ( simd && SDL_HasNEON() ) {
+			done = SDL_Mix8_NEON(dst, srcs, volumes, count, samples, is_unsigned);
+		}
 #endif
+		SDL_Mix8_C(dst, srcs, volumes, count, done, samples, is_unsigned);
+	    }
+		break;
 
-#if defined(__GNUC__) && defined(__M68000__) && defined(SDL_ASSEMBLY_ROUTINES)
-			SDL_MixAudio_m68k_S16LSB((short*)dst,(short*)src,(unsigned long)len,(long)volume);
-#else
-			{
-			Sint16 src1, src2;
-			int dst_sample;
-			const int max_audioval = ((1<<(16-1))-1);
-			const int min_audioval = -(1<<(16-1));
-
-			len /= 2;
-			while ( len-- ) {
-				src1 = ((src[1])<<8|src[0]);
-				ADJUST_VOLUME(src1, volume);
-				src2 = ((dst[1])<<8|dst[0]);
-				src += 2;
-				dst_sample = src1+src2;
-				if ( dst_sample > max_audioval ) {
-					dst_sample = max_audioval;
-				} else
-				if ( dst_sample < min_audioval ) {
-					dst_sample = min_audioval;
-				}
-				dst[0] = dst_sample&0xFF;
-				dst_sample >>= 8;
-				dst[1] = dst_sample&0xFF;
-				dst += 2;
-			}
-			}
+	    case AUDIO_S16LSB:
+	    case AUDIO_S16MSB: {
+		const int swap = (format != AUDIO_S16SYS);
+
+		samples = len / 2;
+#if SDL_AVX2_INTRINSICS
+		if ( simd && SDL_HasAVX2() ) {
+			done = SDL_MixS16_AVX2(dst, srcs, volumes, count, samples, swap);
+		} else
 #endif
+#if SDL_SSE2_INTRINSICS
+		if ( simd && SDL_HasSSE2() ) {
+			done = SDL_MixS16_SSE2(dst, srcs, volumes, count, samples, swap);
+		}
+#elif SDL_NEON_INTRINSICS
+		if ( simd && SDL_HasNEON() ) {
+			done = SDL_MixS16_NEON(dst, srcs, volumes, count, samples, swap);
 		}
+#endif
+		SDL_MixS16_C(dst, srcs, volumes, count, done, samples, swap);
+	    }
 		break;
 
-		case AUDIO_S16MSB: {
-#if defined(__GNUC__) && defined(__M68000__) && defined(SDL_ASSEMBLY_ROUTINES)
-			SDL_MixAudio_m68k_S16MSB((short*)dst,(short*)src,(unsigned long)len,(long)volume);
-#else
-			Sint16 src1, src2;
-			int dst_sample;
-			const int max_audioval = ((1<<(16-1))-1);
-			const int min_audioval = -(1<<(16-1));
-
-			len /= 2;
-			while ( len-- ) {
-				src1 = ((src[0])<<8|src[1]);
-				ADJUST_VOLUME(src1, volume);
-				src2 = ((dst[0])<<8|dst[1]);
-				src += 2;
-				dst_sample = src1+src2;
-				if ( dst_sample > max_audioval ) {
-					dst_sample = max_audioval;
-				} else
-				if ( dst_sample < min_audioval ) {
-					dst_sample = min_audioval;
-				}
-				dst[1] = dst_sample&0xFF;
-				dst_sample >>= 8;
-				dst[0] = dst_sample&0xFF;
-				dst += 2;
+	    case AUDIO_S32LSB:
+	    case AUDIO_S32MSB: {
+		const int swap = (format != AUDIO_S32SYS);
+
+		samples = len / 4;
+#ifdef SDL_HAS_64BIT_TYPE
+#if SDL_AVX2_INTRINSICS
+		if ( simd && SDL_HasAVX2() ) {
+			done = SDL_MixS32_AVX2(dst, srcs, volumes, count, samples, swap);
+		} else
+#endif
+#if SDL_SSE2_INTRINSICS
+		if ( simd && SDL_HasSSE2() ) {
+			done = SDL_MixS32_SSE2(dst, srcs, volumes, count, samples, swap);
+		}
+#endif
+#endif /* SDL_HAS_64BIT_TYPE */
+		SDL_MixS32_C(dst, srcs, volumes, count, done, samples, swap);
+	    }
+		break;
+
+	    case AUDIO_F32LSB:
+	    case AUDIO_F32MSB: {
+		const int swap = (format != AUDIO_F32SYS);
+
+		samples = len / 4;
+		if ( !swap ) {
+#if SDL_AVX2_INTRINSICS
+			if ( SDL_HasAVX2() ) {
+				done = SDL_MixF32_AVX2(dst, srcs, volumes, count, samples);
+			} else
+#endif
+#if SDL_SSE2_INTRINSICS
+			if ( SDL_HasSSE2() ) {
+				done = SDL_MixF32_SSE2(dst, srcs, volumes, count, samples);
+			}
+#elif SDL_NEON_INTRINSICS
+			if ( SDL_HasNEON() ) {
+				done = SDL_MixF32_NEON(dst, srcs, volumes, count, samples);
 			}
 #endif
 		}
+		SDL_MixF32_C(dst, srcs, volumes, count, done, samples, swap);
+	    }
 		break;
 
-		default: /* If this happens... FIXME! */
-			SDL_SetError("SDL_MixAudio(): unknown audio format");
-			return;
+	    default: /* If this happens... FIXME! */
+		SDL_SetError("SDL_MixAudio(): unknown audio format");
+		return;
+	}
+}
+
+void SDL_MixAudioFormat (Uint8 *dst, const Uint8 *src, Uint16 format,
+                         Uint32 len, int volume)
+{
+	if ( volume == 0 ) {
+		return;
 	}
+	SDL_MixAudioSources(dst, &src, &volume, 1, format, len);
 }
 
+void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	Uint16 format;
+
+	if ( volume == 0 ) {
+		return;
+	}
+	/* Mix the user-level audio format */
+	if ( current_audio ) {
+		if ( current_audio->convert.needed ) {
+			format = current_audio->convert.src_format;
+		} else {
+			format = current_audio->spec.format;
+		}
+	} else {
+  		/* HACK HACK HACK */
+		format = AUDIO_S16;
+	}
+
+#if defined(__GNUC__) && defined(__M68000__) && defined(SDL_ASSEMBLY_ROUTINES)
+	switch (format) {
+		case AUDIO_U8:
+			SDL_MixAudio_m68k_U8((char*)dst,(char*)src,(unsigned long)len,(long)volume,(char *)mix8);
+			return;
+		case AUDIO_S8:
+			SDL_MixAudio_m68k_S8((char*)dst,(char*)src,(unsigned long)len,(long)volume);
+			return;
+		case AUDIO_S16LSB:
+			SDL_MixAudio_m68k_S16LSB((short*)dst,(short*)src,(unsigned long)len,(long)volume);
+			return;
+		case AUDIO_S16MSB:
+			SDL_MixAudio_m68k_S16MSB((short*)dst,(short*)src,(unsigned long)len,(long)volume);
+			return;
+	}
+#endif
+	SDL_MixAudioFormat(dst, src, format, len, volume);
+}
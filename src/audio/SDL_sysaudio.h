@@ -24,6 +24,7 @@
 #ifndef _SDL_sysaudio_h
 #define _SDL_sysaudio_h
 
+#include "SDL_atomic.h"
 #include "SDL_mutex.h"
 #include "SDL_thread.h"
 
@@ -68,11 +69,26 @@ struct SDL_AudioDevice {
 	/* An audio conversion block for audio format emulation */
 	SDL_AudioCVT convert;
 
-	/* Current state flags */
-	int enabled;
-	int paused;
+	/* Used instead of 'convert' by SDL_RunAudio() if the size changes */
+	SDL_AudioStream *stream;
+
+	/* Set by drivers that can open AUDIO_S32 and AUDIO_F32 devices */
+	int wide_formats;
+
+	/* Current state flags, the audio thread reads them unlocked */
+	SDL_atomic_t enabled;
+	SDL_atomic_t paused;
 	int opened;
 
+	/* Ring buffer for SDL_QueueAudio(), the size is a power of two.
+	   Only SDL_QueueAudio() moves the head, only the audio thread
+	   moves the tail. */
+	Uint8 *queue;
+	Uint32 queue_size;
+	SDL_atomic_t queue_head;
+	SDL_atomic_t queue_tail;
+	int queue_frame;
+
 	/* Fake audio buffer for when the audio hardware is busy */
 	Uint8 *fake_stream;
 
@@ -24,10 +24,21 @@
 /* Microsoft WAVE file loading routines */
 
 #include "SDL_audio.h"
+#include "SDL_atomic.h"
 #include "SDL_wave.h"
 
 
-static int ReadChunk(SDL_RWops *src, Chunk *chunk);
+static int ReadChunk(SDL_RWops *src, Chunk *chunk, int borrow);
+
+/* PCM data left in place in a mapped file, closed by SDL_FreeWAV() */
+typedef struct WAVMapping {
+	Uint8 *audio_buf;
+	SDL_RWops *src;
+	struct WAVMapping *next;
+} WAVMapping;
+
+static WAVMapping *wav_mappings = NULL;
+static SDL_SpinLock wav_mappings_lock = 0;
 
 struct MS_ADPCM_decodestate {
 	Uint8 hPredictor;
@@ -117,7 +128,7 @@ static Sint32 MS_ADPCM_nibble(struct MS_ADPCM_decodestate *state,
 static int MS_ADPCM_decode(Uint8 **audio_buf, Uint32 *audio_len)
 {
 	struct MS_ADPCM_decodestate *state[2];
-	Uint8 *freeable, *encoded, *decoded;
+	Uint8 *encoded, *decoded;
 	Sint32 encoded_len, samplesleft;
 	Sint8 nybble, stereo;
 	Sint16 *coeff[2];
@@ -126,7 +137,6 @@ static int MS_ADPCM_decode(Uint8 **audio_buf, Uint32 *audio_len)
 	/* Allocate the proper sized output buffer */
 	encoded_len = *audio_len;
 	encoded = *audio_buf;
-	freeable = *audio_buf;
 	*audio_len = (encoded_len/MS_ADPCM_state.wavefmt.blockalign) * 
 				MS_ADPCM_state.wSamplesPerBlock*
 				MS_ADPCM_state.wavefmt.channels*sizeof(Sint16);
@@ -209,7 +219,6 @@ static int MS_ADPCM_decode(Uint8 **audio_buf, Uint32 *audio_len)
 		}
 		encoded_len -= MS_ADPCM_state.wavefmt.blockalign;
 	}
-	SDL_free(freeable);
 	return(0);
 }
 
@@ -327,7 +336,7 @@ static void Fill_IMA_ADPCM_block(Uint8 *decoded, Uint8 *encoded,
 static int IMA_ADPCM_decode(Uint8 **audio_buf, Uint32 *audio_len)
 {
 	struct IMA_ADPCM_decodestate *state;
-	Uint8 *freeable, *encoded, *decoded;
+	Uint8 *encoded, *decoded;
 	Sint32 encoded_len, samplesleft;
 	unsigned int c, channels;
 
@@ -343,7 +352,6 @@ static int IMA_ADPCM_decode(Uint8 **audio_buf, Uint32 *audio_len)
 	/* Allocate the proper sized output buffer */
 	encoded_len = *audio_len;
 	encoded = *audio_buf;
-	freeable = *audio_buf;
 	*audio_len = (encoded_len/IMA_ADPCM_state.wavefmt.blockalign) * 
 				IMA_ADPCM_state.wSamplesPerBlock*
 				IMA_ADPCM_state.wavefmt.channels*sizeof(Sint16);
@@ -389,7 +397,6 @@ static int IMA_ADPCM_decode(Uint8 **audio_buf, Uint32 *audio_len)
 		}
 		encoded_len -= IMA_ADPCM_state.wavefmt.blockalign;
 	}
-	SDL_free(freeable);
 	return(0);
 }
 
@@ -442,7 +449,7 @@ SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
 			SDL_free(chunk.data);
 			chunk.data = NULL;
 		}
-		lenread = ReadChunk(src, &chunk);
+		lenread = ReadChunk(src, &chunk, 0);
 		if ( lenread < 0 ) {
 			was_error = 1;
 			goto done;
@@ -522,10 +529,12 @@ SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
 	*audio_buf = NULL;
 	do {
 		if ( *audio_buf != NULL ) {
-			SDL_free(*audio_buf);
+			if ( !chunk.borrowed ) {
+				SDL_free(*audio_buf);
+			}
 			*audio_buf = NULL;
 		}
-		lenread = ReadChunk(src, &chunk);
+		lenread = ReadChunk(src, &chunk, 1);
 		if ( lenread < 0 ) {
 			was_error = 1;
 			goto done;
@@ -536,17 +545,49 @@ SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
 	} while ( chunk.magic != DATA );
 	headerDiff += 2 * sizeof(Uint32); /* for the data chunk and len */
 
-	if ( MS_ADPCM_encoded ) {
-		if ( MS_ADPCM_decode(audio_buf, audio_len) < 0 ) {
-			was_error = 1;
-			goto done;
+	if ( MS_ADPCM_encoded || IMA_ADPCM_encoded ) {
+		/* Decode straight from the source if it's in memory */
+		Uint8 *encoded = *audio_buf;
+		int status;
+
+		if ( MS_ADPCM_encoded ) {
+			status = MS_ADPCM_decode(audio_buf, audio_len);
+		} else {
+			status = IMA_ADPCM_decode(audio_buf, audio_len);
 		}
-	}
-	if ( IMA_ADPCM_encoded ) {
-		if ( IMA_ADPCM_decode(audio_buf, audio_len) < 0 ) {
+		if ( !chunk.borrowed ) {
+			SDL_free(encoded);
+		}
+		if ( status < 0 ) {
 			was_error = 1;
 			goto done;
 		}
+	} else if ( chunk.borrowed ) {
+		/* A mapped file we own can stay open, anything else is copied */
+		WAVMapping *mapping = NULL;
+
+		if ( freesrc && SDL_RWMappedData(src, NULL) ) {
+			mapping = (WAVMapping *)SDL_malloc(sizeof(*mapping));
+		}
+		if ( mapping ) {
+			mapping->audio_buf = *audio_buf;
+			mapping->src = src;
+			SDL_AtomicLock(&wav_mappings_lock);
+			mapping->next = wav_mappings;
+			wav_mappings = mapping;
+			SDL_AtomicUnlock(&wav_mappings_lock);
+			src = NULL;
+		} else {
+			Uint8 *copy = (Uint8 *)SDL_malloc(*audio_len);
+			if ( copy == NULL ) {
+				SDL_Error(SDL_ENOMEM);
+				*audio_buf = NULL;
+				was_error = 1;
+				goto done;
+			}
+			SDL_memcpy(copy, *audio_buf, *audio_len);
+			*audio_buf = copy;
+		}
 	}
 
 	/* Don't return a buffer that isn't a multiple of samplesize */
@@ -576,15 +617,53 @@ done:
  */
 void SDL_FreeWAV(Uint8 *audio_buf)
 {
-	if ( audio_buf != NULL ) {
+	WAVMapping *mapping, *prev = NULL;
+
+	if ( audio_buf == NULL ) {
+		return;
+	}
+	SDL_AtomicLock(&wav_mappings_lock);
+	for ( mapping = wav_mappings; mapping; mapping = mapping->next ) {
+		if ( mapping->audio_buf == audio_buf ) {
+			if ( prev ) {
+				prev->next = mapping->next;
+			} else {
+				wav_mappings = mapping->next;
+			}
+			break;
+		}
+		prev = mapping;
+	}
+	SDL_AtomicUnlock(&wav_mappings_lock);
+
+	if ( mapping ) {
+		SDL_RWclose(mapping->src);
+		SDL_free(mapping);
+	} else {
 		SDL_free(audio_buf);
 	}
 }
 
-static int ReadChunk(SDL_RWops *src, Chunk *chunk)
+static int ReadChunk(SDL_RWops *src, Chunk *chunk, int borrow)
 {
 	chunk->magic	= SDL_ReadLE32(src);
 	chunk->length	= SDL_ReadLE32(src);
+	chunk->borrowed = 0;
+	if ( borrow && (int)chunk->length >= 0 ) {
+		const void *data;
+		int length = SDL_RWborrow(src, &data, chunk->length);
+		if ( length == (int)chunk->length ) {
+			chunk->data = (Uint8 *)data;
+			chunk->borrowed = 1;
+			return(chunk->length);
+		}
+		if ( length >= 0 ) {
+			/* A memory stream that's too short */
+			SDL_Error(SDL_EFREAD);
+			chunk->data = NULL;
+			return(-1);
+		}
+	}
 	chunk->data = (Uint8 *)SDL_malloc(chunk->length);
 	if ( chunk->data == NULL ) {
 		SDL_Error(SDL_ENOMEM);
@@ -239,6 +239,7 @@ static SDL_AudioDevice *Audio_CreateDevice(int devindex)
 	this->PlayAudio = ALSA_PlayAudio;
 	this->GetAudioBuf = ALSA_GetAudioBuf;
 	this->CloseAudio = ALSA_CloseAudio;
+	this->wide_formats = 1;
 
 	this->free = Audio_DeleteDevice;
 
@@ -313,7 +314,7 @@ static void ALSA_PlayAudio(_THIS)
 
 	frames_left = ((snd_pcm_uframes_t) this->spec.samples);
 
-	while ( frames_left > 0 && this->enabled ) {
+	while ( frames_left > 0 && SDL_AtomicGet(&this->enabled) ) {
 		/* This works, but needs more testing before going live */
 		/*SDL_NAME(snd_pcm_wait)(pcm_handle, -1);*/
 
@@ -328,7 +329,7 @@ static void ALSA_PlayAudio(_THIS)
 			if ( status < 0 ) {
 				/* Hmm, not much we can do - abort */
 				fprintf(stderr, "ALSA write failed (unrecoverable): %s\n", SDL_NAME(snd_strerror)(status));
-				this->enabled = 0;
+				SDL_AtomicSet(&this->enabled, 0);
 				return;
 			}
 			continue;
@@ -518,6 +519,18 @@ static int ALSA_OpenAudio(_THIS, SDL_AudioSpec *spec)
 			case AUDIO_U16MSB:
 				format = SND_PCM_FORMAT_U16_BE;
 				break;
+			case AUDIO_S32LSB:
+				format = SND_PCM_FORMAT_S32_LE;
+				break;
+			case AUDIO_S32MSB:
+				format = SND_PCM_FORMAT_S32_BE;
+				break;
+			case AUDIO_F32LSB:
+				format = SND_PCM_FORMAT_FLOAT_LE;
+				break;
+			case AUDIO_F32MSB:
+				format = SND_PCM_FORMAT_FLOAT_BE;
+				break;
 			default:
 				format = 0;
 				break;
@@ -105,6 +105,7 @@ static SDL_AudioDevice *DISKAUD_CreateDevice(int devindex)
 	this->PlayAudio = DISKAUD_PlayAudio;
 	this->GetAudioBuf = DISKAUD_GetAudioBuf;
 	this->CloseAudio = DISKAUD_CloseAudio;
+	this->wide_formats = 1;
 
 	this->free = DISKAUD_DeleteDevice;
 
@@ -133,7 +134,7 @@ static void DISKAUD_PlayAudio(_THIS)
 
 	/* If we couldn't write, assume fatal error for now */
 	if ( (Uint32)written != this->hidden->mixlen ) {
-		this->enabled = 0;
+		SDL_AtomicSet(&this->enabled, 0);
 	}
 #ifdef DEBUG_AUDIO
 	fprintf(stderr, "Wrote %d bytes of audio data\n", written);
@@ -146,7 +146,7 @@ static void DMA_WaitAudio(_THIS)
 		*/
 		if (parent && (((++cnt)%10) == 0)) { /* Check every 10 loops */
 			if ( kill(parent, 0) < 0 ) {
-				this->enabled = 0;
+				SDL_AtomicSet(&this->enabled, 0);
 			}
 		}
 	}
@@ -188,7 +188,7 @@ static void DMA_WaitAudio(_THIS)
 			                      this->spec->freq;
 			next_frame = SDL_GetTicks()+frame_ticks;
 #else
-			this->enabled = 0;
+			SDL_AtomicSet(&this->enabled, 0);
 			/* Don't try to close - may hang */
 			audio_fd = -1;
 #ifdef DEBUG_AUDIO
@@ -221,7 +221,7 @@ static Uint8 *DMA_GetAudioBuf(_THIS)
 	do {
 		if ( ioctl(audio_fd, SNDCTL_DSP_GETOPTR, &info) < 0 ) {
 			/* Uh oh... */
-			this->enabled = 0;
+			SDL_AtomicSet(&this->enabled, 0);
 			return(NULL);
 		}
 	} while ( frame_ticks && (info.blocks < 1) );
@@ -118,7 +118,7 @@ static void AL_PlayAudio(_THIS)
 	/* Write the audio data out */
 	if ( alWriteFrames(audio_port, mixbuf, this->spec.samples) < 0 ) {
 		/* Assume fatal error, for now */
-		this->enabled = 0;
+		SDL_AtomicSet(&this->enabled, 0);
 	}
 }
 
@@ -135,7 +135,7 @@ static void DSP_PlayAudio(_THIS)
 	if (write(audio_fd, mixbuf, mixlen)==-1)
 	{
 		perror("Audio write");
-		this->enabled = 0;
+		SDL_AtomicSet(&this->enabled, 0);
 	}
 
 #ifdef DEBUG_AUDIO
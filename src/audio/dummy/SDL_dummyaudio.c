@@ -85,6 +85,7 @@ static SDL_AudioDevice *DUMMYAUD_CreateDevice(int devindex)
 	this->PlayAudio = DUMMYAUD_PlayAudio;
 	this->GetAudioBuf = DUMMYAUD_GetAudioBuf;
 	this->CloseAudio = DUMMYAUD_CloseAudio;
+	this->wide_formats = 1;
 
 	this->free = DUMMYAUD_DeleteDevice;
 
@@ -120,7 +120,7 @@ static volatile Uint32 fill_me = 0;
 
 static void mix_buffer(SDL_AudioDevice *audio, UInt8 *buffer)
 {
-   if ( ! audio->paused ) {
+   if ( ! SDL_AtomicGet(&audio->paused) ) {
 #ifdef __MACOSX__
         SDL_mutexP(audio->mixer_lock);
 #endif
@@ -177,7 +177,7 @@ static void callBackProc (SndChannel *chan, SndCommand *cmd_passed ) {
    fill_me = cmd_passed->param2;  /* buffer that has just finished playing, so fill it */      
    play_me = ! fill_me;           /* filled buffer to play _now_ */
 
-   if ( ! audio->enabled ) {
+   if ( ! SDL_AtomicGet(&audio->enabled) ) {
       return;
    }
    
@@ -336,12 +336,12 @@ void sndDoubleBackProc (SndChannelPtr chan, SndDoubleBufferPtr newbuf)
     SDL_AudioDevice *audio = (SDL_AudioDevice *)newbuf->dbUserInfo[0];
 
     /* If audio is quitting, don't do anything */
-    if ( ! audio->enabled ) {
+    if ( ! SDL_AtomicGet(&audio->enabled) ) {
         return;
     }
     memset (newbuf->dbSoundData, 0, audio->spec.size);
     newbuf->dbNumFrames = audio->spec.samples;
-    if ( ! audio->paused ) {
+    if ( ! SDL_AtomicGet(&audio->paused) ) {
         if ( audio->convert.needed ) {
             audio->spec.callback(audio->spec.userdata,
                 (Uint8 *)audio->convert.buf,audio->convert.len);
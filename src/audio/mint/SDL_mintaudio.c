@@ -65,7 +65,7 @@ void SDL_MintAudio_Callback(void)
  	buffer = SDL_MintAudio_audiobuf[SDL_MintAudio_numbuf];
 	SDL_memset(buffer, audio->spec.silence, audio->spec.size);
 
-	if (audio->paused)
+	if (SDL_AtomicGet(&audio->paused))
 		return;
 
 	if (audio->convert.needed) {
@@ -121,10 +121,10 @@ void SoundMixCallback(void *stream,u32 len)
 	SDL_memset(stream, audio->spec.silence, len);
 
 	/* Only do soemthing if audio is enabled */
-	if ( ! audio->enabled )
+	if ( ! SDL_AtomicGet(&audio->enabled) )
 		return;
 
-	if ( ! audio->paused ) {
+	if ( ! SDL_AtomicGet(&audio->paused) ) {
 		if ( audio->convert.needed ) {
 			//fprintf(stderr,"converting audio\n");
 			SDL_mutexP(audio->mixer_lock);
@@ -259,7 +259,7 @@ void static NDS_WaitAudio(_THIS)
 static void NDS_PlayAudio(_THIS)
 {
 	//printf("playing audio\n");
-	if (this->paused)
+	if (SDL_AtomicGet(&this->paused))
 		return;
 	
 }
@@ -249,7 +249,7 @@ static void NTO_PlayAudio(_THIS)
     int towrite;
     void* pcmbuffer;
 
-    if (!this->enabled)
+    if (!SDL_AtomicGet(&this->enabled))
     {
         return;
     }
@@ -304,12 +304,12 @@ static void NTO_PlayAudio(_THIS)
             towrite -= written;
             pcmbuffer += written * this->spec.channels;
         }
-    } while ((towrite > 0)  && (this->enabled));
+    } while ((towrite > 0)  && (SDL_AtomicGet(&this->enabled)));
 
     /* If we couldn't write, assume fatal error for now */
     if (towrite != 0)
     {
-        this->enabled = 0;
+        SDL_AtomicSet(&this->enabled, 0);
     }
 
     return;
@@ -324,7 +324,7 @@ static void NTO_CloseAudio(_THIS)
 {
     int rval;
 
-    this->enabled = 0;
+    SDL_AtomicSet(&this->enabled, 0);
 
     if (audio_handle != NULL)
     {
@@ -350,7 +350,7 @@ static int NTO_OpenAudio(_THIS, SDL_AudioSpec* spec)
     int found;
 
     audio_handle = NULL;
-    this->enabled = 0;
+    SDL_AtomicSet(&this->enabled, 0);
 
     if (pcm_buf != NULL)
     {
@@ -495,7 +495,7 @@ static int NTO_OpenAudio(_THIS, SDL_AudioSpec* spec)
         return (-1);
     }
 
-    this->enabled = 1;
+    SDL_AtomicSet(&this->enabled, 1);
 
     /* Get the parent process id (we're the parent of the audio thread) */
     parent = getpid();
@@ -173,7 +173,7 @@ static void Paud_WaitAudio(_THIS)
              * the user know what happened.
              */
             fprintf(stderr, "SDL: %s - %s\n", strerror(errno), message);
-            this->enabled = 0;
+            SDL_AtomicSet(&this->enabled, 0);
             /* Don't try to close - may hang */
             audio_fd = -1;
 #ifdef DEBUG_AUDIO
@@ -206,7 +206,7 @@ static void Paud_PlayAudio(_THIS)
 
 	/* If we couldn't write, assume fatal error for now */
 	if ( written < 0 ) {
-		this->enabled = 0;
+		SDL_AtomicSet(&this->enabled, 0);
 	}
 #ifdef DEBUG_AUDIO
 	fprintf(stderr, "Wrote %d bytes of audio data\n", written);
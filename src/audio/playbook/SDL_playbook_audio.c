@@ -179,7 +179,7 @@ static void PLAYBOOK_AUD_PlayAudio(_THIS)
     /* If we couldn't write, assume fatal error for now */
     if ( (Uint32)written != this->hidden->mixlen ) {
         DEBUG_printf (stderr, "write error (%d bytes written)\n", written);
-        this->enabled = 0;
+        SDL_AtomicSet(&this->enabled, 0);
     }
 #endif
 
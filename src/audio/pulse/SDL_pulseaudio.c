@@ -281,6 +281,7 @@ static SDL_AudioDevice *Audio_CreateDevice(int devindex)
 	this->GetAudioBuf = PULSE_GetAudioBuf;
 	this->CloseAudio = PULSE_CloseAudio;
 	this->WaitDone = PULSE_WaitDone;
+	this->wide_formats = 1;
 
 	this->free = Audio_DeleteDevice;
 
@@ -300,7 +301,7 @@ static void PULSE_WaitAudio(_THIS)
 		if (SDL_NAME(pa_context_get_state)(context) != PA_CONTEXT_READY ||
 		    SDL_NAME(pa_stream_get_state)(stream) != PA_STREAM_READY ||
 		    SDL_NAME(pa_mainloop_iterate)(mainloop, 1, NULL) < 0) {
-			this->enabled = 0;
+			SDL_AtomicSet(&this->enabled, 0);
 			return;
 		}
 		size = SDL_NAME(pa_stream_writable_size)(stream);
@@ -313,7 +314,7 @@ static void PULSE_PlayAudio(_THIS)
 {
 	/* Write the audio data */
 	if (SDL_NAME(pa_stream_write)(stream, mixbuf, mixlen, NULL, 0LL, PA_SEEK_RELATIVE) < 0)
-		this->enabled = 0;
+		SDL_AtomicSet(&this->enabled, 0);
 }
 
 static Uint8 *PULSE_GetAudioBuf(_THIS)
@@ -415,9 +416,24 @@ static int PULSE_OpenAudio(_THIS, SDL_AudioSpec *spec)
 			case AUDIO_S16MSB:
 				paspec.format = PA_SAMPLE_S16BE;
 				break;
+#ifdef PA_SAMPLE_S32NE	/* Added in PulseAudio 0.9.11 */
+			case AUDIO_S32LSB:
+				paspec.format = PA_SAMPLE_S32LE;
+				break;
+			case AUDIO_S32MSB:
+				paspec.format = PA_SAMPLE_S32BE;
+				break;
+#endif
+			case AUDIO_F32LSB:
+				paspec.format = PA_SAMPLE_FLOAT32LE;
+				break;
+			case AUDIO_F32MSB:
+				paspec.format = PA_SAMPLE_FLOAT32BE;
+				break;
 		}
 		if ( paspec.format != PA_SAMPLE_INVALID )
 			break;
+		test_format = SDL_NextAudioFormat();
 	}
 	if (paspec.format == PA_SAMPLE_INVALID ) {
 		SDL_SetError("Couldn't find any suitable audio formats");
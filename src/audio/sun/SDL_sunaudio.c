@@ -207,7 +207,7 @@ void DSP_PlayAudio(_THIS)
 #endif
 		if ( write(audio_fd, ulaw_buf, fragsize) < 0 ) {
 			/* Assume fatal error, for now */
-			this->enabled = 0;
+			SDL_AtomicSet(&this->enabled, 0);
 		}
 		written += fragsize;
 	} else {
@@ -216,7 +216,7 @@ void DSP_PlayAudio(_THIS)
 #endif
 		if ( write(audio_fd, mixbuf, this->spec.size) < 0 ) {
 			/* Assume fatal error, for now */
-			this->enabled = 0;
+			SDL_AtomicSet(&this->enabled, 0);
 		}
 		written += fragsize;
 	}
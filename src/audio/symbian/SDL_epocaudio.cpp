@@ -544,7 +544,7 @@ static int EPOC_OpenAudio(SDL_AudioDevice *thisdevice, SDL_AudioSpec *spec)
 	
    // isSDLAudioPaused = 1;
 
-    thisdevice->enabled = 0; /* enable only after audio engine has been initialized!*/
+    SDL_AtomicSet(&thisdevice->enabled, 0); /* enable only after audio engine has been initialized!*/
 
 	/* We're ready to rock and roll. :-) */
 	return(0);
@@ -566,7 +566,7 @@ static void EPOC_ThreadInit(SDL_AudioDevice *thisdevice)
 	SDL_TRACE("SDL:EPOC_ThreadInit");
     CEpocAudio::Current(thisdevice).ThreadInitL(thisdevice);
     RThread().SetPriority(EPriorityMore);
-    thisdevice->enabled = 1;
+    SDL_AtomicSet(&thisdevice->enabled, 1);
     }
 
 /* This function waits until it is possible to write a full sound buffer */
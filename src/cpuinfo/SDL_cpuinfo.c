@@ -31,6 +31,31 @@
 #elif SDL_ALTIVEC_BLITTERS && HAVE_SETJMP
 #include <signal.h>
 #include <setjmp.h>
+#elif defined(__linux__) && defined(__arm__)
+#include <stdio.h> /* For the NEON check */
+#endif
+
+#if defined(__WIN32__)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h> /* For the CPU count and memory size */
+/* Older headers lack the XP processor and Windows 2000 memory queries */
+#if !defined(_WIN32_WCE) && \
+    ((defined(_MSC_VER) && (_MSC_VER >= 1500)) || defined(__MINGW64_VERSION_MAJOR))
+#define CPU_WIN32_XP_HEADERS	1
+#endif
+#elif defined(__unix__) || defined(__MACOSX__) || defined(__QNXNTO__)
+#include <unistd.h> /* For the CPU count and memory size */
+#if defined(__MACOSX__)
+#include <sys/types.h>
+#include <sys/sysctl.h>
+#elif defined(__linux__)
+#include <stdio.h> /* For the physical core count */
+#endif
+#endif
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1400) && defined(_M_X64)
+#include <intrin.h> /* No inline assembly on x64, use the intrinsics */
+#define CPU_CPUID_INTRINSICS	1
 #endif
 
 #define CPU_HAS_RDTSC	0x00000001
@@ -41,6 +66,18 @@
 #define CPU_HAS_SSE	0x00000040
 #define CPU_HAS_SSE2	0x00000080
 #define CPU_HAS_ALTIVEC	0x00000100
+#define CPU_HAS_AVX2	0x00000200
+#define CPU_HAS_SSSE3	0x00000400
+#define CPU_HAS_SSE41	0x00000800
+#define CPU_HAS_NEON	0x00001000
+#define CPU_HAS_INVARIANT_TSC 0x00002000
+#define CPU_HAS_SSE3	0x00004000
+#define CPU_HAS_SSE42	0x00008000
+#define CPU_HAS_AVX	0x00010000
+#define CPU_HAS_AVX512F	0x00020000
+
+/* Used when the cache line size can't be queried */
+#define CPU_DEFAULT_CACHELINE	64
 
 #if SDL_ALTIVEC_BLITTERS && HAVE_SETJMP && !__MACOSX__
 /* This is the brute force way of detecting instruction sets...
@@ -139,6 +176,8 @@ done:
 "       movl    $1,-8(%rbp)    \n"
 "1:                            \n"
 	);
+#elif CPU_CPUID_INTRINSICS
+	has_CPUID = 1;
 #endif
 	return has_CPUID;
 }
@@ -209,6 +248,13 @@ done:
 #endif
 "1:                                \n"
 "        movl    %edi,%ebx\n" );
+#elif CPU_CPUID_INTRINSICS
+	int regs[4];
+	__cpuid(regs, 0);
+	if ( regs[0] >= 1 ) {
+		__cpuid(regs, 1);
+		features = regs[3];
+	}
 #endif
 	return features;
 }
@@ -276,10 +322,99 @@ done:
 "1:                               \n"
 "        movl    %edi,%ebx\n"
 	    );
+#elif CPU_CPUID_INTRINSICS
+	int regs[4];
+	__cpuid(regs, 0x80000000);
+	if ( (unsigned int)regs[0] >= 0x80000001 ) {
+		__cpuid(regs, 0x80000001);
+		features = regs[3];
+	}
 #endif
 	return features;
 }
 
+static __inline__ void CPU_getCPUIDRegisters(int func, int regs[4])
+{
+	int a = 0, b = 0, c = 0, d = 0;
+#if defined(__GNUC__) && defined(i386)
+	__asm__ (
+"        movl    %%ebx,%%edi\n"
+"        cpuid                       # Get the requested function      \n"
+"        xchgl   %%ebx,%%edi\n"
+	: "=a" (a), "=D" (b), "=c" (c), "=d" (d)
+	: "a" (func), "c" (0)
+	);
+#elif defined(__GNUC__) && defined(__x86_64__)
+	__asm__ (
+"        movq    %%rbx,%%rdi\n"
+"        cpuid                       # Get the requested function      \n"
+"        xchgq   %%rbx,%%rdi\n"
+	: "=a" (a), "=D" (b), "=c" (c), "=d" (d)
+	: "a" (func), "c" (0)
+	);
+#elif (defined(_MSC_VER) && defined(_M_IX86)) || defined(__WATCOMC__)
+	__asm {
+        mov     eax, func
+        xor     ecx, ecx            ; Sub-function 0
+        cpuid                       ; Get the requested function
+        mov     a, eax
+        mov     b, ebx
+        mov     c, ecx
+        mov     d, edx
+	}
+#elif CPU_CPUID_INTRINSICS
+	int r[4];
+	__cpuidex(r, func, 0);
+	a = r[0];
+	b = r[1];
+	c = r[2];
+	d = r[3];
+#endif
+	regs[0] = a;
+	regs[1] = b;
+	regs[2] = c;
+	regs[3] = d;
+}
+
+/* Returns the register state the OS saves on context switch, only valid
+   when CPUID says OSXSAVE is set */
+static __inline__ int CPU_getXCR0(void)
+{
+	int xcr0 = 0;
+#if defined(__GNUC__) && (defined(i386) || defined(__x86_64__))
+	__asm__ (
+"        xorl    %%ecx,%%ecx\n"
+"        .byte   0x0f, 0x01, 0xd0    # xgetbv                          \n"
+	: "=a" (xcr0)
+	:
+	: "%ecx", "%edx"
+	);
+#elif (defined(_MSC_VER) && defined(_M_IX86)) || defined(__WATCOMC__)
+	__asm {
+        xor     ecx, ecx
+        _emit   0x0f                ; xgetbv
+        _emit   0x01
+        _emit   0xd0
+        mov     xcr0, eax
+	}
+#elif CPU_CPUID_INTRINSICS && (_MSC_FULL_VER >= 160040219)
+	xcr0 = (int)_xgetbv(0);
+#endif
+	return xcr0;
+}
+
+/* Returns true if the CPU has OSXSAVE and the OS saves the given state */
+static __inline__ int CPU_OSSavesState(int mask)
+{
+	int regs[4];
+
+	CPU_getCPUIDRegisters(1, regs);
+	if ( !(regs[2] & 0x08000000) ) {
+		return 0;
+	}
+	return ((CPU_getXCR0() & mask) == mask);
+}
+
 static __inline__ int CPU_haveRDTSC(void)
 {
 	if ( CPU_haveCPUID() ) {
@@ -288,6 +423,22 @@ static __inline__ int CPU_haveRDTSC(void)
 	return 0;
 }
 
+static __inline__ int CPU_haveInvariantTSC(void)
+{
+	if ( CPU_haveRDTSC() ) {
+		int regs[4];
+
+		CPU_getCPUIDRegisters(0x80000000, regs);
+		if ( (Uint32)regs[0] < 0x80000007 ) {
+			return 0;
+		}
+		/* The TSC runs at a constant rate in all power states */
+		CPU_getCPUIDRegisters(0x80000007, regs);
+		return (regs[3] & 0x00000100);
+	}
+	return 0;
+}
+
 static __inline__ int CPU_haveMMX(void)
 {
 	if ( CPU_haveCPUID() ) {
@@ -336,6 +487,96 @@ static __inline__ int CPU_haveSSE2(void)
 	return 0;
 }
 
+static __inline__ int CPU_haveSSE3(void)
+{
+	if ( CPU_haveCPUID() ) {
+		int regs[4];
+
+		CPU_getCPUIDRegisters(1, regs);
+		return (regs[2] & 0x00000001);
+	}
+	return 0;
+}
+
+static __inline__ int CPU_haveSSSE3(void)
+{
+	if ( CPU_haveCPUID() ) {
+		int regs[4];
+
+		CPU_getCPUIDRegisters(1, regs);
+		return (regs[2] & 0x00000200);
+	}
+	return 0;
+}
+
+static __inline__ int CPU_haveSSE41(void)
+{
+	if ( CPU_haveCPUID() ) {
+		int regs[4];
+
+		CPU_getCPUIDRegisters(1, regs);
+		return (regs[2] & 0x00080000);
+	}
+	return 0;
+}
+
+static __inline__ int CPU_haveSSE42(void)
+{
+	if ( CPU_haveCPUID() ) {
+		int regs[4];
+
+		CPU_getCPUIDRegisters(1, regs);
+		return (regs[2] & 0x00100000);
+	}
+	return 0;
+}
+
+static __inline__ int CPU_haveAVX(void)
+{
+	if ( CPU_haveCPUID() ) {
+		int regs[4];
+
+		/* The OS must have enabled the XMM and YMM state too */
+		CPU_getCPUIDRegisters(1, regs);
+		return ((regs[2] & 0x10000000) && CPU_OSSavesState(0x06));
+	}
+	return 0;
+}
+
+static __inline__ int CPU_haveAVX2(void)
+{
+	if ( CPU_haveCPUID() && CPU_haveAVX() ) {
+		int regs[4];
+
+		CPU_getCPUIDRegisters(0, regs);
+		if ( regs[0] < 7 ) {
+			return 0;
+		}
+		CPU_getCPUIDRegisters(7, regs);
+		return (regs[1] & 0x00000020);
+	}
+	return 0;
+}
+
+static __inline__ int CPU_haveAVX512F(void)
+{
+	if ( CPU_haveCPUID() && CPU_haveAVX() ) {
+		int regs[4];
+
+		/* The opmask and upper ZMM state as well */
+		if ( !CPU_OSSavesState(0xE6) ) {
+			return 0;
+		}
+		CPU_getCPUIDRegisters(0, regs);
+		if ( regs[0] < 7 ) {
+			return 0;
+		}
+		CPU_getCPUIDRegisters(7, regs);
+		return (regs[1] & 0x00010000);
+	}
+	return 0;
+}
+
 static __inline__ int CPU_haveAltiVec(void)
 {
 	volatile int altivec = 0;
@@ -361,6 +602,29 @@ static __inline__ int CPU_haveAltiVec(void)
 	return altivec; 
 }
 
+static __inline__ int CPU_haveNEON(void)
+{
+	int neon = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+	/* Built with NEON enabled, so it can't run without it */
+	neon = 1;
+#elif defined(__linux__) && defined(__arm__)
+	/* Look for HWCAP_NEON in the auxiliary vector */
+	FILE *f = fopen("/proc/self/auxv", "rb");
+	if ( f ) {
+		unsigned long aux[2];
+		while ( fread(aux, sizeof(aux), 1, f) == 1 ) {
+			if ( aux[0] == 16 ) {	/* AT_HWCAP */
+				neon = ((aux[1] & (1 << 12)) != 0);
+				break;
+			}
+		}
+		fclose(f);
+	}
+#endif
+	return neon;
+}
+
 static Uint32 SDL_CPUFeatures = 0xFFFFFFFF;
 
 static Uint32 SDL_GetCPUFeatures(void)
@@ -370,6 +634,9 @@ static Uint32 SDL_GetCPUFeatures(void)
 		if ( CPU_haveRDTSC() ) {
 			SDL_CPUFeatures |= CPU_HAS_RDTSC;
 		}
+		if ( CPU_haveInvariantTSC() ) {
+			SDL_CPUFeatures |= CPU_HAS_INVARIANT_TSC;
+		}
 		if ( CPU_haveMMX() ) {
 			SDL_CPUFeatures |= CPU_HAS_MMX;
 		}
@@ -391,6 +658,30 @@ static Uint32 SDL_GetCPUFeatures(void)
 		if ( CPU_haveAltiVec() ) {
 			SDL_CPUFeatures |= CPU_HAS_ALTIVEC;
 		}
+		if ( CPU_haveAVX2() ) {
+			SDL_CPUFeatures |= CPU_HAS_AVX2;
+		}
+		if ( CPU_haveSSSE3() ) {
+			SDL_CPUFeatures |= CPU_HAS_SSSE3;
+		}
+		if ( CPU_haveSSE41() ) {
+			SDL_CPUFeatures |= CPU_HAS_SSE41;
+		}
+		if ( CPU_haveNEON() ) {
+			SDL_CPUFeatures |= CPU_HAS_NEON;
+		}
+		if ( CPU_haveSSE3() ) {
+			SDL_CPUFeatures |= CPU_HAS_SSE3;
+		}
+		if ( CPU_haveSSE42() ) {
+			SDL_CPUFeatures |= CPU_HAS_SSE42;
+		}
+		if ( CPU_haveAVX() ) {
+			SDL_CPUFeatures |= CPU_HAS_AVX;
+		}
+		if ( CPU_haveAVX512F() ) {
+			SDL_CPUFeatures |= CPU_HAS_AVX512F;
+		}
 	}
 	return SDL_CPUFeatures;
 }
@@ -403,6 +694,14 @@ SDL_bool SDL_HasRDTSC(void)
 	return SDL_FALSE;
 }
 
+SDL_bool SDL_HasInvariantTSC(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_INVARIANT_TSC ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
 SDL_bool SDL_HasMMX(void)
 {
 	if ( SDL_GetCPUFeatures() & CPU_HAS_MMX ) {
@@ -459,6 +758,241 @@ SDL_bool SDL_HasAltiVec(void)
 	return SDL_FALSE;
 }
 
+SDL_bool SDL_HasAVX2(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_AVX2 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasSSSE3(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSSE3 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasSSE41(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSE41 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasNEON(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_NEON ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasSSE3(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSE3 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasSSE42(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSE42 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasAVX(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_AVX ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasAVX512F(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_AVX512F ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+static int SDL_CPUCount = 0;
+
+int SDL_GetCPUCount(void)
+{
+	if ( SDL_CPUCount == 0 ) {
+#if defined(__WIN32__)
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		SDL_CPUCount = (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+		SDL_CPUCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+		if ( SDL_CPUCount <= 0 ) {
+			SDL_CPUCount = 1;
+		}
+	}
+	return SDL_CPUCount;
+}
+
+#if CPU_WIN32_XP_HEADERS
+typedef BOOL (WINAPI *GetLogicalProcessorInformation_t)(PSYSTEM_LOGICAL_PROCESSOR_INFORMATION, PDWORD);
+#endif
+
+static int SDL_CPUCoreCount = 0;
+
+int SDL_GetCPUCoreCount(void)
+{
+	if ( SDL_CPUCoreCount == 0 ) {
+#if CPU_WIN32_XP_HEADERS
+		/* Not there before XP SP3, so look it up */
+		GetLogicalProcessorInformation_t pGetLogicalProcessorInformation;
+		pGetLogicalProcessorInformation = (GetLogicalProcessorInformation_t)
+			GetProcAddress(GetModuleHandle(TEXT("kernel32.dll")),
+			               "GetLogicalProcessorInformation");
+		if ( pGetLogicalProcessorInformation ) {
+			SYSTEM_LOGICAL_PROCESSOR_INFORMATION *info = NULL;
+			DWORD size = 0;
+
+			pGetLogicalProcessorInformation(NULL, &size);
+			if ( size > 0 ) {
+				info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION *)SDL_malloc(size);
+			}
+			if ( info && pGetLogicalProcessorInformation(info, &size) ) {
+				DWORD i;
+				for ( i = 0; i < size / sizeof(*info); ++i ) {
+					if ( info[i].Relationship == RelationProcessorCore ) {
+						++SDL_CPUCoreCount;
+					}
+				}
+			}
+			SDL_free(info);
+		}
+#elif defined(__MACOSX__)
+		int cores = 0;
+		size_t length = sizeof(cores);
+		if ( sysctlbyname("hw.physicalcpu", &cores, &length, NULL, 0) == 0 ) {
+			SDL_CPUCoreCount = cores;
+		}
+#elif defined(__linux__)
+		/* Count the CPUs that are the first of their hyperthread siblings */
+		int i, count = SDL_GetCPUCount();
+		int cores = 0, found = 0;
+		for ( i = 0; found < count && i < 4096; ++i ) {
+			char path[128];
+			FILE *f;
+			int first;
+
+			SDL_snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", i);
+			f = fopen(path, "r");
+			if ( f == NULL ) {
+				if ( i >= count ) {
+					break;
+				}
+				continue;	/* Offline */
+			}
+			++found;
+			if ( fscanf(f, "%d", &first) == 1 && first == i ) {
+				++cores;
+			}
+			fclose(f);
+		}
+		SDL_CPUCoreCount = cores;
+#endif
+		if ( SDL_CPUCoreCount <= 0 || SDL_CPUCoreCount > SDL_GetCPUCount() ) {
+			SDL_CPUCoreCount = SDL_GetCPUCount();
+		}
+	}
+	return SDL_CPUCoreCount;
+}
+
+static int SDL_CPUCacheLineSize = 0;
+
+int SDL_GetCPUCacheLineSize(void)
+{
+	if ( SDL_CPUCacheLineSize == 0 ) {
+		if ( CPU_haveCPUID() ) {
+			int regs[4];
+
+			/* Bits 15-8 of EBX are the CLFLUSH line size in quadwords */
+			CPU_getCPUIDRegisters(1, regs);
+			if ( CPU_getCPUIDFeatures() & 0x00080000 ) {
+				SDL_CPUCacheLineSize = ((regs[1] >> 8) & 0xFF) * 8;
+			}
+		}
+#if defined(__MACOSX__)
+		if ( SDL_CPUCacheLineSize == 0 ) {
+			int size = 0;
+			size_t length = sizeof(size);
+			if ( sysctlbyname("hw.cachelinesize", &size, &length, NULL, 0) == 0 ) {
+				SDL_CPUCacheLineSize = size;
+			}
+		}
+#elif defined(_SC_LEVEL1_DCACHE_LINESIZE)
+		if ( SDL_CPUCacheLineSize == 0 ) {
+			SDL_CPUCacheLineSize = (int)sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+		}
+#endif
+		if ( SDL_CPUCacheLineSize <= 0 ) {
+			SDL_CPUCacheLineSize = CPU_DEFAULT_CACHELINE;
+		}
+	}
+	return SDL_CPUCacheLineSize;
+}
+
+#if CPU_WIN32_XP_HEADERS
+typedef BOOL (WINAPI *GlobalMemoryStatusEx_t)(LPMEMORYSTATUSEX);
+#endif
+
+static int SDL_SystemRAM = 0;
+
+int SDL_GetSystemRAM(void)
+{
+	if ( SDL_SystemRAM == 0 ) {
+#if defined(__WIN32__)
+		MEMORYSTATUS status;
+#if CPU_WIN32_XP_HEADERS
+		/* The Ex version handles more than 4 GB but needs Windows 2000 */
+		GlobalMemoryStatusEx_t pGlobalMemoryStatusEx;
+		pGlobalMemoryStatusEx = (GlobalMemoryStatusEx_t)
+			GetProcAddress(GetModuleHandle(TEXT("kernel32.dll")),
+			               "GlobalMemoryStatusEx");
+		if ( pGlobalMemoryStatusEx ) {
+			MEMORYSTATUSEX statusex;
+			statusex.dwLength = sizeof(statusex);
+			if ( pGlobalMemoryStatusEx(&statusex) ) {
+				SDL_SystemRAM = (int)(statusex.ullTotalPhys / (1024*1024));
+			}
+		}
+#endif
+		if ( SDL_SystemRAM == 0 ) {
+			status.dwLength = sizeof(status);
+			GlobalMemoryStatus(&status);
+			SDL_SystemRAM = (int)(status.dwTotalPhys / (1024*1024));
+		}
+#elif defined(__MACOSX__)
+		Uint64 memsize = 0;
+		size_t length = sizeof(memsize);
+		if ( sysctlbyname("hw.memsize", &memsize, &length, NULL, 0) == 0 ) {
+			SDL_SystemRAM = (int)(memsize / (1024*1024));
+		}
+#elif defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+		long pages = sysconf(_SC_PHYS_PAGES);
+		long pagesize = sysconf(_SC_PAGESIZE);
+		if ( pages > 0 && pagesize > 0 ) {
+			SDL_SystemRAM = (int)((Uint64)pages * pagesize / (1024*1024));
+		}
+#endif
+	}
+	return SDL_SystemRAM;
+}
+
 #ifdef TEST_MAIN
 
 #include <stdio.h>
@@ -466,6 +1000,7 @@ SDL_bool SDL_HasAltiVec(void)
 int main()
 {
 	printf("RDTSC: %d\n", SDL_HasRDTSC());
+	printf("Invariant TSC: %d\n", SDL_HasInvariantTSC());
 	printf("MMX: %d\n", SDL_HasMMX());
 	printf("MMXExt: %d\n", SDL_HasMMXExt());
 	printf("3DNow: %d\n", SDL_Has3DNow());
@@ -473,6 +1008,18 @@ int main()
 	printf("SSE: %d\n", SDL_HasSSE());
 	printf("SSE2: %d\n", SDL_HasSSE2());
 	printf("AltiVec: %d\n", SDL_HasAltiVec());
+	printf("AVX2: %d\n", SDL_HasAVX2());
+	printf("SSSE3: %d\n", SDL_HasSSSE3());
+	printf("SSE4.1: %d\n", SDL_HasSSE41());
+	printf("NEON: %d\n", SDL_HasNEON());
+	printf("SSE3: %d\n", SDL_HasSSE3());
+	printf("SSE4.2: %d\n", SDL_HasSSE42());
+	printf("AVX: %d\n", SDL_HasAVX());
+	printf("AVX-512F: %d\n", SDL_HasAVX512F());
+	printf("CPU count: %d\n", SDL_GetCPUCount());
+	printf("CPU cores: %d\n", SDL_GetCPUCoreCount());
+	printf("Cache line size: %d\n", SDL_GetCPUCacheLineSize());
+	printf("System RAM: %d MB\n", SDL_GetSystemRAM());
 	return 0;
 }
 
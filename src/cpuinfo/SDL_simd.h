@@ -0,0 +1,67 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+#ifndef _SDL_simd_h
+#define _SDL_simd_h
+
+/* Compiler intrinsics available to the SIMD code paths.
+
+   The kernels are always selected at runtime with the SDL_Has*() calls,
+   so the compiler must be able to emit instructions that the baseline
+   compile flags don't enable.  GCC 4.9+ and clang do this per function
+   with the target attribute, MSVC always allows it.  NEON is only used
+   when the compiler is already targeting it.
+*/
+#if SDL_ASSEMBLY_ROUTINES
+#  if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#    if defined(__clang__) || \
+        (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#      define SDL_SSE2_INTRINSICS 1
+#      define SDL_AVX2_INTRINSICS 1
+#      define SDL_TARGETING(x) __attribute__((target(x)))
+#    elif defined(__GNUC__) && defined(__SSE2__)
+#      define SDL_SSE2_INTRINSICS 1
+#    elif defined(_MSC_VER) && (_MSC_VER >= 1400)
+#      define SDL_SSE2_INTRINSICS 1
+#      if (_MSC_VER >= 1800)
+#        define SDL_AVX2_INTRINSICS 1
+#      endif
+#    endif
+#  elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#    define SDL_NEON_INTRINSICS 1
+#  endif
+#endif /* SDL_ASSEMBLY_ROUTINES */
+
+#ifndef SDL_TARGETING
+#define SDL_TARGETING(x)
+#endif
+
+#if SDL_AVX2_INTRINSICS
+#include <immintrin.h>
+#elif SDL_SSE2_INTRINSICS
+#include <emmintrin.h>
+#elif SDL_NEON_INTRINSICS
+#include <arm_neon.h>
+#endif
+
+#endif /* _SDL_simd_h */
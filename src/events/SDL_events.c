@@ -32,41 +32,314 @@
 #include "../joystick/SDL_joystick_c.h"
 #endif
 
+/* The thread that pumps events sleeps in select() where it's available */
+#if !SDL_THREADS_DISABLED && (defined(__unix__) || defined(__unix) || \
+    (defined(__APPLE__) && defined(__MACH__)))
+#define SDL_EVENTS_SELECT	1
+#include <sys/types.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+#define MAXWAITFDS	16
+
 /* Public data -- the event filter */
 SDL_EventFilter SDL_EventOK = NULL;
 Uint8 SDL_ProcessEvents[SDL_NUMEVENTS];
 static Uint32 SDL_eventstate = 0;
 
-/* Private data -- event queue */
+/* Private data -- event queue
+
+   Events live in nodes allocated in blocks of MAXEVENTS, up to
+   MAXBLOCKS blocks, and are addressed by index.  Any thread can add an
+   event without a lock: it pops a node from the free stack, growing the
+   pool if that's empty, and pushes it on the incoming stack.  Readers
+   hold SDL_EventQ.lock, move the incoming stack in order to the end of
+   a doubly linked list, and unlink events from anywhere in it.
+
+   The free stack head keeps a 16-bit change count next to the index,
+   so a pop can't succeed on a head that was popped and pushed again
+   in the meantime.
+
+   System window manager messages are copied into a ring of MAXEVENTS
+   instead of the node, since the free stack hands back the node that
+   was just polled and the caller may still be reading its message.
+ */
 #define MAXEVENTS	128
+#define MAXBLOCKS	256
+
+typedef struct SDL_EventNode {
+	SDL_Event event;
+	int prev;
+	int next;	/* also links the free and incoming stacks */
+} SDL_EventNode;
+
+#define SDL_EVENTNODE(i)	(&SDL_EventQ.blocks[(i)/MAXEVENTS][(i)%MAXEVENTS])
+
 static struct {
 	SDL_mutex *lock;
 	int active;
-	int head;
+	SDL_EventNode *blocks[MAXBLOCKS];
+	SDL_atomic_t numblocks;
+	SDL_atomic_t free;		/* count << 16 | (index+1) */
+	SDL_atomic_t incoming;		/* index+1 */
+	int head;			/* list owned by the readers */
 	int tail;
-	SDL_Event event[MAXEVENTS];
-	int wmmsg_next;
+	SDL_atomic_t count;
+	SDL_atomic_t highwater;
+	SDL_atomic_t dropped;
+	SDL_atomic_t wmmsg_next;
 	struct SDL_SysWMmsg wmmsg[MAXEVENTS];
+	SDL_mutex *waitlock;		/* SDL_WaitEvent() sleeps on waitcond */
+	SDL_cond *waitcond;
+	SDL_atomic_t waiting;
+	int wakeup;			/* the event thread was woken */
+#if SDL_EVENTS_SELECT
+	int wakepipe[2];		/* or in select() with this */
+#endif
 } SDL_EventQ;
 
-/* Private data -- event locking structure */
+/* Push a node on the free stack */
+static void SDL_FreeEventNode(int spot)
+{
+	Uint32 old, head;
+
+	do {
+		old = (Uint32)SDL_AtomicGet(&SDL_EventQ.free);
+		SDL_EVENTNODE(spot)->next = (int)(old & 0xFFFF) - 1;
+		head = ((old + 0x10000) & 0xFFFF0000) | (Uint32)(spot + 1);
+	} while ( ! SDL_AtomicCAS(&SDL_EventQ.free, (int)old, (int)head) );
+}
+
+/* Pop a node from the free stack, adding a block if it's empty */
+static int SDL_AllocEventNode(void)
+{
+	Uint32 old, head, block;
+	SDL_EventNode *nodes;
+	int spot, i;
+
+	for ( ; ; ) {
+		old = (Uint32)SDL_AtomicGet(&SDL_EventQ.free);
+		if ( (old & 0xFFFF) != 0 ) {
+			spot = (int)(old & 0xFFFF) - 1;
+			head = ((old + 0x10000) & 0xFFFF0000) |
+			      (Uint32)(SDL_EVENTNODE(spot)->next + 1);
+			if ( SDL_AtomicCAS(&SDL_EventQ.free, (int)old, (int)head) ) {
+				return(spot);
+			}
+			continue;
+		}
+
+		/* Claim the next block, one thread at a time gets it.  The
+		   nodes are allocated first so a failure doesn't use it up. */
+		block = (Uint32)SDL_AtomicGet(&SDL_EventQ.numblocks);
+		if ( block == MAXBLOCKS ) {
+			return(-1);
+		}
+		nodes = (SDL_EventNode *)SDL_malloc(MAXEVENTS*sizeof(*nodes));
+		if ( nodes == NULL ) {
+			return(-1);
+		}
+		if ( ! SDL_AtomicCAS(&SDL_EventQ.numblocks, (int)block, (int)block+1) ) {
+			SDL_free(nodes);
+			continue;
+		}
+		SDL_EventQ.blocks[block] = nodes;
+		spot = block * MAXEVENTS;
+		for ( i=1; i<MAXEVENTS; ++i ) {
+			SDL_FreeEventNode(spot + i);
+		}
+		return(spot);
+	}
+}
+
+/* Private data -- event locking structure, the event thread holds the
+   lock except while it sleeps or runs timers */
 static struct {
 	SDL_mutex *lock;
-	int safe;
 } SDL_EventLock;
 
 /* Thread functions */
 static SDL_Thread *SDL_EventThread = NULL;	/* Thread handle */
 static Uint32 event_thread;			/* The event thread id */
 
+/* Wake the threads sleeping in SDL_SleepOnSources() */
+static void SDL_WriteWakePipe(void)
+{
+#if SDL_EVENTS_SELECT
+	char c = 0;
+
+	/* The pipe doesn't block, if it's full a wakeup is pending anyway */
+	if ( SDL_EventQ.wakepipe[1] >= 0 ) {
+		if ( write(SDL_EventQ.wakepipe[1], &c, 1) < 0 ) {
+			;
+		}
+	}
+#endif
+}
+
+static void SDL_BroadcastWaitCond(void)
+{
+	if ( SDL_EventQ.waitcond ) {
+		SDL_mutexP(SDL_EventQ.waitlock);
+		SDL_CondBroadcast(SDL_EventQ.waitcond);
+		SDL_mutexV(SDL_EventQ.waitlock);
+	}
+}
+
+/* Wake up the application in SDL_WaitEvent(), which sleeps with the
+   event sources unless there's an event thread doing that */
+static void SDL_WakeEventWaiters(void)
+{
+	if ( ! SDL_EventThread ) {
+		SDL_WriteWakePipe();
+	}
+	SDL_BroadcastWaitCond();
+}
+
+void SDL_WakeEventThread(void)
+{
+	SDL_WriteWakePipe();
+	if ( SDL_EventQ.waitcond ) {
+		SDL_mutexP(SDL_EventQ.waitlock);
+		SDL_EventQ.wakeup = 1;
+		SDL_CondBroadcast(SDL_EventQ.waitcond);
+		SDL_mutexV(SDL_EventQ.waitlock);
+	}
+}
+
+/* Collect what the thread pumping events has to wake up for: returns
+   the descriptors in 'fds' and shortens 'timeout' (ms, negative for
+   forever) for the sources that have to be polled.  This calls into
+   the video driver, so the event thread does it with the lock held.
+ */
+static int SDL_GetEventSources(int *fds, int *timeout, int interval)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_VideoDevice *this  = current_video;
+	int numfds, polled, wait, fd;
+
+	numfds = 0;
+	polled = 0;
+	wait = SDL_NextKeyRepeat();
+	if ( wait >= 0 && (*timeout < 0 || wait < *timeout) ) {
+		*timeout = wait;
+	}
+#if !SDL_JOYSTICK_DISABLED
+	if ( SDL_numjoysticks && (SDL_eventstate & SDL_JOYEVENTMASK) ) {
+		numfds = SDL_JoystickEventFds(fds, MAXWAITFDS-2);
+		if ( numfds < 0 ) {
+			numfds = 0;
+			polled = 1;
+		}
+	}
+#endif
+	if ( video ) {
+		fd = -1;
+		if ( video->GetEventFd ) {
+			fd = video->GetEventFd(this, timeout);
+		}
+		if ( fd >= 0 ) {
+			fds[numfds++] = fd;
+		} else {
+			polled = 1;
+		}
+	}
+#if !SDL_EVENTS_SELECT
+	if ( numfds > 0 ) {
+		numfds = 0;
+		polled = 1;
+	}
+#endif
+	if ( polled && (*timeout < 0 || *timeout > interval) ) {
+		*timeout = interval;
+	}
+	return(numfds);
+}
+
+/* Sleep on the wait condition until it's signalled or the timeout
+   passes.  If 'app' is set, the application is waiting in
+   SDL_WaitEvent() and new events wake it too.
+ */
+static void SDL_SleepOnCondition(int timeout, int app)
+{
+	if ( SDL_EventQ.waitcond == NULL ) {
+		SDL_Delay((timeout < 0 || timeout > 10) ? 10 : timeout);
+		return;
+	}
+	SDL_mutexP(SDL_EventQ.waitlock);
+	if ( app ) {
+		SDL_AtomicAdd(&SDL_EventQ.waiting, 1);
+	}
+	if ( app ? !SDL_AtomicGet(&SDL_EventQ.incoming) : !SDL_EventQ.wakeup ) {
+		if ( timeout < 0 ) {
+			SDL_CondWait(SDL_EventQ.waitcond, SDL_EventQ.waitlock);
+		} else {
+			SDL_CondWaitTimeout(SDL_EventQ.waitcond,
+			                    SDL_EventQ.waitlock, timeout);
+		}
+	}
+	if ( app ) {
+		SDL_AtomicAdd(&SDL_EventQ.waiting, -1);
+	} else {
+		SDL_EventQ.wakeup = 0;
+	}
+	SDL_mutexV(SDL_EventQ.waitlock);
+}
+
+/* Like SDL_SleepOnCondition(), but the sources being readable or
+   SDL_WakeEventThread() end the sleep too */
+static void SDL_SleepOnSources(int *fds, int numfds, int timeout, int app)
+{
+#if SDL_EVENTS_SELECT
+	if ( SDL_EventQ.wakepipe[0] >= 0 ) {
+		struct timeval tv, *tvp;
+		fd_set fdset;
+		int i, maxfd;
+		char buf[64];
+
+		fds[numfds++] = SDL_EventQ.wakepipe[0];
+		FD_ZERO(&fdset);
+		maxfd = -1;
+		for ( i=0; i<numfds; ++i ) {
+			FD_SET(fds[i], &fdset);
+			if ( fds[i] > maxfd ) {
+				maxfd = fds[i];
+			}
+		}
+		tvp = NULL;
+		if ( timeout >= 0 ) {
+			tv.tv_sec = timeout / 1000;
+			tv.tv_usec = (timeout % 1000) * 1000;
+			tvp = &tv;
+		}
+
+		/* Waiters count themselves before they look at the queue, so
+		   either they see a new event or SDL_AddEvent() sees them */
+		if ( app ) {
+			SDL_AtomicAdd(&SDL_EventQ.waiting, 1);
+		}
+		if ( (!app || !SDL_AtomicGet(&SDL_EventQ.incoming)) &&
+		     select(maxfd+1, &fdset, NULL, NULL, tvp) > 0 &&
+		     FD_ISSET(SDL_EventQ.wakepipe[0], &fdset) ) {
+			while ( read(SDL_EventQ.wakepipe[0], buf, sizeof(buf)) > 0 ) {
+				;
+			}
+		}
+		if ( app ) {
+			SDL_AtomicAdd(&SDL_EventQ.waiting, -1);
+		}
+		return;
+	}
+#endif
+	SDL_SleepOnCondition(timeout, app);
+}
+
 void SDL_Lock_EventThread(void)
 {
 	if ( SDL_EventThread && (SDL_ThreadID() != event_thread) ) {
-		/* Grab lock and spin until we're sure event thread stopped */
+		/* The event thread only lets go of it while it's sleeping */
 		SDL_mutexP(SDL_EventLock.lock);
-		while ( ! SDL_EventLock.safe ) {
-			SDL_Delay(1);
-		}
 	}
 }
 void SDL_Unlock_EventThread(void)
@@ -98,9 +371,12 @@ static int SDLCALL SDL_GobbleEvents(void *unused)
 #endif
 #endif
 
+	SDL_mutexP(SDL_EventLock.lock);
 	while ( SDL_EventQ.active ) {
 		SDL_VideoDevice *video = current_video;
 		SDL_VideoDevice *this  = current_video;
+		int fds[MAXWAITFDS];
+		int numfds, timeout, wait;
 
 		/* Get events from the video subsystem */
 		if ( video ) {
@@ -117,25 +393,24 @@ static int SDLCALL SDL_GobbleEvents(void *unused)
 		}
 #endif
 
-		/* Give up the CPU for the rest of our timeslice */
-		SDL_EventLock.safe = 1;
-		if ( SDL_timer_running ) {
+		timeout = -1;
+		numfds = SDL_GetEventSources(fds, &timeout, 1);
+
+		/* Other threads can lock us out from here until we wake up */
+		SDL_mutexV(SDL_EventLock.lock);
+		if ( SDL_AtomicGet(&SDL_timer_running) ) {
 			SDL_ThreadedTimerCheck();
+			wait = SDL_ThreadedTimerTimeout();
+			if ( wait >= 0 && (timeout < 0 || wait < timeout) ) {
+				timeout = wait;
+			}
+		}
+		if ( SDL_EventQ.active ) {
+			SDL_SleepOnSources(fds, numfds, timeout, 0);
 		}
-		SDL_Delay(1);
-
-		/* Check for event locking.
-		   On the P of the lock mutex, if the lock is held, this thread
-		   will wait until the lock is released before continuing.  The
-		   safe flag will be set, meaning that the other thread can go
-		   about it's business.  The safe flag is reset before the V,
-		   so as soon as the mutex is free, other threads can see that
-		   it's not safe to interfere with the event thread.
-		 */
 		SDL_mutexP(SDL_EventLock.lock);
-		SDL_EventLock.safe = 0;
-		SDL_mutexV(SDL_EventLock.lock);
 	}
+	SDL_mutexV(SDL_EventLock.lock);
 	SDL_SetTimerThreaded(0);
 	event_thread = 0;
 	return(0);
@@ -160,12 +435,26 @@ static int SDL_StartEventThread(Uint32 flags)
 #endif /* !SDL_THREADS_DISABLED */
 	SDL_EventQ.active = 1;
 
+	/* Without these SDL_WaitEvent() falls back to polling */
+#if !SDL_THREADS_DISABLED
+	SDL_EventQ.waitlock = SDL_CreateMutex();
+	SDL_EventQ.waitcond = SDL_CreateCond();
+#endif
+#if SDL_EVENTS_SELECT
+	if ( pipe(SDL_EventQ.wakepipe) == 0 ) {
+		fcntl(SDL_EventQ.wakepipe[0], F_SETFL, O_NONBLOCK);
+		fcntl(SDL_EventQ.wakepipe[1], F_SETFL, O_NONBLOCK);
+	} else {
+		SDL_EventQ.wakepipe[0] = -1;
+		SDL_EventQ.wakepipe[1] = -1;
+	}
+#endif
+
 	if ( (flags&SDL_INIT_EVENTTHREAD) == SDL_INIT_EVENTTHREAD ) {
 		SDL_EventLock.lock = SDL_CreateMutex();
 		if ( SDL_EventLock.lock == NULL ) {
 			return(-1);
 		}
-		SDL_EventLock.safe = 0;
 
 		/* The event thread will handle timers too */
 		SDL_SetTimerThreaded(2);
@@ -188,6 +477,7 @@ static void SDL_StopEventThread(void)
 {
 	SDL_EventQ.active = 0;
 	if ( SDL_EventThread ) {
+		SDL_WakeEventThread();
 		SDL_WaitThread(SDL_EventThread, NULL);
 		SDL_EventThread = NULL;
 		SDL_DestroyMutex(SDL_EventLock.lock);
@@ -196,6 +486,22 @@ static void SDL_StopEventThread(void)
 #ifndef IPOD
 	SDL_DestroyMutex(SDL_EventQ.lock);
 	SDL_EventQ.lock = NULL;
+#endif
+	if ( SDL_EventQ.waitcond ) {
+		SDL_DestroyCond(SDL_EventQ.waitcond);
+		SDL_EventQ.waitcond = NULL;
+	}
+	if ( SDL_EventQ.waitlock ) {
+		SDL_DestroyMutex(SDL_EventQ.waitlock);
+		SDL_EventQ.waitlock = NULL;
+	}
+#if SDL_EVENTS_SELECT
+	if ( SDL_EventQ.wakepipe[0] >= 0 ) {
+		close(SDL_EventQ.wakepipe[0]);
+		close(SDL_EventQ.wakepipe[1]);
+		SDL_EventQ.wakepipe[0] = -1;
+		SDL_EventQ.wakepipe[1] = -1;
+	}
 #endif
 }
 
@@ -208,6 +514,8 @@ Uint32 SDL_EventThreadID(void)
 
 void SDL_StopEventLoop(void)
 {
+	int i;
+
 	/* Halt the event thread, if running */
 	SDL_StopEventThread();
 
@@ -218,19 +526,38 @@ void SDL_StopEventLoop(void)
 	SDL_QuitQuit();
 
 	/* Clean out EventQ */
-	SDL_EventQ.head = 0;
-	SDL_EventQ.tail = 0;
-	SDL_EventQ.wmmsg_next = 0;
+	SDL_AtomicSet(&SDL_EventQ.numblocks, 0);
+	for ( i=0; i<MAXBLOCKS; ++i ) {
+		if ( SDL_EventQ.blocks[i] ) {
+			SDL_free(SDL_EventQ.blocks[i]);
+			SDL_EventQ.blocks[i] = NULL;
+		}
+	}
+	SDL_AtomicSet(&SDL_EventQ.free, 0);
+	SDL_AtomicSet(&SDL_EventQ.incoming, 0);
+	SDL_EventQ.head = -1;
+	SDL_EventQ.tail = -1;
+	SDL_AtomicSet(&SDL_EventQ.count, 0);
+	SDL_AtomicSet(&SDL_EventQ.highwater, 0);
+	SDL_AtomicSet(&SDL_EventQ.dropped, 0);
+	SDL_AtomicSet(&SDL_EventQ.wmmsg_next, 0);
 }
 
 /* This function (and associated calls) may be called more than once */
 int SDL_StartEventLoop(Uint32 flags)
 {
 	int retcode;
+	int spot;
 
 	/* Clean out the event queue */
 	SDL_EventThread = NULL;
 	SDL_EventQ.lock = NULL;
+	SDL_EventQ.waitlock = NULL;
+	SDL_EventQ.waitcond = NULL;
+#if SDL_EVENTS_SELECT
+	SDL_EventQ.wakepipe[0] = -1;
+	SDL_EventQ.wakepipe[1] = -1;
+#endif
 	SDL_StopEventLoop();
 
 	/* No filter to start with, process most event types */
@@ -252,6 +579,14 @@ int SDL_StartEventLoop(Uint32 flags)
 		return(-1);
 	}
 
+	/* Have the first block of events ready, signal handlers add some */
+	spot = SDL_AllocEventNode();
+	if ( spot < 0 ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	SDL_FreeEventNode(spot);
+
 	/* Create the lock and event thread */
 	if ( SDL_StartEventThread(flags) < 0 ) {
 		SDL_StopEventLoop();
@@ -261,58 +596,102 @@ int SDL_StartEventLoop(Uint32 flags)
 }
 
 
-/* Add an event to the event queue -- called with the queue locked */
+/* Add an event to the event queue -- called from any thread */
 static int SDL_AddEvent(SDL_Event *event)
 {
-	int tail, added;
+	SDL_EventNode *node;
+	int old, count;
+	int spot;
 
-	tail = (SDL_EventQ.tail+1)%MAXEVENTS;
-	if ( tail == SDL_EventQ.head ) {
+	spot = SDL_AllocEventNode();
+	if ( spot < 0 ) {
 		/* Overflow, drop event */
-		added = 0;
-	} else {
-		SDL_EventQ.event[SDL_EventQ.tail] = *event;
-		if (event->type == SDL_SYSWMEVENT) {
-			/* Note that it's possible to lose an event */
-			int next = SDL_EventQ.wmmsg_next;
-			SDL_EventQ.wmmsg[next] = *event->syswm.msg;
-		        SDL_EventQ.event[SDL_EventQ.tail].syswm.msg =
-						&SDL_EventQ.wmmsg[next];
-			SDL_EventQ.wmmsg_next = (next+1)%MAXEVENTS;
-		}
-		SDL_EventQ.tail = tail;
-		added = 1;
-	}
-	return(added);
+		SDL_AtomicAdd(&SDL_EventQ.dropped, 1);
+		return(0);
+	}
+	node = SDL_EVENTNODE(spot);
+	node->event = *event;
+	if (event->type == SDL_SYSWMEVENT) {
+		/* We need to copy the window manager information */
+		Uint32 next = (Uint32)SDL_AtomicAdd(&SDL_EventQ.wmmsg_next, 1);
+		struct SDL_SysWMmsg *wmmsg = &SDL_EventQ.wmmsg[next%MAXEVENTS];
+
+		*wmmsg = *event->syswm.msg;
+		node->event.syswm.msg = wmmsg;
+	}
+	do {
+		old = SDL_AtomicGet(&SDL_EventQ.incoming);
+		node->next = old - 1;
+	} while ( ! SDL_AtomicCAS(&SDL_EventQ.incoming, old, spot+1) );
+
+	count = SDL_AtomicAdd(&SDL_EventQ.count, 1) + 1;
+	do {
+		old = SDL_AtomicGet(&SDL_EventQ.highwater);
+	} while ( (count > old) &&
+	          ! SDL_AtomicCAS(&SDL_EventQ.highwater, old, count) );
+
+	/* Waiters count themselves before they look at the queue, so
+	   either they see this event or we see them */
+	if ( SDL_AtomicGet(&SDL_EventQ.waiting) ) {
+		SDL_WakeEventWaiters();
+	}
+	return(1);
 }
 
-/* Cut an event, and return the next valid spot, or the tail */
-/*                           -- called with the queue locked */
-static int SDL_CutEvent(int spot)
+/* Move the incoming events to the end of the list, in the order they
+   were added -- called with the queue locked */
+static void SDL_CollectEvents(void)
 {
-	if ( spot == SDL_EventQ.head ) {
-		SDL_EventQ.head = (SDL_EventQ.head+1)%MAXEVENTS;
-		return(SDL_EventQ.head);
-	} else
-	if ( (spot+1)%MAXEVENTS == SDL_EventQ.tail ) {
-		SDL_EventQ.tail = spot;
-		return(SDL_EventQ.tail);
-	} else
-	/* We cut the middle -- shift everything over */
-	{
-		int here, next;
-
-		/* This can probably be optimized with SDL_memcpy() -- careful! */
-		if ( --SDL_EventQ.tail < 0 ) {
-			SDL_EventQ.tail = MAXEVENTS-1;
-		}
-		for ( here=spot; here != SDL_EventQ.tail; here = next ) {
-			next = (here+1)%MAXEVENTS;
-			SDL_EventQ.event[here] = SDL_EventQ.event[next];
+	int old;
+	int spot, prev, next;
+
+	do {
+		old = SDL_AtomicGet(&SDL_EventQ.incoming);
+	} while ( old && ! SDL_AtomicCAS(&SDL_EventQ.incoming, old, 0) );
+
+	/* The stack is newest first, link it backwards */
+	next = -1;
+	for ( spot = old - 1; spot >= 0; spot = prev ) {
+		SDL_EventNode *node = SDL_EVENTNODE(spot);
+
+		prev = node->next;
+		node->next = next;
+		if ( next >= 0 ) {
+			SDL_EVENTNODE(next)->prev = spot;
 		}
-		return(spot);
+		next = spot;
+	}
+	if ( next >= 0 ) {
+		SDL_EVENTNODE(next)->prev = SDL_EventQ.tail;
+		if ( SDL_EventQ.tail >= 0 ) {
+			SDL_EVENTNODE(SDL_EventQ.tail)->next = next;
+		} else {
+			SDL_EventQ.head = next;
+		}
+		while ( SDL_EVENTNODE(next)->next >= 0 ) {
+			next = SDL_EVENTNODE(next)->next;
+		}
+		SDL_EventQ.tail = next;
+	}
+}
+
+/* Cut an event out of the list -- called with the queue locked */
+static void SDL_CutEvent(int spot)
+{
+	SDL_EventNode *node = SDL_EVENTNODE(spot);
+
+	if ( node->prev >= 0 ) {
+		SDL_EVENTNODE(node->prev)->next = node->next;
+	} else {
+		SDL_EventQ.head = node->next;
+	}
+	if ( node->next >= 0 ) {
+		SDL_EVENTNODE(node->next)->prev = node->prev;
+	} else {
+		SDL_EventQ.tail = node->prev;
 	}
-	/* NOTREACHED */
+	SDL_AtomicAdd(&SDL_EventQ.count, -1);
+	SDL_FreeEventNode(spot);
 }
 
 /* Lock the event queue, take a peep at it, and unlock it */
@@ -325,36 +704,40 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 	if ( ! SDL_EventQ.active ) {
 		return(-1);
 	}
-	/* Lock the event queue */
 	used = 0;
+
+	/* Adding doesn't need the lock */
+	if ( action == SDL_ADDEVENT ) {
+		for ( i=0; i<numevents; ++i ) {
+			used += SDL_AddEvent(&events[i]);
+		}
+		return(used);
+	}
+
+	/* Lock the event queue */
 	if ( SDL_mutexP(SDL_EventQ.lock) == 0 ) {
-		if ( action == SDL_ADDEVENT ) {
-			for ( i=0; i<numevents; ++i ) {
-				used += SDL_AddEvent(&events[i]);
-			}
-		} else {
-			SDL_Event tmpevent;
-			int spot;
-
-			/* If 'events' is NULL, just see if they exist */
-			if ( events == NULL ) {
-				action = SDL_PEEKEVENT;
-				numevents = 1;
-				events = &tmpevent;
-			}
-			spot = SDL_EventQ.head;
-			while ((used < numevents)&&(spot != SDL_EventQ.tail)) {
-				if ( mask & SDL_EVENTMASK(SDL_EventQ.event[spot].type) ) {
-					events[used++] = SDL_EventQ.event[spot];
-					if ( action == SDL_GETEVENT ) {
-						spot = SDL_CutEvent(spot);
-					} else {
-						spot = (spot+1)%MAXEVENTS;
-					}
-				} else {
-					spot = (spot+1)%MAXEVENTS;
+		SDL_Event tmpevent;
+		int spot, next;
+
+		/* If 'events' is NULL, just see if they exist */
+		if ( events == NULL ) {
+			action = SDL_PEEKEVENT;
+			numevents = 1;
+			events = &tmpevent;
+		}
+		SDL_CollectEvents();
+		spot = SDL_EventQ.head;
+		while ((used < numevents)&&(spot >= 0)) {
+			SDL_EventNode *node = SDL_EVENTNODE(spot);
+
+			next = node->next;
+			if ( mask & SDL_EVENTMASK(node->event.type) ) {
+				events[used++] = node->event;
+				if ( action == SDL_GETEVENT ) {
+					SDL_CutEvent(spot);
 				}
 			}
+			spot = next;
 		}
 		SDL_mutexV(SDL_EventQ.lock);
 	} else {
@@ -364,6 +747,16 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 	return(used);
 }
 
+void SDL_GetEventQueueStats(Uint32 *highwater, Uint32 *dropped)
+{
+	if ( highwater ) {
+		*highwater = (Uint32)SDL_AtomicGet(&SDL_EventQ.highwater);
+	}
+	if ( dropped ) {
+		*dropped = (Uint32)SDL_AtomicGet(&SDL_EventQ.dropped);
+	}
+}
+
 /* Run the system dependent event loops */
 void SDL_PumpEvents(void)
 {
@@ -400,18 +793,43 @@ int SDL_PollEvent (SDL_Event *event)
 	return 1;
 }
 
-int SDL_WaitEvent (SDL_Event *event)
+int SDL_WaitEventTimeout (SDL_Event *event, int timeout)
 {
+	Uint32 expiration = 0;
+	int fds[MAXWAITFDS];
+	int numfds, left;
+
+	if ( timeout > 0 ) {
+		expiration = SDL_GetTicks() + timeout;
+	}
 	while ( 1 ) {
 		SDL_PumpEvents();
 		switch(SDL_PeepEvents(event, 1, SDL_GETEVENT, SDL_ALLEVENTS)) {
 		    case -1: return 0;
 		    case 1: return 1;
-		    case 0: SDL_Delay(10);
+		}
+		left = -1;
+		if ( timeout >= 0 ) {
+			left = (timeout > 0) ? (int)(expiration - SDL_GetTicks()) : 0;
+			if ( left <= 0 ) {
+				return 0;
+			}
+		}
+		if ( SDL_EventThread ) {
+			/* The event thread pumps, it wakes us with new events */
+			SDL_SleepOnCondition(left, 1);
+		} else {
+			numfds = SDL_GetEventSources(fds, &left, 10);
+			SDL_SleepOnSources(fds, numfds, left, 1);
 		}
 	}
 }
 
+int SDL_WaitEvent (SDL_Event *event)
+{
+	return SDL_WaitEventTimeout(event, -1);
+}
+
 int SDL_PushEvent(SDL_Event *event)
 {
 	if ( SDL_PeepEvents(event, 1, SDL_ADDEVENT, 0) <= 0 )
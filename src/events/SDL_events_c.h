@@ -81,6 +81,13 @@ extern void SDL_ResetKeyboard(void);
 /* Used by the event loop to queue pending keyboard repeat events */
 extern void SDL_CheckKeyRepeat(void);
 
+/* Used by the timers to make the event thread look at them again */
+extern void SDL_WakeEventThread(void);
+
+/* Used by SDL_WaitEvent() to find the ms until the next key repeat,
+   or -1 if no key is repeating */
+extern int SDL_NextKeyRepeat(void);
+
 /* Used by the OS keyboard code to detect whether or not to do UNICODE */
 #ifndef DEFAULT_UNICODE_TRANSLATION
 #define DEFAULT_UNICODE_TRANSLATION 0	/* Default off because of overhead */
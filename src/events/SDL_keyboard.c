@@ -593,6 +593,22 @@ void SDL_CheckKeyRepeat(void)
 	}
 }
 
+int SDL_NextKeyRepeat(void)
+{
+	int wait;
+
+	if ( ! SDL_KeyRepeat.timestamp ) {
+		return(-1);
+	}
+	if ( SDL_KeyRepeat.firsttime ) {
+		wait = SDL_KeyRepeat.delay;
+	} else {
+		wait = SDL_KeyRepeat.interval;
+	}
+	wait -= (int)(SDL_GetTicks() - SDL_KeyRepeat.timestamp) - 1;
+	return((wait > 0) ? wait : 0);
+}
+
 int SDL_EnableKeyRepeat(int delay, int interval)
 {
 	if ( (delay < 0) || (interval < 0) ) {
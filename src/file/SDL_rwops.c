@@ -19,6 +19,10 @@
     Sam Lantinga
     slouken@libsdl.org
 */
+/* Use a 64-bit off_t on 32-bit systems so files over 2 GB work */
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
 #include "SDL_config.h"
 
 /* This file provides a general interface for SDL to read and write
@@ -28,6 +32,38 @@
 #include "SDL_endian.h"
 #include "SDL_rwops.h"
 
+#if !defined(__WIN32__) && defined(SDL_HAS_64BIT_TYPE) && \
+    (defined(__unix__) || defined(__MACOSX__) || defined(__QNXNTO__))
+#define SDL_RWOPS_FD	1
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
+#endif
+
+/* Offsets inside SDL are 64-bit where the compiler has a 64-bit type */
+#ifdef SDL_HAS_64BIT_TYPE
+typedef Sint64 rwoff_t;
+#else
+typedef long rwoff_t;
+#endif
+
+static rwoff_t RW_Size(SDL_RWops *context);
+
+/* The old seek function returns an int */
+static int SDL_RWoffset32(rwoff_t offset)
+{
+	if ( offset > 0x7FFFFFFF ) {
+		SDL_SetError("Offset past 2 GB, use SDL_RWseek64()");
+		return(-1);
+	}
+	return((int)offset);
+}
+
 
 #if defined(__WIN32__) && !defined(__SYMBIAN32__)
 
@@ -45,6 +81,33 @@
 
 #define READAHEAD_BUFFER_SIZE	1024
 
+/* SDL_RWops has no room for the read-ahead size, it's kept in front of
+   the buffer */
+static void *win32_buffer_alloc(int capacity)
+{
+	int *block = (int *)SDL_malloc(sizeof(int) + capacity);
+	if ( block == NULL ) {
+		return(NULL);
+	}
+	*block = capacity;
+	return(block + 1);
+}
+
+static void win32_buffer_free(void *data)
+{
+	if ( data ) {
+		SDL_free((int *)data - 1);
+	}
+}
+
+static int win32_buffer_capacity(SDL_RWops *context)
+{
+	if ( context->hidden.win32io.buffer.data == NULL ) {
+		return(0);
+	}
+	return(((int *)context->hidden.win32io.buffer.data)[-1]);
+}
+
 static int SDLCALL win32_file_open(SDL_RWops *context, const char *filename, const char *mode)
 {
 #ifndef _WIN32_WCE
@@ -79,7 +142,7 @@ static int SDLCALL win32_file_open(SDL_RWops *context, const char *filename, con
 	if (!r_right && !w_right) /* inconsistent mode */
 		return -1; /* failed (invalid call) */
 
-	context->hidden.win32io.buffer.data = (char *)SDL_malloc(READAHEAD_BUFFER_SIZE);
+	context->hidden.win32io.buffer.data = win32_buffer_alloc(READAHEAD_BUFFER_SIZE);
 	if (!context->hidden.win32io.buffer.data) {
 		SDL_OutOfMemory();
 		return -1;
@@ -92,7 +155,7 @@ static int SDLCALL win32_file_open(SDL_RWops *context, const char *filename, con
 
 		if ( MultiByteToWideChar(CP_UTF8, 0, filename, -1, filenameW, size) == 0 ) {
 			SDL_stack_free(filenameW);
-			SDL_free(context->hidden.win32io.buffer.data);
+			win32_buffer_free(context->hidden.win32io.buffer.data);
 			context->hidden.win32io.buffer.data = NULL;
 			SDL_SetError("Unable to convert filename to Unicode");
 			return -1;
@@ -125,7 +188,7 @@ static int SDLCALL win32_file_open(SDL_RWops *context, const char *filename, con
 		wchar_t *filenameW = SDL_stack_alloc(wchar_t, size);
 		if ( MultiByteToWideChar(CP_UTF8, 0, filename, -1, filenameW, size) == 0 ) {
 			SDL_stack_free(filenameW);
-			SDL_free(context->hidden.win32io.buffer.data);
+			win32_buffer_free(context->hidden.win32io.buffer.data);
 			context->hidden.win32io.buffer.data = NULL;
 			SDL_SetError("Unable to convert filename to Unicode");
 			return -1;
@@ -152,7 +215,7 @@ static int SDLCALL win32_file_open(SDL_RWops *context, const char *filename, con
 			bDefCharUsed) {
 			SDL_stack_free(filenameA);
 			SDL_free(utf16);
-			SDL_free(context->hidden.win32io.buffer.data);
+			win32_buffer_free(context->hidden.win32io.buffer.data);
 			context->hidden.win32io.buffer.data = NULL;
 			SDL_SetError("Unable to convert filename to Unicode");
 			return -1;
@@ -173,7 +236,7 @@ static int SDLCALL win32_file_open(SDL_RWops *context, const char *filename, con
 #endif /* _WIN32_WCE */
 
 	if (h==INVALID_HANDLE_VALUE) {
-		SDL_free(context->hidden.win32io.buffer.data);
+		win32_buffer_free(context->hidden.win32io.buffer.data);
 		context->hidden.win32io.buffer.data = NULL;
 		SDL_SetError("Couldn't open %s",filename);
 		return -2; /* failed (CreateFile) */
@@ -183,10 +246,11 @@ static int SDLCALL win32_file_open(SDL_RWops *context, const char *filename, con
 
 	return 0; /* ok */
 }
-static int SDLCALL win32_file_seek(SDL_RWops *context, int offset, int whence)
+static rwoff_t win32_file_seek64(SDL_RWops *context, rwoff_t offset, int whence)
 {
 	DWORD win32whence;
-	int   file_pos;
+	LONG  high;
+	DWORD low;
 	
 	if (!context || context->hidden.win32io.h == INVALID_HANDLE_VALUE) {
 		SDL_SetError("win32_file_seek: invalid context/file not opened");
@@ -211,14 +275,19 @@ static int SDLCALL win32_file_seek(SDL_RWops *context, int offset, int whence)
 			return -1;
 	}
 
-	file_pos = SetFilePointer(context->hidden.win32io.h,offset,NULL,win32whence);
+	high = (LONG)(offset >> 32);
+	low = SetFilePointer(context->hidden.win32io.h,(LONG)offset,&high,win32whence);
 
-	if ( file_pos != INVALID_SET_FILE_POINTER )
-		return file_pos; /* success */
+	if ( low != INVALID_SET_FILE_POINTER || GetLastError() == NO_ERROR )
+		return ((rwoff_t)high << 32) | low; /* success */
 	
 	SDL_Error(SDL_EFSEEK);
 	return -1; /* error */
 }
+static int SDLCALL win32_file_seek(SDL_RWops *context, int offset, int whence)
+{
+	return SDL_RWoffset32(win32_file_seek64(context, offset, whence));
+}
 static int SDLCALL win32_file_read(SDL_RWops *context, void *ptr, int size, int maxnum)
 {
 	int		total_need; 
@@ -247,8 +316,8 @@ static int SDLCALL win32_file_read(SDL_RWops *context, void *ptr, int size, int
 		total_read += read_ahead;
     }
 
-    if (total_need < READAHEAD_BUFFER_SIZE) {
-        if (!ReadFile(context->hidden.win32io.h,context->hidden.win32io.buffer.data,READAHEAD_BUFFER_SIZE,&byte_read,NULL)) {
+    if (total_need < win32_buffer_capacity(context)) {
+        if (!ReadFile(context->hidden.win32io.h,context->hidden.win32io.buffer.data,win32_buffer_capacity(context),&byte_read,NULL)) {
             SDL_Error(SDL_EFREAD);
             return 0;
         }
@@ -307,7 +376,7 @@ static int SDLCALL win32_file_close(SDL_RWops *context)
 			context->hidden.win32io.h = INVALID_HANDLE_VALUE; /* to be sure */
 		}
 		if (context->hidden.win32io.buffer.data) {
-			SDL_free(context->hidden.win32io.buffer.data);
+			win32_buffer_free(context->hidden.win32io.buffer.data);
 			context->hidden.win32io.buffer.data = NULL;
 		}
 		SDL_FreeRW(context);
@@ -320,14 +389,24 @@ static int SDLCALL win32_file_close(SDL_RWops *context)
 
 /* Functions to read/write stdio file pointers */
 
-static int SDLCALL stdio_seek(SDL_RWops *context, int offset, int whence)
+static rwoff_t stdio_seek64(SDL_RWops *context, rwoff_t offset, int whence)
 {
-	if ( fseek(context->hidden.stdio.fp, offset, whence) == 0 ) {
+#if HAVE_FSEEKO
+	if ( fseeko(context->hidden.stdio.fp, (off_t)offset, whence) == 0 ) {
+		return(ftello(context->hidden.stdio.fp));
+	}
+#else
+	if ( offset == (long)offset &&
+	     fseek(context->hidden.stdio.fp, (long)offset, whence) == 0 ) {
 		return(ftell(context->hidden.stdio.fp));
-	} else {
-		SDL_Error(SDL_EFSEEK);
-		return(-1);
 	}
+#endif
+	SDL_Error(SDL_EFSEEK);
+	return(-1);
+}
+static int SDLCALL stdio_seek(SDL_RWops *context, int offset, int whence)
+{
+	return SDL_RWoffset32(stdio_seek64(context, offset, whence));
 }
 static int SDLCALL stdio_read(SDL_RWops *context, void *ptr, int size, int maxnum)
 {
@@ -362,34 +441,230 @@ static int SDLCALL stdio_close(SDL_RWops *context)
 }
 #endif /* !HAVE_STDIO_H */
 
+#if SDL_RWOPS_FD
+
+/* Functions to read/write POSIX file descriptors.  Small reads are served
+   from a read-ahead buffer, and 'position' is where the caller thinks the
+   file is, which is behind the real file offset while the buffer holds
+   data.
+ */
+
+#define FD_READAHEAD_SIZE	8192
+
+/* Kept behind hidden.unknown.data1, so SDL_RWops doesn't grow */
+struct fd_stream {
+	int fd;
+	int autoclose;
+	int append;
+	Sint64 position;
+	struct {
+		Uint8 *data;
+		int capacity;
+		int size;
+		int pos;
+	} buffer;
+};
+#define FDIO(context)	((struct fd_stream *)(context)->hidden.unknown.data1)
+
+/* Move the file offset back to where the caller is and empty the buffer */
+static int fd_unbuffer(SDL_RWops *context)
+{
+	if ( FDIO(context)->buffer.pos < FDIO(context)->buffer.size ) {
+		if ( lseek(FDIO(context)->fd, (off_t)FDIO(context)->position, SEEK_SET) < 0 ) {
+			SDL_Error(SDL_EFSEEK);
+			return(-1);
+		}
+	}
+	FDIO(context)->buffer.size = 0;
+	FDIO(context)->buffer.pos = 0;
+	return(0);
+}
+static Sint64 fd_seek64(SDL_RWops *context, Sint64 offset, int whence)
+{
+	Sint64 position = FDIO(context)->position;
+	int pos = FDIO(context)->buffer.pos;
+	int size = FDIO(context)->buffer.size;
+	Sint64 target;
+	off_t result;
+
+	switch (whence) {
+		case RW_SEEK_SET:
+			target = offset;
+			break;
+		case RW_SEEK_CUR:
+			target = position + offset;
+			break;
+		case RW_SEEK_END:
+			target = -1;
+			break;
+		default:
+			SDL_SetError("Unknown value for 'whence'");
+			return(-1);
+	}
+
+	/* Seeks within the buffer (and SDL_RWtell()) don't touch the file */
+	if ( whence != RW_SEEK_END &&
+	     target >= position - pos && target <= position + (size - pos) ) {
+		FDIO(context)->buffer.pos = pos + (int)(target - position);
+		FDIO(context)->position = target;
+		return(target);
+	}
+
+	if ( whence == RW_SEEK_END ) {
+		result = lseek(FDIO(context)->fd, (off_t)offset, SEEK_END);
+	} else {
+		result = lseek(FDIO(context)->fd, (off_t)target, SEEK_SET);
+	}
+	if ( result < 0 ) {
+		SDL_Error(SDL_EFSEEK);
+		return(-1);
+	}
+	FDIO(context)->buffer.size = 0;
+	FDIO(context)->buffer.pos = 0;
+	FDIO(context)->position = result;
+	return(result);
+}
+static int SDLCALL fd_seek(SDL_RWops *context, int offset, int whence)
+{
+	return SDL_RWoffset32(fd_seek64(context, offset, whence));
+}
+static int SDLCALL fd_read(SDL_RWops *context, void *ptr, int size, int maxnum)
+{
+	Uint8 *dst = (Uint8 *)ptr;
+	size_t total_bytes;
+	size_t done = 0;
+
+	total_bytes = (size_t)maxnum * size;
+	if ( (maxnum <= 0) || (size <= 0) || ((total_bytes / maxnum) != (size_t) size) ) {
+		return 0;
+	}
+
+	while ( done < total_bytes ) {
+		int left = FDIO(context)->buffer.size - FDIO(context)->buffer.pos;
+		ssize_t nread;
+
+		if ( left > 0 ) {
+			size_t count = total_bytes - done;
+			if ( count > (size_t)left ) {
+				count = left;
+			}
+			SDL_memcpy(dst + done, FDIO(context)->buffer.data + FDIO(context)->buffer.pos, count);
+			FDIO(context)->buffer.pos += (int)count;
+			done += count;
+			continue;
+		}
+
+		if ( (total_bytes - done) >= (size_t)FDIO(context)->buffer.capacity ) {
+			/* Big reads go straight to the caller */
+			nread = read(FDIO(context)->fd, dst + done, total_bytes - done);
+			if ( nread > 0 ) {
+				done += nread;
+			}
+		} else {
+			nread = read(FDIO(context)->fd, FDIO(context)->buffer.data, FDIO(context)->buffer.capacity);
+			if ( nread > 0 ) {
+				FDIO(context)->buffer.size = (int)nread;
+				FDIO(context)->buffer.pos = 0;
+			}
+		}
+		if ( nread == 0 ) {
+			break;
+		}
+		if ( nread < 0 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+			SDL_Error(SDL_EFREAD);
+			break;
+		}
+	}
+	FDIO(context)->position += done;
+	return (int)(done / size);
+}
+static int SDLCALL fd_write(SDL_RWops *context, const void *ptr, int size, int num)
+{
+	const Uint8 *src = (const Uint8 *)ptr;
+	size_t total_bytes;
+	size_t done = 0;
+
+	total_bytes = (size_t)num * size;
+	if ( (num <= 0) || (size <= 0) || ((total_bytes / num) != (size_t) size) ) {
+		return 0;
+	}
+	if ( fd_unbuffer(context) < 0 ) {
+		return 0;
+	}
+
+	while ( done < total_bytes ) {
+		ssize_t nwrote = write(FDIO(context)->fd, src + done, total_bytes - done);
+		if ( nwrote < 0 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+			SDL_Error(SDL_EFWRITE);
+			break;
+		}
+		done += nwrote;
+	}
+	if ( FDIO(context)->append ) {
+		off_t result = lseek(FDIO(context)->fd, 0, SEEK_CUR);
+		if ( result >= 0 ) {
+			FDIO(context)->position = result;
+		}
+	} else {
+		FDIO(context)->position += done;
+	}
+	return (int)(done / size);
+}
+static int SDLCALL fd_close(SDL_RWops *context)
+{
+	int status = 0;
+
+	if ( context ) {
+		if ( FDIO(context)->autoclose ) {
+			status = close(FDIO(context)->fd);
+		}
+		SDL_free(FDIO(context)->buffer.data);
+		SDL_free(FDIO(context));
+		SDL_FreeRW(context);
+	}
+	return(status);
+}
+#endif /* SDL_RWOPS_FD */
+
 /* Functions to read/write memory pointers */
 
-static int SDLCALL mem_seek(SDL_RWops *context, int offset, int whence)
+static rwoff_t mem_seek64(SDL_RWops *context, rwoff_t offset, int whence)
 {
-	Uint8 *newpos;
+	rwoff_t size = (context->hidden.mem.stop - context->hidden.mem.base);
+	rwoff_t newpos;
 
 	switch (whence) {
 		case RW_SEEK_SET:
-			newpos = context->hidden.mem.base+offset;
+			newpos = offset;
 			break;
 		case RW_SEEK_CUR:
-			newpos = context->hidden.mem.here+offset;
+			newpos = (context->hidden.mem.here - context->hidden.mem.base) + offset;
 			break;
 		case RW_SEEK_END:
-			newpos = context->hidden.mem.stop+offset;
+			newpos = size + offset;
 			break;
 		default:
 			SDL_SetError("Unknown value for 'whence'");
 			return(-1);
 	}
-	if ( newpos < context->hidden.mem.base ) {
-		newpos = context->hidden.mem.base;
+	if ( newpos < 0 ) {
+		newpos = 0;
 	}
-	if ( newpos > context->hidden.mem.stop ) {
-		newpos = context->hidden.mem.stop;
+	if ( newpos > size ) {
+		newpos = size;
 	}
-	context->hidden.mem.here = newpos;
-	return(context->hidden.mem.here-context->hidden.mem.base);
+	context->hidden.mem.here = context->hidden.mem.base + (size_t)newpos;
+	return(newpos);
+}
+static int SDLCALL mem_seek(SDL_RWops *context, int offset, int whence)
+{
+	return SDL_RWoffset32(mem_seek64(context, offset, whence));
 }
 static int SDLCALL mem_read(SDL_RWops *context, void *ptr, int size, int maxnum)
 {
@@ -433,6 +708,29 @@ static int SDLCALL mem_close(SDL_RWops *context)
 	return(0);
 }
 
+/* Files from SDL_RWFromMappedFile() are memory streams that are either
+   mapped or read into a buffer, and released differently */
+static int SDLCALL map_close(SDL_RWops *context)
+{
+	if ( context ) {
+#if SDL_RWOPS_FD && HAVE_MMAP
+		munmap(context->hidden.mem.base, context->hidden.mem.stop - context->hidden.mem.base);
+#elif defined(__WIN32__) && !defined(__SYMBIAN32__)
+		UnmapViewOfFile(context->hidden.mem.base);
+#endif
+		SDL_FreeRW(context);
+	}
+	return(0);
+}
+static int SDLCALL mapcopy_close(SDL_RWops *context)
+{
+	if ( context ) {
+		SDL_free(context->hidden.mem.base);
+		SDL_FreeRW(context);
+	}
+	return(0);
+}
+
 
 /* Functions to create SDL_RWops structures from various data sources */
 
@@ -483,9 +781,7 @@ static char *unix_to_mac(const char *file)
 SDL_RWops *SDL_RWFromFile(const char *file, const char *mode)
 {
 	SDL_RWops *rwops = NULL;
-#ifdef HAVE_STDIO_H
-	FILE *fp = NULL;
-#endif
+
 	if ( !file || !*file || !mode || !*mode ) {
 		SDL_SetError("SDL_RWFromFile(): No file or no mode specified");
 		return NULL;
@@ -504,21 +800,50 @@ SDL_RWops *SDL_RWFromFile(const char *file, const char *mode)
 	rwops->write = win32_file_write;
 	rwops->close = win32_file_close;
 
+#elif SDL_RWOPS_FD
+	{
+		int flags;
+		int fd;
+
+		if ( SDL_strchr(mode, '+') ) {
+			flags = O_RDWR;
+		} else if ( *mode == 'r' ) {
+			flags = O_RDONLY;
+		} else {
+			flags = O_WRONLY;
+		}
+		if ( *mode == 'w' ) {
+			flags |= (O_CREAT | O_TRUNC);
+		} else if ( *mode == 'a' ) {
+			flags |= (O_CREAT | O_APPEND);
+		}
+		fd = open(file, flags, 0666);
+		if ( fd < 0 ) {
+			SDL_SetError("Couldn't open %s", file);
+		} else {
+			rwops = SDL_RWFromFD(fd, 1);
+			if ( rwops == NULL ) {
+				close(fd);
+			}
+		}
+	}
+
 #elif HAVE_STDIO_H
+	{
+		FILE *fp;
 
 #ifdef __MACOS__
-	{
 		char *mpath = unix_to_mac(file);
 		fp = fopen(mpath, mode);
 		SDL_free(mpath);
-	}
 #else
-	fp = fopen(file, mode);
+		fp = fopen(file, mode);
 #endif
-	if ( fp == NULL ) {
-		SDL_SetError("Couldn't open %s", file);
-	} else {
-		rwops = SDL_RWFromFP(fp, 1);
+		if ( fp == NULL ) {
+			SDL_SetError("Couldn't open %s", file);
+		} else {
+			rwops = SDL_RWFromFP(fp, 1);
+		}
 	}
 #else
 	SDL_SetError("SDL not compiled with stdio support");
@@ -545,6 +870,314 @@ SDL_RWops *SDL_RWFromFP(FILE *fp, int autoclose)
 }
 #endif /* HAVE_STDIO_H */
 
+SDL_RWops *SDL_RWFromFD(int fd, int autoclose)
+{
+#if SDL_RWOPS_FD
+	SDL_RWops *rwops;
+	off_t position;
+	int flags;
+
+	rwops = SDL_AllocRW();
+	if ( rwops == NULL ) {
+		return(NULL);
+	}
+	rwops->hidden.unknown.data1 = SDL_malloc(sizeof(struct fd_stream));
+	if ( rwops->hidden.unknown.data1 == NULL ) {
+		SDL_OutOfMemory();
+		SDL_FreeRW(rwops);
+		return(NULL);
+	}
+	FDIO(rwops)->buffer.data = (Uint8 *)SDL_malloc(FD_READAHEAD_SIZE);
+	if ( FDIO(rwops)->buffer.data == NULL ) {
+		SDL_OutOfMemory();
+		SDL_free(FDIO(rwops));
+		SDL_FreeRW(rwops);
+		return(NULL);
+	}
+	FDIO(rwops)->buffer.capacity = FD_READAHEAD_SIZE;
+	FDIO(rwops)->buffer.size = 0;
+	FDIO(rwops)->buffer.pos = 0;
+
+	position = lseek(fd, 0, SEEK_CUR);
+	flags = fcntl(fd, F_GETFL);
+	rwops->seek = fd_seek;
+	rwops->read = fd_read;
+	rwops->write = fd_write;
+	rwops->close = fd_close;
+	FDIO(rwops)->fd = fd;
+	FDIO(rwops)->autoclose = autoclose;
+	FDIO(rwops)->append = (flags >= 0 && (flags & O_APPEND));
+	FDIO(rwops)->position = (position < 0) ? 0 : position;
+	return(rwops);
+#else
+	SDL_SetError("SDL_RWFromFD() isn't supported on this platform");
+	return(NULL);
+#endif /* SDL_RWOPS_FD */
+}
+
+SDL_RWops *SDL_RWFromMappedFile(const char *file)
+{
+	SDL_RWops *rwops;
+	Uint8 *base = NULL;
+	size_t length = 0;
+	int mapped = 0;
+
+	if ( !file || !*file ) {
+		SDL_SetError("SDL_RWFromMappedFile(): No file specified");
+		return(NULL);
+	}
+	rwops = SDL_AllocRW();
+	if ( rwops == NULL ) {
+		return(NULL);
+	}
+
+#if SDL_RWOPS_FD && HAVE_MMAP
+	{
+		struct stat st;
+		int fd = open(file, O_RDONLY);
+
+		if ( fd < 0 ) {
+			SDL_SetError("Couldn't open %s", file);
+			SDL_FreeRW(rwops);
+			return(NULL);
+		}
+		/* Empty files can't be mapped */
+		if ( fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+		     st.st_size > 0 && (Uint64)st.st_size <= (size_t)-1 ) {
+			void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if ( data != MAP_FAILED ) {
+				base = (Uint8 *)data;
+				length = (size_t)st.st_size;
+				mapped = 1;
+			}
+		}
+		close(fd);
+	}
+#elif defined(__WIN32__) && !defined(__SYMBIAN32__) && !defined(_WIN32_WCE)
+	{
+		SDL_RWops *src = SDL_RWFromFile(file, "rb");
+		DWORD high = 0;
+		DWORD low;
+
+		if ( src == NULL ) {
+			SDL_FreeRW(rwops);
+			return(NULL);
+		}
+		low = GetFileSize(src->hidden.win32io.h, &high);
+		if ( (low != INVALID_FILE_SIZE || GetLastError() == NO_ERROR) &&
+		     (low != 0 || high != 0) && (sizeof(size_t) > 4 || high == 0) ) {
+			HANDLE mapping = CreateFileMapping(src->hidden.win32io.h, NULL, PAGE_READONLY, 0, 0, NULL);
+			if ( mapping ) {
+				base = (Uint8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				CloseHandle(mapping);
+				if ( base ) {
+					length = (size_t)(((Uint64)high << 32) | low);
+					mapped = 1;
+				}
+			}
+		}
+		SDL_RWclose(src);
+	}
+#endif
+
+	if ( !mapped ) {
+		/* Read the whole file instead */
+		SDL_RWops *src = SDL_RWFromFile(file, "rb");
+		rwoff_t size;
+
+		if ( src == NULL ) {
+			SDL_FreeRW(rwops);
+			return(NULL);
+		}
+		size = RW_Size(src);
+		if ( size < 0 || (size_t)size != size ) {
+			SDL_SetError("Couldn't get the size of %s", file);
+		} else {
+			length = (size_t)size;
+			base = (Uint8 *)SDL_malloc(length ? length : 1);
+			if ( base == NULL ) {
+				SDL_OutOfMemory();
+			} else {
+				size_t done = 0;
+				while ( done < length ) {
+					int chunk = (length - done) > 0x40000000 ? 0x40000000 : (int)(length - done);
+					if ( SDL_RWread(src, base + done, 1, chunk) != chunk ) {
+						break;
+					}
+					done += chunk;
+				}
+				if ( done < length ) {
+					SDL_Error(SDL_EFREAD);
+					SDL_free(base);
+					base = NULL;
+				}
+			}
+		}
+		SDL_RWclose(src);
+		if ( base == NULL ) {
+			SDL_FreeRW(rwops);
+			return(NULL);
+		}
+	}
+
+	rwops->seek = mem_seek;
+	rwops->read = mem_read;
+	rwops->write = mem_writeconst;
+	rwops->close = mapped ? map_close : mapcopy_close;
+	rwops->hidden.mem.base = base;
+	rwops->hidden.mem.here = base;
+	rwops->hidden.mem.stop = base + length;
+	return(rwops);
+}
+
+const void *SDL_RWMappedData(SDL_RWops *context, size_t *size)
+{
+	if ( context->close != map_close && context->close != mapcopy_close ) {
+		return(NULL);
+	}
+	if ( size ) {
+		*size = (context->hidden.mem.stop - context->hidden.mem.base);
+	}
+	return(context->hidden.mem.base);
+}
+
+int SDL_RWborrow(SDL_RWops *context, const void **ptr, int size)
+{
+	size_t available;
+
+	if ( context->seek != mem_seek || size < 0 ) {
+		return(-1);
+	}
+	available = (context->hidden.mem.stop - context->hidden.mem.here);
+	if ( (size_t)size > available ) {
+		size = (int)available;
+	}
+	*ptr = context->hidden.mem.here;
+	context->hidden.mem.here += size;
+	return(size);
+}
+
+int SDL_RWSetReadAhead(SDL_RWops *context, int size)
+{
+	if ( size < 0 ) {
+		size = 0;
+	}
+#if SDL_RWOPS_FD
+	if ( context->seek == fd_seek ) {
+		Uint8 *data = NULL;
+
+		if ( fd_unbuffer(context) < 0 ) {
+			return(-1);
+		}
+		if ( size > 0 ) {
+			data = (Uint8 *)SDL_realloc(FDIO(context)->buffer.data, size);
+			if ( data == NULL ) {
+				SDL_OutOfMemory();
+				return(-1);
+			}
+		} else {
+			SDL_free(FDIO(context)->buffer.data);
+		}
+		FDIO(context)->buffer.data = data;
+		FDIO(context)->buffer.capacity = size;
+		return(0);
+	}
+#endif
+#if defined(__WIN32__) && !defined(__SYMBIAN32__)
+	if ( context->seek == win32_file_seek ) {
+		void *data = NULL;
+
+		if ( context->hidden.win32io.buffer.left ) {
+			SetFilePointer(context->hidden.win32io.h,-context->hidden.win32io.buffer.left,NULL,FILE_CURRENT);
+			context->hidden.win32io.buffer.left = 0;
+		}
+		if ( size > 0 ) {
+			data = win32_buffer_alloc(size);
+			if ( data == NULL ) {
+				SDL_OutOfMemory();
+				return(-1);
+			}
+		}
+		win32_buffer_free(context->hidden.win32io.buffer.data);
+		context->hidden.win32io.buffer.data = data;
+		return(0);
+	}
+#endif
+	SDL_SetError("SDL_RWSetReadAhead(): Not a buffered file stream");
+	return(-1);
+}
+
+static rwoff_t RW_Seek(SDL_RWops *context, rwoff_t offset, int whence)
+{
+#if SDL_RWOPS_FD
+	if ( context->seek == fd_seek ) {
+		return fd_seek64(context, offset, whence);
+	}
+#endif
+#if defined(__WIN32__) && !defined(__SYMBIAN32__)
+	if ( context->seek == win32_file_seek ) {
+		return win32_file_seek64(context, offset, whence);
+	}
+#endif
+#ifdef HAVE_STDIO_H
+	if ( context->seek == stdio_seek ) {
+		return stdio_seek64(context, offset, whence);
+	}
+#endif
+	if ( context->seek == mem_seek ) {
+		return mem_seek64(context, offset, whence);
+	}
+
+	/* Somebody else's stream, all we have is the 32-bit seek */
+	if ( offset < -0x7FFFFFFF || offset > 0x7FFFFFFF ) {
+		SDL_SetError("Offset out of range for this data source");
+		return(-1);
+	}
+	return SDL_RWseek(context, (int)offset, whence);
+}
+
+static rwoff_t RW_Size(SDL_RWops *context)
+{
+	rwoff_t pos, size;
+
+#if SDL_RWOPS_FD
+	if ( context->seek == fd_seek ) {
+		struct stat st;
+		if ( fstat(FDIO(context)->fd, &st) == 0 && S_ISREG(st.st_mode) ) {
+			return(st.st_size);
+		}
+	}
+#endif
+	if ( context->seek == mem_seek ) {
+		return(context->hidden.mem.stop - context->hidden.mem.base);
+	}
+
+	pos = RW_Seek(context, 0, RW_SEEK_CUR);
+	if ( pos < 0 ) {
+		return(-1);
+	}
+	size = RW_Seek(context, 0, RW_SEEK_END);
+	RW_Seek(context, pos, RW_SEEK_SET);
+	return(size);
+}
+
+#ifdef SDL_HAS_64BIT_TYPE
+Sint64 SDL_RWseek64(SDL_RWops *context, Sint64 offset, int whence)
+{
+	return RW_Seek(context, offset, whence);
+}
+
+Sint64 SDL_RWtell64(SDL_RWops *context)
+{
+	return RW_Seek(context, 0, RW_SEEK_CUR);
+}
+
+Sint64 SDL_RWsize(SDL_RWops *context)
+{
+	return RW_Size(context);
+}
+#endif /* SDL_HAS_64BIT_TYPE */
+
 SDL_RWops *SDL_RWFromMem(void *mem, int size)
 {
 	SDL_RWops *rwops;
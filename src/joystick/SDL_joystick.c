@@ -522,6 +522,23 @@ void SDL_JoystickUpdate(void)
 	}
 }
 
+int SDL_JoystickEventFds(int *fds, int maxfds)
+{
+	int i;
+
+	for ( i=0; SDL_joysticks[i]; ++i ) {
+#if SDL_JOYSTICK_LINUX
+		if ( i == maxfds ) {
+			return(-1);
+		}
+		fds[i] = SDL_SYS_JoystickFd(SDL_joysticks[i]);
+#else
+		return(-1);
+#endif
+	}
+	return(i);
+}
+
 int SDL_JoystickEventState(int state)
 {
 #if SDL_EVENTS_DISABLED
@@ -27,6 +27,12 @@
 /* The number of available joysticks on the system */
 extern Uint8 SDL_numjoysticks;
 
+/* Used by the event loop to sleep until there's joystick input.  This
+   stores descriptors that become readable on input in 'fds' and returns
+   how many, or -1 if the joysticks have to be polled instead.
+ */
+extern int SDL_JoystickEventFds(int *fds, int maxfds);
+
 /* Internal event queueing functions */
 extern int SDL_PrivateJoystickAxis(SDL_Joystick *joystick,
                                    Uint8 axis, Sint16 value);
@@ -77,6 +77,11 @@ extern void SDL_SYS_JoystickUpdate(SDL_Joystick *joystick);
 /* Function to close a joystick after use */
 extern void SDL_SYS_JoystickClose(SDL_Joystick *joystick);
 
+#if SDL_JOYSTICK_LINUX
+/* Function to get a descriptor that becomes readable on joystick input */
+extern int SDL_SYS_JoystickFd(SDL_Joystick *joystick);
+#endif
+
 /* Function to perform any system-specific joystick related cleanup */
 extern void SDL_SYS_JoystickQuit(void);
 
@@ -1161,6 +1161,11 @@ void SDL_SYS_JoystickUpdate(SDL_Joystick *joystick)
 	}
 }
 
+int SDL_SYS_JoystickFd(SDL_Joystick *joystick)
+{
+	return(joystick->hwdata->fd);
+}
+
 /* Function to close a joystick after use */
 void SDL_SYS_JoystickClose(SDL_Joystick *joystick)
 {
@@ -23,146 +23,230 @@
 
 /* System independent thread management routines for SDL */
 
+#include "SDL_atomic.h"
 #include "SDL_mutex.h"
 #include "SDL_thread.h"
 #include "SDL_thread_c.h"
 #include "SDL_systhread.h"
 
-#define ARRAY_CHUNKSIZE	32
-/* The array of threads currently active in the application
-   (except the main thread)
-   The manipulation of an array here is safer than using a linked list.
-*/
-static int SDL_maxthreads = 0;
-static int SDL_numthreads = 0;
-static SDL_Thread **SDL_Threads = NULL;
-static SDL_mutex *thread_lock = NULL;
+/* The thread local storage grows by this many IDs at a time */
+#define TLS_ALLOC_CHUNKSIZE	4
+
+/* IDs up to SDL_ERRBUF_TLSID are reserved for SDL */
+static SDL_atomic_t SDL_tls_ids = { SDL_ERRBUF_TLSID };
 
-int SDL_ThreadsInit(void)
+SDL_TLSID SDL_TLSCreate(void)
 {
-	int retval;
+	return((SDL_TLSID)SDL_AtomicAdd(&SDL_tls_ids, 1) + 1);
+}
+
+void *SDL_TLSGet(SDL_TLSID id)
+{
+	SDL_TLSData *storage;
+
+	storage = SDL_SYS_GetTLSData();
+	if ( !storage || id == 0 || id > storage->limit ) {
+		return(NULL);
+	}
+	return(storage->array[id-1].data);
+}
+
+int SDL_TLSSetInternal(SDL_TLSID id, const void *value, void (SDLCALL *destructor)(void*))
+{
+	SDL_TLSData *storage;
+
+	storage = SDL_SYS_GetTLSData();
+	if ( !storage || id > storage->limit ) {
+		SDL_TLSData *new_storage;
+		unsigned int i, oldlimit, newlimit;
+
+		/* Not realloc(), the old block stays registered if this fails */
+		oldlimit = storage ? storage->limit : 0;
+		newlimit = (id + TLS_ALLOC_CHUNKSIZE);
+		new_storage = (SDL_TLSData *)SDL_malloc(sizeof(*new_storage)+(newlimit-1)*sizeof(new_storage->array[0]));
+		if ( !new_storage ) {
+			return(-1);
+		}
+		new_storage->limit = newlimit;
+		for ( i = 0; i < newlimit; ++i ) {
+			if ( i < oldlimit ) {
+				new_storage->array[i] = storage->array[i];
+			} else {
+				new_storage->array[i].data = NULL;
+				new_storage->array[i].destructor = NULL;
+			}
+		}
+		if ( SDL_SYS_SetTLSData(new_storage) != 0 ) {
+			SDL_free(new_storage);
+			return(-1);
+		}
+		SDL_free(storage);
+		storage = new_storage;
+	}
+	storage->array[id-1].data = (void *)value;
+	storage->array[id-1].destructor = destructor;
+	return(0);
+}
 
-	retval = 0;
-	thread_lock = SDL_CreateMutex();
-	if ( thread_lock == NULL ) {
-		retval = -1;
+int SDL_TLSSet(SDL_TLSID id, const void *value, void (SDLCALL *destructor)(void*))
+{
+	if ( id == 0 ) {
+		SDL_SetError("Invalid TLS ID");
+		return(-1);
+	}
+	if ( SDL_TLSSetInternal(id, value, destructor) < 0 ) {
+		SDL_SetError("Couldn't set thread local storage");
+		return(-1);
 	}
-	return(retval);
+	return(0);
 }
 
-/* This should never be called...
-   If this is called by SDL_Quit(), we don't know whether or not we should
-   clean up threads here.  If any threads are still running after this call,
-   they will no longer have access to any per-thread data.
- */
-void SDL_ThreadsQuit(void)
+void SDL_TLSFreeData(SDL_TLSData *storage)
 {
-	SDL_mutex *mutex;
+	unsigned int i;
 
-	mutex = thread_lock;
-	thread_lock = NULL;
-	if ( mutex != NULL ) {
-		SDL_DestroyMutex(mutex);
+	for ( i = 0; i < storage->limit; ++i ) {
+		if ( storage->array[i].destructor ) {
+			storage->array[i].destructor(storage->array[i].data);
+		}
 	}
+	SDL_free(storage);
 }
 
-/* Routines for manipulating the thread list */
-static void SDL_AddThread(SDL_Thread *thread)
+/* Free the thread local storage of a thread that is exiting, it's
+   unregistered first like the pthread key destructor sees it */
+static void SDL_TLSCleanup(void)
 {
+	SDL_TLSData *storage;
+
+	storage = SDL_SYS_GetTLSData();
+	if ( storage ) {
+		SDL_SYS_SetTLSData(NULL);
+		SDL_TLSFreeData(storage);
+	}
+}
+
+#if !SDL_SYS_HAS_TLS
+/* Without native thread local storage, keep a list keyed by thread ID.
+   This is slower, but still doesn't need to know about every thread.
+*/
+typedef struct SDL_TLSEntry {
+	Uint32 thread;
+	SDL_TLSData *storage;
+	struct SDL_TLSEntry *next;
+} SDL_TLSEntry;
+
+static SDL_mutex *SDL_tls_lock = NULL;
+static SDL_TLSEntry *SDL_tls_entries = NULL;
+
+static int SDL_LockTLSList(void)
+{
+	static int creating = 0;
+
 	/* WARNING:
-	   If the very first threads are created simultaneously, then
-	   there could be a race condition causing memory corruption.
-	   In practice, this isn't a problem because by definition there
-	   is only one thread running the first time this is called.
+	   If the very first threads use this simultaneously, two locks
+	   could be created.  In practice SDL_SetError() is called from
+	   the main thread before any others start.
 	*/
-	if ( !thread_lock ) {
-		if ( SDL_ThreadsInit() < 0 ) {
-			return;
+	if ( !SDL_tls_lock ) {
+		/* Creating the lock may set an error, which comes back here */
+		if ( creating ) {
+			return(-1);
+		}
+		creating = 1;
+		SDL_tls_lock = SDL_CreateMutex();
+		creating = 0;
+		if ( !SDL_tls_lock ) {
+			return(-1);
 		}
 	}
-	SDL_mutexP(thread_lock);
+	SDL_mutexP(SDL_tls_lock);
+	return(0);
+}
 
-	/* Expand the list of threads, if necessary */
-#ifdef DEBUG_THREADS
-	printf("Adding thread (%d already - %d max)\n",
-			SDL_numthreads, SDL_maxthreads);
-#endif
-	if ( SDL_numthreads == SDL_maxthreads ) {
-		SDL_Thread **threads;
-		threads = (SDL_Thread **)SDL_realloc(SDL_Threads,
-			(SDL_maxthreads+ARRAY_CHUNKSIZE)*(sizeof *threads));
-		if ( threads == NULL ) {
-			SDL_OutOfMemory();
-			goto done;
+SDL_TLSData *SDL_SYS_GetTLSData(void)
+{
+	Uint32 thread = SDL_ThreadID();
+	SDL_TLSEntry *entry;
+	SDL_TLSData *storage = NULL;
+
+	if ( SDL_LockTLSList() < 0 ) {
+		return(NULL);
+	}
+	for ( entry = SDL_tls_entries; entry; entry = entry->next ) {
+		if ( entry->thread == thread ) {
+			storage = entry->storage;
+			break;
 		}
-		SDL_maxthreads += ARRAY_CHUNKSIZE;
-		SDL_Threads = threads;
 	}
-	SDL_Threads[SDL_numthreads++] = thread;
-done:
-	SDL_mutexV(thread_lock);
+	SDL_mutexV(SDL_tls_lock);
+	return(storage);
 }
 
-static void SDL_DelThread(SDL_Thread *thread)
+int SDL_SYS_SetTLSData(SDL_TLSData *storage)
 {
-	int i;
+	Uint32 thread = SDL_ThreadID();
+	SDL_TLSEntry *prev, *entry;
 
-	if ( !thread_lock ) {
-		return;
+	if ( SDL_LockTLSList() < 0 ) {
+		return(-1);
 	}
-	SDL_mutexP(thread_lock);
-	for ( i=0; i<SDL_numthreads; ++i ) {
-		if ( thread == SDL_Threads[i] ) {
+	for ( prev = NULL, entry = SDL_tls_entries; entry;
+	      prev = entry, entry = entry->next ) {
+		if ( entry->thread == thread ) {
 			break;
 		}
 	}
-	if ( i < SDL_numthreads ) {
-		if ( --SDL_numthreads > 0 ) {
-			while ( i < SDL_numthreads ) {
-				SDL_Threads[i] = SDL_Threads[i+1];
-				++i;
-			}
+	if ( entry ) {
+		if ( storage ) {
+			entry->storage = storage;
 		} else {
-			SDL_maxthreads = 0;
-			SDL_free(SDL_Threads);
-			SDL_Threads = NULL;
+			if ( prev ) {
+				prev->next = entry->next;
+			} else {
+				SDL_tls_entries = entry->next;
+			}
+			SDL_free(entry);
 		}
-#ifdef DEBUG_THREADS
-		printf("Deleting thread (%d left - %d max)\n",
-				SDL_numthreads, SDL_maxthreads);
-#endif
-	}
-	SDL_mutexV(thread_lock);
-
-#if 0	/* There could be memory corruption if another thread is starting */
-	if ( SDL_Threads == NULL ) {
-		SDL_ThreadsQuit();
+	} else if ( storage ) {
+		entry = (SDL_TLSEntry *)SDL_malloc(sizeof(*entry));
+		if ( !entry ) {
+			SDL_mutexV(SDL_tls_lock);
+			return(-1);
+		}
+		entry->thread = thread;
+		entry->storage = storage;
+		entry->next = SDL_tls_entries;
+		SDL_tls_entries = entry;
 	}
-#endif
+	SDL_mutexV(SDL_tls_lock);
+	return(0);
 }
+#endif /* !SDL_SYS_HAS_TLS */
 
 /* The default (non-thread-safe) global error variable */
 static SDL_error SDL_global_error;
 
+static void SDLCALL SDL_FreeErrBuf(void *errbuf)
+{
+	SDL_free(errbuf);
+}
+
 /* Routine to get the thread-specific error variable */
 SDL_error *SDL_GetErrBuf(void)
 {
 	SDL_error *errbuf;
 
-	errbuf = &SDL_global_error;
-	if ( SDL_Threads ) {
-		int i;
-		Uint32 this_thread;
-
-		this_thread = SDL_ThreadID();
-		SDL_mutexP(thread_lock);
-		for ( i=0; i<SDL_numthreads; ++i ) {
-			if ( this_thread == SDL_Threads[i]->threadid ) {
-				errbuf = &SDL_Threads[i]->errbuf;
-				break;
-			}
+	errbuf = (SDL_error *)SDL_TLSGet(SDL_ERRBUF_TLSID);
+	if ( !errbuf ) {
+		errbuf = (SDL_error *)SDL_calloc(1, sizeof(*errbuf));
+		if ( !errbuf ) {
+			return(&SDL_global_error);
+		}
+		if ( SDL_TLSSetInternal(SDL_ERRBUF_TLSID, errbuf, SDL_FreeErrBuf) < 0 ) {
+			SDL_free(errbuf);
+			return(&SDL_global_error);
 		}
-		SDL_mutexV(thread_lock);
 	}
 	return(errbuf);
 }
@@ -202,6 +286,9 @@ void SDL_RunThread(void *data)
 
 	/* Run the function */
 	*statusloc = userfunc(userdata);
+
+	/* Clean up thread local storage */
+	SDL_TLSCleanup();
 }
 
 #ifdef SDL_PASSED_BEGINTHREAD_ENDTHREAD
@@ -240,9 +327,6 @@ DECLSPEC SDL_Thread * SDLCALL SDL_CreateThread(int (SDLCALL *fn)(void *), void *
 		return(NULL);
 	}
 
-	/* Add the thread to the list of available threads */
-	SDL_AddThread(thread);
-
 	/* Create the thread and go! */
 #ifdef SDL_PASSED_BEGINTHREAD_ENDTHREAD
 	ret = SDL_SYS_CreateThread(thread, args, pfnBeginThread, pfnEndThread);
@@ -254,7 +338,6 @@ DECLSPEC SDL_Thread * SDLCALL SDL_CreateThread(int (SDLCALL *fn)(void *), void *
 		SDL_SemWait(args->wait);
 	} else {
 		/* Oops, failed.  Gotta free everything */
-		SDL_DelThread(thread);
 		SDL_free(thread);
 		thread = NULL;
 	}
@@ -272,7 +355,6 @@ void SDL_WaitThread(SDL_Thread *thread, int *status)
 		if ( status ) {
 			*status = thread->status;
 		}
-		SDL_DelThread(thread);
 		SDL_free(thread);
 	}
 }
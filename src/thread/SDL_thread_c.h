@@ -54,11 +54,28 @@ struct SDL_Thread {
 	Uint32 threadid;
 	SYS_ThreadHandle handle;
 	int status;
-	SDL_error errbuf;
 	void *data;
 };
 
 /* This is the function called to run a thread */
 extern void SDL_RunThread(void *data);
 
+/* This is the thread local storage of a thread, indexed by TLS ID - 1 */
+typedef struct {
+	unsigned int limit;
+	struct {
+		void *data;
+		void (SDLCALL *destructor)(void*);
+	} array[1];
+} SDL_TLSData;
+
+/* The TLS ID reserved for the SDL error buffer */
+#define SDL_ERRBUF_TLSID	1
+
+/* Set a TLS value without setting an error, so SDL_GetErrBuf() can use it */
+extern int SDL_TLSSetInternal(SDL_TLSID id, const void *value, void (SDLCALL *destructor)(void*));
+
+/* Call the destructors in the storage of an exiting thread and free it */
+extern void SDL_TLSFreeData(SDL_TLSData *storage);
+
 #endif /* _SDL_thread_c_h */
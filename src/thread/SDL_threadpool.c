@@ -0,0 +1,446 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* A work-stealing thread pool
+
+   Every pool thread has a queue of its own, and queue 0 takes the
+   tasks added by other threads.  A pool thread runs the newest task in
+   its own queue, then the oldest in queue 0, then steals the oldest
+   task of another thread.  The queues are short critical sections
+   under spin locks.  Idle threads sleep on a condition variable.
+ */
+
+#include "SDL_atomic.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
+#include "SDL_timer.h"
+
+#define POOL_MAX_THREADS	64
+#define QUEUE_MIN_SIZE		64
+
+typedef struct {
+	SDL_TaskFunction func;
+	void *data;
+	SDL_TaskGroup *group;
+} SDL_Task;
+
+typedef struct {
+	SDL_SpinLock lock;
+	SDL_Task *tasks;		/* ring buffer, the size is a power of two */
+	int size;
+	int head;			/* oldest task, where thieves take */
+	int tail;			/* newest task, where the owner takes */
+} SDL_TaskQueue;
+
+struct SDL_TaskGroup {
+	SDL_atomic_t pending;		/* tasks not finished yet */
+	SDL_atomic_t finishing;		/* tasks between finishing and posting */
+	SDL_sem *done;			/* posted when pending drops to 0 */
+};
+
+static struct {
+	SDL_SpinLock startlock;
+	SDL_atomic_t started;
+	int numthreads;			/* pool threads, not counting waiters */
+	SDL_Thread *threads[POOL_MAX_THREADS];
+	SDL_TaskQueue queues[POOL_MAX_THREADS+1];
+	SDL_TLSID self;			/* queue index of a pool thread */
+	SDL_mutex *lock;		/* idle threads sleep on wake */
+	SDL_cond *wake;
+	SDL_atomic_t queued;
+	SDL_atomic_t sleeping;
+	SDL_atomic_t quit;
+} SDL_pool;
+
+static int SDL_PushTask(SDL_TaskQueue *queue, const SDL_Task *task)
+{
+	SDL_AtomicLock(&queue->lock);
+	if ( (queue->tail - queue->head) == queue->size ) {
+		int size = queue->size ? queue->size * 2 : QUEUE_MIN_SIZE;
+		SDL_Task *tasks;
+		int i;
+
+		tasks = (SDL_Task *)SDL_malloc(size * sizeof(*tasks));
+		if ( tasks == NULL ) {
+			SDL_AtomicUnlock(&queue->lock);
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		for ( i = 0; i < (queue->tail - queue->head); ++i ) {
+			tasks[i] = queue->tasks[(queue->head + i) & (queue->size - 1)];
+		}
+		if ( queue->tasks ) {
+			SDL_free(queue->tasks);
+		}
+		queue->tasks = tasks;
+		queue->tail -= queue->head;
+		queue->head = 0;
+		queue->size = size;
+	}
+	queue->tasks[queue->tail & (queue->size - 1)] = *task;
+	++queue->tail;
+	SDL_AtomicUnlock(&queue->lock);
+	return(0);
+}
+
+/* Take the newest task if 'newest' is set, otherwise the oldest */
+static int SDL_TakeTask(SDL_TaskQueue *queue, SDL_Task *task, int newest)
+{
+	int found = 0;
+
+	/* Peek first, most queues are empty most of the time */
+	if ( *(volatile int *)&queue->tail == *(volatile int *)&queue->head ) {
+		return(0);
+	}
+	SDL_AtomicLock(&queue->lock);
+	if ( queue->tail != queue->head ) {
+		if ( newest ) {
+			--queue->tail;
+			*task = queue->tasks[queue->tail & (queue->size - 1)];
+		} else {
+			*task = queue->tasks[queue->head & (queue->size - 1)];
+			++queue->head;
+		}
+		found = 1;
+	}
+	SDL_AtomicUnlock(&queue->lock);
+	return(found);
+}
+
+static int SDL_FindTask(int self, SDL_Task *task)
+{
+	int i, victim;
+
+	if ( self > 0 && SDL_TakeTask(&SDL_pool.queues[self], task, 1) ) {
+		goto found;
+	}
+	if ( SDL_TakeTask(&SDL_pool.queues[0], task, 0) ) {
+		goto found;
+	}
+	victim = self;
+	for ( i = 0; i < SDL_pool.numthreads; ++i ) {
+		victim = (victim % SDL_pool.numthreads) + 1;
+		if ( victim != self &&
+		     SDL_TakeTask(&SDL_pool.queues[victim], task, 0) ) {
+			goto found;
+		}
+	}
+	return(0);
+
+found:
+	SDL_AtomicAdd(&SDL_pool.queued, -1);
+	return(1);
+}
+
+static void SDL_RunTask(SDL_Task *task)
+{
+	SDL_TaskGroup *group = task->group;
+
+	task->func(task->data);
+	if ( group ) {
+		SDL_AtomicAdd(&group->finishing, 1);
+		if ( SDL_AtomicDecRef(&group->pending) ) {
+			SDL_SemPost(group->done);
+		}
+		SDL_AtomicAdd(&group->finishing, -1);
+	}
+}
+
+static int SDLCALL SDL_PoolThread(void *data)
+{
+	int self = (int)(size_t)data;
+	SDL_Task task;
+
+	SDL_TLSSet(SDL_pool.self, data, NULL);
+	for ( ; ; ) {
+		if ( SDL_FindTask(self, &task) ) {
+			SDL_RunTask(&task);
+			continue;
+		}
+
+		/* Sleepers count themselves before they look at the queues,
+		   so either they see a new task or SDL_AddTask() sees them */
+		SDL_mutexP(SDL_pool.lock);
+		SDL_AtomicAdd(&SDL_pool.sleeping, 1);
+		while ( !SDL_AtomicGet(&SDL_pool.queued) &&
+		        !SDL_AtomicGet(&SDL_pool.quit) ) {
+			SDL_CondWait(SDL_pool.wake, SDL_pool.lock);
+		}
+		SDL_AtomicAdd(&SDL_pool.sleeping, -1);
+		SDL_mutexV(SDL_pool.lock);
+
+		if ( SDL_AtomicGet(&SDL_pool.quit) &&
+		     !SDL_AtomicGet(&SDL_pool.queued) ) {
+			break;
+		}
+	}
+	return(0);
+}
+
+static void SDL_StartThreadPool(void)
+{
+	const char *env;
+	int count;
+
+	SDL_AtomicLock(&SDL_pool.startlock);
+	if ( SDL_AtomicGet(&SDL_pool.started) ) {
+		SDL_AtomicUnlock(&SDL_pool.startlock);
+		return;
+	}
+
+	/* The thread that waits for the tasks helps with them */
+	count = SDL_GetCPUCount();
+	env = SDL_getenv("SDL_THREADPOOL_THREADS");
+	if ( env ) {
+		count = SDL_atoi(env);
+	}
+	count -= 1;
+	if ( count > POOL_MAX_THREADS ) {
+		count = POOL_MAX_THREADS;
+	}
+
+	if ( !SDL_pool.self ) {
+		SDL_pool.self = SDL_TLSCreate();
+	}
+	SDL_AtomicSet(&SDL_pool.quit, 0);
+	SDL_pool.numthreads = 0;
+	if ( count > 0 ) {
+		SDL_pool.lock = SDL_CreateMutex();
+		SDL_pool.wake = SDL_CreateCond();
+	}
+	if ( SDL_pool.lock && SDL_pool.wake ) {
+		while ( SDL_pool.numthreads < count ) {
+			SDL_Thread *thread;
+
+			/* Stealing goes by numthreads, so only count started threads */
+			thread = SDL_CreateThread(SDL_PoolThread,
+			                          (void *)(size_t)(SDL_pool.numthreads + 1));
+			if ( thread == NULL ) {
+				break;
+			}
+			SDL_pool.threads[SDL_pool.numthreads++] = thread;
+		}
+	}
+	SDL_AtomicSet(&SDL_pool.started, 1);
+	SDL_AtomicUnlock(&SDL_pool.startlock);
+}
+
+/* Called by SDL_Quit(), the queued tasks are run first */
+void SDL_ThreadPoolQuit(void)
+{
+	int i;
+
+	SDL_AtomicLock(&SDL_pool.startlock);
+	if ( SDL_AtomicGet(&SDL_pool.started) ) {
+		if ( SDL_pool.numthreads > 0 ) {
+			SDL_mutexP(SDL_pool.lock);
+			SDL_AtomicSet(&SDL_pool.quit, 1);
+			SDL_CondBroadcast(SDL_pool.wake);
+			SDL_mutexV(SDL_pool.lock);
+			for ( i = 0; i < SDL_pool.numthreads; ++i ) {
+				SDL_WaitThread(SDL_pool.threads[i], NULL);
+			}
+		}
+		for ( i = 0; i <= SDL_pool.numthreads; ++i ) {
+			if ( SDL_pool.queues[i].tasks ) {
+				SDL_free(SDL_pool.queues[i].tasks);
+			}
+			SDL_memset(&SDL_pool.queues[i], 0, sizeof(SDL_pool.queues[i]));
+		}
+		if ( SDL_pool.wake ) {
+			SDL_DestroyCond(SDL_pool.wake);
+			SDL_pool.wake = NULL;
+		}
+		if ( SDL_pool.lock ) {
+			SDL_DestroyMutex(SDL_pool.lock);
+			SDL_pool.lock = NULL;
+		}
+		SDL_pool.numthreads = 0;
+		SDL_AtomicSet(&SDL_pool.started, 0);
+	}
+	SDL_AtomicUnlock(&SDL_pool.startlock);
+}
+
+int SDL_GetThreadPoolSize(void)
+{
+	if ( !SDL_AtomicGet(&SDL_pool.started) ) {
+		SDL_StartThreadPool();
+	}
+	return(SDL_pool.numthreads + 1);
+}
+
+SDL_TaskGroup *SDL_CreateTaskGroup(void)
+{
+	SDL_TaskGroup *group;
+
+	group = (SDL_TaskGroup *)SDL_malloc(sizeof(*group));
+	if ( group == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_AtomicSet(&group->pending, 0);
+	SDL_AtomicSet(&group->finishing, 0);
+	group->done = SDL_CreateSemaphore(0);
+	if ( group->done == NULL ) {
+		SDL_free(group);
+		return(NULL);
+	}
+	return(group);
+}
+
+int SDL_AddTask(SDL_TaskGroup *group, SDL_TaskFunction func, void *data)
+{
+	SDL_Task task;
+	int self;
+
+	if ( !SDL_AtomicGet(&SDL_pool.started) ) {
+		SDL_StartThreadPool();
+	}
+	task.func = func;
+	task.data = data;
+	task.group = group;
+	if ( SDL_pool.numthreads == 0 ) {
+		func(data);
+		return(0);
+	}
+
+	if ( group ) {
+		SDL_AtomicAdd(&group->pending, 1);
+	}
+	self = (int)(size_t)SDL_TLSGet(SDL_pool.self);
+	if ( SDL_PushTask(&SDL_pool.queues[self], &task) < 0 ) {
+		if ( group ) {
+			SDL_AtomicAdd(&group->pending, -1);
+		}
+		return(-1);
+	}
+	SDL_AtomicAdd(&SDL_pool.queued, 1);
+	if ( SDL_AtomicGet(&SDL_pool.sleeping) ) {
+		SDL_mutexP(SDL_pool.lock);
+		SDL_CondSignal(SDL_pool.wake);
+		SDL_mutexV(SDL_pool.lock);
+	}
+	return(0);
+}
+
+void SDL_WaitTaskGroup(SDL_TaskGroup *group)
+{
+	SDL_Task task;
+	int self;
+
+	self = (int)(size_t)SDL_TLSGet(SDL_pool.self);
+	while ( SDL_AtomicGet(&group->pending) > 0 ) {
+		if ( SDL_FindTask(self, &task) ) {
+			SDL_RunTask(&task);
+		} else {
+			/* A post left from an earlier wait just goes round again */
+			SDL_SemWait(group->done);
+		}
+	}
+
+	/* The last task may still be posting, the group can't go yet */
+	while ( SDL_AtomicGet(&group->finishing) ) {
+		SDL_Delay(0);
+	}
+}
+
+void SDL_DestroyTaskGroup(SDL_TaskGroup *group)
+{
+	if ( group ) {
+		SDL_WaitTaskGroup(group);
+		SDL_DestroySemaphore(group->done);
+		SDL_free(group);
+	}
+}
+
+typedef struct {
+	SDL_RangeFunction func;
+	void *data;
+	int start, end, grain;
+	int chunks;
+	SDL_atomic_t next;		/* next chunk to run */
+} SDL_ParallelForData;
+
+/* Run chunks until they're all taken, on every participating thread */
+static void SDLCALL SDL_ParallelForTask(void *data)
+{
+	SDL_ParallelForData *pf = (SDL_ParallelForData *)data;
+	int chunk, start, end;
+
+	while ( (chunk = SDL_AtomicAdd(&pf->next, 1)) < pf->chunks ) {
+		start = pf->start + chunk * pf->grain;
+		end = start + pf->grain;
+		if ( end > pf->end || end < start ) {
+			end = pf->end;
+		}
+		pf->func(pf->data, start, end);
+	}
+}
+
+void SDL_ParallelFor(int start, int end, int grain, SDL_RangeFunction func, void *data)
+{
+	SDL_ParallelForData pf;
+	SDL_TaskGroup *group;
+	int threads, helpers, i;
+
+	if ( end <= start ) {
+		return;
+	}
+	threads = SDL_GetThreadPoolSize();
+	if ( grain <= 0 ) {
+		grain = (end - start) / (threads * 4);
+		if ( grain < 1 ) {
+			grain = 1;
+		}
+	}
+	pf.func = func;
+	pf.data = data;
+	pf.start = start;
+	pf.end = end;
+	pf.grain = grain;
+	pf.chunks = (end - start) / grain + (((end - start) % grain) ? 1 : 0);
+	SDL_AtomicSet(&pf.next, 0);
+
+	helpers = threads - 1;
+	if ( helpers > pf.chunks - 1 ) {
+		helpers = pf.chunks - 1;
+	}
+	group = NULL;
+	if ( helpers > 0 ) {
+		group = SDL_CreateTaskGroup();
+	}
+	if ( group == NULL ) {
+		func(data, start, end);
+		return;
+	}
+
+	/* Helpers that start late find no chunks left and return */
+	for ( i = 0; i < helpers; ++i ) {
+		if ( SDL_AddTask(group, SDL_ParallelForTask, &pf) < 0 ) {
+			break;
+		}
+	}
+	SDL_ParallelForTask(&pf);
+	SDL_DestroyTaskGroup(group);
+}
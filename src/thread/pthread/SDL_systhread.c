@@ -118,3 +118,39 @@ void SDL_SYS_KillThread(SDL_Thread *thread)
 	pthread_kill(thread->handle, SIGKILL);
 #endif
 }
+
+static pthread_once_t tls_once = PTHREAD_ONCE_INIT;
+static pthread_key_t thread_local_storage;
+static int tls_created = 0;
+
+/* Threads SDL didn't create don't go through SDL_RunThread() */
+static void SDLCALL TLSDestructor(void *data)
+{
+	SDL_TLSFreeData((SDL_TLSData *)data);
+}
+
+static void CreateTLSKey(void)
+{
+	if ( pthread_key_create(&thread_local_storage, TLSDestructor) == 0 ) {
+		tls_created = 1;
+	}
+}
+
+SDL_TLSData *SDL_SYS_GetTLSData(void)
+{
+	pthread_once(&tls_once, CreateTLSKey);
+	if ( !tls_created ) {
+		return(NULL);
+	}
+	return((SDL_TLSData *)pthread_getspecific(thread_local_storage));
+}
+
+int SDL_SYS_SetTLSData(SDL_TLSData *data)
+{
+	pthread_once(&tls_once, CreateTLSKey);
+	if ( !tls_created ||
+	     pthread_setspecific(thread_local_storage, data) != 0 ) {
+		return(-1);
+	}
+	return(0);
+}
@@ -24,3 +24,6 @@
 #include <pthread.h>
 
 typedef pthread_t SYS_ThreadHandle;
+
+/* Thread local storage uses pthread_getspecific() */
+#define SDL_SYS_HAS_TLS	1
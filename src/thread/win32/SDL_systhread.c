@@ -148,3 +148,36 @@ void SDL_SYS_KillThread(SDL_Thread *thread)
 {
 	TerminateThread(thread->handle, FALSE);
 }
+
+static DWORD thread_local_storage = TLS_OUT_OF_INDEXES;
+
+static int CreateTLSIndex(void)
+{
+	if ( thread_local_storage == TLS_OUT_OF_INDEXES ) {
+		DWORD storage = TlsAlloc();
+		if ( storage == TLS_OUT_OF_INDEXES ) {
+			return(-1);
+		}
+		/* Another thread may have got there first */
+		if ( InterlockedCompareExchange((LONG volatile *)&thread_local_storage, (LONG)storage, (LONG)TLS_OUT_OF_INDEXES) != (LONG)TLS_OUT_OF_INDEXES ) {
+			TlsFree(storage);
+		}
+	}
+	return(0);
+}
+
+SDL_TLSData *SDL_SYS_GetTLSData(void)
+{
+	if ( CreateTLSIndex() < 0 ) {
+		return(NULL);
+	}
+	return((SDL_TLSData *)TlsGetValue(thread_local_storage));
+}
+
+int SDL_SYS_SetTLSData(SDL_TLSData *data)
+{
+	if ( CreateTLSIndex() < 0 || !TlsSetValue(thread_local_storage, data) ) {
+		return(-1);
+	}
+	return(0);
+}
@@ -26,3 +26,6 @@
 
 typedef HANDLE SYS_ThreadHandle;
 
+/* Thread local storage uses TlsGetValue() */
+#define SDL_SYS_HAS_TLS	1
+
@@ -25,11 +25,14 @@
 #include "SDL_timer_c.h"
 #include "SDL_mutex.h"
 #include "SDL_systimer.h"
+#if !SDL_EVENTS_DISABLED
+#include "../events/SDL_events_c.h"
+#endif
 
 /* #define DEBUG_TIMERS */
 
 int SDL_timer_started = 0;
-int SDL_timer_running = 0;
+SDL_atomic_t SDL_timer_running;
 
 /* Data to handle a single periodic alarm */
 Uint32 SDL_alarm_interval = 0;
@@ -38,17 +41,292 @@ SDL_TimerCallback SDL_alarm_callback;
 /* Data used for a thread-based timer */
 static int SDL_timer_threaded = 0;
 
-struct _SDL_TimerID {
+/* Deadlines are kept in microseconds where a 64-bit type is available,
+   otherwise in milliseconds, compared so that wrapping is harmless.
+*/
+#ifdef SDL_HAS_64BIT_TYPE
+typedef Uint64 SDL_TimerTime;
+typedef Sint64 SDL_TimerDiff;
+#define TIMER_UNITS	1000
+#else
+typedef Uint32 SDL_TimerTime;
+typedef Sint32 SDL_TimerDiff;
+#define TIMER_UNITS	1
+#endif
+#define TIMER_DUE(deadline, now)	((SDL_TimerDiff)((now) - (deadline)) >= 0)
+
+typedef struct SDL_Timer {
 	Uint32 interval;
 	SDL_NewTimerCallback cb;
 	void *param;
-	Uint32 last_alarm;
-	struct _SDL_TimerID *next;
-};
+	SDL_TimerTime deadline;
+	int index;		/* position in SDL_timers, -1 when not queued */
+	int slot;		/* entry in SDL_timer_slots */
+	SDL_bool removed;	/* removed while its callback was running */
+} SDL_Timer;
+
+/* A SDL_TimerID isn't a pointer to the timer but its slot + 1 in the low
+   TIMER_SLOT_BITS and the generation of the slot above them.  A slot's
+   generation changes when its timer is freed, so an ID of a one-shot
+   timer that has fired simply isn't found any more.
+*/
+#define TIMER_SLOT_BITS	16
+#define TIMER_SLOT_MASK	((1 << TIMER_SLOT_BITS) - 1)
+#define TIMER_ID(slot, generation) \
+	((SDL_TimerID)(((uintptr_t)(generation) << TIMER_SLOT_BITS) | \
+	               (uintptr_t)((slot) + 1)))
+
+typedef struct {
+	SDL_Timer *timer;	/* NULL when the slot is free */
+	Uint32 generation;
+	int next_free;
+} SDL_TimerSlot;
+
+static SDL_TimerSlot *SDL_timer_slots = NULL;
+static int SDL_numslots = 0;
+static int SDL_free_slot = -1;
+
+/* The pending timers, as a binary min-heap ordered by deadline */
+static SDL_Timer **SDL_timers = NULL;
+static int SDL_numtimers = 0;
+static int SDL_maxtimers = 0;
+
+/* The timer whose callback is running, outside of the heap */
+static SDL_Timer *SDL_current_timer = NULL;
 
-static SDL_TimerID SDL_timers = NULL;
 static SDL_mutex *SDL_timer_mutex;
-static volatile SDL_bool list_changed = SDL_FALSE;
+static SDL_cond *SDL_timer_cond;
+static int SDL_timer_wakeup = 0;
+
+#ifdef SDL_HAS_64BIT_TYPE
+
+#if !SDL_TIMER_UNIX && !SDL_TIMER_WIN32
+/* Platforms without a better counter fall back to the millisecond ticks */
+Uint64 SDL_GetPerformanceCounter(void)
+{
+	static Uint32 last_ticks = 0;
+	static Uint32 wraps = 0;
+	Uint32 ticks = SDL_GetTicks();
+
+	/* Callers on other threads may have seen slightly later ticks */
+	if ( ticks < last_ticks && (last_ticks - ticks) > 0x80000000 ) {
+		++wraps;
+	}
+	last_ticks = ticks;
+	return(((Uint64)wraps << 32) | ticks);
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+	return(1000);
+}
+#endif /* !SDL_TIMER_UNIX && !SDL_TIMER_WIN32 */
+
+/* Convert between counter ticks and a unit, without overflowing */
+static Uint64 SDL_CounterToUnits(Uint64 counter, Uint64 frequency, Uint64 units)
+{
+	return((counter / frequency) * units +
+	       (counter % frequency) * units / frequency);
+}
+
+/* SDL_Delay() may oversleep by this much, so we spin for the rest */
+#define DELAY_SPIN_MS	1
+
+void SDL_DelayPrecise(Uint64 ns)
+{
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 start = SDL_GetPerformanceCounter();
+	Uint64 ticks = SDL_CounterToUnits(ns, 1000000000, frequency);
+	Uint64 elapsed, ms;
+
+	for ( ;; ) {
+		elapsed = SDL_GetPerformanceCounter() - start;
+		if ( elapsed >= ticks ) {
+			break;
+		}
+		ms = SDL_CounterToUnits(ticks - elapsed, frequency, 1000);
+		if ( ms > DELAY_SPIN_MS ) {
+			SDL_Delay((Uint32)(ms - DELAY_SPIN_MS));
+		}
+	}
+}
+
+#endif /* SDL_HAS_64BIT_TYPE */
+
+/* This is called with the timer mutex held */
+static SDL_TimerTime SDL_TimerNow(void)
+{
+#ifdef SDL_HAS_64BIT_TYPE
+	return(SDL_CounterToUnits(SDL_GetPerformanceCounter(),
+	                          SDL_GetPerformanceFrequency(), 1000000));
+#else
+	/* Accumulate the ticks so the 49 day wrap doesn't matter */
+	static Uint32 last_ticks = 0;
+	static SDL_TimerTime now = 0;
+	Uint32 ticks = SDL_GetTicks();
+
+	now += (SDL_TimerTime)(Uint32)(ticks - last_ticks) * TIMER_UNITS;
+	last_ticks = ticks;
+	return(now);
+#endif
+}
+
+static void SDL_SetHeapTimer(int index, SDL_Timer *t)
+{
+	SDL_timers[index] = t;
+	t->index = index;
+}
+
+static void SDL_SiftTimerUp(int index)
+{
+	SDL_Timer *t = SDL_timers[index];
+
+	while ( index > 0 ) {
+		int parent = (index - 1) / 2;
+		if ( TIMER_DUE(SDL_timers[parent]->deadline, t->deadline) ) {
+			break;
+		}
+		SDL_SetHeapTimer(index, SDL_timers[parent]);
+		index = parent;
+	}
+	SDL_SetHeapTimer(index, t);
+}
+
+static void SDL_SiftTimerDown(int index)
+{
+	SDL_Timer *t = SDL_timers[index];
+
+	for ( ;; ) {
+		int child = index * 2 + 1;
+		if ( child >= SDL_numtimers ) {
+			break;
+		}
+		if ( child + 1 < SDL_numtimers &&
+		     !TIMER_DUE(SDL_timers[child]->deadline,
+		                SDL_timers[child+1]->deadline) ) {
+			++child;
+		}
+		if ( TIMER_DUE(t->deadline, SDL_timers[child]->deadline) ) {
+			break;
+		}
+		SDL_SetHeapTimer(index, SDL_timers[child]);
+		index = child;
+	}
+	SDL_SetHeapTimer(index, t);
+}
+
+static int SDL_QueueTimer(SDL_Timer *t)
+{
+	if ( SDL_numtimers == SDL_maxtimers ) {
+		int maxtimers = SDL_maxtimers ? SDL_maxtimers * 2 : 16;
+		SDL_Timer **timers;
+
+		timers = (SDL_Timer **)SDL_realloc(SDL_timers,
+		                             maxtimers * sizeof(*timers));
+		if ( timers == NULL ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		SDL_timers = timers;
+		SDL_maxtimers = maxtimers;
+	}
+	SDL_timers[SDL_numtimers] = t;
+	SDL_SiftTimerUp(SDL_numtimers++);
+	return(0);
+}
+
+static void SDL_UnqueueTimer(SDL_Timer *t)
+{
+	int index = t->index;
+	SDL_Timer *last = SDL_timers[--SDL_numtimers];
+
+	t->index = -1;
+	if ( last != t ) {
+		SDL_SetHeapTimer(index, last);
+		if ( index > 0 && TIMER_DUE(last->deadline,
+		                  SDL_timers[(index - 1) / 2]->deadline) ) {
+			SDL_SiftTimerUp(index);
+		} else {
+			SDL_SiftTimerDown(index);
+		}
+	}
+}
+
+/* Give a timer a slot for its ID, with the mutex held */
+static int SDL_AllocTimerSlot(SDL_Timer *t)
+{
+	int slot;
+
+	if ( SDL_free_slot < 0 ) {
+		int numslots = SDL_numslots ? SDL_numslots * 2 : 16;
+		SDL_TimerSlot *slots;
+
+		if ( numslots > TIMER_SLOT_MASK ) {
+			numslots = TIMER_SLOT_MASK;
+		}
+		if ( numslots == SDL_numslots ) {
+			SDL_SetError("Too many timers");
+			return(-1);
+		}
+		slots = (SDL_TimerSlot *)SDL_realloc(SDL_timer_slots,
+		                               numslots * sizeof(*slots));
+		if ( slots == NULL ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		for ( slot = SDL_numslots; slot < numslots; ++slot ) {
+			slots[slot].timer = NULL;
+			slots[slot].generation = 0;
+			slots[slot].next_free = slot + 1 < numslots ? slot + 1 : -1;
+		}
+		SDL_free_slot = SDL_numslots;
+		SDL_timer_slots = slots;
+		SDL_numslots = numslots;
+	}
+	slot = SDL_free_slot;
+	SDL_free_slot = SDL_timer_slots[slot].next_free;
+	SDL_timer_slots[slot].timer = t;
+	t->slot = slot;
+	return(0);
+}
+
+/* Free a timer and retire its ID, with the mutex held */
+static void SDL_FreeTimer(SDL_Timer *t)
+{
+	SDL_TimerSlot *entry = &SDL_timer_slots[t->slot];
+
+	entry->timer = NULL;
+	++entry->generation;
+	entry->next_free = SDL_free_slot;
+	SDL_free_slot = t->slot;
+	SDL_free(t);
+}
+
+/* Find the timer with an ID, or NULL if it's gone, with the mutex held */
+static SDL_Timer *SDL_LookupTimer(SDL_TimerID id)
+{
+	int slot = (int)((uintptr_t)id & TIMER_SLOT_MASK) - 1;
+
+	if ( slot < 0 || slot >= SDL_numslots ||
+	     id != TIMER_ID(slot, SDL_timer_slots[slot].generation) ) {
+		return(NULL);
+	}
+	return(SDL_timer_slots[slot].timer);
+}
+
+/* Wake whoever is sleeping until the first timer, with the mutex held */
+static void SDL_WakeTimerThread(void)
+{
+	if ( SDL_timer_threaded == 1 ) {
+		SDL_timer_wakeup = 1;
+		SDL_CondSignal(SDL_timer_cond);
+	}
+#if !SDL_EVENTS_DISABLED
+	if ( SDL_timer_threaded == 2 ) {
+		SDL_WakeEventThread();
+	}
+#endif
+}
 
 /* Set whether or not the timer should use a thread.
    This should not be called while the timer subsystem is running.
@@ -75,11 +353,17 @@ int SDL_TimerInit(void)
 	if ( SDL_timer_started ) {
 		SDL_TimerQuit();
 	}
+	/* A timer thread sleeps on these, so create them before it starts */
+	SDL_timer_mutex = SDL_CreateMutex();
+	SDL_timer_cond = SDL_CreateCond();
 	if ( ! SDL_timer_threaded ) {
 		retval = SDL_SYS_TimerInit();
 	}
-	if ( SDL_timer_threaded ) {
-		SDL_timer_mutex = SDL_CreateMutex();
+	if ( ! SDL_timer_threaded ) {
+		SDL_DestroyCond(SDL_timer_cond);
+		SDL_timer_cond = NULL;
+		SDL_DestroyMutex(SDL_timer_mutex);
+		SDL_timer_mutex = NULL;
 	}
 	if ( retval == 0 ) {
 		SDL_timer_started = 1;
@@ -94,97 +378,159 @@ void SDL_TimerQuit(void)
 		SDL_SYS_TimerQuit();
 	}
 	if ( SDL_timer_threaded ) {
+		SDL_free(SDL_timers);
+		SDL_timers = NULL;
+		SDL_maxtimers = 0;
+		SDL_free(SDL_timer_slots);
+		SDL_timer_slots = NULL;
+		SDL_numslots = 0;
+		SDL_free_slot = -1;
+		SDL_DestroyCond(SDL_timer_cond);
+		SDL_timer_cond = NULL;
 		SDL_DestroyMutex(SDL_timer_mutex);
 		SDL_timer_mutex = NULL;
 	}
+	SDL_timer_wakeup = 0;
 	SDL_timer_started = 0;
 	SDL_timer_threaded = 0;
 }
 
 void SDL_ThreadedTimerCheck(void)
 {
-	Uint32 now, ms;
-	SDL_TimerID t, prev, next;
-	SDL_bool removed;
+	SDL_TimerTime now;
+	SDL_Timer *t;
+	Uint32 ms;
 
 	SDL_mutexP(SDL_timer_mutex);
-	list_changed = SDL_FALSE;
-	now = SDL_GetTicks();
-	for ( prev = NULL, t = SDL_timers; t; t = next ) {
-		removed = SDL_FALSE;
-		ms = t->interval - SDL_TIMESLICE;
-		next = t->next;
-		if ( (int)(now - t->last_alarm) > (int)ms ) {
-			struct _SDL_TimerID timer;
-
-			if ( (now - t->last_alarm) < t->interval ) {
-				t->last_alarm += t->interval;
-			} else {
-				t->last_alarm = now;
-			}
+	now = SDL_TimerNow();
+	while ( SDL_numtimers > 0 && TIMER_DUE(SDL_timers[0]->deadline, now) ) {
+		t = SDL_timers[0];
+		SDL_UnqueueTimer(t);
 #ifdef DEBUG_TIMERS
-			printf("Executing timer %p (thread = %d)\n",
-				t, SDL_ThreadID());
+		printf("Executing timer %p (thread = %d)\n",
+			t, SDL_ThreadID());
 #endif
-			timer = *t;
-			SDL_mutexV(SDL_timer_mutex);
-			ms = timer.cb(timer.interval, timer.param);
-			SDL_mutexP(SDL_timer_mutex);
-			if ( list_changed ) {
-				/* Abort, list of timers modified */
-				/* FIXME: what if ms was changed? */
-				break;
-			}
-			if ( ms != t->interval ) {
-				if ( ms ) {
-					t->interval = ROUND_RESOLUTION(ms);
-				} else {
-					/* Remove timer from the list */
+		/* The callback may add and remove timers, including this one */
+		SDL_current_timer = t;
+		SDL_mutexV(SDL_timer_mutex);
+		ms = t->cb(t->interval, t->param);
+		SDL_mutexP(SDL_timer_mutex);
+		SDL_current_timer = NULL;
+
+		if ( t->removed ) {
+			SDL_FreeTimer(t);
+		} else if ( ms == 0 ) {
 #ifdef DEBUG_TIMERS
-					printf("SDL: Removing timer %p\n", t);
+			printf("SDL: Removing timer %p\n", t);
 #endif
-					if ( prev ) {
-						prev->next = next;
-					} else {
-						SDL_timers = next;
-					}
-					SDL_free(t);
-					--SDL_timer_running;
-					removed = SDL_TRUE;
-				}
+			SDL_FreeTimer(t);
+			SDL_AtomicAdd(&SDL_timer_running, -1);
+		} else {
+			/* Keep to the original schedule unless we fell behind */
+			t->interval = ms;
+			t->deadline += (SDL_TimerTime)ms * TIMER_UNITS;
+			if ( TIMER_DUE(t->deadline, now) ) {
+				t->deadline = SDL_TimerNow() + (SDL_TimerTime)ms * TIMER_UNITS;
+			}
+			if ( SDL_QueueTimer(t) < 0 ) {
+				SDL_FreeTimer(t);
+				SDL_AtomicAdd(&SDL_timer_running, -1);
 			}
 		}
-		/* Don't update prev if the timer has disappeared */
-		if ( ! removed ) {
-			prev = t;
+	}
+	SDL_mutexV(SDL_timer_mutex);
+}
+
+/* This is called with the timer mutex held */
+static int SDL_NextTimerTimeout(void)
+{
+	SDL_TimerDiff wait;
+
+	if ( SDL_numtimers == 0 ) {
+		return(-1);
+	}
+	wait = (SDL_TimerDiff)(SDL_timers[0]->deadline - SDL_TimerNow());
+	if ( wait <= 0 ) {
+		return(0);
+	}
+	/* Round up, so that the first timer is due when we wake up */
+	return((int)((wait + TIMER_UNITS - 1) / TIMER_UNITS));
+}
+
+int SDL_ThreadedTimerTimeout(void)
+{
+	int timeout;
+
+	SDL_mutexP(SDL_timer_mutex);
+	timeout = SDL_NextTimerTimeout();
+	SDL_mutexV(SDL_timer_mutex);
+	return(timeout);
+}
+
+void SDL_ThreadedTimerSleep(void)
+{
+	int timeout;
+
+	if ( ! SDL_timer_cond ) {
+		SDL_Delay(1);
+		return;
+	}
+	SDL_mutexP(SDL_timer_mutex);
+	if ( ! SDL_timer_wakeup ) {
+		timeout = SDL_NextTimerTimeout();
+		if ( timeout < 0 ) {
+			SDL_CondWait(SDL_timer_cond, SDL_timer_mutex);
+		} else if ( timeout > 0 ) {
+			SDL_CondWaitTimeout(SDL_timer_cond, SDL_timer_mutex, timeout);
 		}
 	}
+	SDL_timer_wakeup = 0;
 	SDL_mutexV(SDL_timer_mutex);
 }
 
-static SDL_TimerID SDL_AddTimerInternal(Uint32 interval, SDL_NewTimerCallback callback, void *param)
+void SDL_ThreadedTimerWake(void)
 {
-	SDL_TimerID t;
-	t = (SDL_TimerID) SDL_calloc(1, sizeof(struct _SDL_TimerID));
+	SDL_mutexP(SDL_timer_mutex);
+	SDL_WakeTimerThread();
+	SDL_mutexV(SDL_timer_mutex);
+}
+
+static SDL_Timer *SDL_AddTimerInternal(Uint32 interval, SDL_NewTimerCallback callback, void *param)
+{
+	SDL_Timer *t;
+	t = (SDL_Timer *) SDL_calloc(1, sizeof(*t));
+	if ( t && SDL_AllocTimerSlot(t) < 0 ) {
+		SDL_free(t);
+		t = NULL;
+	}
 	if ( t ) {
-		t->interval = ROUND_RESOLUTION(interval);
+		if ( interval == 0 ) {
+			interval = 1;
+		}
+		t->interval = interval;
 		t->cb = callback;
 		t->param = param;
-		t->last_alarm = SDL_GetTicks();
-		t->next = SDL_timers;
-		SDL_timers = t;
-		++SDL_timer_running;
-		list_changed = SDL_TRUE;
+		t->deadline = SDL_TimerNow() + (SDL_TimerTime)interval * TIMER_UNITS;
+		if ( SDL_QueueTimer(t) < 0 ) {
+			SDL_FreeTimer(t);
+			return NULL;
+		}
+		SDL_AtomicAdd(&SDL_timer_running, 1);
+		/* The timer thread may be asleep until a later timer */
+		if ( t->index == 0 ) {
+			SDL_WakeTimerThread();
+		}
 	}
 #ifdef DEBUG_TIMERS
-	printf("SDL_AddTimer(%d) = %08x num_timers = %d\n", interval, (Uint32)t, SDL_timer_running);
+	printf("SDL_AddTimer(%d) = %08x num_timers = %d\n", interval, (Uint32)t, SDL_AtomicGet(&SDL_timer_running));
 #endif
 	return t;
 }
 
 SDL_TimerID SDL_AddTimer(Uint32 interval, SDL_NewTimerCallback callback, void *param)
 {
-	SDL_TimerID t;
+	SDL_Timer *t;
+	SDL_TimerID id = NULL;
 	if ( ! SDL_timer_mutex ) {
 		if ( SDL_timer_started ) {
 			SDL_SetError("This platform doesn't support multiple timers");
@@ -199,34 +545,36 @@ SDL_TimerID SDL_AddTimer(Uint32 interval, SDL_NewTimerCallback callback, void *p
 	}
 	SDL_mutexP(SDL_timer_mutex);
 	t = SDL_AddTimerInternal(interval, callback, param);
+	if ( t ) {
+		id = TIMER_ID(t->slot, SDL_timer_slots[t->slot].generation);
+	}
 	SDL_mutexV(SDL_timer_mutex);
-	return t;
+	return id;
 }
 
 SDL_bool SDL_RemoveTimer(SDL_TimerID id)
 {
-	SDL_TimerID t, prev = NULL;
+	SDL_Timer *t;
 	SDL_bool removed;
 
 	removed = SDL_FALSE;
 	SDL_mutexP(SDL_timer_mutex);
-	/* Look for id in the linked list of timers */
-	for (t = SDL_timers; t; prev=t, t = t->next ) {
-		if ( t == id ) {
-			if(prev) {
-				prev->next = t->next;
-			} else {
-				SDL_timers = t->next;
-			}
-			SDL_free(t);
-			--SDL_timer_running;
+	t = SDL_LookupTimer(id);
+	if ( t && t == SDL_current_timer ) {
+		/* SDL_ThreadedTimerCheck() frees it after the callback */
+		if ( ! t->removed ) {
+			t->removed = SDL_TRUE;
+			SDL_AtomicAdd(&SDL_timer_running, -1);
 			removed = SDL_TRUE;
-			list_changed = SDL_TRUE;
-			break;
 		}
+	} else if ( t ) {
+		SDL_UnqueueTimer(t);
+		SDL_FreeTimer(t);
+		SDL_AtomicAdd(&SDL_timer_running, -1);
+		removed = SDL_TRUE;
 	}
 #ifdef DEBUG_TIMERS
-	printf("SDL_RemoveTimer(%08x) = %d num_timers = %d thread = %d\n", (Uint32)id, removed, SDL_timer_running, SDL_ThreadID());
+	printf("SDL_RemoveTimer(%08x) = %d num_timers = %d thread = %d\n", (Uint32)id, removed, SDL_AtomicGet(&SDL_timer_running), SDL_ThreadID());
 #endif
 	SDL_mutexV(SDL_timer_mutex);
 	return removed;
@@ -251,18 +599,18 @@ int SDL_SetTimer(Uint32 ms, SDL_TimerCallback callback)
 	if ( SDL_timer_threaded ) {
 		SDL_mutexP(SDL_timer_mutex);
 	}
-	if ( SDL_timer_running ) {	/* Stop any currently running timer */
+	if ( SDL_AtomicGet(&SDL_timer_running) ) {	/* Stop any currently running timer */
 		if ( SDL_timer_threaded ) {
-			while ( SDL_timers ) {
-				SDL_TimerID freeme = SDL_timers;
-				SDL_timers = SDL_timers->next;
-				SDL_free(freeme);
+			while ( SDL_numtimers > 0 ) {
+				SDL_FreeTimer(SDL_timers[--SDL_numtimers]);
+			}
+			if ( SDL_current_timer ) {
+				SDL_current_timer->removed = SDL_TRUE;
 			}
-			SDL_timer_running = 0;
-			list_changed = SDL_TRUE;
+			SDL_AtomicSet(&SDL_timer_running, 0);
 		} else {
 			SDL_SYS_StopTimer();
-			SDL_timer_running = 0;
+			SDL_AtomicSet(&SDL_timer_running, 0);
 		}
 	}
 	if ( ms ) {
@@ -271,7 +619,7 @@ int SDL_SetTimer(Uint32 ms, SDL_TimerCallback callback)
 				retval = -1;
 			}
 		} else {
-			SDL_timer_running = 1;
+			SDL_AtomicSet(&SDL_timer_running, 1);
 			SDL_alarm_interval = ms;
 			SDL_alarm_callback = callback;
 			retval = SDL_SYS_StartTimer();
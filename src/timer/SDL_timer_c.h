@@ -22,13 +22,14 @@
 #include "SDL_config.h"
 
 /* Useful functions and variables from SDL_timer.c */
+#include "SDL_atomic.h"
 #include "SDL_timer.h"
 
 #define ROUND_RESOLUTION(X)	\
 	(((X+TIMER_RESOLUTION-1)/TIMER_RESOLUTION)*TIMER_RESOLUTION)
 
 extern int SDL_timer_started;
-extern int SDL_timer_running;
+extern SDL_atomic_t SDL_timer_running;
 
 /* Data to handle a single periodic alarm */
 extern Uint32 SDL_alarm_interval;
@@ -44,3 +45,12 @@ extern void SDL_TimerQuit(void);
 
 /* This function is called from the SDL event thread if it is available */
 extern void SDL_ThreadedTimerCheck(void);
+
+/* Returns the ms until SDL_ThreadedTimerCheck() has a timer to run,
+   or -1 if there are no timers */
+extern int SDL_ThreadedTimerTimeout(void);
+
+/* Sleeps until the first timer is due or SDL_ThreadedTimerWake() is
+   called, for a timer thread that runs SDL_ThreadedTimerCheck() */
+extern void SDL_ThreadedTimerSleep(void);
+extern void SDL_ThreadedTimerWake(void);
@@ -54,7 +54,7 @@ static SDL_Thread *timer = NULL;
 static int RunTimer(void *unused)
 {
 	while ( timer_alive ) {
-		if ( SDL_timer_running ) {
+		if ( SDL_AtomicGet(&SDL_timer_running) ) {
 			SDL_ThreadedTimerCheck();
 		}
 		SDL_Delay(10);
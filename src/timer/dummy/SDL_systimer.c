@@ -50,10 +50,10 @@ static SDL_Thread *timer = NULL;
 static int RunTimer(void *unused)
 {
 	while ( timer_alive ) {
-		if ( SDL_timer_running ) {
+		if ( SDL_AtomicGet(&SDL_timer_running) ) {
 			SDL_ThreadedTimerCheck();
 		}
-		SDL_Delay(1);
+		SDL_ThreadedTimerSleep();
 	}
 	return(0);
 }
@@ -72,6 +72,7 @@ void SDL_SYS_TimerQuit(void)
 {
 	timer_alive = 0;
 	if ( timer ) {
+		SDL_ThreadedTimerWake();
 		SDL_WaitThread(timer, NULL);
 		timer = NULL;
 	}
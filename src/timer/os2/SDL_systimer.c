@@ -186,7 +186,7 @@ static int SDLCALL RunTimer(void *unused)
 {
         DosSetPriority(PRTYS_THREAD, PRTYC_TIMECRITICAL, 0, 0);
         while ( timer_alive ) {
-                if ( SDL_timer_running ) {
+                if ( SDL_AtomicGet(&SDL_timer_running) ) {
                         SDL_ThreadedTimerCheck();
                 }
                 SDL_Delay(10);
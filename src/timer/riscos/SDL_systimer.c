@@ -157,7 +157,7 @@ void SDL_SYS_StopTimer(void)
 
 void RISCOS_CheckTimer()
 {
-	if (SDL_timer_running && SDL_GetTicks() - timerStart >= SDL_alarm_interval)
+	if (SDL_AtomicGet(&SDL_timer_running) && SDL_GetTicks() - timerStart >= SDL_alarm_interval)
 	{
 		Uint32 ms;
 
@@ -170,7 +170,7 @@ void RISCOS_CheckTimer()
 			} else
 			{
 				SDL_alarm_interval = 0;
-				SDL_timer_running = 0;
+				SDL_AtomicSet(&SDL_timer_running, 0);
 			}
 		}
 		if (SDL_alarm_interval) timerStart = SDL_GetTicks();
@@ -190,7 +190,7 @@ static SDL_Thread *timer = NULL;
 static int RunTimer(void *unused)
 {
 	while ( timer_alive ) {
-		if ( SDL_timer_running ) {
+		if ( SDL_AtomicGet(&SDL_timer_running) ) {
 			SDL_ThreadedTimerCheck();
 		}
 		SDL_Delay(1);
@@ -69,7 +69,7 @@ static int RunTimer(void *unused)
 	{
 	while ( timer_alive )
 		{
-		if (SDL_timer_running)
+		if (SDL_AtomicGet(&SDL_timer_running))
 			{
 			SDL_ThreadedTimerCheck();
 			}
@@ -31,6 +31,7 @@
 #include <errno.h>
 
 #include "SDL_timer.h"
+#include "SDL_cpuinfo.h"
 #include "../SDL_timer_c.h"
 
 /* The clock_gettime provides monotonous time, so we should use it if
@@ -50,6 +51,10 @@
 #define USE_ITIMER
 #endif
 
+#if SDL_THREAD_PTHREAD && !SDL_THREAD_PTH
+#include <pthread.h>
+#endif
+
 /* The first ticks value of the application */
 #ifdef HAVE_CLOCK_GETTIME
 static struct timespec start;
@@ -58,6 +63,116 @@ static struct timeval start;
 #endif /* HAVE_CLOCK_GETTIME */
 
 
+#ifdef SDL_HAS_64BIT_TYPE
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define USE_RDTSC
+#endif
+
+#if HAVE_CLOCK_GETTIME
+#define CLOCK_FREQUENCY	1000000000
+#else
+#define CLOCK_FREQUENCY	1000000
+#endif
+
+/* The counter uses the TSC where it runs at a constant rate.  The TSC
+   frequency is measured against the clock once, when the counter is
+   started by SDL_Init(), so reading it later never blocks.
+*/
+#define TSC_CALIBRATION_MS	20
+
+#if SDL_THREAD_PTHREAD && !SDL_THREAD_PTH
+static pthread_once_t counter_once = PTHREAD_ONCE_INIT;
+#else
+static int counter_started = 0;
+#endif
+#ifdef USE_RDTSC
+static int counter_tsc = 0;
+static Uint64 tsc_frequency = 0;
+#endif
+
+static Uint64 ReadClock(void)
+{
+#if HAVE_CLOCK_GETTIME
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return((Uint64)now.tv_sec * 1000000000 + now.tv_nsec);
+#else
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return((Uint64)now.tv_sec * 1000000 + now.tv_usec);
+#endif
+}
+
+#ifdef USE_RDTSC
+static __inline__ Uint64 ReadTSC(void)
+{
+	Uint32 lo, hi;
+	__asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+	return(((Uint64)hi << 32) | lo);
+}
+#endif
+
+static void CalibrateCounter(void)
+{
+#ifdef USE_RDTSC
+	const char *hint = SDL_getenv("SDL_TIMER_RDTSC");
+	Uint64 clock_start, clock_elapsed, tsc_start, tsc_elapsed;
+	Uint64 min_elapsed = (Uint64)CLOCK_FREQUENCY * TSC_CALIBRATION_MS / 1000;
+
+	if ( SDL_HasInvariantTSC() && (!hint || SDL_atoi(hint)) ) {
+		clock_start = ReadClock();
+		tsc_start = ReadTSC();
+		do {
+			SDL_Delay(TSC_CALIBRATION_MS);
+			clock_elapsed = ReadClock() - clock_start;
+		} while ( clock_elapsed < min_elapsed );
+		tsc_elapsed = ReadTSC() - tsc_start;
+		tsc_frequency = (Uint64)((double)tsc_elapsed * CLOCK_FREQUENCY / clock_elapsed);
+		counter_tsc = 1;
+	}
+#endif
+}
+
+/* Both SDL_StartTicks() and the first counter read on any thread may get
+   here, but the calibration runs once and is visible to every caller.
+*/
+static void StartCounter(void)
+{
+#if SDL_THREAD_PTHREAD && !SDL_THREAD_PTH
+	pthread_once(&counter_once, CalibrateCounter);
+#else
+	if ( ! counter_started ) {
+		CalibrateCounter();
+		counter_started = 1;
+	}
+#endif
+}
+
+Uint64 SDL_GetPerformanceCounter(void)
+{
+	StartCounter();
+#ifdef USE_RDTSC
+	if ( counter_tsc ) {
+		return(ReadTSC());
+	}
+#endif
+	return(ReadClock());
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+	StartCounter();
+#ifdef USE_RDTSC
+	if ( counter_tsc ) {
+		return(tsc_frequency);
+	}
+#endif
+	return(CLOCK_FREQUENCY);
+}
+
+#endif /* SDL_HAS_64BIT_TYPE */
+
 void SDL_StartTicks(void)
 {
 	/* Set first ticks value */
@@ -66,6 +181,9 @@ void SDL_StartTicks(void)
 #else
 	gettimeofday(&start, NULL);
 #endif
+#ifdef SDL_HAS_64BIT_TYPE
+	StartCounter();
+#endif
 }
 
 Uint32 SDL_GetTicks (void)
@@ -203,10 +321,10 @@ static SDL_Thread *timer = NULL;
 static int RunTimer(void *unused)
 {
 	while ( timer_alive ) {
-		if ( SDL_timer_running ) {
+		if ( SDL_AtomicGet(&SDL_timer_running) ) {
 			SDL_ThreadedTimerCheck();
 		}
-		SDL_Delay(1000);
+		SDL_ThreadedTimerSleep();
 	}
 	return(0);
 }
@@ -225,6 +343,7 @@ void SDL_SYS_TimerQuit(void)
 {
 	timer_alive = 0;
 	if ( timer ) {
+		SDL_ThreadedTimerWake();
 		SDL_WaitThread(timer, NULL);
 		timer = NULL;
 	}
@@ -22,6 +22,7 @@
 #include "SDL_config.h"
 
 #include "SDL_video.h"
+#include "SDL_thread.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
 #include "SDL_RLEaccel_c.h"
@@ -39,9 +40,85 @@
 #include "mmx.h"
 #endif
 
-/* The general purpose software blit routine */
-static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
-			SDL_Surface *dst, SDL_Rect *dstrect)
+/* Large blits can be split into horizontal bands run on the thread pool.
+   This is off unless the SDL_BLIT_THREADS environment variable gives the
+   number of bands to use, and small blits always stay on the calling
+   thread, where the hand-off would cost more than it saves. */
+#define BLIT_THREADS_MAX	16
+#define BLIT_THREADS_MIN_PIXELS	(256*256)
+#define BLIT_THREADS_MIN_ROWS	16
+
+typedef struct {
+	SDL_BandFunc func;
+	void *data;
+	int height, bands;
+} SDL_BlitBandJob;
+
+static void SDLCALL SDL_RunBlitBand(void *data, int start, int end)
+{
+	SDL_BlitBandJob *job = (SDL_BlitBandJob *)data;
+	int band, y;
+
+	for ( band = start; band < end; ++band ) {
+		y = (job->height * band) / job->bands;
+		job->func(job->data, y, (job->height * (band + 1)) / job->bands - y);
+	}
+}
+
+int SDL_RunBlitBands(SDL_BandFunc func, void *data, int width, int height)
+{
+	SDL_BlitBandJob job;
+	const char *env;
+	int bands;
+
+	if ( (width * height) < BLIT_THREADS_MIN_PIXELS ) {
+		return(0);
+	}
+	env = SDL_getenv("SDL_BLIT_THREADS");
+	if ( !env ) {
+		return(0);
+	}
+	bands = SDL_atoi(env);
+	if ( bands > BLIT_THREADS_MAX ) {
+		bands = BLIT_THREADS_MAX;
+	}
+	if ( bands > (height / BLIT_THREADS_MIN_ROWS) ) {
+		bands = height / BLIT_THREADS_MIN_ROWS;
+	}
+	if ( bands < 2 || SDL_GetThreadPoolSize() < 2 ) {
+		return(0);
+	}
+
+	job.func = func;
+	job.data = data;
+	job.height = height;
+	job.bands = bands;
+	SDL_ParallelFor(0, bands, 1, SDL_RunBlitBand, &job);
+	return(1);
+}
+
+typedef struct {
+	SDL_loblit blit;
+	SDL_BlitInfo *info;
+	int srcpitch, dstpitch;
+} SDL_BlitBands;
+
+static void SDL_BlitBand(void *data, int y, int rows)
+{
+	SDL_BlitBands *bands = (SDL_BlitBands *)data;
+	SDL_BlitInfo info = *bands->info;
+
+	info.s_pixels += y * bands->srcpitch;
+	info.d_pixels += y * bands->dstpitch;
+	info.s_height = rows;
+	info.d_height = rows;
+	bands->blit(&info);
+}
+
+/* Runs the software blitter over a list of clipped rectangles, locking
+   the surfaces once for all of them */
+static int SDL_SoftBlitList(SDL_Surface *src, SDL_Surface *dst,
+			    const SDL_BlitRectPair *pairs, int numrects)
 {
 	int okay;
 	int src_locked;
@@ -70,31 +147,54 @@ static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
 	}
 
 	/* Set up source and destination buffer pointers, and BLIT! */
-	if ( okay  && srcrect->w && srcrect->h ) {
+	if ( okay ) {
 		SDL_BlitInfo info;
+		SDL_BlitBands bands;
 		SDL_loblit RunBlit;
+		int srcbpp = src->format->BytesPerPixel;
+		int dstbpp = dst->format->BytesPerPixel;
+		int i;
 
-		/* Set up the blit information */
-		info.s_pixels = (Uint8 *)src->pixels +
-				(Uint16)srcrect->y*src->pitch +
-				(Uint16)srcrect->x*src->format->BytesPerPixel;
-		info.s_width = srcrect->w;
-		info.s_height = srcrect->h;
-		info.s_skip=src->pitch-info.s_width*src->format->BytesPerPixel;
-		info.d_pixels = (Uint8 *)dst->pixels +
-				(Uint16)dstrect->y*dst->pitch +
-				(Uint16)dstrect->x*dst->format->BytesPerPixel;
-		info.d_width = dstrect->w;
-		info.d_height = dstrect->h;
-		info.d_skip=dst->pitch-info.d_width*dst->format->BytesPerPixel;
+		/* Set up the blit information shared by all rectangles */
 		info.aux_data = src->map->sw_data->aux_data;
 		info.src = src->format;
 		info.table = src->map->table;
 		info.dst = dst->format;
 		RunBlit = src->map->sw_data->blit;
+		bands.blit = RunBlit;
+		bands.info = &info;
+		bands.srcpitch = src->pitch;
+		bands.dstpitch = dst->pitch;
+
+		for ( i = 0; i < numrects; ++i ) {
+			const SDL_Rect *srcrect = &pairs[i].src;
+			const SDL_Rect *dstrect = &pairs[i].dst;
 
-		/* Run the actual software blit */
-		RunBlit(&info);
+			if ( !srcrect->w || !srcrect->h ) {
+				continue;
+			}
+			info.s_pixels = (Uint8 *)src->pixels +
+					(Uint16)srcrect->y*src->pitch +
+					(Uint16)srcrect->x*srcbpp;
+			info.s_width = srcrect->w;
+			info.s_height = srcrect->h;
+			info.s_skip=src->pitch-info.s_width*srcbpp;
+			info.d_pixels = (Uint8 *)dst->pixels +
+					(Uint16)dstrect->y*dst->pitch +
+					(Uint16)dstrect->x*dstbpp;
+			info.d_width = dstrect->w;
+			info.d_height = dstrect->h;
+			info.d_skip=dst->pitch-info.d_width*dstbpp;
+
+			/* Run the actual software blit, in bands if it's big
+			   enough.  Blits within one surface may overlap, so
+			   they can't be split. */
+			if ( src == dst ||
+			     !SDL_RunBlitBands(SDL_BlitBand, &bands,
+			                       info.d_width, info.d_height) ) {
+				RunBlit(&info);
+			}
+		}
 	}
 
 	/* We need to unlock the surfaces if they're locked */
@@ -108,6 +208,37 @@ static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
 	return(okay ? 0 : -1);
 }
 
+/* The general purpose software blit routine */
+static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
+			SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	SDL_BlitRectPair pair;
+
+	pair.src = *srcrect;
+	pair.dst = *dstrect;
+	return(SDL_SoftBlitList(src, dst, &pair, 1));
+}
+
+int SDL_SoftBlitRects(SDL_Surface *src, SDL_Surface *dst,
+		      SDL_BlitRectPair *pairs, int numrects)
+{
+	int i, retval;
+
+	if ( src->map->sw_blit == SDL_SoftBlit ) {
+		return(SDL_SoftBlitList(src, dst, pairs, numrects));
+	}
+
+	/* The RLE blitters set themselves up */
+	retval = 0;
+	for ( i = 0; i < numrects; ++i ) {
+		if ( src->map->sw_blit(src, &pairs[i].src,
+		                       dst, &pairs[i].dst) < 0 ) {
+			retval = -1;
+		}
+	}
+	return(retval);
+}
+
 #ifdef MMX_ASMBLIT
 static __inline__ void SDL_memcpyMMX(Uint8 *to, const Uint8 *from, int len)
 {
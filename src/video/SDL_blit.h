@@ -51,6 +51,28 @@ struct private_swaccel {
 	void *aux_data;
 };
 
+/* The number of other destinations a surface remembers mappings for */
+#define SDL_BLITMAP_CACHE	4
+
+/* What a mapping depends on in its destination, when that isn't in video
+   memory, the source itself or paletted, so it can be used for any other
+   destination with the same pixel layout.  BitsPerPixel is 0 otherwise. */
+typedef struct SDL_BlitMapKey {
+	Uint8 BitsPerPixel;
+	Uint32 Rmask, Gmask, Bmask, Amask;
+} SDL_BlitMapKey;
+
+/* A software mapping to another destination, kept by SDL_MapSurface() */
+typedef struct SDL_CachedMap {
+	SDL_Surface *dst;
+	unsigned int format_version;
+	SDL_BlitMapKey key;
+	int identity;
+	Uint8 *table;
+	SDL_blit sw_blit;
+	struct private_swaccel *sw_data;
+} SDL_CachedMap;
+
 /* Blit mapping definition */
 typedef struct SDL_BlitMap {
 	SDL_Surface *dst;
@@ -64,12 +86,47 @@ typedef struct SDL_BlitMap {
 	/* the version count matches the destination; mismatch indicates
 	   an invalid mapping */
         unsigned int format_version;
+	SDL_BlitMapKey key;
+
+	/* Mappings to the last few destinations, most recently used first */
+	SDL_CachedMap cache[SDL_BLITMAP_CACHE];
+	int cached;
 } SDL_BlitMap;
 
 
+/* A clipped source rectangle and where it goes */
+typedef struct {
+	SDL_Rect src;
+	SDL_Rect dst;
+} SDL_BlitRectPair;
+
 /* Functions found in SDL_blit.c */
 extern int SDL_CalculateBlit(SDL_Surface *surface);
 
+/* Software blits a list of clipped rectangles with a valid blit map,
+   locking the surfaces once when the general blitter is used. */
+extern int SDL_SoftBlitRects(SDL_Surface *src, SDL_Surface *dst,
+			     SDL_BlitRectPair *pairs, int numrects);
+
+/* Runs func(data, y, rows) over horizontal bands covering 'height' rows on
+   the thread pool.  Returns 0 without calling func if the work is too
+   small or threading isn't enabled.
+ */
+typedef void (*SDL_BandFunc)(void *data, int y, int rows);
+extern int SDL_RunBlitBands(SDL_BandFunc func, void *data, int width, int height);
+
+/* Functions found in SDL_fillrect.c */
+#define SDL_FILL_PATTERN_SIZE	128
+extern void SDL_InitFillPattern(Uint8 *pattern, int bpp, Uint32 color);
+
+/* Fills a clipped rectangle of a locked surface with 'color', using a
+   pattern made for it by SDL_InitFillPattern(). */
+extern void SDL_SoftFillRect(SDL_Surface *dst, const SDL_Rect *rect,
+			     Uint32 color, const Uint8 *pattern);
+
+/* Functions found in SDL_shadow.c */
+extern void SDL_PresentShadow(SDL_Surface *shadow, int numrects, SDL_Rect *rects);
+
 /* Functions found in SDL_blit_{0,1,N,A}.c */
 extern SDL_loblit SDL_CalculateBlit0(SDL_Surface *surface, int complex);
 extern SDL_loblit SDL_CalculateBlit1(SDL_Surface *surface, int complex);
@@ -52,6 +52,7 @@
 
 /* Function to check the CPU flags */
 #include "SDL_cpuinfo.h"
+#include "../cpuinfo/SDL_simd.h"
 #if GCC_ASMBLIT
 #include "mmx.h"
 #elif MSVC_ASMBLIT
@@ -2583,6 +2584,681 @@ static void BlitARGBto555PixelAlpha(SDL_BlitInfo *info)
 	}
 }
 
+#if SDL_SSE2_INTRINSICS
+/*
+ * The SSE2 and AVX2 blitters use the same arithmetic as the C and MMX
+ * versions so the results are bit-identical whichever one gets picked:
+ * 32 bit channels are blended as d + ((s - d) * alpha >> 8) modulo 256 and
+ * 16 bit channels as d + ((s - d) * alpha >> 5) with 5 bit alpha.  Opaque
+ * pixels are handled by bumping alpha to 256 (32 for 5 bit), which turns
+ * the blend into an exact copy instead of needing a separate branch.
+ */
+
+/* blend 4 ARGB pixels with pixel alpha; the dst alpha channel is kept */
+static __inline__ SDL_TARGETING("sse2")
+__m128i BlendRGBtoRGBPixelAlphaSSE2(__m128i s, __m128i d, __m128i amask,
+                                    __m128i ashift, __m128i chanmask)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i a, alo, ahi, dlo, dhi, lo, hi;
+
+	a = _mm_srl_epi32(_mm_and_si128(s, amask), ashift);
+	a = _mm_sub_epi32(a, _mm_cmpeq_epi32(a, _mm_set1_epi32(255)));
+	a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+	alo = _mm_and_si128(_mm_unpacklo_epi32(a, a), chanmask);
+	ahi = _mm_and_si128(_mm_unpackhi_epi32(a, a), chanmask);
+
+	dlo = _mm_unpacklo_epi8(d, zero);
+	dhi = _mm_unpackhi_epi8(d, zero);
+	lo = _mm_sub_epi16(_mm_unpacklo_epi8(s, zero), dlo);
+	hi = _mm_sub_epi16(_mm_unpackhi_epi8(s, zero), dhi);
+	lo = _mm_srli_epi16(_mm_mullo_epi16(lo, alo), 8);
+	hi = _mm_srli_epi16(_mm_mullo_epi16(hi, ahi), 8);
+	lo = _mm_add_epi8(lo, dlo);
+	hi = _mm_add_epi8(hi, dhi);
+	return _mm_packus_epi16(lo, hi);
+}
+
+/* blend 4 (A)RGB pixels with surface alpha; alpha holds 0 for the lane
+   that isn't a colour channel, so that lane keeps the dst value */
+static __inline__ SDL_TARGETING("sse2")
+__m128i BlendRGBtoRGBSurfaceAlphaSSE2(__m128i s, __m128i d, __m128i alpha,
+                                      __m128i dalpha)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i dlo, dhi, lo, hi;
+
+	dlo = _mm_unpacklo_epi8(d, zero);
+	dhi = _mm_unpackhi_epi8(d, zero);
+	lo = _mm_sub_epi16(_mm_unpacklo_epi8(s, zero), dlo);
+	hi = _mm_sub_epi16(_mm_unpackhi_epi8(s, zero), dhi);
+	lo = _mm_srli_epi16(_mm_mullo_epi16(lo, alpha), 8);
+	hi = _mm_srli_epi16(_mm_mullo_epi16(hi, alpha), 8);
+	lo = _mm_add_epi8(lo, dlo);
+	hi = _mm_add_epi8(hi, dhi);
+	return _mm_or_si128(_mm_packus_epi16(lo, hi), dalpha);
+}
+
+/* blend 8 16 bit pixels given as separate 5/6 bit channels and 5 bit alpha,
+   gbits is the size of the green channel (6 for 565, 5 for 555) */
+static __inline__ SDL_TARGETING("sse2")
+__m128i Blend16ChannelsSSE2(__m128i sr, __m128i sg, __m128i sb, __m128i d,
+                            __m128i a, int gbits)
+{
+	__m128i mask5 = _mm_set1_epi16(0x1f);
+	__m128i gmask = _mm_set1_epi16((1 << gbits) - 1);
+	__m128i dr, dg, db;
+
+	dr = _mm_and_si128(_mm_srli_epi16(d, 5 + gbits), mask5);
+	dg = _mm_and_si128(_mm_srli_epi16(d, 5), gmask);
+	db = _mm_and_si128(d, mask5);
+	dr = _mm_add_epi16(dr, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(sr, dr), a), 5));
+	dg = _mm_add_epi16(dg, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(sg, dg), a), 5));
+	db = _mm_add_epi16(db, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(sb, db), a), 5));
+	return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(dr, 5 + gbits),
+	                                 _mm_slli_epi16(dg, 5)), db);
+}
+
+/* blend 8 ARGB8888 pixels (s0, s1) with pixel alpha onto 8 RGB565/555 pixels */
+static __inline__ SDL_TARGETING("sse2")
+__m128i BlendARGBto16PixelAlphaSSE2(__m128i s0, __m128i s1, __m128i d, int gbits)
+{
+	__m128i mask5 = _mm_set1_epi32(0x1f);
+	__m128i gmask = _mm_set1_epi32((1 << gbits) - 1);
+	__m128i sr, sg, sb, a, keep;
+
+	sr = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 19), mask5),
+	                     _mm_and_si128(_mm_srli_epi32(s1, 19), mask5));
+	sg = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 16 - gbits), gmask),
+	                     _mm_and_si128(_mm_srli_epi32(s1, 16 - gbits), gmask));
+	sb = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 3), mask5),
+	                     _mm_and_si128(_mm_srli_epi32(s1, 3), mask5));
+	a = _mm_packs_epi32(_mm_srli_epi32(s0, 27), _mm_srli_epi32(s1, 27));
+	/* transparent pixels are left alone, including the unused 555 bit */
+	keep = _mm_cmpeq_epi16(a, _mm_setzero_si128());
+	a = _mm_sub_epi16(a, _mm_cmpeq_epi16(a, _mm_set1_epi16(31)));
+	return _mm_or_si128(_mm_and_si128(keep, d),
+	                    _mm_andnot_si128(keep, Blend16ChannelsSSE2(sr, sg, sb, d, a, gbits)));
+}
+
+/* blend 8 RGB565/555 pixels with surface alpha (5 bit) */
+static __inline__ SDL_TARGETING("sse2")
+__m128i Blend16to16SurfaceAlphaSSE2(__m128i s, __m128i d, __m128i a, int gbits)
+{
+	__m128i mask5 = _mm_set1_epi16(0x1f);
+	__m128i gmask = _mm_set1_epi16((1 << gbits) - 1);
+	__m128i sr, sg, sb;
+
+	sr = _mm_and_si128(_mm_srli_epi16(s, 5 + gbits), mask5);
+	sg = _mm_and_si128(_mm_srli_epi16(s, 5), gmask);
+	sb = _mm_and_si128(s, mask5);
+	return Blend16ChannelsSSE2(sr, sg, sb, d, a, gbits);
+}
+
+/* blend 8 16 bit pixels at 50%, the same way as BLEND16_50() */
+static __inline__ SDL_TARGETING("sse2")
+__m128i Blend16to16SurfaceAlpha128SSE2(__m128i s, __m128i d, __m128i mask)
+{
+	return _mm_add_epi16(_mm_add_epi16(_mm_srli_epi16(_mm_and_si128(s, mask), 1),
+	                                   _mm_srli_epi16(_mm_and_si128(d, mask), 1)),
+	                     _mm_andnot_si128(mask, _mm_and_si128(s, d)));
+}
+
+/* blend 4 RGB888 pixels at 50%, the same way as
+   BlitRGBtoRGBSurfaceAlpha128MMX() */
+static __inline__ SDL_TARGETING("sse2")
+__m128i BlendRGBtoRGBSurfaceAlpha128SSE2(__m128i s, __m128i d, __m128i dalpha)
+{
+	__m128i mask = _mm_set1_epi32(0x00fefefe);
+	__m128i lsb = _mm_set1_epi32(0x00010101);
+
+	return _mm_or_si128(_mm_add_epi32(_mm_srli_epi32(_mm_add_epi32(
+	                        _mm_and_si128(s, mask), _mm_and_si128(d, mask)), 1),
+	                    _mm_and_si128(_mm_and_si128(s, d), lsb)), dalpha);
+}
+
+/* 16 bit words of the colour channels of a 32 bit pixel format */
+static __inline__ SDL_TARGETING("sse2")
+__m128i ChannelWordsSSE2(Uint32 chanmask)
+{
+	__m128i mask = _mm_set1_epi32(chanmask);
+	return _mm_unpacklo_epi8(mask, mask);
+}
+
+/* fast ARGB888->(A)RGB888 blending with pixel alpha */
+static void SDL_TARGETING("sse2") BlitRGBtoRGBPixelAlphaSSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	SDL_PixelFormat *sf = info->src;
+	__m128i amask = _mm_set1_epi32(sf->Amask);
+	__m128i ashift = _mm_cvtsi32_si128(sf->Ashift);
+	__m128i chanmask = ChannelWordsSSE2(~sf->Amask);
+	__m128i zero = _mm_setzero_si128();
+
+	while(height--) {
+		int n = width;
+		while(n >= 4) {
+			__m128i s = _mm_loadu_si128((__m128i *)srcp);
+			/* skip fully transparent runs, they are common in sprites */
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, amask), zero)) != 0xffff) {
+				__m128i d = _mm_loadu_si128((__m128i *)dstp);
+				d = BlendRGBtoRGBPixelAlphaSSE2(s, d, amask, ashift, chanmask);
+				_mm_storeu_si128((__m128i *)dstp, d);
+			}
+			srcp += 4;
+			dstp += 4;
+			n -= 4;
+		}
+		while(n--) {
+			__m128i s = _mm_cvtsi32_si128(*srcp);
+			__m128i d = _mm_cvtsi32_si128(*dstp);
+			d = BlendRGBtoRGBPixelAlphaSSE2(s, d, amask, ashift, chanmask);
+			*dstp = _mm_cvtsi128_si32(d);
+			++srcp;
+			++dstp;
+		}
+		srcp += srcskip;
+		dstp += dstskip;
+	}
+}
+
+/* fast RGB888->(A)RGB888 blending with surface alpha */
+static void SDL_TARGETING("sse2") BlitRGBtoRGBSurfaceAlphaSSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	SDL_PixelFormat *df = info->dst;
+	Uint32 chans = (0xff << df->Rshift) | (0xff << df->Gshift) | (0xff << df->Bshift);
+	__m128i alpha = _mm_and_si128(_mm_set1_epi16(info->src->alpha), ChannelWordsSSE2(chans));
+	__m128i dalpha = _mm_set1_epi32(df->Amask);
+	/* only use the 50% blend when R,G,B occupy the lower bits, like MMX */
+	int half = (info->src->alpha == 128 && chans == 0x00ffffff);
+
+	while(height--) {
+		int n = width;
+		while(n >= 4) {
+			__m128i s = _mm_loadu_si128((__m128i *)srcp);
+			__m128i d = _mm_loadu_si128((__m128i *)dstp);
+			if(half)
+				d = BlendRGBtoRGBSurfaceAlpha128SSE2(s, d, dalpha);
+			else
+				d = BlendRGBtoRGBSurfaceAlphaSSE2(s, d, alpha, dalpha);
+			_mm_storeu_si128((__m128i *)dstp, d);
+			srcp += 4;
+			dstp += 4;
+			n -= 4;
+		}
+		while(n--) {
+			__m128i s = _mm_cvtsi32_si128(*srcp);
+			__m128i d = _mm_cvtsi32_si128(*dstp);
+			if(half)
+				d = BlendRGBtoRGBSurfaceAlpha128SSE2(s, d, dalpha);
+			else
+				d = BlendRGBtoRGBSurfaceAlphaSSE2(s, d, alpha, dalpha);
+			*dstp = _mm_cvtsi128_si32(d);
+			++srcp;
+			++dstp;
+		}
+		srcp += srcskip;
+		dstp += dstskip;
+	}
+}
+
+/* fast ARGB8888->RGB565/555 blending with pixel alpha */
+static void SDL_TARGETING("sse2") BlitARGBto16PixelAlphaSSE2(SDL_BlitInfo *info, int gbits)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
+	__m128i amask = _mm_set1_epi32(0xf8000000);
+	__m128i zero = _mm_setzero_si128();
+
+	while(height--) {
+		int n = width;
+		while(n >= 8) {
+			__m128i s0 = _mm_loadu_si128((__m128i *)srcp);
+			__m128i s1 = _mm_loadu_si128((__m128i *)(srcp + 4));
+			__m128i t = _mm_or_si128(_mm_and_si128(s0, amask),
+			                         _mm_and_si128(s1, amask));
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(t, zero)) != 0xffff) {
+				__m128i d = _mm_loadu_si128((__m128i *)dstp);
+				d = BlendARGBto16PixelAlphaSSE2(s0, s1, d, gbits);
+				_mm_storeu_si128((__m128i *)dstp, d);
+			}
+			srcp += 8;
+			dstp += 8;
+			n -= 8;
+		}
+		while(n--) {
+			__m128i s = _mm_cvtsi32_si128(*srcp);
+			__m128i d = _mm_cvtsi32_si128(*dstp);
+			d = BlendARGBto16PixelAlphaSSE2(s, zero, d, gbits);
+			*dstp = (Uint16)_mm_cvtsi128_si32(d);
+			++srcp;
+			++dstp;
+		}
+		srcp += srcskip;
+		dstp += dstskip;
+	}
+}
+
+static void BlitARGBto565PixelAlphaSSE2(SDL_BlitInfo *info)
+{
+	BlitARGBto16PixelAlphaSSE2(info, 6);
+}
+
+static void BlitARGBto555PixelAlphaSSE2(SDL_BlitInfo *info)
+{
+	BlitARGBto16PixelAlphaSSE2(info, 5);
+}
+
+/* fast RGB565/555->RGB565/555 blending with surface alpha */
+static void SDL_TARGETING("sse2") Blit16to16SurfaceAlphaSSE2(SDL_BlitInfo *info, int gbits)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *srcp = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip >> 1;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
+	int half = (info->src->alpha == 128);
+	__m128i alpha = _mm_set1_epi16(info->src->alpha >> 3); /* downscale alpha to 5 bits */
+	__m128i mask = _mm_set1_epi16((gbits == 6) ? 0xf7de : 0xfbde);
+
+	while(height--) {
+		int n = width;
+		while(n >= 8) {
+			__m128i s = _mm_loadu_si128((__m128i *)srcp);
+			__m128i d = _mm_loadu_si128((__m128i *)dstp);
+			if(half)
+				d = Blend16to16SurfaceAlpha128SSE2(s, d, mask);
+			else
+				d = Blend16to16SurfaceAlphaSSE2(s, d, alpha, gbits);
+			_mm_storeu_si128((__m128i *)dstp, d);
+			srcp += 8;
+			dstp += 8;
+			n -= 8;
+		}
+		while(n--) {
+			__m128i s = _mm_cvtsi32_si128(*srcp);
+			__m128i d = _mm_cvtsi32_si128(*dstp);
+			if(half)
+				d = Blend16to16SurfaceAlpha128SSE2(s, d, mask);
+			else
+				d = Blend16to16SurfaceAlphaSSE2(s, d, alpha, gbits);
+			*dstp = (Uint16)_mm_cvtsi128_si32(d);
+			++srcp;
+			++dstp;
+		}
+		srcp += srcskip;
+		dstp += dstskip;
+	}
+}
+
+static void Blit565to565SurfaceAlphaSSE2(SDL_BlitInfo *info)
+{
+	Blit16to16SurfaceAlphaSSE2(info, 6);
+}
+
+static void Blit555to555SurfaceAlphaSSE2(SDL_BlitInfo *info)
+{
+	Blit16to16SurfaceAlphaSSE2(info, 5);
+}
+
+#if SDL_AVX2_INTRINSICS
+/* The AVX2 versions do 8 (32 bit) or 16 (16 bit) pixels at a time and leave
+   the rest of each row to the SSE2 helpers above.  The unpack and pack
+   instructions work within 128 bit lanes, which keeps the 32 bit pixels in
+   order; only the 32->16 bit pack needs the quadwords put back in place. */
+
+static __inline__ SDL_TARGETING("avx2")
+__m256i BlendRGBtoRGBPixelAlphaAVX2(__m256i s, __m256i d, __m256i amask,
+                                    __m128i ashift, __m256i chanmask)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i a, alo, ahi, dlo, dhi, lo, hi;
+
+	a = _mm256_srl_epi32(_mm256_and_si256(s, amask), ashift);
+	a = _mm256_sub_epi32(a, _mm256_cmpeq_epi32(a, _mm256_set1_epi32(255)));
+	a = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+	alo = _mm256_and_si256(_mm256_unpacklo_epi32(a, a), chanmask);
+	ahi = _mm256_and_si256(_mm256_unpackhi_epi32(a, a), chanmask);
+
+	dlo = _mm256_unpacklo_epi8(d, zero);
+	dhi = _mm256_unpackhi_epi8(d, zero);
+	lo = _mm256_sub_epi16(_mm256_unpacklo_epi8(s, zero), dlo);
+	hi = _mm256_sub_epi16(_mm256_unpackhi_epi8(s, zero), dhi);
+	lo = _mm256_srli_epi16(_mm256_mullo_epi16(lo, alo), 8);
+	hi = _mm256_srli_epi16(_mm256_mullo_epi16(hi, ahi), 8);
+	lo = _mm256_add_epi8(lo, dlo);
+	hi = _mm256_add_epi8(hi, dhi);
+	return _mm256_packus_epi16(lo, hi);
+}
+
+static __inline__ SDL_TARGETING("avx2")
+__m256i BlendRGBtoRGBSurfaceAlpha128AVX2(__m256i s, __m256i d, __m256i dalpha)
+{
+	__m256i mask = _mm256_set1_epi32(0x00fefefe);
+	__m256i lsb = _mm256_set1_epi32(0x00010101);
+
+	return _mm256_or_si256(_mm256_add_epi32(_mm256_srli_epi32(_mm256_add_epi32(
+	                           _mm256_and_si256(s, mask), _mm256_and_si256(d, mask)), 1),
+	                       _mm256_and_si256(_mm256_and_si256(s, d), lsb)), dalpha);
+}
+
+static __inline__ SDL_TARGETING("avx2")
+__m256i BlendRGBtoRGBSurfaceAlphaAVX2(__m256i s, __m256i d, __m256i alpha,
+                                      __m256i dalpha)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i dlo, dhi, lo, hi;
+
+	dlo = _mm256_unpacklo_epi8(d, zero);
+	dhi = _mm256_unpackhi_epi8(d, zero);
+	lo = _mm256_sub_epi16(_mm256_unpacklo_epi8(s, zero), dlo);
+	hi = _mm256_sub_epi16(_mm256_unpackhi_epi8(s, zero), dhi);
+	lo = _mm256_srli_epi16(_mm256_mullo_epi16(lo, alpha), 8);
+	hi = _mm256_srli_epi16(_mm256_mullo_epi16(hi, alpha), 8);
+	lo = _mm256_add_epi8(lo, dlo);
+	hi = _mm256_add_epi8(hi, dhi);
+	return _mm256_or_si256(_mm256_packus_epi16(lo, hi), dalpha);
+}
+
+static __inline__ SDL_TARGETING("avx2")
+__m256i Blend16ChannelsAVX2(__m256i sr, __m256i sg, __m256i sb, __m256i d,
+                            __m256i a, int gbits)
+{
+	__m256i mask5 = _mm256_set1_epi16(0x1f);
+	__m256i gmask = _mm256_set1_epi16((1 << gbits) - 1);
+	__m256i dr, dg, db;
+
+	dr = _mm256_and_si256(_mm256_srli_epi16(d, 5 + gbits), mask5);
+	dg = _mm256_and_si256(_mm256_srli_epi16(d, 5), gmask);
+	db = _mm256_and_si256(d, mask5);
+	dr = _mm256_add_epi16(dr, _mm256_srai_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(sr, dr), a), 5));
+	dg = _mm256_add_epi16(dg, _mm256_srai_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(sg, dg), a), 5));
+	db = _mm256_add_epi16(db, _mm256_srai_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(sb, db), a), 5));
+	return _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi16(dr, 5 + gbits),
+	                                       _mm256_slli_epi16(dg, 5)), db);
+}
+
+/* s0 and s1 hold pixels 0-7 and 8-15, d holds pixels 0-15 */
+static __inline__ SDL_TARGETING("avx2")
+__m256i BlendARGBto16PixelAlphaAVX2(__m256i s0, __m256i s1, __m256i d, int gbits)
+{
+	__m256i mask5 = _mm256_set1_epi32(0x1f);
+	__m256i gmask = _mm256_set1_epi32((1 << gbits) - 1);
+	__m256i sr, sg, sb, a, keep;
+
+	/* the packs below leave the pixels in quadword order 0, 2, 1, 3 */
+	d = _mm256_permute4x64_epi64(d, 0xd8);
+	sr = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(s0, 19), mask5),
+	                        _mm256_and_si256(_mm256_srli_epi32(s1, 19), mask5));
+	sg = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(s0, 16 - gbits), gmask),
+	                        _mm256_and_si256(_mm256_srli_epi32(s1, 16 - gbits), gmask));
+	sb = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(s0, 3), mask5),
+	                        _mm256_and_si256(_mm256_srli_epi32(s1, 3), mask5));
+	a = _mm256_packs_epi32(_mm256_srli_epi32(s0, 27), _mm256_srli_epi32(s1, 27));
+	keep = _mm256_cmpeq_epi16(a, _mm256_setzero_si256());
+	a = _mm256_sub_epi16(a, _mm256_cmpeq_epi16(a, _mm256_set1_epi16(31)));
+	d = _mm256_or_si256(_mm256_and_si256(keep, d),
+	                    _mm256_andnot_si256(keep, Blend16ChannelsAVX2(sr, sg, sb, d, a, gbits)));
+	return _mm256_permute4x64_epi64(d, 0xd8);
+}
+
+static __inline__ SDL_TARGETING("avx2")
+__m256i Blend16to16SurfaceAlpha128AVX2(__m256i s, __m256i d, __m256i mask)
+{
+	return _mm256_add_epi16(_mm256_add_epi16(_mm256_srli_epi16(_mm256_and_si256(s, mask), 1),
+	                                         _mm256_srli_epi16(_mm256_and_si256(d, mask), 1)),
+	                        _mm256_andnot_si256(mask, _mm256_and_si256(s, d)));
+}
+
+static __inline__ SDL_TARGETING("avx2")
+__m256i Blend16to16SurfaceAlphaAVX2(__m256i s, __m256i d, __m256i a, int gbits)
+{
+	__m256i mask5 = _mm256_set1_epi16(0x1f);
+	__m256i gmask = _mm256_set1_epi16((1 << gbits) - 1);
+	__m256i sr, sg, sb;
+
+	sr = _mm256_and_si256(_mm256_srli_epi16(s, 5 + gbits), mask5);
+	sg = _mm256_and_si256(_mm256_srli_epi16(s, 5), gmask);
+	sb = _mm256_and_si256(s, mask5);
+	return Blend16ChannelsAVX2(sr, sg, sb, d, a, gbits);
+}
+
+/* fast ARGB888->(A)RGB888 blending with pixel alpha */
+static void SDL_TARGETING("avx2") BlitRGBtoRGBPixelAlphaAVX2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	SDL_PixelFormat *sf = info->src;
+	__m128i amask = _mm_set1_epi32(sf->Amask);
+	__m128i ashift = _mm_cvtsi32_si128(sf->Ashift);
+	__m128i chanmask = ChannelWordsSSE2(~sf->Amask);
+	__m256i amask8 = _mm256_broadcastsi128_si256(amask);
+	__m256i chanmask8 = _mm256_broadcastsi128_si256(chanmask);
+	__m256i zero8 = _mm256_setzero_si256();
+
+	while(height--) {
+		int n = width;
+		while(n >= 8) {
+			__m256i s = _mm256_loadu_si256((__m256i *)srcp);
+			/* skip fully transparent runs, they are common in sprites */
+			if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(s, amask8), zero8)) != -1) {
+				__m256i d = _mm256_loadu_si256((__m256i *)dstp);
+				d = BlendRGBtoRGBPixelAlphaAVX2(s, d, amask8, ashift, chanmask8);
+				_mm256_storeu_si256((__m256i *)dstp, d);
+			}
+			srcp += 8;
+			dstp += 8;
+			n -= 8;
+		}
+		if(n >= 4) {
+			__m128i s = _mm_loadu_si128((__m128i *)srcp);
+			__m128i d = _mm_loadu_si128((__m128i *)dstp);
+			d = BlendRGBtoRGBPixelAlphaSSE2(s, d, amask, ashift, chanmask);
+			_mm_storeu_si128((__m128i *)dstp, d);
+			srcp += 4;
+			dstp += 4;
+			n -= 4;
+		}
+		while(n--) {
+			__m128i s = _mm_cvtsi32_si128(*srcp);
+			__m128i d = _mm_cvtsi32_si128(*dstp);
+			d = BlendRGBtoRGBPixelAlphaSSE2(s, d, amask, ashift, chanmask);
+			*dstp = _mm_cvtsi128_si32(d);
+			++srcp;
+			++dstp;
+		}
+		srcp += srcskip;
+		dstp += dstskip;
+	}
+}
+
+/* fast RGB888->(A)RGB888 blending with surface alpha */
+static void SDL_TARGETING("avx2") BlitRGBtoRGBSurfaceAlphaAVX2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	SDL_PixelFormat *df = info->dst;
+	Uint32 chans = (0xff << df->Rshift) | (0xff << df->Gshift) | (0xff << df->Bshift);
+	__m128i alpha = _mm_and_si128(_mm_set1_epi16(info->src->alpha), ChannelWordsSSE2(chans));
+	__m128i dalpha = _mm_set1_epi32(df->Amask);
+	__m256i alpha8 = _mm256_broadcastsi128_si256(alpha);
+	__m256i dalpha8 = _mm256_broadcastsi128_si256(dalpha);
+	/* only use the 50% blend when R,G,B occupy the lower bits, like MMX */
+	int half = (info->src->alpha == 128 && chans == 0x00ffffff);
+
+	while(height--) {
+		int n = width;
+		while(n >= 8) {
+			__m256i s = _mm256_loadu_si256((__m256i *)srcp);
+			__m256i d = _mm256_loadu_si256((__m256i *)dstp);
+			if(half)
+				d = BlendRGBtoRGBSurfaceAlpha128AVX2(s, d, dalpha8);
+			else
+				d = BlendRGBtoRGBSurfaceAlphaAVX2(s, d, alpha8, dalpha8);
+			_mm256_storeu_si256((__m256i *)dstp, d);
+			srcp += 8;
+			dstp += 8;
+			n -= 8;
+		}
+		while(n--) {
+			__m128i s = _mm_cvtsi32_si128(*srcp);
+			__m128i d = _mm_cvtsi32_si128(*dstp);
+			if(half)
+				d = BlendRGBtoRGBSurfaceAlpha128SSE2(s, d, dalpha);
+			else
+				d = BlendRGBtoRGBSurfaceAlphaSSE2(s, d, alpha, dalpha);
+			*dstp = _mm_cvtsi128_si32(d);
+			++srcp;
+			++dstp;
+		}
+		srcp += srcskip;
+		dstp += dstskip;
+	}
+}
+
+/* fast ARGB8888->RGB565/555 blending with pixel alpha */
+static void SDL_TARGETING("avx2") BlitARGBto16PixelAlphaAVX2(SDL_BlitInfo *info, int gbits)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
+	__m256i amask = _mm256_set1_epi32(0xf8000000);
+	__m256i zero8 = _mm256_setzero_si256();
+	__m128i zero = _mm_setzero_si128();
+
+	while(height--) {
+		int n = width;
+		while(n >= 16) {
+			__m256i s0 = _mm256_loadu_si256((__m256i *)srcp);
+			__m256i s1 = _mm256_loadu_si256((__m256i *)(srcp + 8));
+			__m256i t = _mm256_or_si256(_mm256_and_si256(s0, amask),
+			                            _mm256_and_si256(s1, amask));
+			if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(t, zero8)) != -1) {
+				__m256i d = _mm256_loadu_si256((__m256i *)dstp);
+				d = BlendARGBto16PixelAlphaAVX2(s0, s1, d, gbits);
+				_mm256_storeu_si256((__m256i *)dstp, d);
+			}
+			srcp += 16;
+			dstp += 16;
+			n -= 16;
+		}
+		if(n >= 8) {
+			__m128i s0 = _mm_loadu_si128((__m128i *)srcp);
+			__m128i s1 = _mm_loadu_si128((__m128i *)(srcp + 4));
+			__m128i d = _mm_loadu_si128((__m128i *)dstp);
+			d = BlendARGBto16PixelAlphaSSE2(s0, s1, d, gbits);
+			_mm_storeu_si128((__m128i *)dstp, d);
+			srcp += 8;
+			dstp += 8;
+			n -= 8;
+		}
+		while(n--) {
+			__m128i s = _mm_cvtsi32_si128(*srcp);
+			__m128i d = _mm_cvtsi32_si128(*dstp);
+			d = BlendARGBto16PixelAlphaSSE2(s, zero, d, gbits);
+			*dstp = (Uint16)_mm_cvtsi128_si32(d);
+			++srcp;
+			++dstp;
+		}
+		srcp += srcskip;
+		dstp += dstskip;
+	}
+}
+
+static void BlitARGBto565PixelAlphaAVX2(SDL_BlitInfo *info)
+{
+	BlitARGBto16PixelAlphaAVX2(info, 6);
+}
+
+static void BlitARGBto555PixelAlphaAVX2(SDL_BlitInfo *info)
+{
+	BlitARGBto16PixelAlphaAVX2(info, 5);
+}
+
+/* fast RGB565/555->RGB565/555 blending with surface alpha */
+static void SDL_TARGETING("avx2") Blit16to16SurfaceAlphaAVX2(SDL_BlitInfo *info, int gbits)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *srcp = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip >> 1;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
+	int half = (info->src->alpha == 128);
+	__m128i alpha = _mm_set1_epi16(info->src->alpha >> 3); /* downscale alpha to 5 bits */
+	__m128i mask = _mm_set1_epi16((gbits == 6) ? 0xf7de : 0xfbde);
+	__m256i alpha16 = _mm256_broadcastsi128_si256(alpha);
+	__m256i mask16 = _mm256_broadcastsi128_si256(mask);
+
+	while(height--) {
+		int n = width;
+		while(n >= 16) {
+			__m256i s = _mm256_loadu_si256((__m256i *)srcp);
+			__m256i d = _mm256_loadu_si256((__m256i *)dstp);
+			if(half)
+				d = Blend16to16SurfaceAlpha128AVX2(s, d, mask16);
+			else
+				d = Blend16to16SurfaceAlphaAVX2(s, d, alpha16, gbits);
+			_mm256_storeu_si256((__m256i *)dstp, d);
+			srcp += 16;
+			dstp += 16;
+			n -= 16;
+		}
+		while(n--) {
+			__m128i s = _mm_cvtsi32_si128(*srcp);
+			__m128i d = _mm_cvtsi32_si128(*dstp);
+			if(half)
+				d = Blend16to16SurfaceAlpha128SSE2(s, d, mask);
+			else
+				d = Blend16to16SurfaceAlphaSSE2(s, d, alpha, gbits);
+			*dstp = (Uint16)_mm_cvtsi128_si32(d);
+			++srcp;
+			++dstp;
+		}
+		srcp += srcskip;
+		dstp += dstskip;
+	}
+}
+
+static void Blit565to565SurfaceAlphaAVX2(SDL_BlitInfo *info)
+{
+	Blit16to16SurfaceAlphaAVX2(info, 6);
+}
+
+static void Blit555to555SurfaceAlphaAVX2(SDL_BlitInfo *info)
+{
+	Blit16to16SurfaceAlphaAVX2(info, 5);
+}
+#endif /* SDL_AVX2_INTRINSICS */
+#endif /* SDL_SSE2_INTRINSICS */
+
 /* General (slow) N->N blending with per-surface alpha */
 static void BlitNtoNSurfaceAlpha(SDL_BlitInfo *info)
 {
@@ -2746,6 +3422,14 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		if(surface->map->identity) {
 		    if(df->Gmask == 0x7e0)
 		    {
+#if SDL_AVX2_INTRINSICS
+		if(SDL_HasAVX2())
+			return Blit565to565SurfaceAlphaAVX2;
+#endif
+#if SDL_SSE2_INTRINSICS
+		if(SDL_HasSSE2())
+			return Blit565to565SurfaceAlphaSSE2;
+#endif
 #if MMX_ASMBLIT
 		if(SDL_HasMMX())
 			return Blit565to565SurfaceAlphaMMX;
@@ -2755,6 +3439,14 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		    }
 		    else if(df->Gmask == 0x3e0)
 		    {
+#if SDL_AVX2_INTRINSICS
+		if(SDL_HasAVX2())
+			return Blit555to555SurfaceAlphaAVX2;
+#endif
+#if SDL_SSE2_INTRINSICS
+		if(SDL_HasSSE2())
+			return Blit555to555SurfaceAlphaSSE2;
+#endif
 #if MMX_ASMBLIT
 		if(SDL_HasMMX())
 			return Blit555to555SurfaceAlphaMMX;
@@ -2771,13 +3463,23 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		   && sf->Bmask == df->Bmask
 		   && sf->BytesPerPixel == 4)
 		{
-#if MMX_ASMBLIT
 			if(sf->Rshift % 8 == 0
 			   && sf->Gshift % 8 == 0
-			   && sf->Bshift % 8 == 0
-			   && SDL_HasMMX())
-			    return BlitRGBtoRGBSurfaceAlphaMMX;
+			   && sf->Bshift % 8 == 0)
+			{
+#if SDL_AVX2_INTRINSICS
+			    if(SDL_HasAVX2())
+				return BlitRGBtoRGBSurfaceAlphaAVX2;
 #endif
+#if SDL_SSE2_INTRINSICS
+			    if(SDL_HasSSE2())
+				return BlitRGBtoRGBSurfaceAlphaSSE2;
+#endif
+#if MMX_ASMBLIT
+			    if(SDL_HasMMX())
+				return BlitRGBtoRGBSurfaceAlphaMMX;
+#endif
+			}
 			if((sf->Rmask | sf->Gmask | sf->Bmask) == 0xffffff)
 			{
 #if SDL_ALTIVEC_BLITTERS
@@ -2819,10 +3521,27 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 	       && sf->Gmask == 0xff00
 	       && ((sf->Rmask == 0xff && df->Rmask == 0x1f)
 		   || (sf->Bmask == 0xff && df->Bmask == 0x1f))) {
-		if(df->Gmask == 0x7e0)
+		if(df->Gmask == 0x7e0) {
+#if SDL_AVX2_INTRINSICS
+		    if(SDL_HasAVX2())
+			return BlitARGBto565PixelAlphaAVX2;
+#endif
+#if SDL_SSE2_INTRINSICS
+		    if(SDL_HasSSE2())
+			return BlitARGBto565PixelAlphaSSE2;
+#endif
 		    return BlitARGBto565PixelAlpha;
-		else if(df->Gmask == 0x3e0)
+		} else if(df->Gmask == 0x3e0) {
+#if SDL_AVX2_INTRINSICS
+		    if(SDL_HasAVX2())
+			return BlitARGBto555PixelAlphaAVX2;
+#endif
+#if SDL_SSE2_INTRINSICS
+		    if(SDL_HasSSE2())
+			return BlitARGBto555PixelAlphaSSE2;
+#endif
 		    return BlitARGBto555PixelAlpha;
+		}
 	    }
 	    return BlitNtoNPixelAlpha;
 
@@ -2832,19 +3551,27 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 	       && sf->Bmask == df->Bmask
 	       && sf->BytesPerPixel == 4)
 	    {
-#if MMX_ASMBLIT
 		if(sf->Rshift % 8 == 0
 		   && sf->Gshift % 8 == 0
 		   && sf->Bshift % 8 == 0
 		   && sf->Ashift % 8 == 0
 		   && sf->Aloss == 0)
 		{
+#if SDL_AVX2_INTRINSICS
+			if(SDL_HasAVX2())
+				return BlitRGBtoRGBPixelAlphaAVX2;
+#endif
+#if SDL_SSE2_INTRINSICS
+			if(SDL_HasSSE2())
+				return BlitRGBtoRGBPixelAlphaSSE2;
+#endif
+#if MMX_ASMBLIT
 			if(SDL_Has3DNow())
 				return BlitRGBtoRGBPixelAlphaMMX3DNOW;
 			if(SDL_HasMMX())
 				return BlitRGBtoRGBPixelAlphaMMX;
-		}
 #endif
+		}
 		if(sf->Amask == 0xff000000)
 		{
 #if SDL_ALTIVEC_BLITTERS
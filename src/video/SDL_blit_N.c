@@ -25,6 +25,7 @@
 #include "SDL_endian.h"
 #include "SDL_cpuinfo.h"
 #include "SDL_blit.h"
+#include "../cpuinfo/SDL_simd.h"
 
 /* Functions to blit from N-bit surfaces to other surfaces */
 
@@ -810,36 +811,50 @@ static void ConvertAltivec32to32_prefetch(SDL_BlitInfo *info)
     vec_dss(DST_CHAN_DEST);
 }
 
+#if __MWERKS__
+#pragma altivec_model off
+#endif
+#endif /* SDL_ALTIVEC_BLITTERS */
+
+/* Blitter features, matched against the blit_features of the tables below */
+#define BLIT_FEATURE_HAS_MMX			0x00000001
+#define BLIT_FEATURE_HAS_ALTIVEC		0x00000002
+#define BLIT_FEATURE_ALTIVEC_DONT_USE_PREFETCH	0x00000004
+#define BLIT_FEATURE_HAS_SSE2			0x00000008
+#define BLIT_FEATURE_HAS_SSSE3			0x00000010
+#define BLIT_FEATURE_HAS_SSE41			0x00000020
+#define BLIT_FEATURE_HAS_AVX2			0x00000040
+#define BLIT_FEATURE_HAS_NEON			0x00000080
+
 static Uint32 GetBlitFeatures( void )
 {
     static Uint32 features = 0xffffffff;
     if (features == 0xffffffff) {
         /* Provide an override for testing .. */
-        char *override = SDL_getenv("SDL_ALTIVEC_BLIT_FEATURES");
+        char *override = SDL_getenv("SDL_BLIT_FEATURES");
+        if (!override) {
+            override = SDL_getenv("SDL_ALTIVEC_BLIT_FEATURES");
+        }
         if (override) {
-            features = 0;
-            SDL_sscanf(override, "%u", &features);
+            features = (Uint32)SDL_strtoul(override, NULL, 0);
         } else {
             features = ( 0
-                /* Feature 1 is has-MMX */
-                | ((SDL_HasMMX()) ? 1 : 0)
-                /* Feature 2 is has-AltiVec */
-                | ((SDL_HasAltiVec()) ? 2 : 0)
-                /* Feature 4 is dont-use-prefetch */
+                | ((SDL_HasMMX()) ? BLIT_FEATURE_HAS_MMX : 0)
+                | ((SDL_HasAltiVec()) ? BLIT_FEATURE_HAS_ALTIVEC : 0)
+#if SDL_ALTIVEC_BLITTERS
                 /* !!!! FIXME: Check for G5 or later, not the cache size! Always prefetch on a G4. */
-                | ((GetL3CacheSize() == 0) ? 4 : 0)
+                | ((GetL3CacheSize() == 0) ? BLIT_FEATURE_ALTIVEC_DONT_USE_PREFETCH : 0)
+#endif
+                | ((SDL_HasSSE2()) ? BLIT_FEATURE_HAS_SSE2 : 0)
+                | ((SDL_HasSSSE3()) ? BLIT_FEATURE_HAS_SSSE3 : 0)
+                | ((SDL_HasSSE41()) ? BLIT_FEATURE_HAS_SSE41 : 0)
+                | ((SDL_HasAVX2()) ? BLIT_FEATURE_HAS_AVX2 : 0)
+                | ((SDL_HasNEON()) ? BLIT_FEATURE_HAS_NEON : 0)
             );
         }
     }
     return features;
 }
-#if __MWERKS__
-#pragma altivec_model off
-#endif
-#else
-/* Feature 1 is has-MMX */
-#define GetBlitFeatures() ((Uint32)(SDL_HasMMX() ? 1 : 0))
-#endif
 
 /* This is now endian dependent */
 #if SDL_BYTEORDER == SDL_LIL_ENDIAN
@@ -2269,6 +2284,812 @@ static void BlitNtoNKeyCopyAlpha(SDL_BlitInfo *info)
 	}
 }
 
+#if SDL_SSE2_INTRINSICS || SDL_NEON_INTRINSICS
+/*
+ * Vector versions of the C blitters above, for 16 and 32 bit sources going
+ * to 32 bit destinations.  Each channel of the source pixel has the bits it
+ * would lose in DISEMBLE_RGB/ASSEMBLE_RGBA masked off first, after which a
+ * single shift puts it in its destination place, so the results are the
+ * same as the C versions for any format with up to 8 bits per channel.
+ */
+typedef struct {
+	Uint32 mask[4];
+	int shift[4];		/* to the left if positive, right if negative */
+	Uint32 alpha;		/* or'ed in when the alpha isn't copied */
+} VectorShift;
+
+static void CalculateVectorShift(const SDL_PixelFormat *srcfmt,
+                                 const SDL_PixelFormat *dstfmt,
+                                 VectorShift *vs)
+{
+	const Uint32 smask[4] = {
+		srcfmt->Rmask, srcfmt->Gmask, srcfmt->Bmask, srcfmt->Amask
+	};
+	const int sshift[4] = {
+		srcfmt->Rshift, srcfmt->Gshift, srcfmt->Bshift, srcfmt->Ashift
+	};
+	const int sloss[4] = {
+		srcfmt->Rloss, srcfmt->Gloss, srcfmt->Bloss, srcfmt->Aloss
+	};
+	const int dshift[4] = {
+		dstfmt->Rshift, dstfmt->Gshift, dstfmt->Bshift, dstfmt->Ashift
+	};
+	const int dloss[4] = {
+		dstfmt->Rloss, dstfmt->Gloss, dstfmt->Bloss, dstfmt->Aloss
+	};
+	int copy_alpha = (srcfmt->Amask && dstfmt->Amask);
+	int i;
+
+	for ( i = 0; i < 4; ++i ) {
+		int drop = (dloss[i] > sloss[i]) ? dloss[i] - sloss[i] : 0;
+
+		if ( (i == 3 && !copy_alpha) || sshift[i] + drop >= 32 ) {
+			vs->mask[i] = 0;
+		} else {
+			vs->mask[i] = smask[i] & ~(((Uint32)1 << (sshift[i] + drop)) - 1);
+		}
+		if ( vs->mask[i] ) {
+			vs->shift[i] = dshift[i] - sshift[i] + sloss[i] - dloss[i];
+		} else {
+			vs->shift[i] = 0;
+		}
+	}
+	if ( dstfmt->Amask && !copy_alpha ) {
+		vs->alpha = (srcfmt->alpha >> dstfmt->Aloss) << dstfmt->Ashift;
+	} else {
+		vs->alpha = 0;
+	}
+}
+
+/*
+ * RGB 5-6-5 to 8 bit channels the way the RGB565_*_LUT tables do it:
+ * r = r5 * 1053 >> 7 (same for b), g = g_lo3 * 4 + (g_hi3 * 259 >> 3)
+ * where the green bits are split at the byte boundary of the pixel.
+ */
+
+#if SDL_SSE2_INTRINSICS
+static __inline__ SDL_TARGETING("sse2")
+__m128i ConvertNto4SSE2(__m128i s, const __m128i *mask, const __m128i *lshift,
+                        const __m128i *rshift, __m128i alpha)
+{
+	__m128i d = alpha;
+	int i;
+
+	for ( i = 0; i < 4; ++i ) {
+		__m128i c = _mm_and_si128(s, mask[i]);
+		c = _mm_srl_epi32(_mm_sll_epi32(c, lshift[i]), rshift[i]);
+		d = _mm_or_si128(d, c);
+	}
+	return d;
+}
+
+static __inline__ SDL_TARGETING("sse2")
+void SetupNto4SSE2(SDL_BlitInfo *info, __m128i *mask, __m128i *lshift,
+                   __m128i *rshift, __m128i *alpha)
+{
+	VectorShift vs;
+	int i;
+
+	CalculateVectorShift(info->src, info->dst, &vs);
+	for ( i = 0; i < 4; ++i ) {
+		mask[i] = _mm_set1_epi32(vs.mask[i]);
+		lshift[i] = _mm_cvtsi32_si128(vs.shift[i] > 0 ? vs.shift[i] : 0);
+		rshift[i] = _mm_cvtsi32_si128(vs.shift[i] < 0 ? -vs.shift[i] : 0);
+	}
+	*alpha = _mm_set1_epi32(vs.alpha);
+}
+
+/* load 4 source pixels, or 1 for the end of a row, as 32 bit lanes */
+static __inline__ SDL_TARGETING("sse2")
+__m128i LoadNto4SSE2(const Uint8 *src, int srcbpp)
+{
+	if ( srcbpp == 2 ) {
+		return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)src),
+		                          _mm_setzero_si128());
+	}
+	return _mm_loadu_si128((const __m128i *)src);
+}
+
+static __inline__ SDL_TARGETING("sse2")
+__m128i LoadPixelNto4SSE2(const Uint8 *src, int srcbpp)
+{
+	if ( srcbpp == 2 ) {
+		return _mm_cvtsi32_si128(*(const Uint16 *)src);
+	}
+	return _mm_cvtsi32_si128(*(const Uint32 *)src);
+}
+
+/* blits 32 bit RGB<->RGBA with both surfaces having the same R,G,B fields */
+static void SDL_TARGETING("sse2") Blit4to4MaskAlphaSSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	__m128i ormask, andmask;
+
+	if ( dstfmt->Amask ) {
+		ormask = _mm_set1_epi32((srcfmt->alpha >> dstfmt->Aloss) << dstfmt->Ashift);
+		andmask = _mm_set1_epi32(0xffffffff);
+	} else {
+		ormask = _mm_setzero_si128();
+		andmask = _mm_set1_epi32(srcfmt->Rmask | srcfmt->Gmask | srcfmt->Bmask);
+	}
+
+	while ( height-- ) {
+		int n = width;
+		while ( n >= 4 ) {
+			__m128i s = _mm_loadu_si128((__m128i *)src);
+			s = _mm_or_si128(_mm_and_si128(s, andmask), ormask);
+			_mm_storeu_si128((__m128i *)dst, s);
+			src += 4;
+			dst += 4;
+			n -= 4;
+		}
+		while ( n-- ) {
+			__m128i s = _mm_cvtsi32_si128(*src);
+			s = _mm_or_si128(_mm_and_si128(s, andmask), ormask);
+			*dst = _mm_cvtsi128_si32(s);
+			++src;
+			++dst;
+		}
+		src = (Uint32*)((Uint8*)src + srcskip);
+		dst = (Uint32*)((Uint8*)dst + dstskip);
+	}
+}
+
+/* BlitNtoN and BlitNtoNCopyAlpha for 16 or 32 bit to 32 bit */
+static void SDL_TARGETING("sse2") BlitNto4SSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	int srcbpp = info->src->BytesPerPixel;
+	__m128i mask[4], lshift[4], rshift[4], alpha;
+
+	SetupNto4SSE2(info, mask, lshift, rshift, &alpha);
+
+	while ( height-- ) {
+		int n = width;
+		while ( n >= 4 ) {
+			__m128i s = LoadNto4SSE2(src, srcbpp);
+			s = ConvertNto4SSE2(s, mask, lshift, rshift, alpha);
+			_mm_storeu_si128((__m128i *)dst, s);
+			src += 4 * srcbpp;
+			dst += 4;
+			n -= 4;
+		}
+		while ( n-- ) {
+			__m128i s = LoadPixelNto4SSE2(src, srcbpp);
+			s = ConvertNto4SSE2(s, mask, lshift, rshift, alpha);
+			*dst = _mm_cvtsi128_si32(s);
+			src += srcbpp;
+			++dst;
+		}
+		src += srcskip;
+		dst = (Uint32*)((Uint8*)dst + dstskip);
+	}
+}
+
+/* BlitNtoNKey and BlitNtoNKeyCopyAlpha for 16 or 32 bit to 32 bit */
+static void SDL_TARGETING("sse2") BlitNto4KeySSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	int srcbpp = info->src->BytesPerPixel;
+	Uint32 rgbmask = ~info->src->Amask;
+	Uint32 ckey = info->src->colorkey & rgbmask;
+	__m128i ckey4 = _mm_set1_epi32(ckey);
+	__m128i keymask4 = _mm_set1_epi32(rgbmask);
+	__m128i mask[4], lshift[4], rshift[4], alpha;
+
+	SetupNto4SSE2(info, mask, lshift, rshift, &alpha);
+
+	while ( height-- ) {
+		int n = width;
+		while ( n >= 4 ) {
+			__m128i s = LoadNto4SSE2(src, srcbpp);
+			__m128i d = _mm_loadu_si128((__m128i *)dst);
+			__m128i key = _mm_cmpeq_epi32(_mm_and_si128(s, keymask4), ckey4);
+			s = ConvertNto4SSE2(s, mask, lshift, rshift, alpha);
+			d = _mm_or_si128(_mm_and_si128(key, d), _mm_andnot_si128(key, s));
+			_mm_storeu_si128((__m128i *)dst, d);
+			src += 4 * srcbpp;
+			dst += 4;
+			n -= 4;
+		}
+		while ( n-- ) {
+			__m128i s = LoadPixelNto4SSE2(src, srcbpp);
+			if ( ((Uint32)_mm_cvtsi128_si32(s) & rgbmask) != ckey ) {
+				s = ConvertNto4SSE2(s, mask, lshift, rshift, alpha);
+				*dst = _mm_cvtsi128_si32(s);
+			}
+			src += srcbpp;
+			++dst;
+		}
+		src += srcskip;
+		dst = (Uint32*)((Uint8*)dst + dstskip);
+	}
+}
+
+/* 8 RGB565 pixels to 8 bit channels in 16 bit lanes */
+static __inline__ SDL_TARGETING("sse2")
+void ExpandRGB565SSE2(__m128i p, __m128i *r, __m128i *g, __m128i *b)
+{
+	__m128i m5 = _mm_set1_epi16(1053);
+	__m128i glo, ghi;
+
+	*r = _mm_srli_epi16(_mm_mullo_epi16(_mm_srli_epi16(p, 11), m5), 7);
+	*b = _mm_srli_epi16(_mm_mullo_epi16(_mm_and_si128(p, _mm_set1_epi16(0x1f)), m5), 7);
+	glo = _mm_and_si128(_mm_srli_epi16(p, 3), _mm_set1_epi16(0x1c));
+	ghi = _mm_and_si128(_mm_srli_epi16(p, 8), _mm_set1_epi16(7));
+	ghi = _mm_srli_epi16(_mm_mullo_epi16(ghi, _mm_set1_epi16(259)), 3);
+	*g = _mm_add_epi16(glo, ghi);
+}
+
+static __inline__ SDL_TARGETING("sse2")
+void ConvertRGB565SSE2(const Uint16 *src, Uint32 *dst, __m128i rshift,
+                       __m128i gshift, __m128i bshift, __m128i alpha)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i r, g, b, lo, hi;
+
+	ExpandRGB565SSE2(_mm_loadu_si128((const __m128i *)src), &r, &g, &b);
+	lo = _mm_or_si128(alpha, _mm_sll_epi32(_mm_unpacklo_epi16(r, zero), rshift));
+	hi = _mm_or_si128(alpha, _mm_sll_epi32(_mm_unpackhi_epi16(r, zero), rshift));
+	lo = _mm_or_si128(lo, _mm_sll_epi32(_mm_unpacklo_epi16(g, zero), gshift));
+	hi = _mm_or_si128(hi, _mm_sll_epi32(_mm_unpackhi_epi16(g, zero), gshift));
+	lo = _mm_or_si128(lo, _mm_sll_epi32(_mm_unpacklo_epi16(b, zero), bshift));
+	hi = _mm_or_si128(hi, _mm_sll_epi32(_mm_unpackhi_epi16(b, zero), bshift));
+	_mm_storeu_si128((__m128i *)dst, lo);
+	_mm_storeu_si128((__m128i *)(dst + 4), hi);
+}
+
+/* convert a row of RGB565 pixels, 8 at a time with the end done in a copy */
+static __inline__ SDL_TARGETING("sse2")
+void ConvertRGB565RowSSE2(const Uint16 *src, Uint32 *dst, int n,
+                          __m128i rshift, __m128i gshift, __m128i bshift,
+                          __m128i alpha)
+{
+	while ( n >= 8 ) {
+		ConvertRGB565SSE2(src, dst, rshift, gshift, bshift, alpha);
+		src += 8;
+		dst += 8;
+		n -= 8;
+	}
+	if ( n ) {
+		Uint16 s[8];
+		Uint32 d[8];
+		SDL_memcpy(s, src, n * 2);
+		ConvertRGB565SSE2(s, d, rshift, gshift, bshift, alpha);
+		SDL_memcpy(dst, d, n * 4);
+	}
+}
+
+/* Special optimized blit for RGB 5-6-5 --> 8-8-8-8 with alpha, any order */
+static void SDL_TARGETING("sse2") Blit_RGB565_8888SSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *src = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	SDL_PixelFormat *dstfmt = info->dst;
+	__m128i rshift = _mm_cvtsi32_si128(dstfmt->Rshift);
+	__m128i gshift = _mm_cvtsi32_si128(dstfmt->Gshift);
+	__m128i bshift = _mm_cvtsi32_si128(dstfmt->Bshift);
+	__m128i alpha = _mm_set1_epi32(~(dstfmt->Rmask | dstfmt->Gmask | dstfmt->Bmask));
+
+	while ( height-- ) {
+		ConvertRGB565RowSSE2(src, dst, width, rshift, gshift, bshift, alpha);
+		src = (Uint16*)((Uint8*)(src + width) + srcskip);
+		dst = (Uint32*)((Uint8*)(dst + width) + dstskip);
+	}
+}
+
+#if SDL_AVX2_INTRINSICS
+/* The AVX2 versions do 8 pixels at a time (16 for RGB565) and leave the
+   rest of each row to the SSE2 helpers above. */
+
+static __inline__ SDL_TARGETING("avx2")
+__m256i ConvertNto4AVX2(__m256i s, const __m256i *mask, const __m128i *lshift,
+                        const __m128i *rshift, __m256i alpha)
+{
+	__m256i d = alpha;
+	int i;
+
+	for ( i = 0; i < 4; ++i ) {
+		__m256i c = _mm256_and_si256(s, mask[i]);
+		c = _mm256_srl_epi32(_mm256_sll_epi32(c, lshift[i]), rshift[i]);
+		d = _mm256_or_si256(d, c);
+	}
+	return d;
+}
+
+static __inline__ SDL_TARGETING("avx2")
+__m256i LoadNto4AVX2(const Uint8 *src, int srcbpp)
+{
+	if ( srcbpp == 2 ) {
+		return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)src));
+	}
+	return _mm256_loadu_si256((const __m256i *)src);
+}
+
+static void SDL_TARGETING("avx2") Blit4to4MaskAlphaAVX2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	__m256i ormask, andmask;
+
+	if ( dstfmt->Amask ) {
+		ormask = _mm256_set1_epi32((srcfmt->alpha >> dstfmt->Aloss) << dstfmt->Ashift);
+		andmask = _mm256_set1_epi32(0xffffffff);
+	} else {
+		ormask = _mm256_setzero_si256();
+		andmask = _mm256_set1_epi32(srcfmt->Rmask | srcfmt->Gmask | srcfmt->Bmask);
+	}
+
+	while ( height-- ) {
+		int n = width;
+		while ( n >= 8 ) {
+			__m256i s = _mm256_loadu_si256((__m256i *)src);
+			s = _mm256_or_si256(_mm256_and_si256(s, andmask), ormask);
+			_mm256_storeu_si256((__m256i *)dst, s);
+			src += 8;
+			dst += 8;
+			n -= 8;
+		}
+		while ( n-- ) {
+			__m128i s = _mm_cvtsi32_si128(*src);
+			s = _mm_or_si128(_mm_and_si128(s, _mm256_castsi256_si128(andmask)),
+			                 _mm256_castsi256_si128(ormask));
+			*dst = _mm_cvtsi128_si32(s);
+			++src;
+			++dst;
+		}
+		src = (Uint32*)((Uint8*)src + srcskip);
+		dst = (Uint32*)((Uint8*)dst + dstskip);
+	}
+}
+
+static void SDL_TARGETING("avx2") BlitNto4AVX2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	int srcbpp = info->src->BytesPerPixel;
+	__m128i mask[4], lshift[4], rshift[4], alpha;
+	__m256i mask8[4], alpha8;
+	int i;
+
+	SetupNto4SSE2(info, mask, lshift, rshift, &alpha);
+	for ( i = 0; i < 4; ++i ) {
+		mask8[i] = _mm256_broadcastsi128_si256(mask[i]);
+	}
+	alpha8 = _mm256_broadcastsi128_si256(alpha);
+
+	while ( height-- ) {
+		int n = width;
+		while ( n >= 8 ) {
+			__m256i s = LoadNto4AVX2(src, srcbpp);
+			s = ConvertNto4AVX2(s, mask8, lshift, rshift, alpha8);
+			_mm256_storeu_si256((__m256i *)dst, s);
+			src += 8 * srcbpp;
+			dst += 8;
+			n -= 8;
+		}
+		while ( n-- ) {
+			__m128i s = LoadPixelNto4SSE2(src, srcbpp);
+			s = ConvertNto4SSE2(s, mask, lshift, rshift, alpha);
+			*dst = _mm_cvtsi128_si32(s);
+			src += srcbpp;
+			++dst;
+		}
+		src += srcskip;
+		dst = (Uint32*)((Uint8*)dst + dstskip);
+	}
+}
+
+static void SDL_TARGETING("avx2") BlitNto4KeyAVX2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	int srcbpp = info->src->BytesPerPixel;
+	Uint32 rgbmask = ~info->src->Amask;
+	Uint32 ckey = info->src->colorkey & rgbmask;
+	__m256i ckey8 = _mm256_set1_epi32(ckey);
+	__m256i keymask8 = _mm256_set1_epi32(rgbmask);
+	__m128i mask[4], lshift[4], rshift[4], alpha;
+	__m256i mask8[4], alpha8;
+	int i;
+
+	SetupNto4SSE2(info, mask, lshift, rshift, &alpha);
+	for ( i = 0; i < 4; ++i ) {
+		mask8[i] = _mm256_broadcastsi128_si256(mask[i]);
+	}
+	alpha8 = _mm256_broadcastsi128_si256(alpha);
+
+	while ( height-- ) {
+		int n = width;
+		while ( n >= 8 ) {
+			__m256i s = LoadNto4AVX2(src, srcbpp);
+			__m256i d = _mm256_loadu_si256((__m256i *)dst);
+			__m256i key = _mm256_cmpeq_epi32(_mm256_and_si256(s, keymask8), ckey8);
+			s = ConvertNto4AVX2(s, mask8, lshift, rshift, alpha8);
+			d = _mm256_blendv_epi8(s, d, key);
+			_mm256_storeu_si256((__m256i *)dst, d);
+			src += 8 * srcbpp;
+			dst += 8;
+			n -= 8;
+		}
+		while ( n-- ) {
+			__m128i s = LoadPixelNto4SSE2(src, srcbpp);
+			if ( ((Uint32)_mm_cvtsi128_si32(s) & rgbmask) != ckey ) {
+				s = ConvertNto4SSE2(s, mask, lshift, rshift, alpha);
+				*dst = _mm_cvtsi128_si32(s);
+			}
+			src += srcbpp;
+			++dst;
+		}
+		src += srcskip;
+		dst = (Uint32*)((Uint8*)dst + dstskip);
+	}
+}
+
+static void SDL_TARGETING("avx2") Blit_RGB565_8888AVX2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *src = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	SDL_PixelFormat *dstfmt = info->dst;
+	__m128i rshift = _mm_cvtsi32_si128(dstfmt->Rshift);
+	__m128i gshift = _mm_cvtsi32_si128(dstfmt->Gshift);
+	__m128i bshift = _mm_cvtsi32_si128(dstfmt->Bshift);
+	__m128i alpha = _mm_set1_epi32(~(dstfmt->Rmask | dstfmt->Gmask | dstfmt->Bmask));
+	__m256i alpha8 = _mm256_broadcastsi128_si256(alpha);
+	__m256i m5 = _mm256_set1_epi16(1053);
+	__m256i zero = _mm256_setzero_si256();
+
+	while ( height-- ) {
+		int n = width;
+		while ( n >= 16 ) {
+			__m256i p = _mm256_loadu_si256((__m256i *)src);
+			__m256i r, g, b, glo, ghi, lo, hi;
+
+			r = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_srli_epi16(p, 11), m5), 7);
+			b = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_and_si256(p, _mm256_set1_epi16(0x1f)), m5), 7);
+			glo = _mm256_and_si256(_mm256_srli_epi16(p, 3), _mm256_set1_epi16(0x1c));
+			ghi = _mm256_and_si256(_mm256_srli_epi16(p, 8), _mm256_set1_epi16(7));
+			ghi = _mm256_srli_epi16(_mm256_mullo_epi16(ghi, _mm256_set1_epi16(259)), 3);
+			g = _mm256_add_epi16(glo, ghi);
+
+			/* the unpacks work within 128 bit lanes: lo has pixels
+			   0-3 and 8-11, hi has 4-7 and 12-15 */
+			lo = _mm256_or_si256(alpha8, _mm256_sll_epi32(_mm256_unpacklo_epi16(r, zero), rshift));
+			hi = _mm256_or_si256(alpha8, _mm256_sll_epi32(_mm256_unpackhi_epi16(r, zero), rshift));
+			lo = _mm256_or_si256(lo, _mm256_sll_epi32(_mm256_unpacklo_epi16(g, zero), gshift));
+			hi = _mm256_or_si256(hi, _mm256_sll_epi32(_mm256_unpackhi_epi16(g, zero), gshift));
+			lo = _mm256_or_si256(lo, _mm256_sll_epi32(_mm256_unpacklo_epi16(b, zero), bshift));
+			hi = _mm256_or_si256(hi, _mm256_sll_epi32(_mm256_unpackhi_epi16(b, zero), bshift));
+			_mm256_storeu_si256((__m256i *)dst, _mm256_permute2x128_si256(lo, hi, 0x20));
+			_mm256_storeu_si256((__m256i *)(dst + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+			src += 16;
+			dst += 16;
+			n -= 16;
+		}
+		ConvertRGB565RowSSE2(src, dst, n, rshift, gshift, bshift, alpha);
+		src = (Uint16*)((Uint8*)(src + n) + srcskip);
+		dst = (Uint32*)((Uint8*)(dst + n) + dstskip);
+	}
+}
+#endif /* SDL_AVX2_INTRINSICS */
+#endif /* SDL_SSE2_INTRINSICS */
+
+#if SDL_NEON_INTRINSICS
+static __inline__ uint32x4_t ConvertNto4NEON(uint32x4_t s, const uint32x4_t *mask,
+                                              const int32x4_t *shift, uint32x4_t alpha)
+{
+	uint32x4_t d = alpha;
+	int i;
+
+	for ( i = 0; i < 4; ++i ) {
+		d = vorrq_u32(d, vshlq_u32(vandq_u32(s, mask[i]), shift[i]));
+	}
+	return d;
+}
+
+static __inline__ void SetupNto4NEON(SDL_BlitInfo *info, uint32x4_t *mask,
+                                     int32x4_t *shift, uint32x4_t *alpha)
+{
+	VectorShift vs;
+	int i;
+
+	CalculateVectorShift(info->src, info->dst, &vs);
+	for ( i = 0; i < 4; ++i ) {
+		mask[i] = vdupq_n_u32(vs.mask[i]);
+		shift[i] = vdupq_n_s32(vs.shift[i]);
+	}
+	*alpha = vdupq_n_u32(vs.alpha);
+}
+
+static __inline__ uint32x4_t LoadNto4NEON(const Uint8 *src, int srcbpp)
+{
+	if ( srcbpp == 2 ) {
+		return vmovl_u16(vld1_u16((const uint16_t *)src));
+	}
+	return vld1q_u32((const uint32_t *)src);
+}
+
+static __inline__ uint32x4_t LoadPixelNto4NEON(const Uint8 *src, int srcbpp)
+{
+	if ( srcbpp == 2 ) {
+		return vdupq_n_u32(*(const Uint16 *)src);
+	}
+	return vdupq_n_u32(*(const Uint32 *)src);
+}
+
+static void Blit4to4MaskAlphaNEON(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	Uint32 ormask, andmask;
+	uint32x4_t ormask4, andmask4;
+
+	if ( dstfmt->Amask ) {
+		ormask = (srcfmt->alpha >> dstfmt->Aloss) << dstfmt->Ashift;
+		andmask = 0xffffffff;
+	} else {
+		ormask = 0;
+		andmask = srcfmt->Rmask | srcfmt->Gmask | srcfmt->Bmask;
+	}
+	ormask4 = vdupq_n_u32(ormask);
+	andmask4 = vdupq_n_u32(andmask);
+
+	while ( height-- ) {
+		int n = width;
+		while ( n >= 4 ) {
+			uint32x4_t s = vld1q_u32(src);
+			vst1q_u32(dst, vorrq_u32(vandq_u32(s, andmask4), ormask4));
+			src += 4;
+			dst += 4;
+			n -= 4;
+		}
+		while ( n-- ) {
+			*dst = (*src & andmask) | ormask;
+			++src;
+			++dst;
+		}
+		src = (Uint32*)((Uint8*)src + srcskip);
+		dst = (Uint32*)((Uint8*)dst + dstskip);
+	}
+}
+
+static void BlitNto4NEON(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	int srcbpp = info->src->BytesPerPixel;
+	uint32x4_t mask[4], alpha;
+	int32x4_t shift[4];
+
+	SetupNto4NEON(info, mask, shift, &alpha);
+
+	while ( height-- ) {
+		int n = width;
+		while ( n >= 4 ) {
+			uint32x4_t s = LoadNto4NEON(src, srcbpp);
+			vst1q_u32(dst, ConvertNto4NEON(s, mask, shift, alpha));
+			src += 4 * srcbpp;
+			dst += 4;
+			n -= 4;
+		}
+		while ( n-- ) {
+			uint32x4_t s = LoadPixelNto4NEON(src, srcbpp);
+			*dst = vgetq_lane_u32(ConvertNto4NEON(s, mask, shift, alpha), 0);
+			src += srcbpp;
+			++dst;
+		}
+		src += srcskip;
+		dst = (Uint32*)((Uint8*)dst + dstskip);
+	}
+}
+
+static void BlitNto4KeyNEON(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	int srcbpp = info->src->BytesPerPixel;
+	Uint32 rgbmask = ~info->src->Amask;
+	Uint32 ckey = info->src->colorkey & rgbmask;
+	uint32x4_t ckey4 = vdupq_n_u32(ckey);
+	uint32x4_t keymask4 = vdupq_n_u32(rgbmask);
+	uint32x4_t mask[4], alpha;
+	int32x4_t shift[4];
+
+	SetupNto4NEON(info, mask, shift, &alpha);
+
+	while ( height-- ) {
+		int n = width;
+		while ( n >= 4 ) {
+			uint32x4_t s = LoadNto4NEON(src, srcbpp);
+			uint32x4_t key = vceqq_u32(vandq_u32(s, keymask4), ckey4);
+			s = ConvertNto4NEON(s, mask, shift, alpha);
+			vst1q_u32(dst, vbslq_u32(key, vld1q_u32(dst), s));
+			src += 4 * srcbpp;
+			dst += 4;
+			n -= 4;
+		}
+		while ( n-- ) {
+			uint32x4_t s = LoadPixelNto4NEON(src, srcbpp);
+			if ( (vgetq_lane_u32(s, 0) & rgbmask) != ckey ) {
+				*dst = vgetq_lane_u32(ConvertNto4NEON(s, mask, shift, alpha), 0);
+			}
+			src += srcbpp;
+			++dst;
+		}
+		src += srcskip;
+		dst = (Uint32*)((Uint8*)dst + dstskip);
+	}
+}
+
+static __inline__ void ConvertRGB565NEON(const Uint16 *src, Uint32 *dst,
+                                         int32x4_t rshift, int32x4_t gshift,
+                                         int32x4_t bshift, uint32x4_t alpha)
+{
+	uint16x8_t p = vld1q_u16(src);
+	uint16x8_t r, g, b, glo, ghi;
+
+	r = vshrq_n_u16(vmulq_n_u16(vshrq_n_u16(p, 11), 1053), 7);
+	b = vshrq_n_u16(vmulq_n_u16(vandq_u16(p, vdupq_n_u16(0x1f)), 1053), 7);
+	glo = vandq_u16(vshrq_n_u16(p, 3), vdupq_n_u16(0x1c));
+	ghi = vandq_u16(vshrq_n_u16(p, 8), vdupq_n_u16(7));
+	g = vaddq_u16(glo, vshrq_n_u16(vmulq_n_u16(ghi, 259), 3));
+
+	vst1q_u32(dst, vorrq_u32(vorrq_u32(alpha,
+	          vshlq_u32(vmovl_u16(vget_low_u16(r)), rshift)),
+	          vorrq_u32(vshlq_u32(vmovl_u16(vget_low_u16(g)), gshift),
+	                    vshlq_u32(vmovl_u16(vget_low_u16(b)), bshift))));
+	vst1q_u32(dst + 4, vorrq_u32(vorrq_u32(alpha,
+	          vshlq_u32(vmovl_u16(vget_high_u16(r)), rshift)),
+	          vorrq_u32(vshlq_u32(vmovl_u16(vget_high_u16(g)), gshift),
+	                    vshlq_u32(vmovl_u16(vget_high_u16(b)), bshift))));
+}
+
+static void Blit_RGB565_8888NEON(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *src = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	SDL_PixelFormat *dstfmt = info->dst;
+	int32x4_t rshift = vdupq_n_s32(dstfmt->Rshift);
+	int32x4_t gshift = vdupq_n_s32(dstfmt->Gshift);
+	int32x4_t bshift = vdupq_n_s32(dstfmt->Bshift);
+	uint32x4_t alpha = vdupq_n_u32(~(dstfmt->Rmask | dstfmt->Gmask | dstfmt->Bmask));
+
+	while ( height-- ) {
+		int n = width;
+		while ( n >= 8 ) {
+			ConvertRGB565NEON(src, dst, rshift, gshift, bshift, alpha);
+			src += 8;
+			dst += 8;
+			n -= 8;
+		}
+		if ( n ) {
+			Uint16 s[8];
+			Uint32 d[8];
+			SDL_memcpy(s, src, n * 2);
+			ConvertRGB565NEON(s, d, rshift, gshift, bshift, alpha);
+			SDL_memcpy(dst, d, n * 4);
+		}
+		src = (Uint16*)((Uint8*)(src + n) + srcskip);
+		dst = (Uint32*)((Uint8*)(dst + n) + dstskip);
+	}
+}
+#endif /* SDL_NEON_INTRINSICS */
+
+/* Vector versions of the C fallback blitters, tried in order */
+struct vector_blit {
+	SDL_loblit blitfunc;		/* the C blitter it replaces */
+	Uint32 blit_features;
+	SDL_loblit vectorfunc;
+};
+static const struct vector_blit vector_blits[] = {
+#if SDL_AVX2_INTRINSICS
+	{ Blit4to4MaskAlpha, BLIT_FEATURE_HAS_AVX2, Blit4to4MaskAlphaAVX2 },
+	{ BlitNtoN, BLIT_FEATURE_HAS_AVX2, BlitNto4AVX2 },
+	{ BlitNtoNCopyAlpha, BLIT_FEATURE_HAS_AVX2, BlitNto4AVX2 },
+	{ BlitNtoNKey, BLIT_FEATURE_HAS_AVX2, BlitNto4KeyAVX2 },
+	{ BlitNtoNKeyCopyAlpha, BLIT_FEATURE_HAS_AVX2, BlitNto4KeyAVX2 },
+#endif
+#if SDL_SSE2_INTRINSICS
+	{ Blit4to4MaskAlpha, BLIT_FEATURE_HAS_SSE2, Blit4to4MaskAlphaSSE2 },
+	{ BlitNtoN, BLIT_FEATURE_HAS_SSE2, BlitNto4SSE2 },
+	{ BlitNtoNCopyAlpha, BLIT_FEATURE_HAS_SSE2, BlitNto4SSE2 },
+	{ BlitNtoNKey, BLIT_FEATURE_HAS_SSE2, BlitNto4KeySSE2 },
+	{ BlitNtoNKeyCopyAlpha, BLIT_FEATURE_HAS_SSE2, BlitNto4KeySSE2 },
+#endif
+#if SDL_NEON_INTRINSICS
+	{ Blit4to4MaskAlpha, BLIT_FEATURE_HAS_NEON, Blit4to4MaskAlphaNEON },
+	{ BlitNtoN, BLIT_FEATURE_HAS_NEON, BlitNto4NEON },
+	{ BlitNtoNCopyAlpha, BLIT_FEATURE_HAS_NEON, BlitNto4NEON },
+	{ BlitNtoNKey, BLIT_FEATURE_HAS_NEON, BlitNto4KeyNEON },
+	{ BlitNtoNKeyCopyAlpha, BLIT_FEATURE_HAS_NEON, BlitNto4KeyNEON },
+#endif
+	{ NULL, 0, NULL }
+};
+
+static SDL_loblit GetVectorBlit(SDL_loblit blitfun,
+                                const SDL_PixelFormat *srcfmt,
+                                const SDL_PixelFormat *dstfmt)
+{
+	int which;
+
+	/* 16 or 32 bit to 32 bit, with at most 8 bits per channel */
+	if ( dstfmt->BytesPerPixel != 4 ||
+	     (srcfmt->BytesPerPixel != 2 && srcfmt->BytesPerPixel != 4) ||
+	     srcfmt->Rloss > 8 || srcfmt->Gloss > 8 ||
+	     srcfmt->Bloss > 8 || srcfmt->Aloss > 8 ||
+	     dstfmt->Rloss > 8 || dstfmt->Gloss > 8 ||
+	     dstfmt->Bloss > 8 || dstfmt->Aloss > 8 ) {
+		return blitfun;
+	}
+	for ( which=0; vector_blits[which].blitfunc; ++which ) {
+		if ( vector_blits[which].blitfunc == blitfun &&
+		     ((vector_blits[which].blit_features & GetBlitFeatures()) == vector_blits[which].blit_features) ) {
+			return vector_blits[which].vectorfunc;
+		}
+	}
+	return blitfun;
+}
+#else
+#define GetVectorBlit(blitfun, srcfmt, dstfmt) (blitfun)
+#endif /* SDL_SSE2_INTRINSICS || SDL_NEON_INTRINSICS */
+
 /* Normal N to N optimized blitters */
 struct blit_table {
 	Uint32 srcR, srcG, srcB;
@@ -2294,9 +3115,39 @@ static const struct blit_table normal_blit_2[] = {
 #elif SDL_ALTIVEC_BLITTERS
     /* has-altivec */
     { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00000000,0x00000000,0x00000000,
-      2, NULL, Blit_RGB565_32Altivec, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+      BLIT_FEATURE_HAS_ALTIVEC, NULL, Blit_RGB565_32Altivec, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
     { 0x00007C00,0x000003E0,0x0000001F, 4, 0x00000000,0x00000000,0x00000000,
-      2, NULL, Blit_RGB555_32Altivec, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+      BLIT_FEATURE_HAS_ALTIVEC, NULL, Blit_RGB555_32Altivec, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+#endif
+#if SDL_AVX2_INTRINSICS
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      BLIT_FEATURE_HAS_AVX2, NULL, Blit_RGB565_8888AVX2, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      BLIT_FEATURE_HAS_AVX2, NULL, Blit_RGB565_8888AVX2, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0xFF000000,0x00FF0000,0x0000FF00,
+      BLIT_FEATURE_HAS_AVX2, NULL, Blit_RGB565_8888AVX2, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x0000FF00,0x00FF0000,0xFF000000,
+      BLIT_FEATURE_HAS_AVX2, NULL, Blit_RGB565_8888AVX2, SET_ALPHA },
+#endif
+#if SDL_SSE2_INTRINSICS
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      BLIT_FEATURE_HAS_SSE2, NULL, Blit_RGB565_8888SSE2, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      BLIT_FEATURE_HAS_SSE2, NULL, Blit_RGB565_8888SSE2, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0xFF000000,0x00FF0000,0x0000FF00,
+      BLIT_FEATURE_HAS_SSE2, NULL, Blit_RGB565_8888SSE2, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x0000FF00,0x00FF0000,0xFF000000,
+      BLIT_FEATURE_HAS_SSE2, NULL, Blit_RGB565_8888SSE2, SET_ALPHA },
+#endif
+#if SDL_NEON_INTRINSICS
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      BLIT_FEATURE_HAS_NEON, NULL, Blit_RGB565_8888NEON, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      BLIT_FEATURE_HAS_NEON, NULL, Blit_RGB565_8888NEON, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0xFF000000,0x00FF0000,0x0000FF00,
+      BLIT_FEATURE_HAS_NEON, NULL, Blit_RGB565_8888NEON, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x0000FF00,0x00FF0000,0xFF000000,
+      BLIT_FEATURE_HAS_NEON, NULL, Blit_RGB565_8888NEON, SET_ALPHA },
 #endif
     { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00FF0000,0x0000FF00,0x000000FF,
       0, NULL, Blit_RGB565_ARGB8888, SET_ALPHA },
@@ -2317,23 +3168,23 @@ static const struct blit_table normal_blit_3[] = {
 static const struct blit_table normal_blit_4[] = {
 #if SDL_HERMES_BLITTERS
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
-      1, ConvertMMXpII32_16RGB565, ConvertMMX, NO_ALPHA },
+      BLIT_FEATURE_HAS_MMX, ConvertMMXpII32_16RGB565, ConvertMMX, NO_ALPHA },
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
       0, ConvertX86p32_16RGB565, ConvertX86, NO_ALPHA },
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000007E0,0x0000F800,
-      1, ConvertMMXpII32_16BGR565, ConvertMMX, NO_ALPHA },
+      BLIT_FEATURE_HAS_MMX, ConvertMMXpII32_16BGR565, ConvertMMX, NO_ALPHA },
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000007E0,0x0000F800,
       0, ConvertX86p32_16BGR565, ConvertX86, NO_ALPHA },
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x00007C00,0x000003E0,0x0000001F,
-      1, ConvertMMXpII32_16RGB555, ConvertMMX, NO_ALPHA },
+      BLIT_FEATURE_HAS_MMX, ConvertMMXpII32_16RGB555, ConvertMMX, NO_ALPHA },
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x00007C00,0x000003E0,0x0000001F,
       0, ConvertX86p32_16RGB555, ConvertX86, NO_ALPHA },
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000003E0,0x00007C00,
-      1, ConvertMMXpII32_16BGR555, ConvertMMX, NO_ALPHA },
+      BLIT_FEATURE_HAS_MMX, ConvertMMXpII32_16BGR555, ConvertMMX, NO_ALPHA },
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000003E0,0x00007C00,
       0, ConvertX86p32_16BGR555, ConvertX86, NO_ALPHA },
     { 0x00FF0000,0x0000FF00,0x000000FF, 3, 0x00FF0000,0x0000FF00,0x000000FF,
-      1, ConvertMMXpII32_24RGB888, ConvertMMX, NO_ALPHA },
+      BLIT_FEATURE_HAS_MMX, ConvertMMXpII32_24RGB888, ConvertMMX, NO_ALPHA },
     { 0x00FF0000,0x0000FF00,0x000000FF, 3, 0x00FF0000,0x0000FF00,0x000000FF,
       0, ConvertX86p32_24RGB888, ConvertX86, NO_ALPHA },
     { 0x00FF0000,0x0000FF00,0x000000FF, 3, 0x000000FF,0x0000FF00,0x00FF0000,
@@ -2348,13 +3199,14 @@ static const struct blit_table normal_blit_4[] = {
 #if SDL_ALTIVEC_BLITTERS
     /* has-altivec | dont-use-prefetch */
     { 0x00000000,0x00000000,0x00000000, 4, 0x00000000,0x00000000,0x00000000,
-      6, NULL, ConvertAltivec32to32_noprefetch, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+      BLIT_FEATURE_HAS_ALTIVEC | BLIT_FEATURE_ALTIVEC_DONT_USE_PREFETCH,
+      NULL, ConvertAltivec32to32_noprefetch, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
     /* has-altivec */
     { 0x00000000,0x00000000,0x00000000, 4, 0x00000000,0x00000000,0x00000000,
-      2, NULL, ConvertAltivec32to32_prefetch, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+      BLIT_FEATURE_HAS_ALTIVEC, NULL, ConvertAltivec32to32_prefetch, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
     /* has-altivec */
     { 0x00000000,0x00000000,0x00000000, 2, 0x0000F800,0x000007E0,0x0000001F,
-      2, NULL, Blit_RGB888_RGB565Altivec, NO_ALPHA },
+      BLIT_FEATURE_HAS_ALTIVEC, NULL, Blit_RGB888_RGB565Altivec, NO_ALPHA },
 #endif
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
       0, NULL, Blit_RGB888_RGB565, NO_ALPHA },
@@ -2413,9 +3265,10 @@ SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int blit_index)
 #endif
 
 		if(srcfmt->Amask && dstfmt->Amask)
-		    return BlitNtoNKeyCopyAlpha;
+		    blitfun = BlitNtoNKeyCopyAlpha;
 		else
-		    return BlitNtoNKey;
+		    blitfun = BlitNtoNKey;
+		return GetVectorBlit(blitfun, srcfmt, dstfmt);
 	    }
 	}
 
@@ -2470,6 +3323,7 @@ SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int blit_index)
 			} else if ( a_need == COPY_ALPHA ) {
 			    blitfun = BlitNtoNCopyAlpha;
 			}
+			blitfun = GetVectorBlit(blitfun, srcfmt, dstfmt);
 		}
 	}
 
@@ -58,7 +58,10 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 	SDL_Palette *palette;
 	Uint8 *bits;
 	Uint8 *top, *end;
+	const Uint8 *row;
+	int rowbytes;
 	SDL_bool topDown;
+	SDL_bool borrow;
 	int ExpandBMP;
 
 	/* The Win32 BMP file header (14 bytes) */
@@ -268,7 +271,19 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 	} else {
 		bits = end - surface->pitch;
 	}
+
+	/* Memory streams hand out each row in place */
+	rowbytes = (ExpandBMP ? bmpPitch : surface->pitch) + pad;
+	borrow = (SDL_RWborrow(src, (const void **)&row, 0) == 0);
+
 	while ( bits >= top && bits < end ) {
+		row = NULL;
+		if ( borrow &&
+		     SDL_RWborrow(src, (const void **)&row, rowbytes) != rowbytes ) {
+			SDL_Error(SDL_EFREAD);
+			was_error = SDL_TRUE;
+			goto done;
+		}
 		switch (ExpandBMP) {
 			case 1:
 			case 4: {
@@ -276,7 +291,9 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 			int   shift = (8-ExpandBMP);
 			for ( i=0; i<surface->w; ++i ) {
 				if ( i%(8/ExpandBMP) == 0 ) {
-					if ( !SDL_RWread(src, &pixel, 1, 1) ) {
+					if ( row ) {
+						pixel = *row++;
+					} else if ( !SDL_RWread(src, &pixel, 1, 1) ) {
 						SDL_SetError(
 					"Error reading from BMP");
 						was_error = SDL_TRUE;
@@ -289,7 +306,9 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 			break;
 
 			default:
-			if ( SDL_RWread(src, bits, 1, surface->pitch)
+			if ( row ) {
+				SDL_memcpy(bits, row, surface->pitch);
+			} else if ( SDL_RWread(src, bits, 1, surface->pitch)
 							 != surface->pitch ) {
 				SDL_Error(SDL_EFREAD);
 				was_error = SDL_TRUE;
@@ -318,7 +337,7 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 			break;
 		}
 		/* Skip padding bytes, ugh */
-		if ( pad ) {
+		if ( pad && !row ) {
 			Uint8 padbyte;
 			for ( i=0; i<pad; ++i ) {
 				SDL_RWread(src, &padbyte, 1, 1);
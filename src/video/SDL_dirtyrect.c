@@ -0,0 +1,222 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Collect the areas of the screen that need updating, merging them when
+   updating the merged area would cost less than updating each part */
+
+#include "SDL_video.h"
+#include "SDL_sysvideo.h"
+#include "SDL_dirtyrect_c.h"
+
+/* Updating a rectangle costs about as much as this many pixels on top of
+   the pixels themselves, SDL_DIRTYRECT_COST can override it */
+#define DIRTY_RECT_COST		1024
+
+/* When the list is full, new rectangles are merged with the closest one */
+#define MAX_DIRTY_RECTS		256
+
+typedef struct {
+	int x, y, w, h;
+} DirtyRect;
+
+SDL_Surface *SDL_DirtySurface = NULL;
+
+static DirtyRect dirty_rects[MAX_DIRTY_RECTS];
+static int num_dirty = 0;
+static int dirty_cost = -1;
+
+/* Dirty rectangle statistics, read and cleared by SDL_GetDirtyRectStats() */
+static Uint32 stat_rects_in;
+static Uint32 stat_rects_out;
+static Uint32 stat_pixels;
+
+static void DirtyUnion(const DirtyRect *a, const DirtyRect *b, DirtyRect *u)
+{
+	int x2 = SDL_max(a->x + a->w, b->x + b->w);
+	int y2 = SDL_max(a->y + a->h, b->y + b->h);
+
+	u->x = SDL_min(a->x, b->x);
+	u->y = SDL_min(a->y, b->y);
+	u->w = x2 - u->x;
+	u->h = y2 - u->y;
+}
+
+/* How much more merging 'a' and 'b' costs than updating both, which is
+   negative when the merged rectangle is cheaper */
+static int DirtyMergeCost(const DirtyRect *a, const DirtyRect *b)
+{
+	DirtyRect u;
+
+	DirtyUnion(a, b, &u);
+	return(u.w * u.h - a->w * a->h - b->w * b->h - dirty_cost);
+}
+
+static void AddDirtyRect(const SDL_Rect *area, SDL_Surface *screen)
+{
+	DirtyRect rect;
+	int i, best;
+
+	/* Clip it to the screen */
+	rect.x = SDL_max(area->x, 0);
+	rect.y = SDL_max(area->y, 0);
+	rect.w = SDL_min(area->x + area->w, screen->w) - rect.x;
+	rect.h = SDL_min(area->y + area->h, screen->h) - rect.y;
+	if ( rect.w <= 0 || rect.h <= 0 ) {
+		return;
+	}
+	++stat_rects_in;
+
+	if ( dirty_cost < 0 ) {
+		const char *env = SDL_getenv("SDL_DIRTYRECT_COST");
+		dirty_cost = env ? SDL_atoi(env) : DIRTY_RECT_COST;
+		if ( dirty_cost < 0 ) {
+			dirty_cost = 0;
+		}
+	}
+
+	/* Merge it with whatever it's cheaper to update it with.  The merged
+	   rectangle is bigger, so it has to be checked against all the
+	   others again. */
+	i = 0;
+	while ( i < num_dirty ) {
+		if ( DirtyMergeCost(&dirty_rects[i], &rect) < 0 ) {
+			DirtyUnion(&dirty_rects[i], &rect, &rect);
+			dirty_rects[i] = dirty_rects[--num_dirty];
+			i = 0;
+		} else {
+			++i;
+		}
+	}
+
+	if ( num_dirty == MAX_DIRTY_RECTS ) {
+		best = 0;
+		for ( i = 1; i < num_dirty; ++i ) {
+			if ( DirtyMergeCost(&dirty_rects[i], &rect) <
+			     DirtyMergeCost(&dirty_rects[best], &rect) ) {
+				best = i;
+			}
+		}
+		DirtyUnion(&dirty_rects[best], &rect, &dirty_rects[best]);
+		return;
+	}
+	dirty_rects[num_dirty++] = rect;
+}
+
+void SDL_MarkDirty(const SDL_Rect *rect)
+{
+	AddDirtyRect(rect, SDL_DirtySurface);
+}
+
+void SDL_ClearDirtyRects(void)
+{
+	num_dirty = 0;
+}
+
+void SDL_ResetDirtyRects(void)
+{
+	SDL_DirtySurface = NULL;
+	num_dirty = 0;
+}
+
+/* Check that 'screen' is the display surface */
+static int CheckDirtyScreen(SDL_Surface *screen)
+{
+	if ( !current_video || !screen || screen != SDL_PublicSurface ) {
+		SDL_SetError("Dirty rectangles are only kept for the display surface");
+		return(-1);
+	}
+	return(0);
+}
+
+void SDL_AddDirtyRects(SDL_Surface *screen, int numrects, const SDL_Rect *rects)
+{
+	int i;
+
+	if ( CheckDirtyScreen(screen) < 0 ) {
+		return;
+	}
+	for ( i = 0; i < numrects; ++i ) {
+		AddDirtyRect(&rects[i], screen);
+	}
+}
+
+void SDL_UpdateDirtyRects(SDL_Surface *screen)
+{
+	SDL_Rect rects[MAX_DIRTY_RECTS];
+	SDL_Surface *tracked;
+	int i, n;
+
+	if ( CheckDirtyScreen(screen) < 0 ) {
+		return;
+	}
+	n = num_dirty;
+	for ( i = 0; i < n; ++i ) {
+		rects[i].x = (Sint16)dirty_rects[i].x;
+		rects[i].y = (Sint16)dirty_rects[i].y;
+		rects[i].w = (Uint16)dirty_rects[i].w;
+		rects[i].h = (Uint16)dirty_rects[i].h;
+		stat_pixels += dirty_rects[i].w * dirty_rects[i].h;
+	}
+	stat_rects_out += n;
+	num_dirty = 0;
+
+	/* SDL_UpdateRects() adds to the dirty rectangles while tracking */
+	if ( n > 0 ) {
+		tracked = SDL_DirtySurface;
+		SDL_DirtySurface = NULL;
+		SDL_UpdateRects(screen, n, rects);
+		SDL_DirtySurface = tracked;
+	}
+}
+
+int SDL_TrackDirtyRects(SDL_Surface *screen, int enable)
+{
+	int was_tracking;
+
+	if ( CheckDirtyScreen(screen) < 0 ) {
+		return(-1);
+	}
+	was_tracking = (SDL_DirtySurface == screen);
+	if ( enable > 0 ) {
+		SDL_DirtySurface = screen;
+	} else if ( enable == 0 ) {
+		SDL_DirtySurface = NULL;
+	}
+	return(was_tracking);
+}
+
+void SDL_GetDirtyRectStats(Uint32 *rectsin, Uint32 *rectsout, Uint32 *pixels)
+{
+	if ( rectsin ) {
+		*rectsin = stat_rects_in;
+	}
+	if ( rectsout ) {
+		*rectsout = stat_rects_out;
+	}
+	if ( pixels ) {
+		*pixels = stat_pixels;
+	}
+	stat_rects_in = 0;
+	stat_rects_out = 0;
+	stat_pixels = 0;
+}
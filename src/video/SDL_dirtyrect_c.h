@@ -0,0 +1,46 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Useful variables and functions from SDL_dirtyrect.c */
+#include "SDL_video.h"
+
+/* The surface whose blits and fills are added to the dirty rectangles,
+   or NULL if they aren't being tracked */
+extern SDL_Surface *SDL_DirtySurface;
+
+/* Add a rectangle to the dirty area */
+extern void SDL_MarkDirty(const SDL_Rect *rect);
+
+/* Forget the dirty area, after the whole screen was updated */
+extern void SDL_ClearDirtyRects(void);
+
+/* Forget the dirty area, and stop tracking blits and fills */
+extern void SDL_ResetDirtyRects(void);
+
+/* Mark the area drawn by a blit or fill if it's on the tracked surface */
+#define SDL_TRACK_DIRTY(surface, rect) \
+	do { \
+		if ( (surface) == SDL_DirtySurface ) { \
+			SDL_MarkDirty(rect); \
+		} \
+	} while ( 0 )
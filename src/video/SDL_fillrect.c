@@ -0,0 +1,401 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Software rectangle fills, with vector kernels where the CPU has them */
+
+#include "SDL_video.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_sysvideo.h"
+#include "SDL_blit.h"
+#include "../cpuinfo/SDL_simd.h"
+
+/* Fills bigger than this go around the cache with non-temporal stores,
+   since they would only push everything else out of it */
+#define FILL_STREAM_BYTES	(4*1024*1024)
+
+/* The pattern is the fill colour repeated from the first byte of a row.
+   Pixels of 1, 2, 3 and 4 bytes all repeat every 96 bytes, so the kernels
+   load vectors from an offset of up to 31 bytes and store them over and
+   over. */
+void SDL_InitFillPattern(Uint8 *pattern, int bpp, Uint32 color)
+{
+	Uint8 pixel[4];
+	int i;
+
+	switch (bpp) {
+	    case 1:
+		pixel[0] = (Uint8)color;
+		break;
+	    case 2: {
+		Uint16 c = (Uint16)color;
+		SDL_memcpy(pixel, &c, 2);
+	    }
+		break;
+	    case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		color <<= 8;
+#endif
+		SDL_memcpy(pixel, &color, 3);
+		break;
+	    default:
+		SDL_memcpy(pixel, &color, 4);
+		break;
+	}
+	for ( i = 0; i < bpp; ++i ) {
+		pattern[i] = pixel[i];
+	}
+	for ( ; i < SDL_FILL_PATTERN_SIZE; ++i ) {
+		pattern[i] = pattern[i - bpp];
+	}
+}
+
+/* The vector kernels start each row with an unaligned store, carry on with
+   aligned ones from the next boundary, and end with an unaligned store
+   that may overlap the last aligned one.  Rows narrower than a vector are
+   copied from the pattern. */
+#if SDL_SSE2_INTRINSICS
+static void SDL_TARGETING("sse2") SDL_FillRect_SSE2(Uint8 *row, int pitch,
+	int len, int rows, const Uint8 *pattern, int stream)
+{
+	if ( len < 16 ) {
+		for ( ; rows; --rows ) {
+			SDL_memcpy(row, pattern, len);
+			row += pitch;
+		}
+		return;
+	}
+	for ( ; rows; --rows ) {
+		int head = (int)(-(uintptr_t)row & 15);
+		const Uint8 *p = pattern + head;
+		Uint8 *d = row + head;
+		int n = len - head;
+		__m128i v0, v1, v2;
+
+		_mm_storeu_si128((__m128i *)row, _mm_loadu_si128((const __m128i *)pattern));
+		v0 = _mm_loadu_si128((const __m128i *)p);
+		v1 = _mm_loadu_si128((const __m128i *)(p + 16));
+		v2 = _mm_loadu_si128((const __m128i *)(p + 32));
+		if ( stream ) {
+			for ( ; n >= 48; n -= 48, d += 48 ) {
+				_mm_stream_si128((__m128i *)d, v0);
+				_mm_stream_si128((__m128i *)(d + 16), v1);
+				_mm_stream_si128((__m128i *)(d + 32), v2);
+			}
+		} else {
+			for ( ; n >= 48; n -= 48, d += 48 ) {
+				_mm_store_si128((__m128i *)d, v0);
+				_mm_store_si128((__m128i *)(d + 16), v1);
+				_mm_store_si128((__m128i *)(d + 32), v2);
+			}
+		}
+		if ( n >= 16 ) {
+			_mm_store_si128((__m128i *)d, v0);
+			d += 16;
+			n -= 16;
+			p += 16;
+			if ( n >= 16 ) {
+				_mm_store_si128((__m128i *)d, v1);
+				d += 16;
+				n -= 16;
+				p += 16;
+			}
+		}
+		if ( n > 0 ) {
+			p += n - 16;
+			if ( p < pattern ) {
+				p += 48;
+			}
+			_mm_storeu_si128((__m128i *)(d + n - 16), _mm_loadu_si128((const __m128i *)p));
+		}
+		row += pitch;
+	}
+	if ( stream ) {
+		_mm_sfence();
+	}
+}
+#endif /* SDL_SSE2_INTRINSICS */
+
+#if SDL_AVX2_INTRINSICS
+static void SDL_TARGETING("avx2") SDL_FillRect_AVX2(Uint8 *row, int pitch,
+	int len, int rows, const Uint8 *pattern, int stream)
+{
+	if ( len < 32 ) {
+		for ( ; rows; --rows ) {
+			SDL_memcpy(row, pattern, len);
+			row += pitch;
+		}
+		return;
+	}
+	for ( ; rows; --rows ) {
+		int head = (int)(-(uintptr_t)row & 31);
+		const Uint8 *p = pattern + head;
+		Uint8 *d = row + head;
+		int n = len - head;
+		__m256i v0, v1, v2;
+
+		_mm256_storeu_si256((__m256i *)row, _mm256_loadu_si256((const __m256i *)pattern));
+		v0 = _mm256_loadu_si256((const __m256i *)p);
+		v1 = _mm256_loadu_si256((const __m256i *)(p + 32));
+		v2 = _mm256_loadu_si256((const __m256i *)(p + 64));
+		if ( stream ) {
+			for ( ; n >= 96; n -= 96, d += 96 ) {
+				_mm256_stream_si256((__m256i *)d, v0);
+				_mm256_stream_si256((__m256i *)(d + 32), v1);
+				_mm256_stream_si256((__m256i *)(d + 64), v2);
+			}
+		} else {
+			for ( ; n >= 96; n -= 96, d += 96 ) {
+				_mm256_store_si256((__m256i *)d, v0);
+				_mm256_store_si256((__m256i *)(d + 32), v1);
+				_mm256_store_si256((__m256i *)(d + 64), v2);
+			}
+		}
+		if ( n >= 32 ) {
+			_mm256_store_si256((__m256i *)d, v0);
+			d += 32;
+			n -= 32;
+			p += 32;
+			if ( n >= 32 ) {
+				_mm256_store_si256((__m256i *)d, v1);
+				d += 32;
+				n -= 32;
+				p += 32;
+			}
+		}
+		if ( n > 0 ) {
+			p += n - 32;
+			if ( p < pattern ) {
+				p += 96;
+			}
+			_mm256_storeu_si256((__m256i *)(d + n - 32), _mm256_loadu_si256((const __m256i *)p));
+		}
+		row += pitch;
+	}
+	if ( stream ) {
+		_mm_sfence();
+	}
+}
+#endif /* SDL_AVX2_INTRINSICS */
+
+#if SDL_NEON_INTRINSICS
+/* NEON has no non-temporal stores, and doesn't need aligned ones */
+static void SDL_FillRect_NEON(Uint8 *row, int pitch,
+	int len, int rows, const Uint8 *pattern, int stream)
+{
+	const uint8x16_t v0 = vld1q_u8(pattern);
+	const uint8x16_t v1 = vld1q_u8(pattern + 16);
+	const uint8x16_t v2 = vld1q_u8(pattern + 32);
+
+	while ( rows-- ) {
+		Uint8 *d = row;
+		const Uint8 *p = pattern;
+		int n = len;
+
+		for ( ; n >= 48; n -= 48, d += 48 ) {
+			vst1q_u8(d, v0);
+			vst1q_u8(d + 16, v1);
+			vst1q_u8(d + 32, v2);
+		}
+		if ( n >= 16 ) {
+			vst1q_u8(d, v0);
+			d += 16;
+			n -= 16;
+			p += 16;
+			if ( n >= 16 ) {
+				vst1q_u8(d, v1);
+				d += 16;
+				n -= 16;
+				p += 16;
+			}
+		}
+		SDL_memcpy(d, p, n);
+		row += pitch;
+	}
+}
+#endif /* SDL_NEON_INTRINSICS */
+
+static void SDL_FillRect_C(Uint8 *row, int pitch, int len, int rows,
+				int bpp, Uint32 color, const Uint8 *pattern)
+{
+	int n;
+
+	switch (bpp) {
+	    case 1:
+		for ( ; rows; --rows ) {
+			SDL_memset(row, color, len);
+			row += pitch;
+		}
+		break;
+
+	    case 2:
+		for ( ; rows; --rows ) {
+			Uint16 *pixels = (Uint16 *)row;
+			Uint16 c = (Uint16)color;
+			Uint32 cc = (Uint32)c << 16 | c;
+			n = len >> 1;
+			if((uintptr_t)pixels & 3) {
+				*pixels++ = c;
+				n--;
+			}
+			if(n >> 1)
+				SDL_memset4(pixels, cc, n >> 1);
+			if(n & 1)
+				pixels[n - 1] = c;
+			row += pitch;
+		}
+		break;
+
+	    case 3:
+		/* Copy in whole pixels of the pattern, then keep doubling
+		   what's there */
+		for ( ; rows; --rows ) {
+			n = SDL_FILL_PATTERN_SIZE - (SDL_FILL_PATTERN_SIZE % 3);
+			if ( n > len ) {
+				n = len;
+			}
+			SDL_memcpy(row, pattern, n);
+			while ( n < len ) {
+				int copy = (len - n < n) ? len - n : n;
+				SDL_memcpy(row + n, row, copy);
+				n += copy;
+			}
+			row += pitch;
+		}
+		break;
+
+	    case 4:
+		for ( ; rows; --rows ) {
+			SDL_memset4(row, color, len >> 2);
+			row += pitch;
+		}
+		break;
+	}
+}
+
+#ifdef __powerpc__
+/*
+ * SDL_memset() on PPC (both glibc and codewarrior) uses
+ * the dcbz (Data Cache Block Zero) instruction, which
+ * causes an alignment exception if the destination is
+ * uncachable, so only use it on software surfaces
+ */
+static void SDL_FillRect_PPC(Uint8 *row, int pitch, int x, int rows,
+							Uint32 color)
+{
+	int y;
+
+	if(x >= 8) {
+		/*
+		 * 64-bit stores are probably most
+		 * efficient to uncached video memory
+		 */
+		double fill;
+		SDL_memset(&fill, color, (sizeof fill));
+		for(y = rows; y; y--) {
+			Uint8 *d = row;
+			unsigned n = x;
+			unsigned nn;
+			Uint8 c = color;
+			double f = fill;
+			while((unsigned long)d
+			      & (sizeof(double) - 1)) {
+				*d++ = c;
+				n--;
+			}
+			nn = n / (sizeof(double) * 4);
+			while(nn) {
+				((double *)d)[0] = f;
+				((double *)d)[1] = f;
+				((double *)d)[2] = f;
+				((double *)d)[3] = f;
+				d += 4*sizeof(double);
+				nn--;
+			}
+			n &= ~(sizeof(double) * 4 - 1);
+			nn = n / sizeof(double);
+			while(nn) {
+				*(double *)d = f;
+				d += sizeof(double);
+				nn--;
+			}
+			n &= ~(sizeof(double) - 1);
+			while(n) {
+				*d++ = c;
+				n--;
+			}
+			row += pitch;
+		}
+	} else {
+		/* narrow boxes */
+		for(y = rows; y; y--) {
+			Uint8 *d = row;
+			Uint8 c = color;
+			int n = x;
+			while(n) {
+				*d++ = c;
+				n--;
+			}
+			row += pitch;
+		}
+	}
+}
+#endif /* __powerpc__ */
+
+void SDL_SoftFillRect(SDL_Surface *dst, const SDL_Rect *rect,
+		      Uint32 color, const Uint8 *pattern)
+{
+	int bpp = dst->format->BytesPerPixel;
+	int len = rect->w * bpp;
+	Uint8 *row;
+	int stream;
+
+	row = (Uint8 *)dst->pixels + rect->y*dst->pitch + rect->x*bpp;
+	stream = ((len * rect->h) >= FILL_STREAM_BYTES);
+
+#ifdef __powerpc__
+	if ( (bpp == 1 || color == 0) &&
+	     (dst->flags & SDL_HWSURFACE) == SDL_HWSURFACE ) {
+		SDL_FillRect_PPC(row, dst->pitch, len, rect->h,
+		                 bpp == 1 ? color : 0);
+		return;
+	}
+#endif
+#if SDL_AVX2_INTRINSICS
+	if ( SDL_HasAVX2() ) {
+		SDL_FillRect_AVX2(row, dst->pitch, len, rect->h, pattern, stream);
+		return;
+	}
+#endif
+#if SDL_SSE2_INTRINSICS
+	if ( SDL_HasSSE2() ) {
+		SDL_FillRect_SSE2(row, dst->pitch, len, rect->h, pattern, stream);
+		return;
+	}
+#elif SDL_NEON_INTRINSICS
+	if ( SDL_HasNEON() ) {
+		SDL_FillRect_NEON(row, dst->pitch, len, rect->h, pattern, stream);
+		return;
+	}
+#endif
+	SDL_FillRect_C(row, dst->pitch, len, rect->h, bpp, color, pattern);
+}
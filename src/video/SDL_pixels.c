@@ -24,6 +24,7 @@
 /* General (mostly internal) pixel/color manipulation routines for SDL */
 
 #include "SDL_endian.h"
+#include "SDL_atomic.h"
 #include "SDL_video.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
@@ -524,11 +525,40 @@ SDL_BlitMap *SDL_AllocBlitMap(void)
 	/* It's ready to go */
 	return(map);
 }
-void SDL_InvalidateMap(SDL_BlitMap *map)
+
+/* Blit map statistics, read and cleared by SDL_GetBlitMapStats() */
+static SDL_atomic_t map_rebuilds;
+static SDL_atomic_t map_reuses;
+
+#define KEY_MATCHES(A, B)						\
+    ((A)->BitsPerPixel && (A)->BitsPerPixel == (B)->BitsPerPixel	\
+     && (A)->Rmask == (B)->Rmask && (A)->Gmask == (B)->Gmask		\
+     && (A)->Bmask == (B)->Bmask && (A)->Amask == (B)->Amask)
+
+/* Only software mappings without RLE data can be kept for later */
+#define MAP_CACHEABLE(src)						\
+    ((src)->map->dst != NULL &&						\
+     !((src)->flags & (SDL_HWSURFACE|SDL_HWACCEL|SDL_RLEACCEL)))
+
+static void SDL_GetBlitMapKey(SDL_Surface *src, SDL_Surface *dst,
+						SDL_BlitMapKey *key)
 {
-	if ( ! map ) {
-		return;
+	SDL_PixelFormat *fmt = dst->format;
+
+	SDL_memset(key, 0, sizeof(*key));
+	if ( (dst != src) && (fmt->palette == NULL) &&
+	     !((src->flags | dst->flags) & SDL_HWSURFACE) ) {
+		key->BitsPerPixel = fmt->BitsPerPixel;
+		key->Rmask = fmt->Rmask;
+		key->Gmask = fmt->Gmask;
+		key->Bmask = fmt->Bmask;
+		key->Amask = fmt->Amask;
 	}
+}
+
+/* Forget the current mapping, but not the cached ones */
+static void SDL_DropMap(SDL_BlitMap *map)
+{
 	map->dst = NULL;
 	map->format_version = (unsigned int)-1;
 	if ( map->table ) {
@@ -536,18 +566,151 @@ void SDL_InvalidateMap(SDL_BlitMap *map)
 		map->table = NULL;
 	}
 }
+
+static void SDL_FlushMapCache(SDL_BlitMap *map)
+{
+	while ( map->cached > 0 ) {
+		SDL_CachedMap *entry = &map->cache[--map->cached];
+
+		if ( entry->table ) {
+			SDL_free(entry->table);
+		}
+		SDL_free(entry->sw_data);
+	}
+}
+
+/* Move the current mapping to the front of the cache */
+static void SDL_SaveMap(SDL_BlitMap *map)
+{
+	SDL_CachedMap *entry;
+
+	SDL_memmove(&map->cache[1], &map->cache[0],
+	            map->cached * sizeof(map->cache[0]));
+	++map->cached;
+	entry = &map->cache[0];
+	entry->dst = map->dst;
+	entry->format_version = map->format_version;
+	entry->key = map->key;
+	entry->identity = map->identity;
+	entry->table = map->table;
+	entry->sw_blit = map->sw_blit;
+	entry->sw_data = map->sw_data;
+	map->table = NULL;
+	map->sw_data = NULL;
+	SDL_DropMap(map);
+}
+
+/* Cache the current mapping and give the map fresh blit data to build a
+   new one with, evicting the least recently used entry if it's full */
+static void SDL_StashMap(SDL_BlitMap *map)
+{
+	struct private_swaccel *sw_data;
+
+	if ( map->cached == SDL_BLITMAP_CACHE ) {
+		SDL_CachedMap *entry = &map->cache[--map->cached];
+
+		if ( entry->table ) {
+			SDL_free(entry->table);
+		}
+		sw_data = entry->sw_data;
+	} else {
+		sw_data = (struct private_swaccel *)SDL_malloc(sizeof(*sw_data));
+		if ( sw_data == NULL ) {
+			SDL_DropMap(map);
+			return;
+		}
+	}
+	SDL_SaveMap(map);
+	SDL_memset(sw_data, 0, sizeof(*sw_data));
+	map->sw_data = sw_data;
+}
+
+/* Make a cached mapping that suits 'dst' the current one */
+static int SDL_ReuseMap(SDL_Surface *src, SDL_Surface *dst,
+					const SDL_BlitMapKey *key)
+{
+	SDL_BlitMap *map = src->map;
+	SDL_CachedMap entry;
+	int i;
+
+	if ( (src->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
+		return(0);
+	}
+	for ( i = 0; i < map->cached; ++i ) {
+		if ( ((map->cache[i].dst == dst) &&
+		      (map->cache[i].format_version == dst->format_version)) ||
+		     KEY_MATCHES(&map->cache[i].key, key) ) {
+			break;
+		}
+	}
+	if ( i == map->cached ) {
+		return(0);
+	}
+	entry = map->cache[i];
+	--map->cached;
+	SDL_memmove(&map->cache[i], &map->cache[i+1],
+	            (map->cached - i) * sizeof(map->cache[0]));
+
+	if ( MAP_CACHEABLE(src) ) {
+		SDL_SaveMap(map);
+	} else {
+		SDL_DropMap(map);
+		SDL_free(map->sw_data);
+	}
+	map->dst = dst;
+	map->format_version = dst->format_version;
+	map->key = entry.key;
+	map->identity = entry.identity;
+	map->table = entry.table;
+	map->hw_blit = NULL;
+	map->sw_blit = entry.sw_blit;
+	map->sw_data = entry.sw_data;
+	src->flags &= ~SDL_HWACCEL;
+	return(1);
+}
+
+void SDL_InvalidateMap(SDL_BlitMap *map)
+{
+	if ( ! map ) {
+		return;
+	}
+	SDL_DropMap(map);
+	SDL_FlushMapCache(map);
+}
 int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst)
 {
 	SDL_PixelFormat *srcfmt;
 	SDL_PixelFormat *dstfmt;
 	SDL_BlitMap *map;
+	SDL_BlitMapKey key;
 
-	/* Clear out any previous mapping */
+	/* See if a mapping we already have will do */
 	map = src->map;
+	SDL_GetBlitMapKey(src, dst, &key);
+	if ( map->dst && KEY_MATCHES(&map->key, &key) ) {
+		/* Same pixel layout, RLE data included, so just retarget it */
+		map->dst = dst;
+		map->format_version = dst->format_version;
+		SDL_AtomicAdd(&map_reuses, 1);
+		return(0);
+	}
 	if ( (src->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
 		SDL_UnRLESurface(src, 1);
+		SDL_DropMap(map);
 	}
-	SDL_InvalidateMap(map);
+	if ( SDL_ReuseMap(src, dst, &key) ) {
+		SDL_AtomicAdd(&map_reuses, 1);
+		return(0);
+	}
+	SDL_AtomicAdd(&map_rebuilds, 1);
+
+	/* Keep the previous mapping around in case we switch back to it */
+	if ( MAP_CACHEABLE(src) ) {
+		SDL_StashMap(map);
+	} else {
+		SDL_DropMap(map);
+	}
+	map->key = key;
 
 	/* Figure out what kind of mapping we're doing */
 	map->identity = 0;
@@ -611,6 +774,19 @@ int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst)
 	/* Choose your blitters wisely */
 	return(SDL_CalculateBlit(src));
 }
+void SDL_GetBlitMapStats(Uint32 *rebuilds, Uint32 *reused)
+{
+	Uint32 value;
+
+	value = (Uint32)SDL_AtomicSet(&map_rebuilds, 0);
+	if ( rebuilds ) {
+		*rebuilds = value;
+	}
+	value = (Uint32)SDL_AtomicSet(&map_reuses, 0);
+	if ( reused ) {
+		*reused = value;
+	}
+}
 void SDL_FreeBlitMap(SDL_BlitMap *map)
 {
 	if ( map ) {
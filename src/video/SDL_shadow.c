@@ -0,0 +1,485 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Copying the shadow surface to the video surface, with converters for the
+   usual cases of emulating a video mode:  8-bit palettes on 16 and 32-bit
+   displays, and 32-bit surfaces on 16-bit displays.  Everything else goes
+   through the blit mapping. */
+
+#include "SDL_video.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_sysvideo.h"
+#include "SDL_blit.h"
+#include "SDL_cursor_c.h"
+#include "SDL_pixels_c.h"
+#include "../cpuinfo/SDL_simd.h"
+
+typedef struct SDL_ShadowJob SDL_ShadowJob;
+
+/* Converts 'w' pixels of one row, starting at (x, y) on the screen */
+typedef void (*SDL_ShadowRow)(const SDL_ShadowJob *job, const Uint8 *src,
+			      Uint8 *dst, int x, int y, int w);
+
+struct SDL_ShadowJob {
+	SDL_ShadowRow convert;
+
+	/* The rectangle being converted */
+	const Uint8 *src;
+	Uint8 *dst;
+	int srcpitch, dstpitch;
+	int x, y, w;
+
+	/* Display pixels for the 8-bit palette entries */
+	Uint32 lut[256];
+
+	/* 32 to 16-bit:  the dither added to each byte of the pixels in
+	   columns 0 to 11 of rows 0 to 3 of the pattern, and how to move
+	   each channel from its byte to the display pixel */
+	Uint32 dither[4][12];
+	int shift[3];
+	Uint32 mask[3];
+	int dshift[3];
+};
+
+/* 4x4 ordered dither */
+static const Uint8 bayer[4][4] = {
+	{  0,  8,  2, 10 },
+	{ 12,  4, 14,  6 },
+	{  3, 11,  1,  9 },
+	{ 15,  7, 13,  5 }
+};
+
+static void SDL_Shadow8to16_C(const SDL_ShadowJob *job, const Uint8 *src,
+			      Uint8 *dstrow, int x, int y, int w)
+{
+	const Uint32 *lut = job->lut;
+	Uint16 *dst = (Uint16 *)dstrow;
+
+	for ( ; w >= 4; w -= 4 ) {
+		dst[0] = (Uint16)lut[src[0]];
+		dst[1] = (Uint16)lut[src[1]];
+		dst[2] = (Uint16)lut[src[2]];
+		dst[3] = (Uint16)lut[src[3]];
+		src += 4;
+		dst += 4;
+	}
+	while ( w-- ) {
+		*dst++ = (Uint16)lut[*src++];
+	}
+}
+
+static void SDL_Shadow8to32_C(const SDL_ShadowJob *job, const Uint8 *src,
+			      Uint8 *dstrow, int x, int y, int w)
+{
+	const Uint32 *lut = job->lut;
+	Uint32 *dst = (Uint32 *)dstrow;
+
+	for ( ; w >= 4; w -= 4 ) {
+		dst[0] = lut[src[0]];
+		dst[1] = lut[src[1]];
+		dst[2] = lut[src[2]];
+		dst[3] = lut[src[3]];
+		src += 4;
+		dst += 4;
+	}
+	while ( w-- ) {
+		*dst++ = lut[*src++];
+	}
+}
+
+#if SDL_AVX2_INTRINSICS
+static void SDL_TARGETING("avx2") SDL_Shadow8to32_AVX2(const SDL_ShadowJob *job,
+	const Uint8 *src, Uint8 *dstrow, int x, int y, int w)
+{
+	const int *lut = (const int *)job->lut;
+	Uint32 *dst = (Uint32 *)dstrow;
+
+	for ( ; w >= 16; w -= 16 ) {
+		__m128i index = _mm_loadu_si128((const __m128i *)src);
+		__m256i a = _mm256_i32gather_epi32(lut, _mm256_cvtepu8_epi32(index), 4);
+		__m256i b = _mm256_i32gather_epi32(lut, _mm256_cvtepu8_epi32(_mm_srli_si128(index, 8)), 4);
+		_mm256_storeu_si256((__m256i *)dst, a);
+		_mm256_storeu_si256((__m256i *)(dst + 8), b);
+		src += 16;
+		dst += 16;
+	}
+	SDL_Shadow8to32_C(job, src, (Uint8 *)dst, x, y, w);
+}
+#endif /* SDL_AVX2_INTRINSICS */
+
+/* Adds the dither to each byte of a pixel, stopping at 255.  The dither
+   bytes are less than 128, so the low 7 bits can't carry into the next
+   byte. */
+static __inline__ Uint32 SDL_AddDither(Uint32 pixel, Uint32 dither)
+{
+	Uint32 sum = (pixel & 0x7F7F7F7F) + dither;
+	Uint32 over = (pixel & sum & 0x80808080) >> 7;
+
+	return((sum ^ (pixel & 0x80808080)) | (over * 0xFF));
+}
+
+static void SDL_Shadow32to16_C(const SDL_ShadowJob *job, const Uint8 *srcrow,
+			       Uint8 *dstrow, int x, int y, int w)
+{
+	const Uint32 *src = (const Uint32 *)srcrow;
+	const Uint32 *dither = job->dither[y & 3];
+	Uint16 *dst = (Uint16 *)dstrow;
+	Uint32 pixel;
+
+	while ( w-- ) {
+		pixel = SDL_AddDither(*src++, dither[x++ & 3]);
+		*dst++ = (Uint16)
+			(((pixel >> job->shift[0]) & job->mask[0]) << job->dshift[0] |
+			 ((pixel >> job->shift[1]) & job->mask[1]) << job->dshift[1] |
+			 ((pixel >> job->shift[2]) & job->mask[2]) << job->dshift[2]);
+	}
+}
+
+/* The vector versions saturate the dither with byte adds, and pack the
+   pixels to 16 bits after sign extending them so they don't saturate */
+#if SDL_SSE2_INTRINSICS
+static void SDL_TARGETING("sse2") SDL_Shadow32to16_SSE2(const SDL_ShadowJob *job,
+	const Uint8 *srcrow, Uint8 *dstrow, int x, int y, int w)
+{
+	const Uint32 *src = (const Uint32 *)srcrow;
+	Uint16 *dst = (Uint16 *)dstrow;
+	__m128i dither, shift[3], mask[3], dshift[3];
+	__m128i pixels[2];
+	int i, j;
+
+	dither = _mm_loadu_si128((const __m128i *)&job->dither[y & 3][x & 3]);
+	for ( i = 0; i < 3; ++i ) {
+		shift[i] = _mm_cvtsi32_si128(job->shift[i]);
+		mask[i] = _mm_set1_epi32((int)job->mask[i]);
+		dshift[i] = _mm_cvtsi32_si128(job->dshift[i]);
+	}
+	for ( ; w >= 8; w -= 8 ) {
+		for ( j = 0; j < 2; ++j ) {
+			__m128i p = _mm_adds_epu8(_mm_loadu_si128((const __m128i *)(src + j*4)), dither);
+			__m128i out = _mm_setzero_si128();
+			for ( i = 0; i < 3; ++i ) {
+				out = _mm_or_si128(out, _mm_sll_epi32(_mm_and_si128(
+					_mm_srl_epi32(p, shift[i]), mask[i]), dshift[i]));
+			}
+			pixels[j] = _mm_srai_epi32(_mm_slli_epi32(out, 16), 16);
+		}
+		_mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(pixels[0], pixels[1]));
+		src += 8;
+		dst += 8;
+		x += 8;
+	}
+	SDL_Shadow32to16_C(job, (const Uint8 *)src, (Uint8 *)dst, x, y, w);
+}
+#endif /* SDL_SSE2_INTRINSICS */
+
+#if SDL_AVX2_INTRINSICS
+static void SDL_TARGETING("avx2") SDL_Shadow32to16_AVX2(const SDL_ShadowJob *job,
+	const Uint8 *srcrow, Uint8 *dstrow, int x, int y, int w)
+{
+	const Uint32 *src = (const Uint32 *)srcrow;
+	Uint16 *dst = (Uint16 *)dstrow;
+	__m256i dither, mask[3];
+	__m128i shift[3], dshift[3];
+	__m256i pixels[2];
+	int i, j;
+
+	dither = _mm256_loadu_si256((const __m256i *)&job->dither[y & 3][x & 3]);
+	for ( i = 0; i < 3; ++i ) {
+		shift[i] = _mm_cvtsi32_si128(job->shift[i]);
+		mask[i] = _mm256_set1_epi32((int)job->mask[i]);
+		dshift[i] = _mm_cvtsi32_si128(job->dshift[i]);
+	}
+	for ( ; w >= 16; w -= 16 ) {
+		for ( j = 0; j < 2; ++j ) {
+			__m256i p = _mm256_adds_epu8(_mm256_loadu_si256((const __m256i *)(src + j*8)), dither);
+			__m256i out = _mm256_setzero_si256();
+			for ( i = 0; i < 3; ++i ) {
+				out = _mm256_or_si256(out, _mm256_sll_epi32(_mm256_and_si256(
+					_mm256_srl_epi32(p, shift[i]), mask[i]), dshift[i]));
+			}
+			pixels[j] = _mm256_srai_epi32(_mm256_slli_epi32(out, 16), 16);
+		}
+		/* The pack works within each half, so put the halves back in order */
+		_mm256_storeu_si256((__m256i *)dst, _mm256_permute4x64_epi64(
+			_mm256_packs_epi32(pixels[0], pixels[1]), _MM_SHUFFLE(3, 1, 2, 0)));
+		src += 16;
+		dst += 16;
+		x += 16;
+	}
+	SDL_Shadow32to16_C(job, (const Uint8 *)src, (Uint8 *)dst, x, y, w);
+}
+#endif /* SDL_AVX2_INTRINSICS */
+
+#if SDL_NEON_INTRINSICS
+static void SDL_Shadow32to16_NEON(const SDL_ShadowJob *job,
+	const Uint8 *srcrow, Uint8 *dstrow, int x, int y, int w)
+{
+	const Uint32 *src = (const Uint32 *)srcrow;
+	Uint16 *dst = (Uint16 *)dstrow;
+	uint8x16_t dither;
+	int32x4_t shift[3], dshift[3];
+	uint32x4_t mask[3];
+	uint16x4_t pixels[2];
+	int i, j;
+
+	dither = vreinterpretq_u8_u32(vld1q_u32(&job->dither[y & 3][x & 3]));
+	for ( i = 0; i < 3; ++i ) {
+		shift[i] = vdupq_n_s32(-job->shift[i]);
+		mask[i] = vdupq_n_u32(job->mask[i]);
+		dshift[i] = vdupq_n_s32(job->dshift[i]);
+	}
+	for ( ; w >= 8; w -= 8 ) {
+		for ( j = 0; j < 2; ++j ) {
+			uint32x4_t p = vreinterpretq_u32_u8(vqaddq_u8(
+				vreinterpretq_u8_u32(vld1q_u32(src + j*4)), dither));
+			uint32x4_t out = vdupq_n_u32(0);
+			for ( i = 0; i < 3; ++i ) {
+				out = vorrq_u32(out, vshlq_u32(vandq_u32(
+					vshlq_u32(p, shift[i]), mask[i]), dshift[i]));
+			}
+			pixels[j] = vmovn_u32(out);
+		}
+		vst1q_u16(dst, vcombine_u16(pixels[0], pixels[1]));
+		src += 8;
+		dst += 8;
+		x += 8;
+	}
+	SDL_Shadow32to16_C(job, (const Uint8 *)src, (Uint8 *)dst, x, y, w);
+}
+#endif /* SDL_NEON_INTRINSICS */
+
+/* Sets up the dither and shifts for a 32-bit shadow with a channel in each
+   byte, going to a 16-bit display with no alpha and at most 4 bits lost
+   from each channel.  Returns 0 if the formats aren't like that. */
+static int SDL_Setup32to16(SDL_ShadowJob *job, const SDL_PixelFormat *src,
+			   const SDL_PixelFormat *dst)
+{
+	const Uint32 srcmask[3] = { src->Rmask, src->Gmask, src->Bmask };
+	const Uint8 srcshift[3] = { src->Rshift, src->Gshift, src->Bshift };
+	const Uint8 loss[3] = { dst->Rloss, dst->Gloss, dst->Bloss };
+	const Uint8 dshift[3] = { dst->Rshift, dst->Gshift, dst->Bshift };
+	int i, x, y;
+
+	if ( src->Amask || dst->Amask ) {
+		return(0);
+	}
+	for ( i = 0; i < 3; ++i ) {
+		if ( (srcshift[i] % 8) != 0 ||
+		     srcmask[i] != ((Uint32)0xFF << srcshift[i]) ||
+		     loss[i] > 4 ) {
+			return(0);
+		}
+		job->shift[i] = srcshift[i] + loss[i];
+		job->mask[i] = 0xFF >> loss[i];
+		job->dshift[i] = dshift[i];
+	}
+	for ( y = 0; y < 4; ++y ) {
+		for ( x = 0; x < 12; ++x ) {
+			Uint32 dither = 0;
+			for ( i = 0; i < 3; ++i ) {
+				dither |= (Uint32)(bayer[y][x & 3] >> (4 - loss[i])) << srcshift[i];
+			}
+			job->dither[y][x] = dither;
+		}
+	}
+	return(1);
+}
+
+/* Picks a converter for the shadow to the video surface, or returns NULL
+   if the blit mapping has to be used */
+static SDL_ShadowRow SDL_ChooseShadowRow(SDL_ShadowJob *job,
+			SDL_Surface *shadow, SDL_Surface *screen)
+{
+	SDL_PixelFormat *src = shadow->format;
+	SDL_PixelFormat *dst = screen->format;
+	SDL_BlitMap *map = shadow->map;
+	int i;
+
+	if ( shadow->flags & (SDL_SRCCOLORKEY|SDL_SRCALPHA|SDL_HWACCEL|SDL_RLEACCEL) ) {
+		return(NULL);
+	}
+	if ( src->BytesPerPixel == 1 && map->table &&
+	     (dst->BytesPerPixel == 2 || dst->BytesPerPixel == 4) ) {
+		/* The mapping has the display pixels for the palette */
+		SDL_memset(job->lut, 0, sizeof(job->lut));
+		for ( i = 0; i < src->palette->ncolors && i < 256; ++i ) {
+			if ( dst->BytesPerPixel == 2 ) {
+				job->lut[i] = ((Uint16 *)map->table)[i];
+			} else {
+				job->lut[i] = ((Uint32 *)map->table)[i];
+			}
+		}
+		if ( dst->BytesPerPixel == 2 ) {
+			return(SDL_Shadow8to16_C);
+		}
+#if SDL_AVX2_INTRINSICS
+		if ( SDL_HasAVX2() ) {
+			return(SDL_Shadow8to32_AVX2);
+		}
+#endif
+		return(SDL_Shadow8to32_C);
+	}
+	if ( src->BytesPerPixel == 4 && dst->BytesPerPixel == 2 &&
+	     SDL_Setup32to16(job, src, dst) ) {
+#if SDL_AVX2_INTRINSICS
+		if ( SDL_HasAVX2() ) {
+			return(SDL_Shadow32to16_AVX2);
+		}
+#endif
+#if SDL_SSE2_INTRINSICS
+		if ( SDL_HasSSE2() ) {
+			return(SDL_Shadow32to16_SSE2);
+		}
+#elif SDL_NEON_INTRINSICS
+		return(SDL_Shadow32to16_NEON);
+#endif
+		return(SDL_Shadow32to16_C);
+	}
+	return(NULL);
+}
+
+static void SDL_ShadowBand(void *data, int y, int rows)
+{
+	SDL_ShadowJob *job = (SDL_ShadowJob *)data;
+	const Uint8 *src = job->src + y * job->srcpitch;
+	Uint8 *dst = job->dst + y * job->dstpitch;
+
+	for ( y += job->y; rows--; ++y ) {
+		job->convert(job, src, dst, job->x, y, job->w);
+		src += job->srcpitch;
+		dst += job->dstpitch;
+	}
+}
+
+static void SDL_ConvertShadow(SDL_ShadowJob *job, SDL_Surface *shadow,
+			      SDL_Surface *screen, int numrects, SDL_Rect *rects)
+{
+	int i, h;
+
+	if ( SDL_LockSurface(screen) < 0 ) {
+		return;
+	}
+	job->srcpitch = shadow->pitch;
+	job->dstpitch = screen->pitch;
+	for ( i = 0; i < numrects; ++i ) {
+		/* Clip it to the screen */
+		job->x = SDL_max(rects[i].x, 0);
+		job->y = SDL_max(rects[i].y, 0);
+		job->w = SDL_min(rects[i].x + rects[i].w, shadow->w) - job->x;
+		h = SDL_min(rects[i].y + rects[i].h, shadow->h) - job->y;
+		if ( job->w <= 0 || h <= 0 ) {
+			continue;
+		}
+		job->src = (Uint8 *)shadow->pixels + job->y * shadow->pitch +
+		           job->x * shadow->format->BytesPerPixel;
+		job->dst = (Uint8 *)screen->pixels + job->y * screen->pitch +
+		           job->x * screen->format->BytesPerPixel;
+		if ( ! SDL_RunBlitBands(SDL_ShadowBand, job, job->w, h) ) {
+			SDL_ShadowBand(job, 0, h);
+		}
+	}
+	SDL_UnlockSurface(screen);
+}
+
+/* Erases or draws the software cursor on the video surface */
+static void SDL_ShadowCursor(SDL_Surface *screen, int draw)
+{
+	if ( SDL_LockSurface(screen) < 0 ) {
+		return;
+	}
+	if ( draw ) {
+		SDL_DrawCursorNoLock(screen);
+	} else {
+		SDL_EraseCursorNoLock(screen);
+	}
+	SDL_UnlockSurface(screen);
+}
+
+/*
+ * Copy rectangles of the shadow surface to the video surface, without
+ * updating the screen.  The software cursor stays on the video surface:
+ * it's taken off before copying over it and put back on the new pixels,
+ * so the shadow surface is never touched.
+ */
+void SDL_PresentShadow(SDL_Surface *shadow, int numrects, SDL_Rect *rects)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_Surface *screen = SDL_VideoSurface;
+	SDL_Palette *pal = shadow->format->palette;
+	SDL_Color *saved_colors = NULL;
+	SDL_ShadowJob job;
+	SDL_Rect area;
+	int cursor, i;
+
+	if ( pal && !(screen->flags & SDL_HWPALETTE) ) {
+		/* simulated 8bpp, use correct physical palette */
+		saved_colors = pal->colors;
+		if ( video->gammacols ) {
+			/* gamma-corrected palette */
+			pal->colors = video->gammacols;
+		} else if ( video->physpal ) {
+			/* physical palette different from logical */
+			pal->colors = video->physpal->colors;
+		}
+	}
+
+	/* Only the converters need the mapping checked here, SDL_LowerBlit()
+	   does it too */
+	job.convert = NULL;
+	if ( (shadow->map->dst == screen &&
+	      shadow->map->format_version == screen->format_version) ||
+	     SDL_MapSurface(shadow, screen) == 0 ) {
+		job.convert = SDL_ChooseShadowRow(&job, shadow, screen);
+	}
+
+	SDL_LockCursor();
+	cursor = 0;
+	if ( SHOULD_DRAWCURSOR(SDL_cursorstate) ) {
+		SDL_MouseRect(&area);
+		for ( i = 0; i < numrects && !cursor; ++i ) {
+			cursor = area.w && area.h &&
+			         rects[i].x < area.x + area.w &&
+			         area.x < rects[i].x + rects[i].w &&
+			         rects[i].y < area.y + area.h &&
+			         area.y < rects[i].y + rects[i].h;
+		}
+	}
+	if ( cursor ) {
+		SDL_ShadowCursor(screen, 0);
+	}
+	if ( job.convert ) {
+		SDL_ConvertShadow(&job, shadow, screen, numrects, rects);
+	} else {
+		for ( i = 0; i < numrects; ++i ) {
+			SDL_LowerBlit(shadow, &rects[i], screen, &rects[i]);
+		}
+	}
+	if ( cursor ) {
+		SDL_ShadowCursor(screen, 1);
+	}
+	SDL_UnlockCursor();
+
+	if ( saved_colors ) {
+		pal->colors = saved_colors;
+	}
+}
@@ -29,6 +29,8 @@
 
 #include "SDL_video.h"
 #include "SDL_blit.h"
+#include "SDL_cpuinfo.h"
+#include "../cpuinfo/SDL_simd.h"
 
 /* This isn't ready for general consumption yet - it should be folded
    into the general blitting mechanism.
@@ -197,35 +199,11 @@ void copy_row3(Uint8 *src, int src_w, Uint8 *dst, int dst_w)
 /* Perform a stretch blit between two surfaces of the same format.
    NOTE:  This function is not safe to call from multiple threads!
 */
-int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
-                    SDL_Surface *dst, SDL_Rect *dstrect)
+/* Verify the blit rectangles, filling in the full surfaces for NULL ones */
+static int SDL_StretchRects(SDL_Surface *src, SDL_Rect *srcrect,
+                            SDL_Surface *dst, SDL_Rect *dstrect,
+                            SDL_Rect *full_src, SDL_Rect *full_dst)
 {
-	int src_locked;
-	int dst_locked;
-	int pos, inc;
-	int dst_width;
-	int dst_maxrow;
-	int src_row, dst_row;
-	Uint8 *srcp = NULL;
-	Uint8 *dstp;
-	SDL_Rect full_src;
-	SDL_Rect full_dst;
-#ifdef USE_ASM_STRETCH
-	SDL_bool use_asm = SDL_TRUE;
-#ifdef __GNUC__
-	int u1, u2;
-#endif
-#endif /* USE_ASM_STRETCH */
-	const int bpp = dst->format->BytesPerPixel;
-
-	SLOG("SDL_SoftStretch");
-
-	if ( src->format->BitsPerPixel != dst->format->BitsPerPixel ) {
-		SDL_SetError("Only works with same format surfaces");
-		return(-1);
-	}
-
-	/* Verify the blit rectangles */
 	if ( srcrect ) {
 		SLOG("srcrect:[%d %d %d %d]", srcrect->x, srcrect->y, srcrect->w, srcrect->h);
 		if ( (srcrect->x < 0) || (srcrect->y < 0) ||
@@ -234,12 +212,12 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 			SDL_SetError("Invalid source blit rectangle");
 			return(-1);
 		}
+		*full_src = *srcrect;
 	} else {
-		full_src.x = 0;
-		full_src.y = 0;
-		full_src.w = src->w;
-		full_src.h = src->h;
-		srcrect = &full_src;
+		full_src->x = 0;
+		full_src->y = 0;
+		full_src->w = src->w;
+		full_src->h = src->h;
 	}
 	if ( dstrect ) {
 		SLOG("dstrect:[%d %d %d %d]", dstrect->x, dstrect->y, dstrect->w, dstrect->h);
@@ -249,34 +227,81 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 			SDL_SetError("Invalid destination blit rectangle");
 			return(-1);
 		}
+		*full_dst = *dstrect;
 	} else {
-		full_dst.x = 0;
-		full_dst.y = 0;
-		full_dst.w = dst->w;
-		full_dst.h = dst->h;
-		dstrect = &full_dst;
+		full_dst->x = 0;
+		full_dst->y = 0;
+		full_dst->w = dst->w;
+		full_dst->h = dst->h;
 	}
+	return(0);
+}
 
-	/* Lock the destination if it's in hardware */
-	dst_locked = 0;
+/* Lock both surfaces if they're in hardware, returns which got locked */
+static int SDL_StretchLock(SDL_Surface *src, SDL_Surface *dst,
+                           int *src_locked, int *dst_locked)
+{
+	*dst_locked = 0;
 	if ( SDL_MUSTLOCK(dst) ) {
 		if ( SDL_LockSurface(dst) < 0 ) {
 			SDL_SetError("Unable to lock destination surface");
 			return(-1);
 		}
-		dst_locked = 1;
+		*dst_locked = 1;
 	}
-	/* Lock the source if it's in hardware */
-	src_locked = 0;
+	*src_locked = 0;
 	if ( SDL_MUSTLOCK(src) ) {
 		if ( SDL_LockSurface(src) < 0 ) {
-			if ( dst_locked ) {
+			if ( *dst_locked ) {
 				SDL_UnlockSurface(dst);
 			}
 			SDL_SetError("Unable to lock source surface");
 			return(-1);
 		}
-		src_locked = 1;
+		*src_locked = 1;
+	}
+	return(0);
+}
+
+int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
+                    SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	int src_locked;
+	int dst_locked;
+	int pos, inc;
+	int dst_width;
+	int dst_maxrow;
+	int src_row, dst_row;
+	Uint8 *srcp = NULL;
+	Uint8 *dstp;
+	SDL_Rect full_src;
+	SDL_Rect full_dst;
+#ifdef USE_ASM_STRETCH
+	SDL_bool use_asm = SDL_TRUE;
+#ifdef __GNUC__
+	int u1, u2;
+#endif
+#endif /* USE_ASM_STRETCH */
+	const int bpp = dst->format->BytesPerPixel;
+
+	SLOG("SDL_SoftStretch");
+
+	if ( src->format->BitsPerPixel != dst->format->BitsPerPixel ) {
+		SDL_SetError("Only works with same format surfaces");
+		return(-1);
+	}
+
+	/* Verify the blit rectangles */
+	if ( SDL_StretchRects(src, srcrect, dst, dstrect,
+	                      &full_src, &full_dst) < 0 ) {
+		return(-1);
+	}
+	srcrect = &full_src;
+	dstrect = &full_dst;
+
+	/* Lock the surfaces if they're in hardware */
+	if ( SDL_StretchLock(src, dst, &src_locked, &dst_locked) < 0 ) {
+		return(-1);
 	}
 
 	/* Set up the data... */
@@ -360,3 +385,447 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 	return(0);
 }
 
+
+/* Filtered stretching.
+
+   Each axis has a table giving, for every destination pixel, the first
+   source pixel and the weights of the source pixels it's made from: the
+   two nearest for bilinear filtering, and everything under the pixel's
+   footprint weighted by coverage for box filtering.  A destination row is
+   the weighted sum of its source rows, made in a row of floats, which is
+   then filtered across.  Pixels are always held as four channels, 32-bit
+   surfaces are filtered byte by byte and 16-bit surfaces are unpacked to
+   their raw channel values first.
+*/
+typedef struct {
+	int *first;
+	float *weights;
+	int taps;
+} SDL_StretchAxis;
+
+typedef void (*SDL_StretchVertFunc)(float *row, const Uint8 *src,
+                                    float weight, int len);
+typedef void (*SDL_StretchHorzFunc)(Uint8 *dst, const float *row,
+                                    const SDL_StretchAxis *axis, int width);
+
+typedef struct {
+	SDL_Surface *src;
+	SDL_Surface *dst;
+	SDL_Rect srcrect;
+	SDL_Rect dstrect;
+	SDL_StretchAxis xaxis;
+	SDL_StretchAxis yaxis;
+	SDL_StretchVertFunc vert;
+	SDL_StretchHorzFunc horz;
+	volatile int failed;
+} SDL_StretchInfo;
+
+static int SDL_BuildStretchAxis(SDL_StretchAxis *axis,
+                                int srclen, int dstlen, SDL_StretchFilter filter)
+{
+	const double scale = (double)srclen / dstlen;
+	int i, j;
+
+	if ( filter == SDL_STRETCH_BOX ) {
+		axis->taps = (srclen + dstlen - 1) / dstlen + 1;
+	} else {
+		axis->taps = 2;
+	}
+	axis->first = (int *)SDL_malloc(dstlen * sizeof(int));
+	axis->weights = (float *)SDL_malloc(dstlen * axis->taps * sizeof(float));
+	if ( !axis->first || !axis->weights ) {
+		return(-1);
+	}
+
+	for ( i = 0; i < dstlen; ++i ) {
+		float *weights = &axis->weights[i * axis->taps];
+
+		if ( filter == SDL_STRETCH_BOX ) {
+			double start = i * scale;
+			double end = (i + 1) * scale;
+			int first = (int)start;
+
+			for ( j = 0; j < axis->taps; ++j ) {
+				double lo = first + j;
+				double hi = lo + 1.0;
+
+				if ( lo < start ) {
+					lo = start;
+				}
+				if ( hi > end ) {
+					hi = end;
+				}
+				if ( (first + j) < srclen && hi > lo ) {
+					weights[j] = (float)((hi - lo) / scale);
+				} else {
+					weights[j] = 0.0f;
+				}
+			}
+			axis->first[i] = first;
+		} else {
+			double center = (i + 0.5) * scale - 0.5;
+			int first;
+
+			if ( center < 0.0 ) {
+				center = 0.0;
+			}
+			first = (int)center;
+			if ( first >= (srclen - 1) ) {
+				first = srclen - 1;
+				center = first;
+			}
+			weights[0] = (float)(1.0 - (center - first));
+			weights[1] = (float)(center - first);
+			axis->first[i] = first;
+		}
+	}
+	return(0);
+}
+
+static void SDL_FreeStretchAxis(SDL_StretchAxis *axis)
+{
+	if ( axis->first ) {
+		SDL_free(axis->first);
+	}
+	if ( axis->weights ) {
+		SDL_free(axis->weights);
+	}
+}
+
+static void StretchVertC(float *row, const Uint8 *src, float weight, int len)
+{
+	int i;
+
+	for ( i = 0; i < len; ++i ) {
+		row[i] += weight * src[i];
+	}
+}
+
+static void StretchHorzC(Uint8 *dst, const float *row,
+                         const SDL_StretchAxis *axis, int width)
+{
+	const int taps = axis->taps;
+	int x, i, c;
+
+	for ( x = 0; x < width; ++x ) {
+		const float *src = &row[axis->first[x] * 4];
+		const float *weights = &axis->weights[x * taps];
+
+		for ( c = 0; c < 4; ++c ) {
+			float sum = 0.0f;
+			int value;
+
+			for ( i = 0; i < taps; ++i ) {
+				sum += weights[i] * src[i * 4 + c];
+			}
+			value = (int)(sum + 0.5f);
+			*dst++ = (Uint8)(value > 255 ? 255 : value);
+		}
+	}
+}
+
+#if SDL_SSE2_INTRINSICS
+static void SDL_TARGETING("sse2") StretchVertSSE2(float *row, const Uint8 *src,
+                                                  float weight, int len)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 w = _mm_set1_ps(weight);
+	int i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		__m128i bytes = _mm_loadu_si128((const __m128i *)&src[i]);
+		__m128i lo = _mm_unpacklo_epi8(bytes, zero);
+		__m128i hi = _mm_unpackhi_epi8(bytes, zero);
+		__m128 f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+		__m128 f1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+		__m128 f2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+		__m128 f3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+
+		_mm_storeu_ps(&row[i], _mm_add_ps(_mm_loadu_ps(&row[i]), _mm_mul_ps(w, f0)));
+		_mm_storeu_ps(&row[i+4], _mm_add_ps(_mm_loadu_ps(&row[i+4]), _mm_mul_ps(w, f1)));
+		_mm_storeu_ps(&row[i+8], _mm_add_ps(_mm_loadu_ps(&row[i+8]), _mm_mul_ps(w, f2)));
+		_mm_storeu_ps(&row[i+12], _mm_add_ps(_mm_loadu_ps(&row[i+12]), _mm_mul_ps(w, f3)));
+	}
+	StretchVertC(&row[i], &src[i], weight, len - i);
+}
+
+static void SDL_TARGETING("sse2") StretchHorzSSE2(Uint8 *dst, const float *row,
+                                                  const SDL_StretchAxis *axis,
+                                                  int width)
+{
+	const int taps = axis->taps;
+	const __m128 half = _mm_set1_ps(0.5f);
+	int x, i;
+
+	for ( x = 0; x < width; ++x ) {
+		const float *src = &row[axis->first[x] * 4];
+		const float *weights = &axis->weights[x * taps];
+		__m128 sum = _mm_setzero_ps();
+		__m128i value;
+
+		for ( i = 0; i < taps; ++i ) {
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[i]),
+			                                 _mm_loadu_ps(&src[i * 4])));
+		}
+		value = _mm_cvttps_epi32(_mm_add_ps(sum, half));
+		value = _mm_packs_epi32(value, value);
+		value = _mm_packus_epi16(value, value);
+		*(Uint32 *)dst = (Uint32)_mm_cvtsi128_si32(value);
+		dst += 4;
+	}
+}
+#endif /* SDL_SSE2_INTRINSICS */
+
+#if SDL_NEON_INTRINSICS
+static void StretchVertNEON(float *row, const Uint8 *src, float weight, int len)
+{
+	int i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		uint8x16_t bytes = vld1q_u8(&src[i]);
+		uint16x8_t lo = vmovl_u8(vget_low_u8(bytes));
+		uint16x8_t hi = vmovl_u8(vget_high_u8(bytes));
+		float32x4_t f0 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo)));
+		float32x4_t f1 = vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo)));
+		float32x4_t f2 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi)));
+		float32x4_t f3 = vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi)));
+
+		vst1q_f32(&row[i], vaddq_f32(vld1q_f32(&row[i]), vmulq_n_f32(f0, weight)));
+		vst1q_f32(&row[i+4], vaddq_f32(vld1q_f32(&row[i+4]), vmulq_n_f32(f1, weight)));
+		vst1q_f32(&row[i+8], vaddq_f32(vld1q_f32(&row[i+8]), vmulq_n_f32(f2, weight)));
+		vst1q_f32(&row[i+12], vaddq_f32(vld1q_f32(&row[i+12]), vmulq_n_f32(f3, weight)));
+	}
+	StretchVertC(&row[i], &src[i], weight, len - i);
+}
+
+static void StretchHorzNEON(Uint8 *dst, const float *row,
+                            const SDL_StretchAxis *axis, int width)
+{
+	const int taps = axis->taps;
+	const float32x4_t half = vdupq_n_f32(0.5f);
+	int x, i;
+
+	for ( x = 0; x < width; ++x ) {
+		const float *src = &row[axis->first[x] * 4];
+		const float *weights = &axis->weights[x * taps];
+		float32x4_t sum = vdupq_n_f32(0.0f);
+		uint16x4_t value;
+
+		for ( i = 0; i < taps; ++i ) {
+			sum = vaddq_f32(sum, vmulq_n_f32(vld1q_f32(&src[i * 4]),
+			                                 weights[i]));
+		}
+		value = vqmovn_u32(vcvtq_u32_f32(vaddq_f32(sum, half)));
+		vst1_lane_u32((uint32_t *)dst, vreinterpret_u32_u8(
+		              vqmovn_u16(vcombine_u16(value, value))), 0);
+		dst += 4;
+	}
+}
+#endif /* SDL_NEON_INTRINSICS */
+
+/* Unpack 16-bit pixels into a byte for each channel, and back again */
+static void StretchUnpack16(Uint8 *dst, const Uint16 *src, int width,
+                            const SDL_PixelFormat *fmt)
+{
+	int x;
+
+	for ( x = 0; x < width; ++x ) {
+		Uint32 pixel = src[x];
+
+		dst[0] = (Uint8)((pixel & fmt->Rmask) >> fmt->Rshift);
+		dst[1] = (Uint8)((pixel & fmt->Gmask) >> fmt->Gshift);
+		dst[2] = (Uint8)((pixel & fmt->Bmask) >> fmt->Bshift);
+		dst[3] = (Uint8)((pixel & fmt->Amask) >> fmt->Ashift);
+		dst += 4;
+	}
+}
+
+static void StretchPack16(Uint16 *dst, const Uint8 *src, int width,
+                          const SDL_PixelFormat *fmt)
+{
+	int x;
+
+	for ( x = 0; x < width; ++x ) {
+		dst[x] = (Uint16)((((Uint32)src[0] << fmt->Rshift) & fmt->Rmask) |
+		                  (((Uint32)src[1] << fmt->Gshift) & fmt->Gmask) |
+		                  (((Uint32)src[2] << fmt->Bshift) & fmt->Bmask) |
+		                  (((Uint32)src[3] << fmt->Ashift) & fmt->Amask));
+		src += 4;
+	}
+}
+
+static void SDL_StretchBand(void *data, int y, int rows)
+{
+	SDL_StretchInfo *info = (SDL_StretchInfo *)data;
+	SDL_Surface *src = info->src;
+	SDL_Surface *dst = info->dst;
+	const int bpp = dst->format->BytesPerPixel;
+	const int srcw = info->srcrect.w;
+	const int dstw = info->dstrect.w;
+	const int taps = info->yaxis.taps;
+	float *row;
+	Uint8 *srcbuf = NULL;
+	Uint8 *dstbuf = NULL;
+	int i;
+
+	/* The row is padded so the last pixels can read past the end */
+	row = (float *)SDL_calloc((srcw + info->xaxis.taps) * 4, sizeof(float));
+	if ( bpp == 2 ) {
+		srcbuf = (Uint8 *)SDL_malloc(srcw * 4);
+		dstbuf = (Uint8 *)SDL_malloc(dstw * 4);
+	}
+	if ( !row || (bpp == 2 && (!srcbuf || !dstbuf)) ) {
+		info->failed = 1;
+		goto done;
+	}
+
+	for ( ; rows--; ++y ) {
+		const float *weights = &info->yaxis.weights[y * taps];
+		Uint8 *dstp = (Uint8 *)dst->pixels +
+		              (info->dstrect.y + y) * dst->pitch +
+		              info->dstrect.x * bpp;
+
+		SDL_memset(row, 0, srcw * 4 * sizeof(float));
+		for ( i = 0; i < taps; ++i ) {
+			const Uint8 *srcp;
+
+			if ( weights[i] == 0.0f ) {
+				continue;
+			}
+			srcp = (const Uint8 *)src->pixels +
+			       (info->srcrect.y + info->yaxis.first[y] + i) * src->pitch +
+			       info->srcrect.x * bpp;
+			if ( bpp == 2 ) {
+				StretchUnpack16(srcbuf, (const Uint16 *)srcp,
+				                srcw, src->format);
+				srcp = srcbuf;
+			}
+			info->vert(row, srcp, weights[i], srcw * 4);
+		}
+		if ( bpp == 2 ) {
+			info->horz(dstbuf, row, &info->xaxis, dstw);
+			StretchPack16((Uint16 *)dstp, dstbuf, dstw, dst->format);
+		} else {
+			info->horz(dstp, row, &info->xaxis, dstw);
+		}
+	}
+done:
+	if ( row ) {
+		SDL_free(row);
+	}
+	if ( srcbuf ) {
+		SDL_free(srcbuf);
+	}
+	if ( dstbuf ) {
+		SDL_free(dstbuf);
+	}
+}
+
+/* 32-bit surfaces are filtered a byte at a time */
+static int SDL_ByteChannels(SDL_PixelFormat *fmt)
+{
+	if ( fmt->BytesPerPixel == 2 ) {
+		return(1);
+	}
+	return( fmt->BytesPerPixel == 4 &&
+	        (fmt->Rloss == 0 && (fmt->Rshift % 8) == 0) &&
+	        (fmt->Gloss == 0 && (fmt->Gshift % 8) == 0) &&
+	        (fmt->Bloss == 0 && (fmt->Bshift % 8) == 0) &&
+	        ((fmt->Aloss == 0 && (fmt->Ashift % 8) == 0) || !fmt->Amask) );
+}
+
+int SDL_SoftStretchFiltered(SDL_Surface *src, SDL_Rect *srcrect,
+                            SDL_Surface *dst, SDL_Rect *dstrect,
+                            SDL_StretchFilter filter)
+{
+	SDL_StretchInfo info;
+	int src_locked;
+	int dst_locked;
+	int retval;
+
+	if ( filter == SDL_STRETCH_NEAREST ) {
+		return SDL_SoftStretch(src, srcrect, dst, dstrect);
+	}
+	if ( filter != SDL_STRETCH_BILINEAR && filter != SDL_STRETCH_BOX ) {
+		SDL_SetError("Unknown stretch filter");
+		return(-1);
+	}
+
+	if ( src == dst ) {
+		SDL_SetError("Source and destination must be different surfaces");
+		return(-1);
+	}
+	if ( src->format->BytesPerPixel != dst->format->BytesPerPixel ||
+	     src->format->Rmask != dst->format->Rmask ||
+	     src->format->Gmask != dst->format->Gmask ||
+	     src->format->Bmask != dst->format->Bmask ||
+	     src->format->Amask != dst->format->Amask ) {
+		SDL_SetError("Only works with same format surfaces");
+		return(-1);
+	}
+	if ( !SDL_ByteChannels(src->format) ) {
+		SDL_SetError("Filtered stretch needs 16-bit or 8888 surfaces");
+		return(-1);
+	}
+
+	/* Verify the blit rectangles */
+	if ( SDL_StretchRects(src, srcrect, dst, dstrect,
+	                      &info.srcrect, &info.dstrect) < 0 ) {
+		return(-1);
+	}
+	if ( info.srcrect.w == 0 || info.srcrect.h == 0 ||
+	     info.dstrect.w == 0 || info.dstrect.h == 0 ) {
+		return(0);
+	}
+
+	/* Work out where every destination pixel comes from */
+	SDL_memset(&info.xaxis, 0, sizeof(info.xaxis));
+	SDL_memset(&info.yaxis, 0, sizeof(info.yaxis));
+	if ( SDL_BuildStretchAxis(&info.xaxis, info.srcrect.w,
+	                          info.dstrect.w, filter) < 0 ||
+	     SDL_BuildStretchAxis(&info.yaxis, info.srcrect.h,
+	                          info.dstrect.h, filter) < 0 ) {
+		SDL_FreeStretchAxis(&info.xaxis);
+		SDL_FreeStretchAxis(&info.yaxis);
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	info.src = src;
+	info.dst = dst;
+	info.failed = 0;
+	info.vert = StretchVertC;
+	info.horz = StretchHorzC;
+#if SDL_SSE2_INTRINSICS
+	if ( SDL_HasSSE2() ) {
+		info.vert = StretchVertSSE2;
+		info.horz = StretchHorzSSE2;
+	}
+#elif SDL_NEON_INTRINSICS
+	if ( SDL_HasNEON() ) {
+		info.vert = StretchVertNEON;
+		info.horz = StretchHorzNEON;
+	}
+#endif
+
+	/* Lock the surfaces if they're in hardware */
+	retval = SDL_StretchLock(src, dst, &src_locked, &dst_locked);
+	if ( retval == 0 ) {
+		if ( !SDL_RunBlitBands(SDL_StretchBand, &info,
+		                       info.dstrect.w, info.dstrect.h) ) {
+			SDL_StretchBand(&info, 0, info.dstrect.h);
+		}
+		if ( info.failed ) {
+			SDL_OutOfMemory();
+			retval = -1;
+		}
+		if ( dst_locked ) {
+			SDL_UnlockSurface(dst);
+		}
+		if ( src_locked ) {
+			SDL_UnlockSurface(src);
+		}
+	}
+	SDL_FreeStretchAxis(&info.xaxis);
+	SDL_FreeStretchAxis(&info.yaxis);
+	return(retval);
+}
@@ -27,6 +27,7 @@
 #include "SDL_blit.h"
 #include "SDL_RLEaccel_c.h"
 #include "SDL_pixels_c.h"
+#include "SDL_dirtyrect_c.h"
 #include "SDL_leaks.h"
 
 
@@ -439,28 +440,16 @@ int SDL_LowerBlit (SDL_Surface *src, SDL_Rect *srcrect,
 }
 
 
-int SDL_UpperBlit (SDL_Surface *src, SDL_Rect *srcrect,
-		   SDL_Surface *dst, SDL_Rect *dstrect)
+/*
+ * Clip a blit to the source surface and the destination clip rectangle,
+ * moving 'dstrect' and returning the source area in 'sr'.  Returns 0 if
+ * there is nothing left to blit.
+ */
+static int SDL_ClipBlit (SDL_Surface *src, const SDL_Rect *srcrect,
+			 SDL_Surface *dst, SDL_Rect *dstrect, SDL_Rect *sr)
 {
-        SDL_Rect fulldst;
 	int srcx, srcy, w, h;
 
-	/* Make sure the surfaces aren't locked */
-	if ( ! src || ! dst ) {
-		SDL_SetError("SDL_UpperBlit: passed a NULL surface");
-		return(-1);
-	}
-	if ( src->locked || dst->locked ) {
-		SDL_SetError("Surfaces must not be locked during blit");
-		return(-1);
-	}
-
-	/* If the destination rectangle is NULL, use the entire dest surface */
-	if ( dstrect == NULL ) {
-	        fulldst.x = fulldst.y = 0;
-		dstrect = &fulldst;
-	}
-
 	/* clip the source rectangle to the source surface */
 	if(srcrect) {
 	        int maxw, maxh;
@@ -520,17 +509,150 @@ int SDL_UpperBlit (SDL_Surface *src, SDL_Rect *srcrect,
 	}
 
 	if(w > 0 && h > 0) {
-	        SDL_Rect sr;
-	        sr.x = srcx;
-		sr.y = srcy;
-		sr.w = dstrect->w = w;
-		sr.h = dstrect->h = h;
-		return SDL_LowerBlit(src, &sr, dst, dstrect);
+	        sr->x = srcx;
+		sr->y = srcy;
+		sr->w = dstrect->w = w;
+		sr->h = dstrect->h = h;
+		return 1;
 	}
 	dstrect->w = dstrect->h = 0;
 	return 0;
 }
 
+int SDL_UpperBlit (SDL_Surface *src, SDL_Rect *srcrect,
+		   SDL_Surface *dst, SDL_Rect *dstrect)
+{
+        SDL_Rect fulldst;
+	SDL_Rect sr;
+
+	/* Make sure the surfaces aren't locked */
+	if ( ! src || ! dst ) {
+		SDL_SetError("SDL_UpperBlit: passed a NULL surface");
+		return(-1);
+	}
+	if ( src->locked || dst->locked ) {
+		SDL_SetError("Surfaces must not be locked during blit");
+		return(-1);
+	}
+
+	/* If the destination rectangle is NULL, use the entire dest surface */
+	if ( dstrect == NULL ) {
+	        fulldst.x = fulldst.y = 0;
+		dstrect = &fulldst;
+	}
+
+	if ( SDL_ClipBlit(src, srcrect, dst, dstrect, &sr) ) {
+		SDL_TRACK_DIRTY(dst, dstrect);
+		return SDL_LowerBlit(src, &sr, dst, dstrect);
+	}
+	return 0;
+}
+
+/*
+ * Order clipped blits by destination row with a counting sort, which
+ * keeps blits starting on the same row in the order they were given.
+ * They're left as they are if there's no memory for it.
+ */
+static void SDL_SortBlitRows(SDL_BlitRectPair *pairs, int n,
+			     const SDL_Rect *clip)
+{
+	SDL_BlitRectPair *sorted;
+	int *start;
+	int rows = clip->h;
+	int i;
+
+	sorted = (SDL_BlitRectPair *)SDL_malloc(n*sizeof(*sorted) +
+	                                        (rows+1)*sizeof(*start));
+	if ( sorted == NULL ) {
+		return;
+	}
+	start = (int *)(sorted + n);
+	SDL_memset(start, 0, (rows+1)*sizeof(*start));
+	for ( i = 0; i < n; ++i ) {
+		++start[pairs[i].dst.y - clip->y + 1];
+	}
+	for ( i = 1; i <= rows; ++i ) {
+		start[i] += start[i-1];
+	}
+	for ( i = 0; i < n; ++i ) {
+		sorted[start[pairs[i].dst.y - clip->y]++] = pairs[i];
+	}
+	SDL_memcpy(pairs, sorted, n*sizeof(*pairs));
+	SDL_free(sorted);
+}
+
+int SDL_BlitSurfaceRects (SDL_Surface *src, SDL_Rect *srcrects,
+			  SDL_Surface *dst, SDL_Rect *dstrects,
+			  int numrects, Uint32 flags)
+{
+	SDL_BlitRectPair stackpairs[64];
+	SDL_BlitRectPair *pairs;
+	int i, n, retval;
+
+	/* Make sure the surfaces aren't locked */
+	if ( ! src || ! dst || ! dstrects ) {
+		SDL_SetError("SDL_BlitSurfaceRects: passed a NULL pointer");
+		return(-1);
+	}
+	if ( src->locked || dst->locked ) {
+		SDL_SetError("Surfaces must not be locked during blit");
+		return(-1);
+	}
+	if ( numrects <= 0 ) {
+		return(0);
+	}
+	if ( numrects <= (int)SDL_arraysize(stackpairs) ) {
+		pairs = stackpairs;
+	} else {
+		pairs = (SDL_BlitRectPair *)SDL_malloc(numrects*sizeof(*pairs));
+		if ( pairs == NULL ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+	}
+
+	/* Clip them all, dropping the ones that end up empty */
+	n = 0;
+	for ( i = 0; i < numrects; ++i ) {
+		if ( SDL_ClipBlit(src, srcrects ? &srcrects[i] : NULL,
+		                  dst, &dstrects[i], &pairs[n].src) ) {
+			pairs[n].dst = dstrects[i];
+			SDL_TRACK_DIRTY(dst, &pairs[n].dst);
+			++n;
+		}
+	}
+	if ( (flags & SDL_BLIT_SORTROWS) && n > 1 ) {
+		SDL_SortBlitRows(pairs, n, &dst->clip_rect);
+	}
+
+	retval = 0;
+	if ( n > 0 ) {
+		/* Check the blit mapping once for all of them */
+		if ( (src->map->dst != dst) ||
+		     (src->map->dst->format_version != src->map->format_version) ) {
+			retval = SDL_MapSurface(src, dst);
+		}
+		if ( retval < 0 ) {
+			/* SDL_MapSurface() set the error */
+		} else if ( (src->flags & SDL_HWACCEL) == SDL_HWACCEL ) {
+			for ( i = 0; i < n; ++i ) {
+				int status = SDL_LowerBlit(src, &pairs[i].src,
+				                           dst, &pairs[i].dst);
+				if ( status < 0 && retval == 0 ) {
+					retval = status;
+				}
+			}
+		} else {
+			retval = SDL_SoftBlitRects(src, dst, pairs, n);
+		}
+	}
+
+	if ( pairs != stackpairs ) {
+		SDL_free(pairs);
+	}
+	return(retval);
+}
+
 static int SDL_FillRect1(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 {
 	/* FIXME: We have to worry about packing order.. *sigh* */
@@ -545,15 +667,28 @@ static int SDL_FillRect4(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 	return -1;
 }
 
+static int SDL_FillHWRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_VideoDevice *this  = current_video;
+	SDL_Rect hw_rect;
+
+	if ( dst == SDL_VideoSurface ) {
+		hw_rect = *dstrect;
+		hw_rect.x += current_video->offset_x;
+		hw_rect.y += current_video->offset_y;
+		dstrect = &hw_rect;
+	}
+	return(video->FillHWRect(this, dst, dstrect, color));
+}
+
 /* 
  * This function performs a fast fill of the given rectangle with 'color'
  */
 int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 {
 	SDL_VideoDevice *video = current_video;
-	SDL_VideoDevice *this  = current_video;
-	int x, y;
-	Uint8 *row;
+	Uint8 pattern[SDL_FILL_PATTERN_SIZE];
 
 	/* This function doesn't work on surfaces < 8 bpp */
 	if ( dst->format->BitsPerPixel < 8 ) {
@@ -580,146 +715,74 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 	} else {
 		dstrect = &dst->clip_rect;
 	}
+	SDL_TRACK_DIRTY(dst, dstrect);
 
 	/* Check for hardware acceleration */
 	if ( ((dst->flags & SDL_HWSURFACE) == SDL_HWSURFACE) &&
 					video->info.blit_fill ) {
-		SDL_Rect hw_rect;
-		if ( dst == SDL_VideoSurface ) {
-			hw_rect = *dstrect;
-			hw_rect.x += current_video->offset_x;
-			hw_rect.y += current_video->offset_y;
-			dstrect = &hw_rect;
-		}
-		return(video->FillHWRect(this, dst, dstrect, color));
+		return(SDL_FillHWRect(dst, dstrect, color));
 	}
 
 	/* Perform software fill */
 	if ( SDL_LockSurface(dst) != 0 ) {
 		return(-1);
 	}
-	row = (Uint8 *)dst->pixels+dstrect->y*dst->pitch+
-			dstrect->x*dst->format->BytesPerPixel;
-	if ( dst->format->palette || (color == 0) ) {
-		x = dstrect->w*dst->format->BytesPerPixel;
-		if ( !color && !((uintptr_t)row&3) && !(x&3) && !(dst->pitch&3) ) {
-			int n = x >> 2;
-			for ( y=dstrect->h; y; --y ) {
-				SDL_memset4(row, 0, n);
-				row += dst->pitch;
+	SDL_InitFillPattern(pattern, dst->format->BytesPerPixel, color);
+	SDL_SoftFillRect(dst, dstrect, color, pattern);
+	SDL_UnlockSurface(dst);
+
+	/* We're done! */
+	return(0);
+}
+
+/*
+ * Fill several rectangles with one color, locking the surface only once
+ */
+int SDL_FillRects(SDL_Surface *dst, const SDL_Rect *rects, int numrects,
+							Uint32 color)
+{
+	SDL_VideoDevice *video = current_video;
+	Uint8 pattern[SDL_FILL_PATTERN_SIZE];
+	SDL_Rect rect;
+	int i, retval;
+
+	if ( ! dst || (! rects && numrects > 0) ) {
+		SDL_SetError("SDL_FillRects: passed a NULL pointer");
+		return(-1);
+	}
+	if ( dst->format->BitsPerPixel < 8 ) {
+		/* Let SDL_FillRect() report it */
+		return SDL_FillRect(dst, NULL, color);
+	}
+	if ( numrects <= 0 ) {
+		return(0);
+	}
+
+	/* Check for hardware acceleration */
+	if ( ((dst->flags & SDL_HWSURFACE) == SDL_HWSURFACE) &&
+					video->info.blit_fill ) {
+		retval = 0;
+		for ( i = 0; i < numrects; ++i ) {
+			if ( ! SDL_IntersectRect(&rects[i], &dst->clip_rect, &rect) ) {
+				continue;
 			}
-		} else {
-#ifdef __powerpc__
-			/*
-			 * SDL_memset() on PPC (both glibc and codewarrior) uses
-			 * the dcbz (Data Cache Block Zero) instruction, which
-			 * causes an alignment exception if the destination is
-			 * uncachable, so only use it on software surfaces
-			 */
-			if((dst->flags & SDL_HWSURFACE) == SDL_HWSURFACE) {
-				if(dstrect->w >= 8) {
-					/*
-					 * 64-bit stores are probably most
-					 * efficient to uncached video memory
-					 */
-					double fill;
-					SDL_memset(&fill, color, (sizeof fill));
-					for(y = dstrect->h; y; y--) {
-						Uint8 *d = row;
-						unsigned n = x;
-						unsigned nn;
-						Uint8 c = color;
-						double f = fill;
-						while((unsigned long)d
-						      & (sizeof(double) - 1)) {
-							*d++ = c;
-							n--;
-						}
-						nn = n / (sizeof(double) * 4);
-						while(nn) {
-							((double *)d)[0] = f;
-							((double *)d)[1] = f;
-							((double *)d)[2] = f;
-							((double *)d)[3] = f;
-							d += 4*sizeof(double);
-							nn--;
-						}
-						n &= ~(sizeof(double) * 4 - 1);
-						nn = n / sizeof(double);
-						while(nn) {
-							*(double *)d = f;
-							d += sizeof(double);
-							nn--;
-						}
-						n &= ~(sizeof(double) - 1);
-						while(n) {
-							*d++ = c;
-							n--;
-						}
-						row += dst->pitch;
-					}
-				} else {
-					/* narrow boxes */
-					for(y = dstrect->h; y; y--) {
-						Uint8 *d = row;
-						Uint8 c = color;
-						int n = x;
-						while(n) {
-							*d++ = c;
-							n--;
-						}
-						row += dst->pitch;
-					}
-				}
-			} else
-#endif /* __powerpc__ */
-			{
-				for(y = dstrect->h; y; y--) {
-					SDL_memset(row, color, x);
-					row += dst->pitch;
-				}
+			SDL_TRACK_DIRTY(dst, &rect);
+			if ( SDL_FillHWRect(dst, &rect, color) < 0 ) {
+				retval = -1;
 			}
 		}
-	} else {
-		switch (dst->format->BytesPerPixel) {
-		    case 2:
-			for ( y=dstrect->h; y; --y ) {
-				Uint16 *pixels = (Uint16 *)row;
-				Uint16 c = (Uint16)color;
-				Uint32 cc = (Uint32)c << 16 | c;
-				int n = dstrect->w;
-				if((uintptr_t)pixels & 3) {
-					*pixels++ = c;
-					n--;
-				}
-				if(n >> 1)
-					SDL_memset4(pixels, cc, n >> 1);
-				if(n & 1)
-					pixels[n - 1] = c;
-				row += dst->pitch;
-			}
-			break;
-
-		    case 3:
-			#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-				color <<= 8;
-			#endif
-			for ( y=dstrect->h; y; --y ) {
-				Uint8 *pixels = row;
-				for ( x=dstrect->w; x; --x ) {
-					SDL_memcpy(pixels, &color, 3);
-					pixels += 3;
-				}
-				row += dst->pitch;
-			}
-			break;
+		return(retval);
+	}
 
-		    case 4:
-			for(y = dstrect->h; y; --y) {
-				SDL_memset4(row, color, dstrect->w);
-				row += dst->pitch;
-			}
-			break;
+	/* Perform software fill */
+	if ( SDL_LockSurface(dst) != 0 ) {
+		return(-1);
+	}
+	SDL_InitFillPattern(pattern, dst->format->BytesPerPixel, color);
+	for ( i = 0; i < numrects; ++i ) {
+		if ( SDL_IntersectRect(&rects[i], &dst->clip_rect, &rect) ) {
+			SDL_TRACK_DIRTY(dst, &rect);
+			SDL_SoftFillRect(dst, &rect, color, pattern);
 		}
 	}
 	SDL_UnlockSurface(dst);
@@ -258,6 +258,14 @@ struct SDL_VideoDevice {
 	/* Handle any queued OS events */
 	void (*PumpEvents)(_THIS);
 
+	/* If not NULL, returns a descriptor that becomes readable when
+	   PumpEvents() has OS events to handle, or -1.  It is called by
+	   the thread that pumps, just before it sleeps, and may shorten
+	   'timeout' (ms, negative for forever), to 0 if events are
+	   already waiting.
+	*/
+	int (*GetEventFd)(_THIS, int *timeout);
+
 	/* * * */
 	/* Data common to all drivers */
 	SDL_Surface *screen;
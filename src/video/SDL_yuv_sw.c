@@ -85,6 +85,7 @@
 
 #include "SDL_video.h"
 #include "SDL_cpuinfo.h"
+#include "SDL_blit.h"
 #include "SDL_stretch_c.h"
 #include "SDL_yuvfuncs.h"
 #include "SDL_yuv_sw_c.h"
@@ -1163,6 +1164,44 @@ void SDL_UnlockYUV_SW(_THIS, SDL_Overlay *overlay)
 	return;
 }
 
+/* A conversion split into bands of row pairs for SDL_RunBlitBands() */
+typedef struct {
+	void (*display)(int *colortab, Uint32 *rgb_2_pix,
+	                unsigned char *lum, unsigned char *cr,
+	                unsigned char *cb, unsigned char *out,
+	                int rows, int cols, int mod );
+	struct private_yuvhwdata *swdata;
+	Uint8 *lum, *Cr, *Cb;
+	Uint8 *dstp;
+	int packed;		/* YUY2 style, otherwise planar YV12 */
+	int rows, cols, mod;
+	int dstrow;		/* bytes of output for one overlay row */
+} SDL_YUVBands;
+
+static void SDL_DisplayYUVBand(void *data, int pair, int pairs)
+{
+	SDL_YUVBands *bands = (SDL_YUVBands *)data;
+	int y = pair * 2;
+	int rows = pairs * 2;
+	int lumoff, croff;
+
+	/* The last band takes an odd row too */
+	if ( (y + rows) >= (bands->rows & ~1) ) {
+		rows = bands->rows - y;
+	}
+	if ( bands->packed ) {
+		lumoff = y * bands->cols * 2;
+		croff = lumoff;
+	} else {
+		lumoff = y * bands->cols;
+		croff = (y / 2) * (bands->cols / 2);
+	}
+	bands->display(bands->swdata->colortab, bands->swdata->rgb_2_pix,
+	               bands->lum + lumoff, bands->Cr + croff,
+	               bands->Cb + croff, bands->dstp + y * bands->dstrow,
+	               rows, bands->cols, bands->mod);
+}
+
 int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 {
 	struct private_yuvhwdata *swdata;
@@ -1172,6 +1211,7 @@ int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 	Uint8 *lum, *Cr, *Cb;
 	Uint8 *dstp;
 	int mod;
+	SDL_YUVBands bands;
 
 	swdata = overlay->hwdata;
 	stretch = 0;
@@ -1253,14 +1293,31 @@ int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 	}
 	mod = (display->pitch / display->format->BytesPerPixel);
 
+	bands.swdata = swdata;
+	bands.lum = lum;
+	bands.Cr = Cr;
+	bands.Cb = Cb;
+	bands.dstp = dstp;
+	bands.packed = (overlay->format != SDL_YV12_OVERLAY &&
+	                overlay->format != SDL_IYUV_OVERLAY);
+	bands.rows = overlay->h;
+	bands.cols = overlay->w;
+	bands.dstrow = mod * display->format->BytesPerPixel;
 	if ( scale_2x ) {
 		mod -= (overlay->w * 2);
-		swdata->Display2X(swdata->colortab, swdata->rgb_2_pix,
-		                  lum, Cr, Cb, dstp, overlay->h, overlay->w, mod);
+		bands.display = swdata->Display2X;
+		bands.dstrow *= 2;
 	} else {
 		mod -= overlay->w;
-		swdata->Display1X(swdata->colortab, swdata->rgb_2_pix,
-		                  lum, Cr, Cb, dstp, overlay->h, overlay->w, mod);
+		bands.display = swdata->Display1X;
+	}
+	bands.mod = mod;
+
+	/* Large overlays are converted on the thread pool */
+	if ( ! SDL_RunBlitBands(SDL_DisplayYUVBand, &bands,
+	                        overlay->w * 2, overlay->h / 2) ) {
+		bands.display(swdata->colortab, swdata->rgb_2_pix,
+		              lum, Cr, Cb, dstp, overlay->h, overlay->w, mod);
 	}
 	if ( SDL_MUSTLOCK(display) ) {
 		SDL_UnlockSurface(display);
@@ -92,7 +92,7 @@ void FULLSCREEN_PumpEvents(_THIS)
 	RISCOS_PollMouse(this);
 #if SDL_THREADS_DISABLED
 //	DRenderer_FillBuffers();
-	if (SDL_timer_running) RISCOS_CheckTimer();
+	if (SDL_AtomicGet(&SDL_timer_running)) RISCOS_CheckTimer();
 #endif
 }
 
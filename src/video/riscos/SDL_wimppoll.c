@@ -85,7 +85,7 @@ void WIMP_PumpEvents(_THIS)
 	if (hasFocus) RISCOS_PollKeyboard();
 	if (mouseInWindow) WIMP_PollMouse(this);
 #if SDL_THREADS_DISABLED
-	if (SDL_timer_running) RISCOS_CheckTimer();
+	if (SDL_AtomicGet(&SDL_timer_running)) RISCOS_CheckTimer();
 #endif
 }
 
@@ -325,6 +325,6 @@ void RISCOS_BackgroundTasks(void)
 		WIMP_Poll(current_video, 0);
 	}
 #if SDL_THREADS_DISABLED
-	if (SDL_timer_running) RISCOS_CheckTimer();
+	if (SDL_AtomicGet(&SDL_timer_running)) RISCOS_CheckTimer();
 #endif
 }
@@ -911,6 +911,24 @@ int X11_Pending(Display *display)
 	return(0);
 }
 
+int X11_GetEventFd(_THIS, int *timeout)
+{
+	/* Xlib may have read events already, select() wouldn't see them */
+	XFlush(SDL_Display);
+	if ( XEventsQueued(SDL_Display, QueuedAlready) ) {
+		*timeout = 0;
+	}
+
+	/* X11_PumpEvents() has timed work of its own */
+	if ( switch_waiting && (*timeout < 0 || *timeout > 200) ) {
+		*timeout = 200;
+	}
+	if ( !allow_screensaver && (*timeout < 0 || *timeout > 5000) ) {
+		*timeout = 5000;
+	}
+	return(ConnectionNumber(SDL_Display));
+}
+
 void X11_PumpEvents(_THIS)
 {
 	int pending;
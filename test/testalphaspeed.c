@@ -0,0 +1,240 @@
+/*
+ * Measures the throughput of the alpha blending blitters for the common
+ * surface formats.  Each case blits a full-size source onto a destination
+ * in memory, so no video mode is needed and the numbers reflect the
+ * blitter alone.  Before timing, each case checks that a full blit gives
+ * the same pixels as blitting a column at a time, which only runs the
+ * scalar code of the blitters.
+ *
+ *  Usage: testalphaspeed [--width w] [--height h] [--seconds n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+typedef struct {
+    const char *name;
+    int srcbpp;
+    Uint32 srcmasks[4];
+    int srcalpha;	/* -1 for per-pixel alpha */
+    int dstbpp;
+    Uint32 dstmasks[4];
+} AlphaTest;
+
+static const AlphaTest tests[] = {
+    { "ARGB8888 -> RGB888, pixel alpha", 32,
+      { 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 }, -1,
+      32, { 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 } },
+    { "ABGR8888 -> BGR888, pixel alpha", 32,
+      { 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000 }, -1,
+      32, { 0x000000FF, 0x0000FF00, 0x00FF0000, 0x00000000 } },
+    { "RGB888 -> RGB888, surface alpha 96", 32,
+      { 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 }, 96,
+      32, { 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 } },
+    { "RGB888 -> RGB888, surface alpha 128", 32,
+      { 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 }, 128,
+      32, { 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 } },
+    { "ARGB8888 -> RGB565, pixel alpha", 32,
+      { 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 }, -1,
+      16, { 0xF800, 0x07E0, 0x001F, 0x0000 } },
+    { "ARGB8888 -> RGB555, pixel alpha", 32,
+      { 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 }, -1,
+      16, { 0x7C00, 0x03E0, 0x001F, 0x0000 } },
+    { "RGB565 -> RGB565, surface alpha 96", 16,
+      { 0xF800, 0x07E0, 0x001F, 0x0000 }, 96,
+      16, { 0xF800, 0x07E0, 0x001F, 0x0000 } },
+    { "RGB555 -> RGB555, surface alpha 96", 16,
+      { 0x7C00, 0x03E0, 0x001F, 0x0000 }, 96,
+      16, { 0x7C00, 0x03E0, 0x001F, 0x0000 } },
+};
+
+static void fill_random(SDL_Surface *surface)
+{
+    int x, y;
+
+    SDL_LockSurface(surface);
+    for (y = 0; y < surface->h; y++)
+    {
+        Uint8 *row = (Uint8 *) surface->pixels + y * surface->pitch;
+        for (x = 0; x < surface->w * surface->format->BytesPerPixel; x++)
+            row[x] = (Uint8) rand();
+    }
+    SDL_UnlockSurface(surface);
+}
+
+/* Give a quarter of the pixels full and a quarter zero alpha, like sprites */
+static void shape_alpha(SDL_Surface *surface)
+{
+    int x, y;
+    Uint32 amask = surface->format->Amask;
+
+    SDL_LockSurface(surface);
+    for (y = 0; y < surface->h; y++)
+    {
+        Uint32 *row = (Uint32 *) ((Uint8 *) surface->pixels + y * surface->pitch);
+        for (x = 0; x < surface->w; x++)
+        {
+            switch ((x / 16 + y / 16) % 4)
+            {
+                case 0: row[x] &= ~amask; break;
+                case 1: row[x] |= amask; break;
+                default: break;
+            }
+        }
+    }
+    SDL_UnlockSurface(surface);
+}
+
+/* Compare a full blit with a blit a column at a time, where the vector
+   loops never run */
+static int check_test(const AlphaTest *test, SDL_Surface *src, SDL_Surface *dst)
+{
+    SDL_Surface *full;
+    SDL_Surface *columns;
+    int x, y, ok = 1;
+
+    full = SDL_ConvertSurface(dst, dst->format, SDL_SWSURFACE);
+    columns = SDL_ConvertSurface(dst, dst->format, SDL_SWSURFACE);
+    if (full == NULL || columns == NULL)
+    {
+        fprintf(stderr, "Couldn't copy surface: %s\n", SDL_GetError());
+        ok = 0;
+        goto done;
+    }
+
+    SDL_BlitSurface(src, NULL, full, NULL);
+    for (x = 0; x < src->w; x++)
+    {
+        SDL_Rect srcrect, dstrect;
+
+        srcrect.x = dstrect.x = x;
+        srcrect.y = dstrect.y = 0;
+        srcrect.w = 1;
+        srcrect.h = src->h;
+        SDL_BlitSurface(src, &srcrect, columns, &dstrect);
+    }
+
+    for (y = 0; y < full->h && ok; y++)
+    {
+        if (memcmp((Uint8 *) full->pixels + y * full->pitch,
+                   (Uint8 *) columns->pixels + y * columns->pitch,
+                   full->w * full->format->BytesPerPixel) != 0)
+        {
+            printf("%s: FAILED, row %d differs from the scalar blit\n",
+                   test->name, y);
+            ok = 0;
+        }
+    }
+
+done:
+    if (full) SDL_FreeSurface(full);
+    if (columns) SDL_FreeSurface(columns);
+    return ok;
+}
+
+static int run_test(const AlphaTest *test, int w, int h, int seconds)
+{
+    SDL_Surface *src;
+    SDL_Surface *dst;
+    Uint32 start, now, end;
+    Uint32 iterations = 0;
+    double mpixels;
+    int ok;
+
+    src = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, test->srcbpp,
+                               test->srcmasks[0], test->srcmasks[1],
+                               test->srcmasks[2], test->srcmasks[3]);
+    dst = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, test->dstbpp,
+                               test->dstmasks[0], test->dstmasks[1],
+                               test->dstmasks[2], test->dstmasks[3]);
+    if (src == NULL || dst == NULL)
+    {
+        fprintf(stderr, "Couldn't create surfaces: %s\n", SDL_GetError());
+        if (src) SDL_FreeSurface(src);
+        if (dst) SDL_FreeSurface(dst);
+        return 0;
+    }
+
+    fill_random(src);
+    fill_random(dst);
+    if (test->srcalpha < 0)
+    {
+        shape_alpha(src);
+        SDL_SetAlpha(src, SDL_SRCALPHA, 0);
+    }
+    else
+    {
+        SDL_SetAlpha(src, SDL_SRCALPHA, (Uint8) test->srcalpha);
+    }
+    ok = check_test(test, src, dst);
+
+    start = now = SDL_GetTicks();
+    end = start + seconds * 1000;
+    while (now < end)
+    {
+        SDL_BlitSurface(src, NULL, dst, NULL);
+        iterations++;
+        now = SDL_GetTicks();
+    }
+
+    mpixels = ((double) iterations * w * h) / 1000000.0;
+    printf("%-40s %6d blits, %8.1f Mpixels/s\n", test->name, (int) iterations,
+           mpixels / (((double) (now - start)) / 1000.0));
+
+    SDL_FreeSurface(src);
+    SDL_FreeSurface(dst);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    int w = 640;
+    int h = 480;
+    int seconds = 2;
+    int failed = 0;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--width") == 0) && (i + 1 < argc))
+            w = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--height") == 0) && (i + 1 < argc))
+            h = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--seconds") == 0) && (i + 1 < argc))
+            seconds = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--width w] [--height h] [--seconds n]\n", argv[0]);
+            return(1);
+        }
+    }
+
+    if (SDL_Init(0) < 0)
+    {
+        fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+        return(1);
+    }
+
+    printf("MMX %s, SSE2 %s, AVX2 %s\n",
+           SDL_HasMMX() ? "yes" : "no",
+           SDL_HasSSE2() ? "yes" : "no",
+           SDL_HasAVX2() ? "yes" : "no");
+    printf("Blitting %dx%d surfaces for %d seconds per case...\n", w, h, seconds);
+
+    for (i = 0; i < (int) (sizeof (tests) / sizeof (tests[0])); i++)
+        if (!run_test(&tests[i], w, h, seconds))
+            failed++;
+
+    if (failed)
+        printf("%d case%s FAILED\n", failed, failed == 1 ? "" : "s");
+    else
+        printf("All blits match the scalar path\n");
+
+    SDL_Quit();
+    return(failed ? 1 : 0);
+}
+
+/* end of testalphaspeed.c ... */
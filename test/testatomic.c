@@ -0,0 +1,147 @@
+
+/* Test of the atomic operations and spin locks.  Checks the basic
+   operations, then has several threads bump shared counters with
+   SDL_AtomicAdd(), a spin lock and a mutex, and reports how long each
+   took.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SDL.h"
+#include "SDL_atomic.h"
+
+#define NTHREADS	4
+#define NINCREMENTS	1000000
+
+static SDL_atomic_t counter;
+static SDL_SpinLock spinlock;
+static SDL_mutex *mutex;
+static int locked_counter;
+
+static int check(const char *what, int ok)
+{
+	printf("%-40s %s\n", what, ok ? "passed" : "FAILED");
+	return(ok ? 0 : 1);
+}
+
+static int TestBasics(void)
+{
+	SDL_atomic_t a = { 0 };
+	SDL_SpinLock lock = 0;
+	void *ptr = NULL;
+	int value = 0;
+	int failed = 0;
+
+	SDL_AtomicSet(&a, 10);
+	failed += check("SDL_AtomicSet()/SDL_AtomicGet()", SDL_AtomicGet(&a) == 10);
+	failed += check("SDL_AtomicCAS() with old value",
+	                SDL_AtomicCAS(&a, 10, 20) && SDL_AtomicGet(&a) == 20);
+	failed += check("SDL_AtomicCAS() with wrong value",
+	                !SDL_AtomicCAS(&a, 10, 30) && SDL_AtomicGet(&a) == 20);
+	failed += check("SDL_AtomicAdd()",
+	                SDL_AtomicAdd(&a, -5) == 20 && SDL_AtomicGet(&a) == 15);
+	SDL_AtomicSet(&a, 1);
+	SDL_AtomicIncRef(&a);
+	failed += check("SDL_AtomicIncRef()/SDL_AtomicDecRef()",
+	                !SDL_AtomicDecRef(&a) && SDL_AtomicDecRef(&a));
+	failed += check("SDL_AtomicCASPtr()",
+	                SDL_AtomicCASPtr(&ptr, NULL, &value) &&
+	                !SDL_AtomicCASPtr(&ptr, NULL, &a) &&
+	                SDL_AtomicGetPtr(&ptr) == &value);
+	failed += check("SDL_AtomicSetPtr()",
+	                SDL_AtomicSetPtr(&ptr, NULL) == &value && ptr == NULL);
+	failed += check("SDL_AtomicTryLock()",
+	                SDL_AtomicTryLock(&lock) && !SDL_AtomicTryLock(&lock));
+	SDL_AtomicUnlock(&lock);
+	failed += check("SDL_AtomicUnlock()", SDL_AtomicTryLock(&lock));
+	SDL_AtomicUnlock(&lock);
+	return(failed);
+}
+
+int SDLCALL AtomicThread(void *data)
+{
+	int i;
+
+	for ( i=0; i<NINCREMENTS; ++i ) {
+		SDL_AtomicAdd(&counter, 1);
+	}
+	return(0);
+}
+
+int SDLCALL SpinLockThread(void *data)
+{
+	int i;
+
+	for ( i=0; i<NINCREMENTS; ++i ) {
+		SDL_AtomicLock(&spinlock);
+		++locked_counter;
+		SDL_AtomicUnlock(&spinlock);
+	}
+	return(0);
+}
+
+int SDLCALL MutexThread(void *data)
+{
+	int i;
+
+	for ( i=0; i<NINCREMENTS; ++i ) {
+		SDL_mutexP(mutex);
+		++locked_counter;
+		SDL_mutexV(mutex);
+	}
+	return(0);
+}
+
+static void RunThreads(int (SDLCALL *fn)(void *))
+{
+	SDL_Thread *threads[NTHREADS];
+	int i;
+
+	for ( i=0; i<NTHREADS; ++i ) {
+		threads[i] = SDL_CreateThread(fn, NULL);
+	}
+	for ( i=0; i<NTHREADS; ++i ) {
+		SDL_WaitThread(threads[i], NULL);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	char name[64];
+	Uint32 start;
+	int failed;
+
+	if ( SDL_Init(0) < 0 ) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n",SDL_GetError());
+		return(1);
+	}
+	mutex = SDL_CreateMutex();
+
+	failed = TestBasics();
+
+	printf("%d threads adding %d each...\n", NTHREADS, NINCREMENTS);
+	start = SDL_GetTicks();
+	RunThreads(AtomicThread);
+	SDL_snprintf(name, sizeof(name), "SDL_AtomicAdd(), %d ms",
+	             (int)(SDL_GetTicks() - start));
+	failed += check(name, SDL_AtomicGet(&counter) == NTHREADS*NINCREMENTS);
+
+	locked_counter = 0;
+	start = SDL_GetTicks();
+	RunThreads(SpinLockThread);
+	SDL_snprintf(name, sizeof(name), "Spin lock, %d ms",
+	             (int)(SDL_GetTicks() - start));
+	failed += check(name, locked_counter == NTHREADS*NINCREMENTS);
+
+	locked_counter = 0;
+	start = SDL_GetTicks();
+	RunThreads(MutexThread);
+	SDL_snprintf(name, sizeof(name), "Mutex, %d ms",
+	             (int)(SDL_GetTicks() - start));
+	failed += check(name, locked_counter == NTHREADS*NINCREMENTS);
+
+	SDL_DestroyMutex(mutex);
+	SDL_Quit();
+	return(failed ? 1 : 0);
+}
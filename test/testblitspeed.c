@@ -12,6 +12,8 @@
 
 static SDL_Surface *dest = NULL;
 static SDL_Surface *src = NULL;
+static SDL_Surface *layers[8];
+static int numLayers = 0;
 static int testSeconds = 10;
 
 
@@ -255,6 +257,8 @@ static int setup_test(int argc, char **argv)
             screenSurface = 1;
         else if (strcmp(arg, "--dumpfile") == 0)
             dumpfile = argv[++i];
+        else if (strcmp(arg, "--layers") == 0)
+            numLayers = atoi(argv[++i]);
         /* !!! FIXME: set colorkey. */
         else if (0)  /* !!! FIXME: we handle some commandlines elsewhere now */
         {
@@ -295,6 +299,26 @@ static int setup_test(int argc, char **argv)
         return(0);
     }
 
+    /* offscreen layers to blit to in turn, every other one 16-bit... */
+    if (numLayers > (int) (sizeof (layers) / sizeof (layers[0])))
+        numLayers = (int) (sizeof (layers) / sizeof (layers[0]));
+    for (i = 0; i < numLayers; i++)
+    {
+        if (i & 1)
+            layers[i] = SDL_CreateRGBSurface(SDL_SWSURFACE, dstw, dsth, 16,
+                                             0xF800, 0x07E0, 0x001F, 0);
+        else
+            layers[i] = SDL_CreateRGBSurface(SDL_SWSURFACE, dstw, dsth,
+                                             dstbpp, dstrmask, dstgmask,
+                                             dstbmask, dstamask);
+        if (layers[i] == NULL)
+        {
+            fprintf(stderr, "layer creation failed: %s\n", SDL_GetError());
+            SDL_Quit();
+            return(0);
+        }
+    }
+
     src = SDL_CreateRGBSurface(srcflags, srcw, srch, srcbpp,
                                srcrmask, srcgmask, srcbmask, srcamask);
     if (src == NULL)
@@ -369,9 +393,13 @@ static void test_blit_speed(void)
     int wmax = (dest->w - src->w);
     int hmax = (dest->h - src->h);
     int isScreen = (SDL_GetVideoSurface() == dest);
+    Uint32 rebuilds = 0;
+    Uint32 reused = 0;
     SDL_Event event;
+    int i;
 
     printf("Testing blit speed for %d seconds...\n", testSeconds);
+    SDL_GetBlitMapStats(NULL, NULL);
 
     now = SDL_GetTicks();
     end = now + testms;
@@ -385,6 +413,8 @@ static void test_blit_speed(void)
             while (SDL_PollEvent(&event)) { /* no-op. */ }
         }
 
+        for (i = 0; i < numLayers; i++)
+            elasped += blit(layers[i], src, randRange(0, wmax), randRange(0, hmax));
         iterations++;
         elasped += blit(dest, src, randRange(0, wmax), randRange(0, hmax));
         if (isScreen)
@@ -403,6 +433,11 @@ static void test_blit_speed(void)
             (int) iterations,
             (int) elasped,
             (int) (((float)iterations) / (((float)elasped) / 1000.0f)));
+
+    SDL_GetBlitMapStats(&rebuilds, &reused);
+    printf("%d blit maps built, %d reused (%.2f built per frame).\n",
+            (int) rebuilds, (int) reused,
+            iterations ? ((float)rebuilds) / ((float)iterations) : 0.0f);
 }
 
 int main(int argc, char **argv)
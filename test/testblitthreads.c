@@ -0,0 +1,241 @@
+/*
+ * Measures how large blits scale with the number of blit threads.  Each
+ * case is run with SDL_BLIT_THREADS set to 1, 2, ... up to the requested
+ * thread count, on surfaces in memory so the numbers reflect the blitter
+ * alone.  Each run first checks a banded blit of up to 509x512 pixels
+ * against blitting it one column at a time, which runs neither the bands
+ * nor the vector loops.
+ *
+ *  Usage: testblitthreads [--width w] [--height h] [--seconds n] [--threads n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+typedef struct {
+    const char *name;
+    int srcbpp;
+    Uint32 srcmasks[4];
+    int srcalpha;	/* -1 for per-pixel alpha, 0 for none */
+    int colorkey;
+    int dstbpp;
+    Uint32 dstmasks[4];
+} ThreadTest;
+
+static const ThreadTest tests[] = {
+    { "RGB888 -> BGR888 conversion", 32,
+      { 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 }, 0, 0,
+      32, { 0x000000FF, 0x0000FF00, 0x00FF0000, 0x00000000 } },
+    { "RGB888 -> RGB565 conversion", 32,
+      { 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 }, 0, 0,
+      16, { 0xF800, 0x07E0, 0x001F, 0x0000 } },
+    { "RGB565 -> RGB888, colorkey", 16,
+      { 0xF800, 0x07E0, 0x001F, 0x0000 }, 0, 1,
+      32, { 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 } },
+    { "ARGB8888 -> RGB888, pixel alpha", 32,
+      { 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 }, -1, 0,
+      32, { 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 } },
+    { "RGB888 -> RGB888, surface alpha 96", 32,
+      { 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 }, 96, 0,
+      32, { 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 } },
+};
+
+static void fill_random(SDL_Surface *surface)
+{
+    int x, y;
+
+    SDL_LockSurface(surface);
+    for (y = 0; y < surface->h; y++)
+    {
+        Uint8 *row = (Uint8 *) surface->pixels + y * surface->pitch;
+        for (x = 0; x < surface->w * surface->format->BytesPerPixel; x++)
+            row[x] = (Uint8) rand();
+    }
+    SDL_UnlockSurface(surface);
+}
+
+static double time_blits(SDL_Surface *src, SDL_Surface *dst, int seconds)
+{
+    Uint32 start, now, end;
+    Uint32 iterations = 0;
+
+    start = now = SDL_GetTicks();
+    end = start + seconds * 1000;
+    while (now < end)
+    {
+        SDL_BlitSurface(src, NULL, dst, NULL);
+        iterations++;
+        now = SDL_GetTicks();
+    }
+    return ((double) iterations * src->w * src->h) / 1000.0 / (now - start);
+}
+
+static SDL_Surface *copy_surface(SDL_Surface *surface)
+{
+    SDL_Surface *copy = SDL_ConvertSurface(surface, surface->format,
+                                           SDL_SWSURFACE);
+    if (copy == NULL)
+    {
+        fprintf(stderr, "Couldn't copy surface: %s\n", SDL_GetError());
+        exit(1);
+    }
+    return copy;
+}
+
+static int same_pixels(SDL_Surface *a, SDL_Surface *b, const SDL_Rect *rect)
+{
+    int y;
+
+    for (y = rect->y; y < rect->y + rect->h; y++)
+    {
+        if (memcmp((Uint8 *) a->pixels + y * a->pitch,
+                   (Uint8 *) b->pixels + y * b->pitch,
+                   rect->w * a->format->BytesPerPixel) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+static int run_test(const ThreadTest *test, int w, int h, int seconds,
+                    int maxthreads)
+{
+    SDL_Surface *src;
+    SDL_Surface *dst;
+    SDL_Surface *columns;
+    SDL_Surface *scratch;
+    SDL_Rect area;
+    double base = 0.0;
+    int threads, x;
+    int ok = 1;
+
+    src = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, test->srcbpp,
+                               test->srcmasks[0], test->srcmasks[1],
+                               test->srcmasks[2], test->srcmasks[3]);
+    dst = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, test->dstbpp,
+                               test->dstmasks[0], test->dstmasks[1],
+                               test->dstmasks[2], test->dstmasks[3]);
+    if (src == NULL || dst == NULL)
+    {
+        fprintf(stderr, "Couldn't create surfaces: %s\n", SDL_GetError());
+        if (src) SDL_FreeSurface(src);
+        if (dst) SDL_FreeSurface(dst);
+        return 0;
+    }
+
+    fill_random(src);
+    fill_random(dst);
+    if (test->srcalpha < 0)
+        SDL_SetAlpha(src, SDL_SRCALPHA, 0);
+    else if (test->srcalpha > 0)
+        SDL_SetAlpha(src, SDL_SRCALPHA, (Uint8) test->srcalpha);
+    else
+        SDL_SetAlpha(src, 0, 0);
+    if (test->colorkey)
+        SDL_SetColorKey(src, SDL_SRCCOLORKEY, 0);
+
+    /* An odd width leaves pixels for the scalar tails */
+    area.x = 0;
+    area.y = 0;
+    area.w = (w < 509) ? w : 509;
+    area.h = (h < 512) ? h : 512;
+    /* dst stays as filled for the checks, the timed blits go to scratch */
+    columns = copy_surface(dst);
+    scratch = copy_surface(dst);
+    for (x = 0; x < area.w; x++)
+    {
+        SDL_Rect srcrect, dstrect;
+
+        srcrect.x = dstrect.x = x;
+        srcrect.y = dstrect.y = 0;
+        srcrect.w = 1;
+        srcrect.h = area.h;
+        SDL_BlitSurface(src, &srcrect, columns, &dstrect);
+    }
+
+    printf("%s\n", test->name);
+    for (threads = 1; threads <= maxthreads; threads++)
+    {
+        static char env[32];
+        SDL_Surface *full;
+        double mpixels;
+
+        SDL_snprintf(env, sizeof (env), "SDL_BLIT_THREADS=%d", threads);
+        SDL_putenv(env);
+        full = copy_surface(dst);
+        SDL_BlitSurface(src, &area, full, NULL);
+        if (!same_pixels(full, columns, &area))
+        {
+            printf("  %2d thread%s FAILED, differs from the scalar blit\n",
+                   threads, threads == 1 ? " " : "s");
+            ok = 0;
+        }
+        SDL_FreeSurface(full);
+        mpixels = time_blits(src, scratch, seconds);
+        if (threads == 1)
+            base = mpixels;
+        printf("  %2d thread%s %8.1f Mpixels/s  x%.2f\n", threads,
+               threads == 1 ? " " : "s", mpixels, mpixels / base);
+    }
+
+    SDL_FreeSurface(columns);
+    SDL_FreeSurface(scratch);
+    SDL_FreeSurface(src);
+    SDL_FreeSurface(dst);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    int w = 3840;
+    int h = 2160;
+    int seconds = 2;
+    int maxthreads = 4;
+    int failed = 0;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--width") == 0) && (i + 1 < argc))
+            w = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--height") == 0) && (i + 1 < argc))
+            h = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--seconds") == 0) && (i + 1 < argc))
+            seconds = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--threads") == 0) && (i + 1 < argc))
+            maxthreads = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--width w] [--height h] [--seconds n] [--threads n]\n", argv[0]);
+            return(1);
+        }
+    }
+
+    /* The blit threads belong to the video subsystem, but no window is
+       needed, so use the dummy driver unless told otherwise */
+    if (getenv("SDL_VIDEODRIVER") == NULL)
+        SDL_putenv("SDL_VIDEODRIVER=dummy");
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+        return(1);
+    }
+
+    printf("Blitting %dx%d surfaces for %d seconds per run...\n", w, h, seconds);
+
+    for (i = 0; i < (int) (sizeof (tests) / sizeof (tests[0])); i++)
+        if (!run_test(&tests[i], w, h, seconds, maxthreads))
+            failed++;
+
+    if (failed)
+        printf("%d case%s FAILED\n", failed, failed == 1 ? "" : "s");
+    else
+        printf("All blits match the scalar path\n");
+
+    SDL_Quit();
+    return(failed ? 1 : 0);
+}
+
+/* end of testblitthreads.c ... */
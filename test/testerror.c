@@ -1,5 +1,6 @@
 
-/* Simple test of the SDL threading code and error handling */
+/* Simple test of the SDL threading code, thread local storage and
+   error handling */
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,6 +10,7 @@
 #include "SDL_thread.h"
 
 static int alive = 0;
+static SDL_TLSID tls;
 
 /* Call this instead of exit(), so we can clean up SDL: atexit() is evil. */
 static void quit(int rc)
@@ -22,11 +24,13 @@ int SDLCALL ThreadFunc(void *data)
 	/* Set the child thread error string */
 	SDL_SetError("Thread %s (%d) had a problem: %s",
 			(char *)data, SDL_ThreadID(), "nevermind");
+	SDL_TLSSet(tls, "child value", NULL);
 	while ( alive ) {
 		printf("Thread '%s' is alive!\n", (char *)data);
 		SDL_Delay(1*1000);
 	}
 	printf("Child thread error string: %s\n", SDL_GetError());
+	printf("Child thread TLS value: %s\n", (char *)SDL_TLSGet(tls));
 	return(0);
 }
 
@@ -40,8 +44,10 @@ int main(int argc, char *argv[])
 		return(1);
 	}
 
-	/* Set the error value for the main thread */
+	/* Set the error value and thread local value for the main thread */
 	SDL_SetError("No worries");
+	tls = SDL_TLSCreate();
+	SDL_TLSSet(tls, "main value", NULL);
 
 	alive = 1;
 	thread = SDL_CreateThread(ThreadFunc, "#1");
@@ -55,6 +61,7 @@ int main(int argc, char *argv[])
 	SDL_WaitThread(thread, NULL);
 
 	printf("Main thread error string: %s\n", SDL_GetError());
+	printf("Main thread TLS value: %s\n", (char *)SDL_TLSGet(tls));
 
 	SDL_Quit();
 	return(0);
@@ -177,6 +177,37 @@ int main(int argc, char *argv[])
 														RWOP_ERR_QUIT(rwops);
 	rwops->close(rwops);
 	printf("test5 OK\n");
+
+/* test 6: the same file mapped, 64-bit seeks and read-ahead */
+	{
+		const char *data;
+		const void *borrowed;
+		size_t size;
+
+		rwops = SDL_RWFromFile(FBASENAME1,"rb");
+		if (!rwops)											RWOP_ERR_QUIT(rwops);
+		size = (size_t)SDL_RWsize(rwops);
+		if (0!=SDL_RWSetReadAhead(rwops,4))					RWOP_ERR_QUIT(rwops);
+		if (3!=rwops->read(rwops,test_buf,1,3))				RWOP_ERR_QUIT(rwops);
+		if (10!=SDL_RWseek64(rwops,7,RW_SEEK_CUR))			RWOP_ERR_QUIT(rwops);
+		if (10!=SDL_RWtell64(rwops))						RWOP_ERR_QUIT(rwops);
+		if (20!=rwops->read(rwops,test_buf,1,20))			RWOP_ERR_QUIT(rwops);
+		if (SDL_memcmp(test_buf,"12345678901234567123",20))	RWOP_ERR_QUIT(rwops);
+		rwops->close(rwops);
+
+		rwops = SDL_RWFromMappedFile(FBASENAME1);
+		if (!rwops)											RWOP_ERR_QUIT(rwops);
+		data = (const char *)SDL_RWMappedData(rwops,&size);
+		if (!data || size!=(size_t)SDL_RWsize(rwops))		RWOP_ERR_QUIT(rwops);
+		if (SDL_memcmp(data,"123456789012345678901234567123",30))
+															RWOP_ERR_QUIT(rwops);
+		if ((Sint64)size-3!=SDL_RWseek64(rwops,-3,RW_SEEK_END))	RWOP_ERR_QUIT(rwops);
+		if (3!=SDL_RWborrow(rwops,&borrowed,10))				RWOP_ERR_QUIT(rwops);
+		if (borrowed!=data+size-3)							RWOP_ERR_QUIT(rwops);
+		if (-1!=rwops->write(rwops,test_buf,1,1))			RWOP_ERR_QUIT(rwops); /* readonly */
+		rwops->close(rwops);
+	}
+	printf("test6 OK\n");
 	cleanup();
 	return 0; /* all ok */
 }
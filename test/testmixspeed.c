@@ -0,0 +1,235 @@
+/*
+ * Measures the throughput of the audio mixers.  Each case mixes a number
+ * of sources into one buffer, either a source at a time with
+ * SDL_MixAudioFormat() or all at once with SDL_MixAudioSources(), so no
+ * audio device is needed and the numbers reflect the mixer alone.  Both
+ * ways are first checked against mixing one sample at a time, which never
+ * runs the vector loops.
+ *
+ *  Usage: testmixspeed [--samples n] [--sources n] [--seconds n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+typedef struct {
+    const char *name;
+    Uint16 format;
+    int size;
+} MixTest;
+
+static const MixTest tests[] = {
+    { "U8", AUDIO_U8, 1 },
+    { "S8", AUDIO_S8, 1 },
+    { "S16LSB", AUDIO_S16LSB, 2 },
+    { "S16MSB", AUDIO_S16MSB, 2 },
+    { "S32LSB", AUDIO_S32LSB, 4 },
+    { "F32SYS", AUDIO_F32SYS, 4 },
+};
+
+static void fill_random(Uint8 *buf, const MixTest *test, int samples)
+{
+    int i;
+
+    if (test->format == AUDIO_F32SYS)
+    {
+        for (i = 0; i < samples; i++)
+            ((float *) buf)[i] = (rand() / (float) RAND_MAX) - 0.5f;
+    }
+    else
+    {
+        for (i = 0; i < samples * test->size; i++)
+            buf[i] = (Uint8) rand();
+    }
+}
+
+static void mix(const MixTest *test, Uint8 *dst, const Uint8 **srcs,
+                const int *volumes, int count, Uint32 len, int batched)
+{
+    int n;
+
+    if (batched)
+        SDL_MixAudioSources(dst, srcs, volumes, count, test->format, len);
+    else
+        for (n = 0; n < count; n++)
+            SDL_MixAudioFormat(dst, srcs[n], test->format, len, volumes[n]);
+}
+
+/* Compare a full mix with mixing one sample at a time */
+static int check_mix(const MixTest *test, const Uint8 *start,
+                     const Uint8 **srcs, const int *volumes, int count,
+                     int samples, int batched)
+{
+    Uint32 len = samples * test->size;
+    Uint8 *full = (Uint8 *) malloc(len);
+    Uint8 *scalar = (Uint8 *) malloc(len);
+    const Uint8 **offset = (const Uint8 **) malloc(count * sizeof (*offset));
+    int i, n;
+    int ok = 1;
+
+    if (full == NULL || scalar == NULL || offset == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    memcpy(full, start, len);
+    memcpy(scalar, start, len);
+    mix(test, full, srcs, volumes, count, len, batched);
+    for (i = 0; i < samples; i++)
+    {
+        for (n = 0; n < count; n++)
+            offset[n] = srcs[n] + i * test->size;
+        mix(test, scalar + i * test->size, offset, volumes, count,
+            test->size, batched);
+    }
+
+    for (i = 0; i < samples && ok; i++)
+    {
+        if (test->format == AUDIO_F32SYS)
+        {
+            /* Allow for a fused multiply and add in the C code */
+            float a = ((float *) full)[i];
+            float b = ((float *) scalar)[i];
+            ok = (a - b <= 1e-6f && b - a <= 1e-6f);
+        }
+        else
+        {
+            ok = (memcmp(full + i * test->size, scalar + i * test->size,
+                         test->size) == 0);
+        }
+        if (!ok)
+            printf("%-8s FAILED, sample %d %s differs from the scalar mix\n",
+                   test->name, i, batched ? "batched" : "one at a time");
+    }
+
+    free(full);
+    free(scalar);
+    free((void *) offset);
+    return ok;
+}
+
+static double time_mix(const MixTest *test, Uint8 *dst, const Uint8 **srcs,
+                       const int *volumes, int count, Uint32 len,
+                       int batched, int seconds)
+{
+    Uint32 start, now, end;
+    Uint32 iterations = 0;
+
+    start = now = SDL_GetTicks();
+    end = start + seconds * 1000;
+    while (now < end)
+    {
+        mix(test, dst, srcs, volumes, count, len, batched);
+        iterations++;
+        now = SDL_GetTicks();
+    }
+    return ((double) iterations * count * (len / test->size)) / 1000.0 / (now - start);
+}
+
+static int run_test(const MixTest *test, int samples, int count, int seconds)
+{
+    Uint32 len = samples * test->size;
+    Uint8 *dst;
+    const Uint8 **srcs;
+    int *volumes;
+    int n;
+    double single, batched;
+    int ok;
+
+    dst = (Uint8 *) malloc(len);
+    srcs = (const Uint8 **) malloc(count * sizeof (*srcs));
+    volumes = (int *) malloc(count * sizeof (*volumes));
+    if (dst == NULL || srcs == NULL || volumes == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    for (n = 0; n < count; n++)
+    {
+        Uint8 *src = (Uint8 *) malloc(len);
+        if (src == NULL)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+        fill_random(src, test, samples);
+        srcs[n] = src;
+        volumes[n] = SDL_MIX_MAXVOLUME / (n + 1);
+    }
+
+    fill_random(dst, test, samples);
+    ok = check_mix(test, dst, srcs, volumes, count, samples, 0);
+    if (!check_mix(test, dst, srcs, volumes, count, samples, 1))
+        ok = 0;
+    single = time_mix(test, dst, srcs, volumes, count, len, 0, seconds);
+    fill_random(dst, test, samples);
+    batched = time_mix(test, dst, srcs, volumes, count, len, 1, seconds);
+    printf("%-8s %8.1f Msamples/s one at a time, %8.1f Msamples/s batched\n",
+           test->name, single, batched);
+
+    for (n = 0; n < count; n++)
+        free((void *) srcs[n]);
+    free(srcs);
+    free(volumes);
+    free(dst);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    int samples = 4096;
+    int count = 8;
+    int seconds = 2;
+    int failed = 0;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--samples") == 0) && (i + 1 < argc))
+            samples = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--sources") == 0) && (i + 1 < argc))
+            count = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--seconds") == 0) && (i + 1 < argc))
+            seconds = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--samples n] [--sources n] [--seconds n]\n", argv[0]);
+            return(1);
+        }
+    }
+    if (samples <= 0 || count <= 0)
+    {
+        fprintf(stderr, "Nothing to mix\n");
+        return(1);
+    }
+
+    if (SDL_Init(0) < 0)
+    {
+        fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+        return(1);
+    }
+
+    printf("SSE2 %s, AVX2 %s, NEON %s\n",
+           SDL_HasSSE2() ? "yes" : "no",
+           SDL_HasAVX2() ? "yes" : "no",
+           SDL_HasNEON() ? "yes" : "no");
+    printf("Mixing %d sources of %d samples for %d seconds per run...\n",
+           count, samples, seconds);
+
+    for (i = 0; i < (int) (sizeof (tests) / sizeof (tests[0])); i++)
+        if (!run_test(&tests[i], samples, count, seconds))
+            failed++;
+
+    if (failed)
+        printf("%d format%s FAILED\n", failed, failed == 1 ? "" : "s");
+    else
+        printf("All mixes match the scalar path\n");
+
+    SDL_Quit();
+    return(failed ? 1 : 0);
+}
+
+/* end of testmixspeed.c ... */
@@ -131,6 +131,7 @@ int TestCPUInfo(SDL_bool verbose)
 {
 	if ( verbose ) {
 		printf("RDTSC %s\n", SDL_HasRDTSC() ? "detected" : "not detected");
+		printf("Invariant TSC %s\n", SDL_HasInvariantTSC() ? "detected" : "not detected");
 		printf("MMX %s\n", SDL_HasMMX() ? "detected" : "not detected");
 		printf("MMX Ext %s\n", SDL_HasMMXExt() ? "detected" : "not detected");
 		printf("3DNow %s\n", SDL_Has3DNow() ? "detected" : "not detected");
@@ -138,6 +139,18 @@ int TestCPUInfo(SDL_bool verbose)
 		printf("SSE %s\n", SDL_HasSSE() ? "detected" : "not detected");
 		printf("SSE2 %s\n", SDL_HasSSE2() ? "detected" : "not detected");
 		printf("AltiVec %s\n", SDL_HasAltiVec() ? "detected" : "not detected");
+		printf("AVX2 %s\n", SDL_HasAVX2() ? "detected" : "not detected");
+		printf("SSSE3 %s\n", SDL_HasSSSE3() ? "detected" : "not detected");
+		printf("SSE4.1 %s\n", SDL_HasSSE41() ? "detected" : "not detected");
+		printf("NEON %s\n", SDL_HasNEON() ? "detected" : "not detected");
+		printf("SSE3 %s\n", SDL_HasSSE3() ? "detected" : "not detected");
+		printf("SSE4.2 %s\n", SDL_HasSSE42() ? "detected" : "not detected");
+		printf("AVX %s\n", SDL_HasAVX() ? "detected" : "not detected");
+		printf("AVX-512F %s\n", SDL_HasAVX512F() ? "detected" : "not detected");
+		printf("%d CPU%s, %d core%s\n", SDL_GetCPUCount(), SDL_GetCPUCount() == 1 ? "" : "s",
+		       SDL_GetCPUCoreCount(), SDL_GetCPUCoreCount() == 1 ? "" : "s");
+		printf("%d byte cache lines\n", SDL_GetCPUCacheLineSize());
+		printf("%d MB of RAM\n", SDL_GetSystemRAM());
 	}
 	return(0);
 }
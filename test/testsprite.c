@@ -19,6 +19,8 @@ SDL_Rect *positions;
 SDL_Rect *velocities;
 int sprites_visible;
 int debug_flip;
+int batch_blits;
+int dirty_rects;
 Uint16 sprite_w, sprite_h;
 
 /* Call this instead of exit(), so we can clean up SDL: atexit() is evil. */
@@ -67,7 +69,12 @@ void MoveSprites(SDL_Surface *screen, Uint32 background)
 	nupdates = 0;
 	/* Erase all the sprites if necessary */
 	if ( sprites_visible ) {
-		SDL_FillRect(screen, NULL, background);
+		if ( dirty_rects ) {
+			/* Only where they were, the fills are tracked */
+			SDL_FillRects(screen, sprite_rects, numsprites, background);
+		} else {
+			SDL_FillRect(screen, NULL, background);
+		}
 	}
 
 	/* Move the sprite, bounce at the wall, and draw */
@@ -87,9 +94,16 @@ void MoveSprites(SDL_Surface *screen, Uint32 background)
 
 		/* Blit the sprite onto the screen */
 		area = *position;
-		SDL_BlitSurface(sprite, NULL, screen, &area);
+		if ( ! batch_blits ) {
+			SDL_BlitSurface(sprite, NULL, screen, &area);
+		}
 		sprite_rects[nupdates++] = area;
 	}
+	if ( batch_blits ) {
+		/* Draw them all at once, clipping the update rects */
+		SDL_BlitSurfaceRects(sprite, NULL, screen,
+		                     sprite_rects, nupdates, 0);
+	}
 
 	if (debug_flip) {
 		if ( (screen->flags & SDL_DOUBLEBUF) == SDL_DOUBLEBUF ) {
@@ -110,6 +124,8 @@ void MoveSprites(SDL_Surface *screen, Uint32 background)
 	/* Update the screen! */
 	if ( (screen->flags & SDL_DOUBLEBUF) == SDL_DOUBLEBUF ) {
 		SDL_Flip(screen);
+	} else if ( dirty_rects ) {
+		SDL_UpdateDirtyRects(screen);
 	} else {
 		SDL_UpdateRects(screen, nupdates, sprite_rects);
 	}
@@ -202,11 +218,17 @@ int main(int argc, char *argv[])
 		if ( strcmp(argv[argc], "-fullscreen") == 0 ) {
 			videoflags ^= SDL_FULLSCREEN;
 		} else
+		if ( strcmp(argv[argc], "-batch") == 0 ) {
+			batch_blits ^= 1;
+		} else
+		if ( strcmp(argv[argc], "-dirty") == 0 ) {
+			dirty_rects ^= 1;
+		} else
 		if ( isdigit(argv[argc][0]) ) {
 			numsprites = atoi(argv[argc]);
 		} else {
 			fprintf(stderr, 
-	"Usage: %s [-bpp N] [-hw] [-flip] [-fast] [-fullscreen] [numsprites]\n",
+	"Usage: %s [-bpp N] [-hw] [-flip] [-fast] [-fullscreen] [-batch] [-dirty] [numsprites]\n",
 								argv[0]);
 			quit(1);
 		}
@@ -285,6 +307,11 @@ int main(int argc, char *argv[])
 		printf("Sprite blit uses RLE acceleration\n");
 	}
 
+	/* Let SDL work out what to update from the blits and fills */
+	if ( dirty_rects ) {
+		SDL_TrackDirtyRects(screen, 1);
+	}
+
 	/* Loop, blitting sprites and waiting for a keystroke */
 	frames = 0;
 	then = SDL_GetTicks();
@@ -318,6 +345,13 @@ int main(int argc, char *argv[])
 		printf("%2.2f frames per second\n",
 					((double)frames*1000)/(now-then));
 	}
+	if ( dirty_rects && frames > 0 ) {
+		Uint32 rectsin, rectsout, pixels;
+
+		SDL_GetDirtyRectStats(&rectsin, &rectsout, &pixels);
+		printf("%d dirty rects merged into %d, %d pixels per frame\n",
+		       rectsin/frames, rectsout/frames, pixels/frames);
+	}
 	SDL_Quit();
 	return(0);
 }
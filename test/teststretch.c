@@ -0,0 +1,349 @@
+/*
+ * Measures the throughput of SDL_SoftStretchFiltered() for each filter,
+ * shrinking and growing 16 and 32-bit surfaces in memory.  The output size
+ * is counted, so shrinking and growing numbers can be compared directly.
+ * The bilinear and box filtered results are first checked against a plain
+ * C version of the filter.  A few channels may be one off where the
+ * compiler fuses the multiply and add differently.
+ *
+ *  Usage: teststretch [--width w] [--height h] [--seconds n] [--threads n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+typedef struct {
+    const char *name;
+    int bpp;
+    Uint32 masks[4];
+} StretchFormat;
+
+static const StretchFormat formats[] = {
+    { "RGB565", 16, { 0xF800, 0x07E0, 0x001F, 0x0000 } },
+    { "ARGB8888", 32, { 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 } },
+};
+
+static const struct {
+    const char *name;
+    SDL_StretchFilter filter;
+} filters[] = {
+    { "nearest", SDL_STRETCH_NEAREST },
+    { "bilinear", SDL_STRETCH_BILINEAR },
+    { "box", SDL_STRETCH_BOX },
+};
+
+/* Scale factors from the source size, in percent */
+static const int scales[] = { 25, 50, 75, 150, 200 };
+
+static void fill_random(SDL_Surface *surface)
+{
+    int x, y;
+
+    SDL_LockSurface(surface);
+    for (y = 0; y < surface->h; y++)
+    {
+        Uint8 *row = (Uint8 *) surface->pixels + y * surface->pitch;
+        for (x = 0; x < surface->w * surface->format->BytesPerPixel; x++)
+            row[x] = (Uint8) rand();
+    }
+    SDL_UnlockSurface(surface);
+}
+
+/* Where each destination pixel comes from along one axis, as the library
+   works it out */
+static int build_axis(int srclen, int dstlen, SDL_StretchFilter filter,
+                      int *first, float *weights)
+{
+    const double scale = (double) srclen / dstlen;
+    int taps, i, j;
+
+    taps = (filter == SDL_STRETCH_BOX) ? (srclen + dstlen - 1) / dstlen + 1 : 2;
+    for (i = 0; i < dstlen; i++)
+    {
+        float *w = &weights[i * taps];
+
+        if (filter == SDL_STRETCH_BOX)
+        {
+            double start = i * scale;
+            double end = (i + 1) * scale;
+
+            first[i] = (int) start;
+            for (j = 0; j < taps; j++)
+            {
+                double lo = first[i] + j;
+                double hi = lo + 1.0;
+
+                if (lo < start) lo = start;
+                if (hi > end) hi = end;
+                w[j] = ((first[i] + j) < srclen && hi > lo) ?
+                       (float) ((hi - lo) / scale) : 0.0f;
+            }
+        }
+        else
+        {
+            double center = (i + 0.5) * scale - 0.5;
+
+            if (center < 0.0)
+                center = 0.0;
+            first[i] = (int) center;
+            if (first[i] >= srclen - 1)
+            {
+                first[i] = srclen - 1;
+                center = first[i];
+            }
+            w[0] = (float) (1.0 - (center - first[i]));
+            w[1] = (float) (center - first[i]);
+        }
+    }
+    return taps;
+}
+
+/* Channel c of pixel x in a row, bytes for 32-bit pixels and the raw
+   fields of 16-bit ones */
+static int get_channel(const SDL_Surface *surface, const Uint8 *row, int x, int c)
+{
+    const SDL_PixelFormat *fmt = surface->format;
+    Uint32 pixel;
+
+    if (fmt->BytesPerPixel == 4)
+        return row[x * 4 + c];
+    pixel = ((const Uint16 *) row)[x];
+    switch (c)
+    {
+        case 0: return (pixel & fmt->Rmask) >> fmt->Rshift;
+        case 1: return (pixel & fmt->Gmask) >> fmt->Gshift;
+        case 2: return (pixel & fmt->Bmask) >> fmt->Bshift;
+        default: return (pixel & fmt->Amask) >> fmt->Ashift;
+    }
+}
+
+/* Filter the rows, then the columns, like the library does */
+static int check_stretch(SDL_Surface *src, SDL_Surface *dst,
+                         SDL_StretchFilter filter)
+{
+    int *xfirst, *yfirst;
+    float *xweights, *yweights, *row;
+    int xtaps, ytaps, x, y, c, i;
+    int near = 0;
+    int ok = 1;
+
+    xfirst = (int *) malloc(dst->w * sizeof (int));
+    yfirst = (int *) malloc(dst->h * sizeof (int));
+    xweights = (float *) malloc(dst->w * (src->w / dst->w + 2) * sizeof (float));
+    yweights = (float *) malloc(dst->h * (src->h / dst->h + 2) * sizeof (float));
+    row = (float *) malloc(src->w * 4 * sizeof (float));
+    if (!xfirst || !yfirst || !xweights || !yweights || !row)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    xtaps = build_axis(src->w, dst->w, filter, xfirst, xweights);
+    ytaps = build_axis(src->h, dst->h, filter, yfirst, yweights);
+
+    for (y = 0; y < dst->h && ok; y++)
+    {
+        const Uint8 *dstrow = (const Uint8 *) dst->pixels + y * dst->pitch;
+
+        memset(row, 0, src->w * 4 * sizeof (float));
+        for (i = 0; i < ytaps; i++)
+        {
+            const float weight = yweights[y * ytaps + i];
+            const Uint8 *srcrow;
+
+            if (weight == 0.0f)
+                continue;
+            srcrow = (const Uint8 *) src->pixels + (yfirst[y] + i) * src->pitch;
+            for (x = 0; x < src->w; x++)
+                for (c = 0; c < 4; c++)
+                    row[x * 4 + c] += weight * get_channel(src, srcrow, x, c);
+        }
+        for (x = 0; x < dst->w && ok; x++)
+        {
+            for (c = 0; c < 4; c++)
+            {
+                float sum = 0.0f;
+                int expect, got;
+
+                for (i = 0; i < xtaps; i++)
+                {
+                    int sx = xfirst[x] + i;
+
+                    if (sx < src->w)
+                        sum += xweights[x * xtaps + i] * row[sx * 4 + c];
+                }
+                expect = (int) (sum + 0.5f);
+                if (expect > 255)
+                    expect = 255;
+                got = get_channel(dst, dstrow, x, c);
+                if (dst->format->BytesPerPixel == 2)
+                {
+                    /* The packed field only keeps the low bits */
+                    Uint32 mask = (c == 0) ? dst->format->Rmask :
+                                  (c == 1) ? dst->format->Gmask :
+                                  (c == 2) ? dst->format->Bmask :
+                                             dst->format->Amask;
+                    int shift = (c == 0) ? dst->format->Rshift :
+                                (c == 1) ? dst->format->Gshift :
+                                (c == 2) ? dst->format->Bshift :
+                                           dst->format->Ashift;
+                    expect = ((expect << shift) & mask) >> shift;
+                }
+                if (got == expect - 1 || got == expect + 1)
+                {
+                    near++;
+                }
+                else if (got != expect)
+                {
+                    printf("FAILED at %d,%d channel %d: got %d, expected %d\n",
+                           x, y, c, got, expect);
+                    ok = 0;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (ok && near > dst->w * dst->h * 4 / 1000)
+    {
+        printf("FAILED: %d channels are one off\n", near);
+        ok = 0;
+    }
+
+    free(xfirst);
+    free(yfirst);
+    free(xweights);
+    free(yweights);
+    free(row);
+    return ok;
+}
+
+static int run_test(const StretchFormat *format, int w, int h, int scale,
+                    int seconds)
+{
+    SDL_Surface *src;
+    SDL_Surface *dst;
+    int i;
+    int ok = 1;
+
+    src = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, format->bpp,
+                               format->masks[0], format->masks[1],
+                               format->masks[2], format->masks[3]);
+    dst = SDL_CreateRGBSurface(SDL_SWSURFACE, w * scale / 100,
+                               h * scale / 100, format->bpp,
+                               format->masks[0], format->masks[1],
+                               format->masks[2], format->masks[3]);
+    if (src == NULL || dst == NULL)
+    {
+        fprintf(stderr, "Couldn't create surfaces: %s\n", SDL_GetError());
+        if (src) SDL_FreeSurface(src);
+        if (dst) SDL_FreeSurface(dst);
+        return 0;
+    }
+    fill_random(src);
+
+    for (i = 0; i < (int) (sizeof (filters) / sizeof (filters[0])); i++)
+    {
+        Uint32 start, now, end;
+        Uint32 iterations = 0;
+        double mpixels;
+
+        if (filters[i].filter != SDL_STRETCH_NEAREST)
+        {
+            if (SDL_SoftStretchFiltered(src, NULL, dst, NULL,
+                                        filters[i].filter) < 0 ||
+                !check_stretch(src, dst, filters[i].filter))
+            {
+                printf("%-8s %3d%% %-8s FAILED\n",
+                       format->name, scale, filters[i].name);
+                ok = 0;
+            }
+        }
+
+        start = now = SDL_GetTicks();
+        end = start + seconds * 1000;
+        while (now < end)
+        {
+            if (SDL_SoftStretchFiltered(src, NULL, dst, NULL,
+                                        filters[i].filter) < 0)
+            {
+                fprintf(stderr, "Stretch failed: %s\n", SDL_GetError());
+                break;
+            }
+            iterations++;
+            now = SDL_GetTicks();
+        }
+
+        mpixels = ((double) iterations * dst->w * dst->h) / 1000000.0;
+        printf("%-8s %3d%% %-8s %6d stretches, %8.1f Mpixels/s\n",
+               format->name, scale, filters[i].name, (int) iterations,
+               mpixels / (((double) (now - start)) / 1000.0));
+    }
+
+    SDL_FreeSurface(src);
+    SDL_FreeSurface(dst);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    int w = 1920;
+    int h = 1080;
+    int seconds = 1;
+    int threads = 0;
+    int failed = 0;
+    int i, j;
+
+    for (i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--width") == 0) && (i + 1 < argc))
+            w = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--height") == 0) && (i + 1 < argc))
+            h = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--seconds") == 0) && (i + 1 < argc))
+            seconds = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--threads") == 0) && (i + 1 < argc))
+            threads = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--width w] [--height h] [--seconds n] [--threads n]\n", argv[0]);
+            return(1);
+        }
+    }
+
+    if (threads > 0)
+    {
+        static char env[32];
+        SDL_snprintf(env, sizeof (env), "SDL_BLIT_THREADS=%d", threads);
+        SDL_putenv(env);
+    }
+
+    /* The blit threads belong to the video subsystem, but no window is
+       needed, so use the dummy driver unless told otherwise */
+    if (getenv("SDL_VIDEODRIVER") == NULL)
+        SDL_putenv("SDL_VIDEODRIVER=dummy");
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+        return(1);
+    }
+
+    printf("Stretching %dx%d surfaces for %d seconds per case...\n", w, h, seconds);
+
+    for (i = 0; i < (int) (sizeof (formats) / sizeof (formats[0])); i++)
+        for (j = 0; j < (int) (sizeof (scales) / sizeof (scales[0])); j++)
+            if (!run_test(&formats[i], w, h, scales[j], seconds))
+                failed++;
+
+    if (failed)
+        printf("%d case%s FAILED\n", failed, failed == 1 ? "" : "s");
+    else
+        printf("All filtered stretches match the C filter\n");
+
+    SDL_Quit();
+    return(failed ? 1 : 0);
+}
+
+/* end of teststretch.c ... */
@@ -0,0 +1,170 @@
+/*
+ * Checks the thread pool and measures how it scales.  Each case is run
+ * with SDL_THREADPOOL_THREADS set to 1, 2, ... up to the requested thread
+ * count:  a parallel-for over the rows of a Mandelbrot image, a batch of
+ * small tasks in a task group, and tasks that add more tasks.
+ *
+ *  Usage: testthreadpool [--size n] [--tasks n] [--threads n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+static int size = 1024;
+static int ntasks = 100000;
+static Uint8 *image;
+static SDL_atomic_t done;
+
+static void SDLCALL mandelbrot_rows(void *data, int start, int end)
+{
+    int x, y, i;
+
+    for (y = start; y < end; y++)
+    {
+        for (x = 0; x < size; x++)
+        {
+            double cr = (x * 3.0) / size - 2.0;
+            double ci = (y * 2.0) / size - 1.0;
+            double zr = 0.0, zi = 0.0;
+
+            for (i = 0; i < 255 && (zr * zr + zi * zi) < 4.0; i++)
+            {
+                double t = zr * zr - zi * zi + cr;
+                zi = 2.0 * zr * zi + ci;
+                zr = t;
+            }
+            image[y * size + x] = (Uint8) i;
+        }
+    }
+}
+
+static void SDLCALL small_task(void *data)
+{
+    SDL_AtomicAdd(&done, 1);
+}
+
+/* Splits its share in two until it's small, like a recursive sort */
+static void SDLCALL split_task(void *data)
+{
+    int count = (int) (size_t) data;
+
+    if (count <= 64)
+    {
+        SDL_AtomicAdd(&done, count);
+        return;
+    }
+    {
+        SDL_TaskGroup *group = SDL_CreateTaskGroup();
+
+        SDL_AddTask(group, split_task, (void *) (size_t) (count / 2));
+        split_task((void *) (size_t) (count - count / 2));
+        SDL_DestroyTaskGroup(group);
+    }
+}
+
+static double run_case(int which, int *ok)
+{
+    SDL_TaskGroup *group;
+    Uint32 start;
+    Uint32 sum = 0;
+    int i;
+
+    SDL_AtomicSet(&done, 0);
+    start = SDL_GetTicks();
+    switch (which)
+    {
+        case 0:
+            SDL_ParallelFor(0, size, 0, mandelbrot_rows, NULL);
+            for (i = 0; i < size * size; i++)
+                sum += image[i];
+            *ok = (sum != 0);
+            break;
+        case 1:
+            group = SDL_CreateTaskGroup();
+            for (i = 0; i < ntasks; i++)
+                SDL_AddTask(group, small_task, NULL);
+            SDL_DestroyTaskGroup(group);
+            *ok = (SDL_AtomicGet(&done) == ntasks);
+            break;
+        case 2:
+            split_task((void *) (size_t) (ntasks * 64));
+            *ok = (SDL_AtomicGet(&done) == ntasks * 64);
+            break;
+    }
+    return (double) (SDL_GetTicks() - start);
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *names[] = {
+        "Mandelbrot parallel-for",
+        "Small tasks in a group",
+        "Tasks adding tasks",
+    };
+    int maxthreads = 4;
+    int which, threads, i;
+    int failed = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--size") == 0) && (i + 1 < argc))
+            size = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--tasks") == 0) && (i + 1 < argc))
+            ntasks = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--threads") == 0) && (i + 1 < argc))
+            maxthreads = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--size n] [--tasks n] [--threads n]\n", argv[0]);
+            return(1);
+        }
+    }
+
+    image = (Uint8 *) malloc(size * size);
+    if (image == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return(1);
+    }
+    printf("%d CPU cores\n", SDL_GetCPUCount());
+
+    for (which = 0; which < 3; which++)
+    {
+        double base = 0.0;
+
+        printf("%s\n", names[which]);
+        for (threads = 1; threads <= maxthreads; threads++)
+        {
+            static char env[64];
+            double ms;
+            int ok = 0;
+
+            /* The pool is sized when it starts and stopped by SDL_Quit() */
+            SDL_snprintf(env, sizeof (env), "SDL_THREADPOOL_THREADS=%d", threads);
+            SDL_putenv(env);
+            if (SDL_Init(0) < 0)
+            {
+                fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+                return(1);
+            }
+            SDL_GetThreadPoolSize();	/* start it outside the timing */
+            ms = run_case(which, &ok);
+            if (threads == 1)
+                base = ms;
+            printf("  %2d thread%s %8.1f ms  x%.2f  %s\n", threads,
+                   threads == 1 ? " " : "s", ms, ms > 0.0 ? base / ms : 0.0,
+                   ok ? "passed" : "FAILED");
+            if (!ok)
+                failed = 1;
+            SDL_Quit();
+        }
+    }
+
+    free(image);
+    return(failed);
+}
+
+/* end of testthreadpool.c ... */
@@ -1,10 +1,18 @@
 
 /* Test program to check the resolution of the SDL timer on the current
    platform
+
+   With --jitter it instead runs many timers at once and reports how late
+   their callbacks are, then how closely SDL_Delay() and SDL_DelayPrecise()
+   wait for a 60 Hz frame:  testtimer --jitter [timers] [seconds]
+   It first checks that timers fire in deadline order, that one-shot timers
+   fire once and can still be passed to SDL_RemoveTimer() afterwards, even
+   once a new timer has been added, and that removed timers don't fire.
 */
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "SDL.h"
 
@@ -24,6 +32,189 @@ static Uint32 SDLCALL callback(Uint32 interval, void *param)
   return interval;
 }
 
+/* The current time in ms from the high resolution counter */
+static double now_ms(void)
+{
+	static double frequency = 0.0;
+
+	if ( frequency == 0.0 ) {
+		frequency = (double)SDL_GetPerformanceFrequency();
+	}
+	return((double)SDL_GetPerformanceCounter() * 1000.0 / frequency);
+}
+
+static SDL_atomic_t fired[4];
+static SDL_atomic_t fire_order;
+static int order[4];
+
+/* Records when it ran, then stops */
+static Uint32 SDLCALL oneshot_callback(Uint32 interval, void *param)
+{
+	int which = (int)(uintptr_t)param;
+
+	if ( SDL_AtomicAdd(&fired[which], 1) == 0 ) {
+		order[which] = SDL_AtomicAdd(&fire_order, 1);
+	}
+	return(0);
+}
+
+/* Removes itself the second time it runs */
+static SDL_TimerID self_id;
+static Uint32 SDLCALL self_remove_callback(Uint32 interval, void *param)
+{
+	if ( SDL_AtomicAdd(&fired[3], 1) == 1 ) {
+		SDL_RemoveTimer(self_id);
+	}
+	return(interval);
+}
+
+static int check(const char *what, int ok)
+{
+	printf("%-50s %s\n", what, ok ? "passed" : "FAILED");
+	return(ok ? 0 : 1);
+}
+
+static int check_timers(void)
+{
+	SDL_TimerID ids[3], later;
+	int i, failed = 0;
+
+	for ( i = 0; i < 4; ++i ) {
+		SDL_AtomicSet(&fired[i], 0);
+	}
+	SDL_AtomicSet(&fire_order, 0);
+
+	/* Added out of order, they must fire by deadline */
+	ids[0] = SDL_AddTimer(60, oneshot_callback, (void *)0);
+	ids[1] = SDL_AddTimer(20, oneshot_callback, (void *)1);
+	ids[2] = SDL_AddTimer(40, oneshot_callback, (void *)2);
+	self_id = SDL_AddTimer(10, self_remove_callback, NULL);
+	failed += check("SDL_AddTimer()", ids[0] && ids[1] && ids[2] && self_id);
+	failed += check("SDL_RemoveTimer() on a pending timer",
+	                SDL_RemoveTimer(ids[2]) == SDL_TRUE);
+	SDL_Delay(300);
+
+	failed += check("One-shot timers fired once",
+	                SDL_AtomicGet(&fired[0]) == 1 &&
+	                SDL_AtomicGet(&fired[1]) == 1);
+	failed += check("Timers fired in deadline order", order[1] < order[0]);
+	failed += check("Removed timer didn't fire", SDL_AtomicGet(&fired[2]) == 0);
+	failed += check("Timer removed from its callback stopped",
+	                SDL_AtomicGet(&fired[3]) == 2);
+	/* These were freed when they fired or removed themselves, and a new
+	   timer may take their place */
+	later = SDL_AddTimer(10000, oneshot_callback, (void *)2);
+	failed += check("SDL_RemoveTimer() on fired one-shot timers",
+	                SDL_RemoveTimer(ids[0]) == SDL_FALSE &&
+	                SDL_RemoveTimer(ids[1]) == SDL_FALSE &&
+	                SDL_RemoveTimer(self_id) == SDL_FALSE);
+	failed += check("SDL_RemoveTimer() on a removed timer",
+	                SDL_RemoveTimer(ids[2]) == SDL_FALSE);
+	failed += check("Old IDs didn't remove a new timer",
+	                later && SDL_RemoveTimer(later) == SDL_TRUE);
+	return(failed);
+}
+
+typedef struct {
+	double expected;
+	Uint32 calls;
+	Uint32 behind;
+	double late_total;
+	double late_max;
+} JitterTimer;
+
+static Uint32 SDLCALL jitter_callback(Uint32 interval, void *param)
+{
+	JitterTimer *timer = (JitterTimer *)param;
+	double now = now_ms();
+	double late = now - timer->expected;
+
+	++timer->calls;
+	if ( late < 0.0 ) {
+		/* We lost track of the schedule after falling behind, resync */
+		timer->expected = now;
+		late = 0.0;
+	}
+	timer->late_total += late;
+	if ( late > timer->late_max ) {
+		timer->late_max = late;
+	}
+
+	/* The timers keep to their schedule unless they fall behind */
+	if ( late < interval ) {
+		timer->expected += interval;
+	} else {
+		++timer->behind;
+		timer->expected = now + interval;
+	}
+	return(interval);
+}
+
+static int jitter_test(int count, int seconds)
+{
+	JitterTimer *timers;
+	SDL_TimerID *ids;
+	Uint32 calls = 0, behind = 0;
+	double late_total = 0.0, late_max = 0.0;
+	double start, slept;
+	int i;
+
+	timers = (JitterTimer *)calloc(count, sizeof(*timers));
+	ids = (SDL_TimerID *)calloc(count, sizeof(*ids));
+	if ( !timers || !ids ) {
+		fprintf(stderr, "Out of memory\n");
+		return(1);
+	}
+
+	printf("Running %d timers for %d seconds\n", count, seconds);
+	for ( i = 0; i < count; ++i ) {
+		/* Spread the intervals between 1 and 100 ms */
+		Uint32 interval = 1 + (i * 37) % 100;
+
+		timers[i].expected = now_ms() + interval;
+		ids[i] = SDL_AddTimer(interval, jitter_callback, &timers[i]);
+		if ( !ids[i] ) {
+			fprintf(stderr, "Could not create timer %d: %s\n",
+			        i, SDL_GetError());
+			count = i;
+			break;
+		}
+	}
+	SDL_Delay(seconds*1000);
+	for ( i = 0; i < count; ++i ) {
+		SDL_RemoveTimer(ids[i]);
+	}
+
+	for ( i = 0; i < count; ++i ) {
+		calls += timers[i].calls;
+		behind += timers[i].behind;
+		late_total += timers[i].late_total;
+		if ( timers[i].late_max > late_max ) {
+			late_max = timers[i].late_max;
+		}
+	}
+	printf("%u callbacks, %u behind schedule, lateness: mean %.3f ms, max %.3f ms\n",
+	       calls, behind, calls ? late_total / calls : 0.0, late_max);
+
+	/* Compare a 60 Hz frame wait with SDL_Delay() and SDL_DelayPrecise() */
+	start = now_ms();
+	for ( i = 0; i < 10; ++i ) {
+		SDL_Delay(16);
+	}
+	slept = (now_ms() - start) / 10;
+	printf("SDL_Delay(16): %.3f ms\n", slept);
+	start = now_ms();
+	for ( i = 0; i < 10; ++i ) {
+		SDL_DelayPrecise(16666667);
+	}
+	slept = (now_ms() - start) / 10;
+	printf("SDL_DelayPrecise(16666667): %.3f ms\n", slept);
+
+	free(ids);
+	free(timers);
+	return(0);
+}
+
 int main(int argc, char *argv[])
 {
 	int desired;
@@ -34,6 +225,25 @@ int main(int argc, char *argv[])
 		return(1);
 	}
 
+	if ( argv[1] && strcmp(argv[1], "--jitter") == 0 ) {
+		int count = 100;
+		int seconds = 5;
+		int status;
+
+		if ( argv[2] ) {
+			count = atoi(argv[2]);
+			if ( argv[3] ) {
+				seconds = atoi(argv[3]);
+			}
+		}
+		status = check_timers();
+		if ( jitter_test(count, seconds) != 0 ) {
+			status = 1;
+		}
+		SDL_Quit();
+		return(status);
+	}
+
 	/* Start the timer */
 	desired = 0;
 	if ( argv[1] ) {